@@ -0,0 +1,149 @@
+#include "BulkImporter.h"
+#include "Logger.h"
+#include "Tracer.h"
+#include "ZipReader.h"
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QSet>
+
+namespace {
+const int kParsedPercent = 95;  // The rest is the commit
+}
+
+BulkImporter::BulkImporter(ProfileStore *store, QObject *parent)
+    : QObject(parent)
+    , m_store(store)
+{
+    qRegisterMetaType<QVector<BulkImporter::Failure>>();
+}
+
+BulkImporter::~BulkImporter() {
+    m_pool.waitForDone();  // Tasks write into members
+}
+
+bool BulkImporter::start(const QStringList &paths) {
+    if (m_running) return false;
+    m_running = true;
+    m_clock.start();
+    m_sources.clear();
+    m_failures.clear();
+    m_archives.clear();
+    for (const QString &path : paths) collect(path);
+
+    m_results = QVector<Result>(m_sources.size());
+    m_done.storeRelaxed(0);
+    m_reported.storeRelaxed(0);
+    emit progressChanged(0);
+    TPN_INFO("Import", QString("Importing %1 file(s) on %2 thread(s).").arg(m_sources.size()).arg(m_pool.maxThreadCount()));
+    if (m_sources.isEmpty()) {
+        QMetaObject::invokeMethod(this, [this]() { finish(); }, Qt::QueuedConnection);
+        return true;
+    }
+    Result *results = m_results.data();  // Detached here, not concurrently in the tasks
+    for (int i = 0; i < m_sources.size(); ++i) {
+        m_pool.start([this, i, results]() { process(m_sources.at(i), &results[i]); });
+    }
+    return true;
+}
+
+void BulkImporter::collect(const QString &path) {
+    const QFileInfo info(path);
+    if (info.isDir()) {
+        QDirIterator it(path, QStringList() << "*.conf", QDir::Files, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            const QString file = it.next();
+            m_sources.append({ file, QFileInfo(file).completeBaseName(), file, -1, -1 });
+        }
+    } else if (info.suffix().compare("zip", Qt::CaseInsensitive) == 0) {
+        std::unique_ptr<ZipReader> archive(new ZipReader);
+        QString error;
+        if (!archive->open(path, &error)) {
+            m_failures.append({ path, error });
+            return;
+        }
+        const QVector<ZipReader::Entry> &entries = archive->entries();
+        for (int i = 0; i < entries.size(); ++i) {
+            if (!entries[i].name.endsWith(".conf", Qt::CaseInsensitive)) continue;
+            const QString base = entries[i].name.section('/', -1);
+            m_sources.append({ path + ':' + entries[i].name, base.left(base.size() - 5), QString(),
+                               int(m_archives.size()), i });
+        }
+        m_archives.push_back(std::move(archive));
+    } else {
+        m_sources.append({ path, info.completeBaseName(), path, -1, -1 });
+    }
+}
+
+void BulkImporter::process(const Source &source, Result *out) {
+    TPN_TRACE_SCOPE("Import::file");
+    Result &result = *out;
+    QByteArray text;
+    bool ok = false;
+    if (source.archive >= 0) {
+        const ZipReader &archive = *m_archives[size_t(source.archive)];
+        ok = archive.read(archive.entries()[source.entry], &text, &result.error);
+    } else {
+        QFile file(source.path);
+        ok = file.open(QIODevice::ReadOnly);
+        if (ok) text = file.readAll();
+        else result.error = "Failed to open config file.";
+    }
+    if (ok) ProfileStore::prepareImport(source.name, text, &result.import, &result.error);
+
+    // Only cross-thread traffic: a post per whole percent, one at the end
+    const int total = m_sources.size();
+    const int done = m_done.fetchAndAddAcquireRelease(1) + 1;
+    const int percent = int(qint64(done) * kParsedPercent / total);
+    int reported = m_reported.loadRelaxed();
+    while (percent > reported) {
+        if (m_reported.testAndSetRelaxed(reported, percent)) {
+            QMetaObject::invokeMethod(this, [this, percent]() { emit progressChanged(percent); }, Qt::QueuedConnection);
+            break;
+        }
+        reported = m_reported.loadRelaxed();
+    }
+    if (done == total) QMetaObject::invokeMethod(this, [this]() { finish(); }, Qt::QueuedConnection);
+}
+
+void BulkImporter::finish() {
+    QVector<ProfileStore::Import> imports;
+    imports.reserve(m_results.size());
+    QSet<QString> names;
+    QVector<Failure> failures = m_failures;
+    for (int i = 0; i < m_results.size(); ++i) {
+        Result &result = m_results[i];
+        if (!result.error.isEmpty()) {
+            failures.append({ m_sources[i].label, result.error });
+        } else if (names.contains(result.import.profile.name)) {
+            failures.append({ m_sources[i].label, QString("Duplicate profile name '%1'.").arg(result.import.profile.name) });
+        } else {
+            names.insert(result.import.profile.name);
+            imports.append(result.import);
+        }
+    }
+
+    QString commitError;
+    QStringList replaced;
+    if (!imports.isEmpty() && !m_store->commitImports(imports, &commitError, &replaced)) {
+        TPN_WARNING("Import", commitError);
+    }
+    const int imported = commitError.isEmpty() ? imports.size() : 0;
+
+    // The texts carry the keys in base64 and the blobs in raw form; drop the
+    // shared copies first so wiping doesn't detach into a fresh one (the
+    // store has moved its blobs into the cache by now)
+    imports.clear();
+    for (Result &result : m_results) {
+        SecretArena::wipe(result.import.text.data(), size_t(result.import.text.size()));
+        SecretArena::wipe(result.import.profile.blob.data(), size_t(result.import.profile.blob.size()));
+    }
+    m_results.clear();
+    m_archives.clear();
+    m_running = false;
+
+    TPN_INFO("Import", QString("Imported %1 profile(s), %2 replaced, %3 failed, %4 ms.")
+             .arg(imported).arg(replaced.size()).arg(failures.size()).arg(m_clock.elapsed()));
+    if (!replaced.isEmpty()) TPN_INFO("Import", "Replaced existing profiles: " + replaced.join(", "));
+    emit progressChanged(100);
+    emit finished(imported, failures, replaced, commitError, m_clock.elapsed());
+}
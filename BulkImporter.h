@@ -0,0 +1,75 @@
+#ifndef BULKIMPORTER_H
+#define BULKIMPORTER_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <QVector>
+#include <memory>
+#include "ProfileStore.h"
+
+class ZipReader;
+
+// Imports every .conf found in a set of paths (files, directories searched
+// recursively, .zip archives). Each file is read, parsed and encoded as one
+// task on a pool sized to the cores, and progress is reported as the share
+// of files done. Once all have been checked, the valid ones are committed
+// to the store in one step; a name that appears twice keeps the first file
+// and reports the rest, and one that is not a safe file name (see
+// ProfileStore::isValidName) fails that file. The store must not be
+// modified while an import runs.
+class BulkImporter : public QObject {
+    Q_OBJECT
+public:
+    struct Failure {
+        QString file;   // As found: path, or archive path plus entry name
+        QString error;
+    };
+
+    explicit BulkImporter(ProfileStore *store, QObject *parent = nullptr);
+    ~BulkImporter();
+
+    void setMaxThreads(int threads) { m_pool.setMaxThreadCount(threads); }
+    bool start(const QStringList &paths);  // false while a previous import is still running
+    bool isRunning() const { return m_running; }
+
+signals:
+    void progressChanged(int percent);
+    // commitError is set when nothing could be written; failures are per file;
+    // replaced names the imported profiles that overwrote existing ones
+    void finished(int imported, const QVector<BulkImporter::Failure> &failures, const QStringList &replaced,
+                  const QString &commitError, qint64 elapsedMs);
+
+private:
+    struct Source {
+        QString label;
+        QString name;   // Profile name: the file's base name, checked by prepareImport
+        QString path;   // On disk, or empty for an archive entry
+        int archive = -1;
+        int entry = -1;
+    };
+    struct Result {
+        ProfileStore::Import import;
+        QString error;
+    };
+
+    ProfileStore *m_store;
+    QThreadPool m_pool;
+    bool m_running = false;
+    QVector<Source> m_sources;
+    QVector<Result> m_results;  // One slot per source, written by its task only
+    std::vector<std::unique_ptr<ZipReader>> m_archives;
+    QVector<Failure> m_failures;  // Found while collecting sources
+    QAtomicInt m_done;
+    QAtomicInt m_reported;        // Last percentage posted to the UI
+    QElapsedTimer m_clock;
+
+    void collect(const QString &path);
+    void process(const Source &source, Result *result);
+    void finish();
+};
+
+Q_DECLARE_METATYPE(BulkImporter::Failure)
+
+#endif // BULKIMPORTER_H
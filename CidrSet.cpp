@@ -0,0 +1,200 @@
+#include "CidrSet.h"
+
+CidrSet::CidrSet()
+    : m_nodes(2)
+{
+}
+
+void CidrSet::clear() {
+    m_nodes.resize(2);
+    m_nodes[0] = Node();
+    m_nodes[1] = Node();
+    m_free.clear();
+}
+
+bool CidrSet::isEmpty() const {
+    return m_nodes[0].isLeaf() && m_nodes[1].isLeaf();
+}
+
+quint32 CidrSet::allocate() {
+    if (!m_free.isEmpty()) return m_free.takeLast();
+    m_nodes.append(Node());
+    return quint32(m_nodes.size() - 1);
+}
+
+void CidrSet::release(quint32 index) {
+    const Node node = m_nodes[index];
+    if (!node.isFull()) {
+        for (quint32 child : node.child) {
+            if (child != kNone) release(child);
+        }
+    }
+    m_nodes[index] = Node();
+    m_free.append(index);
+}
+
+void CidrSet::insert(const IpPrefix &prefix) {
+    if (prefix.family != 4 && prefix.family != 6) return;
+    quint32 path[128];
+    quint32 node = rootOf(prefix.family);
+    for (int depth = 0; depth < prefix.cidr; ++depth) {
+        if (m_nodes[node].isFull()) return;  // Already covered by a shorter prefix
+        path[depth] = node;
+        const int bit = bitAt(prefix.addr, depth);
+        quint32 next = m_nodes[node].child[bit];
+        if (next == kNone) {
+            next = allocate();
+            m_nodes[node].child[bit] = next;
+        }
+        node = next;
+    }
+    if (m_nodes[node].isFull()) return;
+
+    // Swallow anything more specific below, then merge upwards while both
+    // halves of a parent are covered
+    for (quint32 child : m_nodes[node].child) {
+        if (child != kNone) release(child);
+    }
+    m_nodes[node].child[0] = m_nodes[node].child[1] = kFull;
+    for (int depth = prefix.cidr - 1; depth >= 0; --depth) {
+        const quint32 low = m_nodes[path[depth]].child[0];
+        const quint32 high = m_nodes[path[depth]].child[1];
+        if (low == kNone || high == kNone || !m_nodes[low].isFull() || !m_nodes[high].isFull()) break;
+        release(low);
+        release(high);
+        m_nodes[path[depth]].child[0] = m_nodes[path[depth]].child[1] = kFull;
+    }
+}
+
+void CidrSet::insert(const QVector<IpPrefix> &prefixes) {
+    m_nodes.reserve(m_nodes.size() + prefixes.size() * 8);
+    for (const IpPrefix &prefix : prefixes) insert(prefix);
+}
+
+void CidrSet::subtract(const IpPrefix &prefix) {
+    if (prefix.family != 4 && prefix.family != 6) return;
+    quint32 path[128];
+    quint32 node = rootOf(prefix.family);
+    for (int depth = 0; depth < prefix.cidr; ++depth) {
+        path[depth] = node;
+        if (m_nodes[node].isFull()) {
+            // Split the covering prefix into its two halves
+            const quint32 low = allocate();
+            const quint32 high = allocate();
+            m_nodes[low].child[0] = m_nodes[low].child[1] = kFull;
+            m_nodes[high].child[0] = m_nodes[high].child[1] = kFull;
+            m_nodes[node].child[0] = low;
+            m_nodes[node].child[1] = high;
+        }
+        const quint32 next = m_nodes[node].child[bitAt(prefix.addr, depth)];
+        if (next == kNone) return;  // Nothing covered there
+        node = next;
+    }
+
+    if (prefix.cidr == 0) {
+        const Node root = m_nodes[node];
+        if (!root.isFull()) {
+            for (quint32 child : root.child) {
+                if (child != kNone) release(child);
+            }
+        }
+        m_nodes[node] = Node();
+        return;
+    }
+
+    // Unlink the range, then prune ancestors left without coverage
+    release(node);
+    m_nodes[path[prefix.cidr - 1]].child[bitAt(prefix.addr, prefix.cidr - 1)] = kNone;
+    for (int depth = prefix.cidr - 1; depth >= 1; --depth) {
+        const quint32 index = path[depth];
+        if (!m_nodes[index].isLeaf()) break;
+        release(index);
+        m_nodes[path[depth - 1]].child[bitAt(prefix.addr, depth - 1)] = kNone;
+    }
+}
+
+void CidrSet::subtract(const QVector<IpPrefix> &prefixes) {
+    for (const IpPrefix &prefix : prefixes) subtract(prefix);
+}
+
+bool CidrSet::contains(const IpPrefix &prefix) const {
+    if (prefix.family != 4 && prefix.family != 6) return false;
+    quint32 node = rootOf(prefix.family);
+    for (int depth = 0; depth < prefix.cidr; ++depth) {
+        if (m_nodes[node].isFull()) return true;
+        node = m_nodes[node].child[bitAt(prefix.addr, depth)];
+        if (node == kNone) return false;
+    }
+    return m_nodes[node].isFull();
+}
+
+bool CidrSet::intersects(const IpPrefix &prefix) const {
+    if (prefix.family != 4 && prefix.family != 6) return false;
+    quint32 node = rootOf(prefix.family);
+    for (int depth = 0; depth < prefix.cidr; ++depth) {
+        if (m_nodes[node].isFull()) return true;
+        node = m_nodes[node].child[bitAt(prefix.addr, depth)];
+        if (node == kNone) return false;
+    }
+    return !m_nodes[node].isLeaf();  // Empty non-root nodes are pruned
+}
+
+void CidrSet::collect(quint32 index, quint8 family, int depth, quint8 *bits, QVector<IpPrefix> *out) const {
+    const Node &node = m_nodes[index];
+    if (node.isFull()) {
+        IpPrefix prefix;
+        prefix.family = family;
+        prefix.cidr = quint8(depth);
+        memcpy(prefix.addr, bits, family == 6 ? 16 : 4);
+        out->append(prefix);
+        return;
+    }
+    for (int bit = 0; bit < 2; ++bit) {
+        if (node.child[bit] == kNone) continue;
+        if (bit) bits[depth >> 3] |= quint8(0x80 >> (depth & 7));
+        collect(node.child[bit], family, depth + 1, bits, out);
+        if (bit) bits[depth >> 3] &= quint8(~(0x80 >> (depth & 7)));
+    }
+}
+
+QVector<IpPrefix> CidrSet::prefixes() const {
+    QVector<IpPrefix> out;
+    quint8 bits[16] = {};
+    collect(0, 4, 0, bits, &out);
+    collect(1, 6, 0, bits, &out);
+    return out;
+}
+
+QVector<IpPrefix> CidrSet::aggregate(const QVector<IpPrefix> &include, const QVector<IpPrefix> &exclude) {
+    CidrSet set;
+    set.insert(include);
+    set.subtract(exclude);
+    return set.prefixes();
+}
+
+const QVector<IpPrefix> &CidrSet::localPrefixes() {
+    static const QVector<IpPrefix> prefixes = []() {
+        auto make = [](quint8 family, std::initializer_list<quint8> leading, quint8 cidr) {
+            IpPrefix prefix;
+            prefix.family = family;
+            prefix.cidr = cidr;
+            int i = 0;
+            for (quint8 byte : leading) prefix.addr[i++] = byte;
+            return prefix;
+        };
+        return QVector<IpPrefix>{
+            make(4, { 10 }, 8),
+            make(4, { 127 }, 8),
+            make(4, { 169, 254 }, 16),
+            make(4, { 172, 16 }, 12),
+            make(4, { 192, 168 }, 16),
+            make(4, { 224 }, 4),                      // Multicast
+            make(4, { 255, 255, 255, 255 }, 32),      // Limited broadcast
+            make(6, { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 }, 128),  // ::1
+            make(6, { 0xfc }, 7),                     // Unique local
+            make(6, { 0xfe, 0x80 }, 10),              // Link-local
+            make(6, { 0xff }, 8),                     // Multicast
+        };
+    }();
+    return prefixes;
+}
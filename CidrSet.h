@@ -0,0 +1,56 @@
+#ifndef CIDRSET_H
+#define CIDRSET_H
+
+#include <QVector>
+#include "TunnelConfig.h"
+
+// Set of IPv4/IPv6 addresses stored as a binary radix trie over prefix bits,
+// one root per family. Inserting merges sibling prefixes as soon as both
+// halves are covered and drops anything already covered, so prefixes()
+// always returns the minimal equivalent list; subtracting splits covering
+// prefixes down to the removed range. Nodes live in one pool indexed by
+// position, so building a set from 100k prefixes makes a handful of
+// allocations rather than one per node.
+class CidrSet {
+public:
+    CidrSet();
+
+    void insert(const IpPrefix &prefix);  // Host bits beyond cidr are ignored
+    void insert(const QVector<IpPrefix> &prefixes);
+    void subtract(const IpPrefix &prefix);
+    void subtract(const QVector<IpPrefix> &prefixes);
+    void clear();
+
+    bool contains(const IpPrefix &prefix) const;  // Entirely covered
+    bool intersects(const IpPrefix &prefix) const;
+    bool isEmpty() const;
+
+    QVector<IpPrefix> prefixes() const;  // Minimal, IPv4 first, ascending
+
+    // Minimal form of include minus exclude
+    static QVector<IpPrefix> aggregate(const QVector<IpPrefix> &include,
+                                       const QVector<IpPrefix> &exclude = QVector<IpPrefix>());
+    // Private, link-local, loopback and multicast ranges of both families
+    static const QVector<IpPrefix> &localPrefixes();
+
+private:
+    static const quint32 kNone = 0;           // Child slot unused (node 0 is never a child)
+    static const quint32 kFull = 0xFFFFFFFFu; // Both slots: the whole subtree is covered
+
+    struct Node {
+        quint32 child[2] = { kNone, kNone };
+        bool isFull() const { return child[0] == kFull; }
+        bool isLeaf() const { return child[0] == kNone && child[1] == kNone; }
+    };
+
+    QVector<Node> m_nodes;     // [0] IPv4 root, [1] IPv6 root
+    QVector<quint32> m_free;   // Recycled node indices
+
+    quint32 allocate();
+    void release(quint32 index);  // Frees the whole subtree
+    void collect(quint32 index, quint8 family, int depth, quint8 *bits, QVector<IpPrefix> *out) const;
+    static quint32 rootOf(quint8 family) { return family == 6 ? 1 : 0; }
+    static int bitAt(const quint8 *addr, int i) { return (addr[i >> 3] >> (7 - (i & 7))) & 1; }
+};
+
+#endif // CIDRSET_H
@@ -0,0 +1,72 @@
+#include "ConfigDiff.h"
+#include <QHash>
+#include <cstring>
+
+namespace {
+
+QByteArray keyOf(const PeerConfig &peer) {
+    return QByteArray::fromRawData(reinterpret_cast<const char *>(peer.publicKey), 32);
+}
+
+int changedFields(const PeerConfig &a, const PeerConfig &b) {
+    int fields = 0;
+    if (a.endpointPort != b.endpointPort || a.endpointAddress != b.endpointAddress)
+        fields |= PeerChange::Endpoint;
+    if (a.allowedIPs != b.allowedIPs)
+        fields |= PeerChange::AllowedIPs;
+    if (a.persistentKeepalive != b.persistentKeepalive)
+        fields |= PeerChange::PersistentKeepalive;
+    if (a.hasPresharedKey != b.hasPresharedKey || a.presharedKey != b.presharedKey)
+        fields |= PeerChange::PresharedKey;
+    return fields;
+}
+
+} // namespace
+
+int ConfigDelta::count(PeerChange::Kind kind) const {
+    int n = 0;
+    for (const PeerChange &change : peers) {
+        if (change.kind == kind) ++n;
+    }
+    return n;
+}
+
+ConfigDelta diffConfigs(const TunnelConfig &applied, const TunnelConfig &next) {
+    ConfigDelta delta;
+    delta.privateKeyChanged = applied.iface.privateKey != next.iface.privateKey;
+    delta.listenPortChanged = applied.iface.listenPort != next.iface.listenPort;
+
+    // fromRawData keys point into the configs, both outlive the index
+    QHash<QByteArray, int> oldIndex;
+    oldIndex.reserve(applied.peers.size());
+    for (int i = 0; i < applied.peers.size(); ++i) {
+        oldIndex.insert(keyOf(applied.peers[i]), i);
+    }
+
+    for (int i = 0; i < next.peers.size(); ++i) {
+        auto it = oldIndex.find(keyOf(next.peers[i]));
+        if (it == oldIndex.end()) {
+            delta.peers.append({ PeerChange::Added, i, 0 });
+            continue;
+        }
+        int fields = changedFields(applied.peers[*it], next.peers[i]);
+        if (fields) delta.peers.append({ PeerChange::Updated, i, fields });
+        oldIndex.erase(it);
+    }
+
+    for (int index : qAsConst(oldIndex)) {
+        delta.peers.append({ PeerChange::Removed, index, 0 });
+    }
+    return delta;
+}
+
+ConfigDelta fullConfigDelta(const TunnelConfig &config) {
+    ConfigDelta delta;
+    delta.privateKeyChanged = true;
+    delta.listenPortChanged = true;
+    delta.peers.reserve(config.peers.size());
+    for (int i = 0; i < config.peers.size(); ++i) {
+        delta.peers.append({ PeerChange::Added, i, PeerChange::AllFields });
+    }
+    return delta;
+}
@@ -0,0 +1,38 @@
+#ifndef CONFIGDIFF_H
+#define CONFIGDIFF_H
+
+#include <QVector>
+#include "TunnelConfig.h"
+
+// Difference between the configuration applied to a live adapter and a new
+// one. Peers are matched by public key, so a server switch that keeps most
+// peers only touches the ones that actually changed.
+struct PeerChange {
+    enum Kind { Added, Removed, Updated };
+    enum Field {
+        Endpoint = 0x1,
+        AllowedIPs = 0x2,
+        PersistentKeepalive = 0x4,
+        PresharedKey = 0x8,
+        AllFields = 0xF,
+        AppendAllowedIPs = 0x10  // Domain routes: add to the driver's list without replacing it
+    };
+
+    Kind kind;
+    int index;      // Into the new config's peers (Added/Updated) or the old one (Removed)
+    int fields = 0; // Updated only: which Field values differ
+};
+
+struct ConfigDelta {
+    bool privateKeyChanged = false;
+    bool listenPortChanged = false;
+    QVector<PeerChange> peers;
+
+    bool isEmpty() const { return !privateKeyChanged && !listenPortChanged && peers.isEmpty(); }
+    int count(PeerChange::Kind kind) const;
+};
+
+ConfigDelta diffConfigs(const TunnelConfig &applied, const TunnelConfig &next);
+ConfigDelta fullConfigDelta(const TunnelConfig &config);  // Everything "Added"
+
+#endif // CONFIGDIFF_H
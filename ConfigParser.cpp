@@ -0,0 +1,379 @@
+#include "ConfigParser.h"
+#include "CidrSet.h"
+#include "KeyCodec.h"
+#include "Tracer.h"
+#include <QFile>
+#include <cstring>
+#ifdef Q_OS_WIN
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#endif
+
+namespace {
+
+struct Span {
+    const char *p;
+    int n;
+};
+
+inline bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+Span trim(const char *b, const char *e) {
+    while (b < e && isSpace(*b)) ++b;
+    while (e > b && isSpace(e[-1])) --e;
+    return { b, int(e - b) };
+}
+
+// Case-insensitive compare against a lowercase ASCII literal, no allocation.
+bool equalsLower(Span s, const char *lit) {
+    for (int i = 0; i < s.n; ++i) {
+        char c = s.p[i];
+        if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+        if (lit[i] == '\0' || lit[i] != c) return false;
+    }
+    return lit[s.n] == '\0';
+}
+
+bool parseUInt(Span s, quint32 max, quint32 *out) {
+    if (s.n == 0 || s.n > 10) return false;
+    quint64 v = 0;
+    for (int i = 0; i < s.n; ++i) {
+        if (s.p[i] < '0' || s.p[i] > '9') return false;
+        v = v * 10 + quint64(s.p[i] - '0');
+    }
+    if (v > max) return false;
+    *out = quint32(v);
+    return true;
+}
+
+// Decodes straight into the arena; a failed decode leaves nothing behind
+bool decodeSecret(Span s, SecretBuffer *out) {
+    *out = SecretBuffer(KeyCodec::kKeyBytes);
+    if (KeyCodec::decode(s.p, s.n, out->data())) return true;
+    out->clear();
+    return false;
+}
+
+// Dotted quad without leading zeros; the common case in large prefix lists
+bool parseIPv4(Span s, quint8 out[4]) {
+    int part = 0;
+    int digits = 0;
+    quint32 value = 0;
+    for (int i = 0; i <= s.n; ++i) {
+        if (i == s.n || s.p[i] == '.') {
+            if (digits == 0 || value > 255 || part > 3) return false;
+            out[part++] = quint8(value);
+            value = 0;
+            digits = 0;
+        } else if (s.p[i] >= '0' && s.p[i] <= '9' && digits < 3 && !(digits == 1 && value == 0)) {
+            value = value * 10 + quint32(s.p[i] - '0');
+            ++digits;
+        } else {
+            return false;
+        }
+    }
+    return part == 4;
+}
+
+// "addr" or "addr/cidr", IPv4 or IPv6. Anything but a plain dotted quad is
+// copied into a stack buffer only to NUL-terminate it for inet_pton.
+bool parsePrefix(Span s, IpPrefix *out) {
+    const char *slash = static_cast<const char *>(memchr(s.p, '/', size_t(s.n)));
+    Span addr = slash ? trim(s.p, slash) : s;
+    if (parseIPv4(addr, out->addr)) {
+        out->family = 4;
+        quint32 cidr = 32;
+        if (slash && !parseUInt(trim(slash + 1, s.p + s.n), 32, &cidr)) return false;
+        out->cidr = quint8(cidr);
+        return true;
+    }
+
+    char buf[64];
+    if (addr.n == 0 || addr.n >= int(sizeof(buf))) return false;
+    memcpy(buf, addr.p, size_t(addr.n));
+    buf[addr.n] = '\0';
+
+    quint32 maxCidr;
+    if (inet_pton(AF_INET, buf, out->addr) == 1) {
+        out->family = 4;
+        maxCidr = 32;
+    } else if (inet_pton(AF_INET6, buf, out->addr) == 1) {
+        out->family = 6;
+        maxCidr = 128;
+    } else {
+        return false;
+    }
+
+    quint32 cidr = maxCidr;
+    if (slash && !parseUInt(trim(slash + 1, s.p + s.n), maxCidr, &cidr)) return false;
+    out->cidr = quint8(cidr);
+    return true;
+}
+
+// Calls fn(item) for every trimmed, non-empty comma separated item.
+template <typename Fn>
+bool forEachListItem(Span s, Fn fn) {
+    const char *p = s.p;
+    const char *end = s.p + s.n;
+    while (p < end) {
+        const char *comma = static_cast<const char *>(memchr(p, ',', size_t(end - p)));
+        const char *itemEnd = comma ? comma : end;
+        Span item = trim(p, itemEnd);
+        if (item.n && !fn(item)) return false;
+        p = comma ? comma + 1 : end;
+    }
+    return true;
+}
+
+int countListItems(Span s) {
+    int n = 1;
+    for (int i = 0; i < s.n; ++i) {
+        if (s.p[i] == ',') ++n;
+    }
+    return n;
+}
+
+bool parsePrefixList(Span s, QVector<IpPrefix> *out) {
+    out->reserve(out->size() + countListItems(s));
+    return forEachListItem(s, [out](Span item) {
+        IpPrefix prefix;
+        if (!parsePrefix(item, &prefix)) return false;
+        out->append(prefix);
+        return true;
+    });
+}
+
+// AllowedIPs-style list where "lan" stands for all local ranges
+bool parseExclusionList(Span s, QVector<IpPrefix> *out) {
+    return forEachListItem(s, [out](Span item) {
+        if (equalsLower(item, "lan")) {
+            *out += CidrSet::localPrefixes();
+            return true;
+        }
+        IpPrefix prefix;
+        if (!parsePrefix(item, &prefix)) return false;
+        out->append(prefix);
+        return true;
+    });
+}
+
+// Domain rules: "example.com" or "*.example.com", stored lowercase without
+// a trailing dot
+bool parseDomainList(Span s, QList<QByteArray> *out) {
+    return forEachListItem(s, [out](Span item) {
+        QByteArray name(item.p, item.n);
+        if (name.endsWith('.')) name.chop(1);
+        const int start = name.startsWith("*.") ? 2 : 0;
+        if (name.size() <= start || name.size() > 253) return false;
+        for (int i = start; i < name.size(); ++i) {
+            char &c = name[i];
+            if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+            const bool valid = (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '.';
+            if (!valid || (c == '.' && (i == start || name[i - 1] == '.'))) return false;
+        }
+        out->append(name);
+        return true;
+    });
+}
+
+// "host:port" or "[v6addr]:port"
+bool parseEndpoint(Span s, PeerConfig *peer) {
+    Span host;
+    const char *portStart;
+    if (s.n && s.p[0] == '[') {
+        const char *close = static_cast<const char *>(memchr(s.p, ']', size_t(s.n)));
+        if (!close || close + 1 >= s.p + s.n || close[1] != ':') return false;
+        host = { s.p + 1, int(close - s.p - 1) };
+        portStart = close + 2;
+    } else {
+        const char *colon = nullptr;
+        for (int i = s.n - 1; i >= 0; --i) {
+            if (s.p[i] == ':') { colon = s.p + i; break; }
+        }
+        if (!colon) return false;
+        host = trim(s.p, colon);
+        portStart = colon + 1;
+    }
+    quint32 port;
+    if (host.n == 0 || !parseUInt(trim(portStart, s.p + s.n), 65535, &port) || port == 0) return false;
+    peer->endpointHost = QByteArray(host.p, host.n);
+    peer->endpointPort = quint16(port);
+    return true;
+}
+
+} // namespace
+
+bool ConfigParser::fail(int line, const char *msg) {
+    m_errorLine = line;
+    m_error = QString("Line %1: %2").arg(line).arg(QLatin1String(msg));
+    return false;
+}
+
+bool ConfigParser::parse(const char *data, qsizetype size, TunnelConfig *out) {
+    TPN_TRACE_SCOPE("Config::parse");
+    m_error.clear();
+    m_errorLine = 0;
+    *out = TunnelConfig();
+
+    enum { NoSection, InterfaceSection, PeerSection } section = NoSection;
+    bool havePrivateKey = false;
+    PeerConfig *peer = nullptr;
+    bool peerHasKey = false;
+    QVector<QVector<IpPrefix>> excluded;  // Per peer, applied once all lines are read
+
+    const char *p = data;
+    const char *end = data + size;
+    if (size >= 3 && memcmp(p, "\xEF\xBB\xBF", 3) == 0) p += 3;  // UTF-8 BOM
+    int lineNo = 0;
+
+    while (p < end) {
+        ++lineNo;
+        const char *nl = static_cast<const char *>(memchr(p, '\n', size_t(end - p)));
+        const char *lineEnd = nl ? nl : end;
+        const char *hash = static_cast<const char *>(memchr(p, '#', size_t(lineEnd - p)));
+        Span line = trim(p, hash ? hash : lineEnd);
+        p = nl ? nl + 1 : end;
+        if (line.n == 0) continue;
+
+        if (line.p[0] == '[') {
+            if (section == PeerSection && !peerHasKey) return fail(lineNo, "Peer without PublicKey.");
+            if (equalsLower(line, "[interface]")) {
+                section = InterfaceSection;
+            } else if (equalsLower(line, "[peer]")) {
+                section = PeerSection;
+                out->peers.append(PeerConfig());
+                excluded.append(QVector<IpPrefix>());
+                peer = &out->peers.last();
+                peerHasKey = false;
+            } else {
+                return fail(lineNo, "Unknown section.");
+            }
+            continue;
+        }
+
+        // Split on the first '=' only; base64 values carry '=' padding.
+        const char *eq = static_cast<const char *>(memchr(line.p, '=', size_t(line.n)));
+        if (!eq) return fail(lineNo, "Expected 'Key = Value'.");
+        Span key = trim(line.p, eq);
+        Span value = trim(eq + 1, line.p + line.n);
+        quint32 number;
+
+        if (section == InterfaceSection) {
+            InterfaceConfig &iface = out->iface;
+            if (equalsLower(key, "privatekey")) {
+                if (!decodeSecret(value, &iface.privateKey)) return fail(lineNo, "Invalid PrivateKey.");
+                havePrivateKey = true;
+            } else if (equalsLower(key, "listenport")) {
+                if (!parseUInt(value, 65535, &number)) return fail(lineNo, "Invalid ListenPort.");
+                iface.listenPort = quint16(number);
+            } else if (equalsLower(key, "mtu")) {
+                if (!parseUInt(value, 65535, &number) || number < 576) return fail(lineNo, "Invalid MTU.");
+                iface.mtu = quint16(number);
+            } else if (equalsLower(key, "address")) {
+                if (!parsePrefixList(value, &iface.addresses)) return fail(lineNo, "Invalid Address.");
+            } else if (equalsLower(key, "dns")) {
+                bool ok = forEachListItem(value, [&iface](Span item) {
+                    IpPrefix server;
+                    if (!memchr(item.p, '/', size_t(item.n)) && parsePrefix(item, &server))
+                        iface.dns.append(server);
+                    else
+                        iface.dnsSearch.append(QByteArray(item.p, item.n));
+                    return true;
+                });
+                if (!ok) return fail(lineNo, "Invalid DNS.");
+            }
+            // Table, FwMark, Pre/PostUp etc. are wg-quick only; ignored here
+        } else if (section == PeerSection) {
+            if (equalsLower(key, "publickey")) {
+                if (!KeyCodec::decode(value.p, value.n, peer->publicKey)) return fail(lineNo, "Invalid PublicKey.");
+                peerHasKey = true;
+            } else if (equalsLower(key, "presharedkey")) {
+                if (!decodeSecret(value, &peer->presharedKey)) return fail(lineNo, "Invalid PresharedKey.");
+                peer->hasPresharedKey = true;
+            } else if (equalsLower(key, "endpoint")) {
+                if (!parseEndpoint(value, peer)) return fail(lineNo, "Invalid Endpoint.");
+            } else if (equalsLower(key, "allowedips")) {
+                if (!parsePrefixList(value, &peer->allowedIPs)) return fail(lineNo, "Invalid AllowedIPs.");
+            } else if (equalsLower(key, "excludedips")) {
+                // Client extension: routed as AllowedIPs minus these ranges
+                if (!parseExclusionList(value, &excluded.last())) return fail(lineNo, "Invalid ExcludedIPs.");
+            } else if (equalsLower(key, "alloweddomains")) {
+                // Client extension: addresses these names resolve to are routed to the peer
+                if (!parseDomainList(value, &peer->allowedDomains)) return fail(lineNo, "Invalid AllowedDomains.");
+            } else if (equalsLower(key, "persistentkeepalive")) {
+                if (equalsLower(value, "off")) {
+                    peer->persistentKeepalive = 0;
+                } else if (parseUInt(value, 65535, &number)) {
+                    peer->persistentKeepalive = quint16(number);
+                } else {
+                    return fail(lineNo, "Invalid PersistentKeepalive.");
+                }
+            }
+        } else {
+            return fail(lineNo, "Key outside of a section.");
+        }
+    }
+
+    if (section == PeerSection && !peerHasKey) return fail(lineNo, "Peer without PublicKey.");
+    if (!havePrivateKey) return fail(lineNo, "No PrivateKey found.");
+    if (out->peers.isEmpty()) return fail(lineNo, "No valid Peer found.");
+
+    // Deduplicate, merge and apply exclusions so large split-tunnel lists
+    // reach the driver as the minimal equivalent set
+    TPN_TRACE_SCOPE("Config::aggregate");
+    for (int i = 0; i < out->peers.size(); ++i) {
+        QVector<IpPrefix> &allowed = out->peers[i].allowedIPs;
+        if (allowed.isEmpty()) continue;
+        allowed = CidrSet::aggregate(allowed, excluded[i]);
+    }
+    return true;
+}
+
+bool ConfigParser::parsePrefixes(const char *data, qsizetype size, QVector<IpPrefix> *out) {
+    const char *p = data;
+    const char *end = data + size;
+    while (p < end) {
+        if (*p == '#') {
+            const char *nl = static_cast<const char *>(memchr(p, '\n', size_t(end - p)));
+            p = nl ? nl + 1 : end;
+            continue;
+        }
+        if (isSpace(*p) || *p == ',' || *p == '\n') {
+            ++p;
+            continue;
+        }
+        const char *start = p;
+        while (p < end && !isSpace(*p) && *p != ',' && *p != '\n' && *p != '#') ++p;
+        IpPrefix prefix;
+        if (!parsePrefix({ start, int(p - start) }, &prefix)) return false;
+        out->append(prefix);
+    }
+    return true;
+}
+
+bool ConfigParser::parseFile(const QString &filePath, TunnelConfig *out) {
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        m_errorLine = 0;
+        m_error = "Failed to open config file.";
+        return false;
+    }
+
+    const qint64 size = file.size();
+    if (size == 0) return parse("", 0, out);
+
+    uchar *mapped = file.map(0, size);
+    if (mapped) {
+        bool ok = parse(reinterpret_cast<const char *>(mapped), qsizetype(size), out);
+        file.unmap(mapped);
+        return ok;
+    }
+    // Not mappable (pipes, some network shares): fall back to one read
+    QByteArray bytes = file.readAll();
+    const bool ok = parse(bytes.constData(), bytes.size(), out);
+    SecretArena::wipe(bytes.data(), size_t(bytes.size()));  // Holds the keys in text form
+    return ok;
+}
@@ -0,0 +1,31 @@
+#ifndef CONFIGPARSER_H
+#define CONFIGPARSER_H
+
+#include <QString>
+#include "TunnelConfig.h"
+
+// Single-pass parser for wg-quick style configs. Works directly on the raw
+// bytes (memory-mapped for files) and only allocates for the output lists,
+// so large multi-peer configs don't pay per-line QString churn. AllowedIPs
+// come out aggregated (see CidrSet); a peer's ExcludedIPs ("lan" expands to
+// the local ranges) are subtracted from them. AllowedDomains lists names
+// whose resolved addresses are routed to the peer (see DomainPolicy).
+class ConfigParser {
+public:
+    bool parse(const char *data, qsizetype size, TunnelConfig *out);
+    bool parseFile(const QString &filePath, TunnelConfig *out);
+    // Bare prefix list (comma, space or newline separated, '#' comments),
+    // e.g. a country range file; appended to out without aggregation
+    static bool parsePrefixes(const char *data, qsizetype size, QVector<IpPrefix> *out);
+
+    QString errorString() const { return m_error; }
+    int errorLine() const { return m_errorLine; }
+
+private:
+    QString m_error;
+    int m_errorLine = 0;
+
+    bool fail(int line, const char *msg);
+};
+
+#endif // CONFIGPARSER_H
@@ -0,0 +1,87 @@
+#include "ConnectionState.h"
+#include <QDateTime>
+
+QString ConnectionSnapshot::stateName(State state) {
+    switch (state) {
+    case Inactive: return "Inactive";
+    case Creating: return "Creating...";
+    case Ready: return "Ready";
+    case Connecting: return "Connecting...";
+    case Connected: return "Connected";
+    case Reconnecting: return "Reconnecting...";
+    case Disconnecting: return "Disconnecting...";
+    case Disconnected: return "Disconnected";
+    }
+    return "Unknown";
+}
+
+ConnectionState::ConnectionState(QObject *parent)
+    : QObject(parent)
+    , m_current(nullptr)
+    , m_readers(0)
+    , m_state(ConnectionSnapshot::Inactive)
+{
+    qRegisterMetaType<ConnectionSnapshot>();
+    m_next.sinceMs = QDateTime::currentMSecsSinceEpoch();
+    m_current.store(new ConnectionSnapshot(m_next));
+}
+
+ConnectionState::~ConnectionState() {
+    // Readers on other threads must be gone by now, as with any QObject
+    delete m_current.load();
+    qDeleteAll(m_retired);
+}
+
+ConnectionSnapshot ConnectionState::snapshot() const {
+    m_readers.fetch_add(1);
+    ConnectionSnapshot copy = *m_current.load();
+    m_readers.fetch_sub(1, std::memory_order_release);
+    return copy;
+}
+
+void ConnectionState::setState(ConnectionSnapshot::State state) {
+    if (m_next.state == state) return;
+    m_next.state = state;
+    m_next.sinceMs = QDateTime::currentMSecsSinceEpoch();
+    publish();
+}
+
+void ConnectionState::setProfile(const QString &profile, const QString &endpoint) {
+    if (m_next.profile == profile && m_next.endpoint == endpoint) return;
+    m_next.profile = profile;
+    m_next.endpoint = endpoint;
+    publish();
+}
+
+void ConnectionState::setEndpoint(const QString &endpoint) {
+    setProfile(m_next.profile, endpoint);
+}
+
+void ConnectionState::setError(const QString &error) {
+    if (m_next.lastError == error) return;
+    m_next.lastError = error;
+    publish();
+}
+
+void ConnectionState::publish() {
+    m_next.version++;
+    m_publishes++;
+    m_retired.append(m_current.exchange(new ConnectionSnapshot(m_next)));
+    m_state.store(m_next.state, std::memory_order_release);
+    // A reader still holding a retired snapshot has the count raised; try
+    // again on the next change (state changes come in handfuls)
+    if (m_readers.load() == 0) {
+        qDeleteAll(m_retired);
+        m_retired.clear();
+    }
+
+    if (m_notifyQueued) return;
+    m_notifyQueued = true;
+    QMetaObject::invokeMethod(this, &ConnectionState::notify, Qt::QueuedConnection);
+}
+
+void ConnectionState::notify() {
+    m_notifyQueued = false;
+    m_notifications++;
+    emit changed(snapshot());
+}
@@ -0,0 +1,70 @@
+#ifndef CONNECTIONSTATE_H
+#define CONNECTIONSTATE_H
+
+#include <QObject>
+#include <QMetaType>
+#include <QString>
+#include <QVector>
+#include <atomic>
+
+// What the client is doing with its tunnel, as every consumer should see it
+struct ConnectionSnapshot {
+    enum State { Inactive, Creating, Ready, Connecting, Connected, Reconnecting, Disconnecting, Disconnected };
+
+    State state = Inactive;
+    qint64 sinceMs = 0;   // Unix ms the state was entered
+    QString profile;      // Applied profile, empty before the first
+    QString endpoint;     // "host:port" of the first peer with one
+    QString lastError;    // Most recent failure; cleared when a later command succeeds
+    quint64 version = 0;  // Bumped on every change
+
+    bool isConnected() const { return state == Connected || state == Reconnecting; }
+    bool isBusy() const { return state == Creating || state == Connecting || state == Disconnecting; }
+    static QString stateName(State state);  // "Connected", "Connecting...", ...
+};
+Q_DECLARE_METATYPE(ConnectionSnapshot)
+
+// One authoritative connection state, kept by the manager from worker
+// results so nobody has to ask the driver. Each change publishes a new
+// immutable snapshot: snapshot() is lock-free from any thread and never
+// blocks the owner. Subscribers connect to changed(), which is emitted
+// at most once per event loop pass on the owner thread however many
+// updates landed in between, and carries the latest snapshot.
+class ConnectionState : public QObject {
+    Q_OBJECT
+public:
+    explicit ConnectionState(QObject *parent = nullptr);
+    ~ConnectionState();
+
+    ConnectionSnapshot snapshot() const;  // Any thread
+    ConnectionSnapshot::State state() const { return ConnectionSnapshot::State(m_state.load(std::memory_order_acquire)); }
+
+    // Owner thread only. Setting what is already there changes nothing
+    void setState(ConnectionSnapshot::State state);
+    void setProfile(const QString &profile, const QString &endpoint);
+    void setEndpoint(const QString &endpoint);
+    void setError(const QString &error);  // Empty clears
+
+    quint64 publishes() const { return m_publishes; }
+    quint64 notifications() const { return m_notifications; }
+
+signals:
+    void changed(const ConnectionSnapshot &snapshot);
+
+private:
+    ConnectionSnapshot m_next;  // Owner's working copy
+    // Readers announce themselves before loading the pointer, so a retired
+    // snapshot can be freed once none are inside
+    std::atomic<const ConnectionSnapshot *> m_current;
+    mutable std::atomic<int> m_readers;
+    std::atomic<int> m_state;
+    QVector<const ConnectionSnapshot *> m_retired;
+    bool m_notifyQueued = false;
+    quint64 m_publishes = 0;
+    quint64 m_notifications = 0;
+
+    void publish();
+    void notify();
+};
+
+#endif // CONNECTIONSTATE_H
@@ -0,0 +1,62 @@
+#include "ControlChannel.h"
+#include <QCborValue>
+#include <QDeadlineTimer>
+#include <QLocalSocket>
+#include <QtEndian>
+
+const char *ControlChannel::defaultServerName() {
+    return "tpn-control";
+}
+
+ControlChannel::ControlChannel(QLocalSocket *socket, QObject *parent)
+    : QObject(parent)
+    , m_socket(socket)
+{
+    m_socket->setParent(this);
+    connect(m_socket, &QLocalSocket::readyRead, this, &ControlChannel::onReadyRead);
+    connect(m_socket, &QLocalSocket::disconnected, this, &ControlChannel::disconnected);
+}
+
+void ControlChannel::send(const QCborMap &message) {
+    const QByteArray payload = message.toCborValue().toCbor();
+    char header[4];
+    qToBigEndian(quint32(payload.size()), header);
+    m_socket->write(header, 4);
+    m_socket->write(payload);
+}
+
+void ControlChannel::onReadyRead() {
+    m_buffer += m_socket->readAll();
+    if (m_waiting) return;  // waitForMessage() takes it
+    QCborMap message;
+    while (takeMessage(&message)) emit messageReceived(message);
+}
+
+bool ControlChannel::waitForMessage(QCborMap *out, int timeoutMs) {
+    QDeadlineTimer deadline(timeoutMs);
+    m_waiting = true;
+    m_buffer += m_socket->readAll();
+    bool ok = takeMessage(out);
+    while (!ok && m_socket->state() == QLocalSocket::ConnectedState
+           && m_socket->waitForReadyRead(int(deadline.remainingTime()))) {
+        ok = takeMessage(out);
+    }
+    m_waiting = false;
+    return ok;
+}
+
+bool ControlChannel::takeMessage(QCborMap *out) {
+    if (m_buffer.size() < 4) return false;
+    const quint32 length = qFromBigEndian<quint32>(m_buffer.constData());
+    if (length > quint32(kMaxFrame)) {
+        // Not a client of ours; don't buffer whatever it sends next
+        m_buffer.clear();
+        m_socket->abort();
+        return false;
+    }
+    if (m_buffer.size() < 4 + int(length)) return false;
+    const QCborValue value = QCborValue::fromCbor(m_buffer.mid(4, int(length)));
+    m_buffer.remove(0, 4 + int(length));
+    *out = value.isMap() ? value.toMap() : QCborMap();
+    return true;
+}
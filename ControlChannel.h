@@ -0,0 +1,42 @@
+#ifndef CONTROLCHANNEL_H
+#define CONTROLCHANNEL_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QCborMap>
+
+class QLocalSocket;
+
+// One end of the local control connection. Every message is a CBOR map
+// sent as a frame: 4-byte big-endian payload length, then the payload.
+// Requests carry "id" and "cmd"; replies echo "id" and carry "ok" plus
+// command-specific fields or "error". Works event-driven (messageReceived)
+// or blocking (waitForMessage) for the CLI.
+class ControlChannel : public QObject {
+    Q_OBJECT
+public:
+    static const int kMaxFrame = 1024 * 1024;
+    static const char *defaultServerName();
+
+    explicit ControlChannel(QLocalSocket *socket, QObject *parent = nullptr);  // Takes ownership
+
+    QLocalSocket *socket() const { return m_socket; }
+    void send(const QCborMap &message);
+    bool waitForMessage(QCborMap *out, int timeoutMs);
+
+signals:
+    void messageReceived(const QCborMap &message);
+    void disconnected();
+
+private slots:
+    void onReadyRead();
+
+private:
+    QLocalSocket *m_socket;
+    QByteArray m_buffer;
+    bool m_waiting = false;
+
+    bool takeMessage(QCborMap *out);
+};
+
+#endif // CONTROLCHANNEL_H
@@ -0,0 +1,73 @@
+#include "ControlClient.h"
+#include "ControlChannel.h"
+#include <QCborArray>
+#include <QCborValue>
+#include <QJsonDocument>
+#include <QLocalSocket>
+#include <QTextStream>
+
+bool ControlClient::isRequested(int argc, char *argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--ctl") == 0) return true;
+    }
+    return false;
+}
+
+int ControlClient::run(const QStringList &arguments) {
+    QString socketName = ControlChannel::defaultServerName();
+    int timeoutMs = 30000;  // connect waits for the handshake with the driver
+    bool json = false;
+    QStringList words;
+    for (int i = arguments.indexOf("--ctl") + 1; i < arguments.size(); ++i) {
+        const QString &arg = arguments[i];
+        if (arg.startsWith("--socket=")) socketName = arg.section('=', 1);
+        else if (arg.startsWith("--timeout=")) timeoutMs = qMax(1, arg.section('=', 1).toInt());
+        else if (arg == "--json") json = true;
+        else if (!arg.startsWith("--")) words.append(arg);
+    }
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    if (words.isEmpty()) {
+        err << "Usage: --ctl status|stats|profiles|ping|connect [PROFILE]|disconnect|trace start|stop|save PATH"
+               " [--json] [--socket=NAME]\n";
+        return 2;
+    }
+
+    ControlChannel channel(new QLocalSocket);
+    channel.socket()->connectToServer(socketName);
+    if (!channel.socket()->waitForConnected(1000)) {
+        err << "Cannot reach '" << socketName << "': " << channel.socket()->errorString() << '\n';
+        return 1;
+    }
+
+    QCborMap request;
+    request.insert(QLatin1String("id"), 1);
+    request.insert(QLatin1String("cmd"), words[0]);
+    if (words.size() > 1) request.insert(QLatin1String("args"), QCborArray::fromStringList(words.mid(1)));
+    channel.send(request);
+    channel.socket()->waitForBytesWritten(1000);
+
+    QCborMap reply;
+    if (!channel.waitForMessage(&reply, timeoutMs)) {
+        err << "No reply within " << timeoutMs << " ms.\n";
+        return 1;
+    }
+
+    const bool ok = reply.value(QLatin1String("ok")).toBool();
+    if (json) {
+        out << QJsonDocument(reply.toJsonObject()).toJson(QJsonDocument::Indented);
+    } else {
+        for (auto it = reply.constBegin(); it != reply.constEnd(); ++it) {
+            const QString key = it.key().toString();
+            if (key == "id" || key == "ok" || key == "error") continue;
+            const QCborValue value = it.value();
+            if (value.isArray()) {
+                for (const QCborValue &item : value.toArray()) out << item.toVariant().toString() << '\n';
+            } else {
+                out << key << ": " << value.toVariant().toString() << '\n';
+            }
+        }
+        if (!ok) err << "Failed: " << reply.value(QLatin1String("error")).toString() << '\n';
+    }
+    return ok ? 0 : 1;
+}
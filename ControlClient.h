@@ -0,0 +1,19 @@
+#ifndef CONTROLCLIENT_H
+#define CONTROLCLIENT_H
+
+#include <QStringList>
+
+// Command line client for a running instance's control socket:
+//
+//   tpn-client --ctl status|stats|profiles|ping|disconnect [--json]
+//   tpn-client --ctl connect [PROFILE] [--socket=NAME] [--timeout=MS]
+//   tpn-client --ctl trace start|stop|save PATH
+//
+// Prints the reply fields and exits 0 when the command succeeded.
+class ControlClient {
+public:
+    static bool isRequested(int argc, char *argv[]);
+    static int run(const QStringList &arguments);  // Needs a QCoreApplication
+};
+
+#endif // CONTROLCLIENT_H
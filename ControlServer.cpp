@@ -0,0 +1,188 @@
+#include "ControlServer.h"
+#include "ControlChannel.h"
+#include "ProcessInfo.h"
+#include "Tracer.h"
+#include <QCborArray>
+#include <QLocalServer>
+#include <QLocalSocket>
+
+namespace {
+const int kProbeTimeoutMs = 500;  // For a live server on the name; local connects are immediate
+}
+
+ControlServer::ControlServer(WireGuardManager *manager, QObject *parent)
+    : QObject(parent)
+    , m_manager(manager)
+    , m_server(new QLocalServer(this))
+{
+    m_server->setSocketOptions(QLocalServer::UserAccessOption);
+    connect(m_server, &QLocalServer::newConnection, this, &ControlServer::onNewConnection);
+    connect(m_manager, &WireGuardManager::importFinished, this, &ControlServer::onImportFinished);
+    connect(m_manager, &WireGuardManager::tunnelCommandFinished, this, &ControlServer::onCommandFinished);
+    connect(m_manager, &WireGuardManager::statsUpdated, this, &ControlServer::onStatsUpdated);
+}
+
+bool ControlServer::listen(const QString &name, QString *error) {
+    // A previous instance that crashed leaves its socket file behind, but
+    // one that still answers is alive and keeps its name
+    QLocalSocket probe;
+    probe.connectToServer(name);
+    if (probe.waitForConnected(kProbeTimeoutMs)) {
+        probe.abort();
+        *error = "Another instance is already serving it.";
+        return false;
+    }
+    QLocalServer::removeServer(name);
+    if (m_server->listen(name)) return true;
+    *error = m_server->errorString();
+    return false;
+}
+
+QString ControlServer::serverName() const {
+    return m_server->fullServerName();
+}
+
+void ControlServer::onNewConnection() {
+    while (QLocalSocket *socket = m_server->nextPendingConnection()) {
+        ControlChannel *channel = new ControlChannel(socket, this);
+        connect(channel, &ControlChannel::messageReceived, this, &ControlServer::onMessage);
+        connect(channel, &ControlChannel::disconnected, channel, &QObject::deleteLater);
+    }
+}
+
+void ControlServer::reply(ControlChannel *channel, qint64 id, bool ok, QCborMap fields, const QString &error) {
+    if (!channel) return;
+    fields.insert(QLatin1String("id"), id);
+    fields.insert(QLatin1String("ok"), ok);
+    if (!error.isEmpty()) fields.insert(QLatin1String("error"), error);
+    channel->send(fields);
+}
+
+void ControlServer::onMessage(const QCborMap &message) {
+    ControlChannel *channel = qobject_cast<ControlChannel *>(sender());
+    const qint64 id = message.value(QLatin1String("id")).toInteger();
+    const QString command = message.value(QLatin1String("cmd")).toString();
+    const QCborArray args = message.value(QLatin1String("args")).toArray();
+
+    if (command == "ping") {
+        reply(channel, id, true);
+    } else if (command == "status") {
+        const ConnectionSnapshot connection = m_manager->connection()->snapshot();
+        QCborMap fields;
+        fields.insert(QLatin1String("status"), ConnectionSnapshot::stateName(connection.state));
+        fields.insert(QLatin1String("since_ms"), connection.sinceMs);
+        fields.insert(QLatin1String("profile"), connection.profile);
+        fields.insert(QLatin1String("endpoint"), connection.endpoint);
+        if (!connection.lastError.isEmpty()) fields.insert(QLatin1String("last_error"), connection.lastError);
+        fields.insert(QLatin1String("uptime_ms"), ProcessInfo::sinceStartMs());
+        fields.insert(QLatin1String("rss_kb"), ProcessInfo::residentKb());
+        reply(channel, id, true, fields);
+    } else if (command == "stats") {
+        QCborMap fields;
+        fields.insert(QLatin1String("rx_bytes"), qint64(m_stats.rxBytes));
+        fields.insert(QLatin1String("tx_bytes"), qint64(m_stats.txBytes));
+        fields.insert(QLatin1String("rx_rate"), m_stats.rxRate);
+        fields.insert(QLatin1String("tx_rate"), m_stats.txRate);
+        fields.insert(QLatin1String("last_handshake_ms"), m_stats.lastHandshakeMs);
+        fields.insert(QLatin1String("peers"), m_stats.peers);
+        reply(channel, id, true, fields);
+    } else if (command == "profiles") {
+        QCborArray names;
+        ProfileStore *store = m_manager->profileStore();
+        for (int i = 0; i < store->count(); ++i) names.append(store->profile(i).name);
+        QCborMap fields;
+        fields.insert(QLatin1String("profiles"), names);
+        reply(channel, id, true, fields);
+    } else if (command == "connect") {
+        connectTunnel(channel, id, args.at(0).toString());
+    } else if (command == "disconnect") {
+        if (m_manager->tunnelState() != TunnelWorker::Up) {
+            reply(channel, id, true);
+            return;
+        }
+        m_pending.append({ channel, id, TunnelWorker::Stop, false });
+        m_manager->stopTunnel();
+    } else if (command == "trace") {
+        const QString action = args.at(0).toString();
+        QString error;
+        if (action == "start" || action == "stop") {
+            Tracer::instance().setEnabled(action == "start");
+        } else if (action == "save" && !args.at(1).toString().isEmpty()) {
+            Tracer::instance().setEnabled(false);
+            Tracer::instance().save(args.at(1).toString(), &error);
+        } else {
+            error = "Usage: trace start|stop|save PATH";
+        }
+        QCborMap fields;
+        fields.insert(QLatin1String("recording"), Tracer::isEnabled());
+        fields.insert(QLatin1String("spans"), Tracer::instance().spanCount());
+        fields.insert(QLatin1String("dropped"), qint64(Tracer::instance().dropped()));
+        reply(channel, id, error.isEmpty(), fields, error);
+    } else {
+        reply(channel, id, false, QCborMap(), QString("Unknown command '%1'.").arg(command));
+    }
+}
+
+void ControlServer::connectTunnel(ControlChannel *channel, qint64 id, const QString &profile) {
+    if (!profile.isEmpty() && profile != m_manager->tunnelName()) {
+        if (!m_manager->loadProfile(profile)) {
+            reply(channel, id, false, QCborMap(), QString("Unknown profile '%1'.").arg(profile));
+            return;
+        }
+        m_pending.append({ channel, id, TunnelWorker::Start, true });
+        return;
+    }
+    if (m_manager->tunnelName().isEmpty()) {
+        reply(channel, id, false, QCborMap(), "No profile loaded.");
+        return;
+    }
+    if (m_manager->tunnelState() == TunnelWorker::Up) {
+        reply(channel, id, true);
+        return;
+    }
+    m_pending.append({ channel, id, TunnelWorker::Start, false });
+    m_manager->startTunnel();
+}
+
+void ControlServer::onImportFinished(const QString &tunnelName, bool ok, const QString &error) {
+    Q_UNUSED(tunnelName);
+    bool start = false;
+    for (int i = 0; i < m_pending.size();) {
+        Pending &pending = m_pending[i];
+        if (!pending.loading) {
+            ++i;
+            continue;
+        }
+        if (!ok) {
+            reply(pending.channel, pending.id, false, QCborMap(), error);
+            m_pending.removeAt(i);
+            continue;
+        }
+        pending.loading = false;
+        start = true;
+        ++i;
+    }
+    if (start) m_manager->startTunnel();
+}
+
+void ControlServer::onCommandFinished(TunnelWorker::Command command, bool ok) {
+    if (command != TunnelWorker::Start && command != TunnelWorker::Stop) return;
+    for (int i = 0; i < m_pending.size();) {
+        const Pending &pending = m_pending[i];
+        if (pending.loading) {
+            ++i;
+            continue;
+        }
+        if (pending.command == command) {
+            reply(pending.channel, pending.id, ok, QCborMap(),
+                  ok ? QString() : QString("Driver command failed, see the log."));
+        } else {
+            reply(pending.channel, pending.id, false, QCborMap(), "superseded");
+        }
+        m_pending.removeAt(i);
+    }
+}
+
+void ControlServer::onStatsUpdated(const TrafficStats &stats) {
+    m_stats = stats;
+}
@@ -0,0 +1,53 @@
+#ifndef CONTROLSERVER_H
+#define CONTROLSERVER_H
+
+#include <QObject>
+#include <QPointer>
+#include <QVector>
+#include <QCborMap>
+#include "WireGuardManager.h"
+
+class QLocalServer;
+class ControlChannel;
+
+// Serves the control protocol (see ControlChannel) for a WireGuardManager:
+//   ping, status, stats, profiles, connect [profile], disconnect,
+//   trace start|stop|save PATH
+// Arguments arrive as the "args" array.
+// connect and disconnect reply once the worker has finished the command; a
+// request the queue coalesced away (disconnect then connect) is answered
+// with "superseded". The socket is only reachable by the current user.
+class ControlServer : public QObject {
+    Q_OBJECT
+public:
+    explicit ControlServer(WireGuardManager *manager, QObject *parent = nullptr);
+
+    bool listen(const QString &name, QString *error);  // Fails if a live server already has the name
+    QString serverName() const;
+
+private slots:
+    void onNewConnection();
+    void onMessage(const QCborMap &message);
+    void onImportFinished(const QString &tunnelName, bool ok, const QString &error);
+    void onCommandFinished(TunnelWorker::Command command, bool ok);
+    void onStatsUpdated(const TrafficStats &stats);
+
+private:
+    struct Pending {
+        QPointer<ControlChannel> channel;
+        qint64 id;
+        TunnelWorker::Command command;  // Start or Stop
+        bool loading;                   // Waiting for the profile before starting
+    };
+
+    WireGuardManager *m_manager;
+    QLocalServer *m_server;
+    QVector<Pending> m_pending;
+    TrafficStats m_stats;
+
+    void reply(ControlChannel *channel, qint64 id, bool ok, QCborMap fields = QCborMap(),
+               const QString &error = QString());
+    void connectTunnel(ControlChannel *channel, qint64 id, const QString &profile);
+};
+
+#endif // CONTROLSERVER_H
@@ -0,0 +1,303 @@
+#include "DnsForwarder.h"
+#include "DnsMessage.h"
+#include "Statistics.h"
+#include <QNetworkDatagram>
+#include <QRandomGenerator>
+#include <QtEndian>
+
+namespace {
+
+const int kLatencySamples = 1024;
+const int kSweepMs = 250;
+const int kServFail = 2;
+const int kNxDomain = 3;
+
+QByteArray cacheKey(const DnsMessage &message) {
+    QByteArray key(2, '\0');
+    qToBigEndian<quint16>(message.questionType, key.data());
+    return key + message.question;
+}
+
+double percentileUs(const RingBuffer<qint64> &samples, double p) {
+    QVector<qint64> values(samples.size());
+    for (int i = 0; i < samples.size(); ++i) values[i] = samples.at(i);
+    return unsortedPercentile(values, p) / 1000.0;
+}
+
+} // namespace
+
+QVariantMap DnsForwarder::Stats::toVariantMap() const {
+    QVariantMap map;
+    map["queries"] = queries;
+    map["hits"] = hits;
+    map["negative_hits"] = negativeHits;
+    map["hit_rate"] = hitRate();
+    map["collapsed"] = collapsed;
+    map["upstream_queries"] = upstreamQueries;
+    map["prefetches"] = prefetches;
+    map["failures"] = failures;
+    map["hit_p50_us"] = hitP50Us;
+    map["hit_p99_us"] = hitP99Us;
+    map["miss_p50_us"] = missP50Us;
+    map["miss_p99_us"] = missP99Us;
+    map["entries"] = entries;
+    return map;
+}
+
+DnsForwarder::DnsForwarder(QObject *parent)
+    : QObject(parent)
+    , m_socket(this)
+    , m_upstream(this)
+    , m_sweep(this)
+    , m_retry(this)
+    , m_hitLatency(kLatencySamples)
+    , m_missLatency(kLatencySamples)
+{
+    m_clock.start();
+    m_sweep.setInterval(kSweepMs);
+    connect(&m_socket, &QUdpSocket::readyRead, this, &DnsForwarder::onQuery);
+    connect(&m_upstream, &QUdpSocket::readyRead, this, &DnsForwarder::onUpstreamReply);
+    connect(&m_sweep, &QTimer::timeout, this, &DnsForwarder::sweep);
+    connect(&m_retry, &QTimer::timeout, this, &DnsForwarder::retry);
+}
+
+bool DnsForwarder::listen(const QHostAddress &address, quint16 port) {
+    close();
+    if (!address.isLoopback()) {
+        m_error = "The DNS forwarder only listens on loopback.";
+        return false;
+    }
+    if (!m_socket.bind(address, port)) {
+        m_error = m_socket.errorString();
+        return false;
+    }
+    if (!m_upstream.bind(QHostAddress::Any, 0)) {
+        m_error = m_upstream.errorString();
+        m_socket.close();
+        return false;
+    }
+    m_error.clear();
+    return true;
+}
+
+void DnsForwarder::close() {
+    m_socket.close();
+    m_upstream.close();
+    m_pending.clear();
+    m_pendingIds.clear();
+    m_retry.stop();
+    clearCache();
+}
+
+void DnsForwarder::setUpstreams(const QVector<QHostAddress> &servers, quint16 port) {
+    // Answers from the previous servers are no longer trusted
+    if (servers != m_servers || port != m_serverPort) clearCache();
+    m_servers = servers;
+    m_serverPort = port;
+}
+
+void DnsForwarder::clearCache() {
+    m_cache.clear();
+    m_expiry = decltype(m_expiry)();
+    m_popular.clear();
+    m_sweep.stop();
+}
+
+DnsForwarder::Stats DnsForwarder::stats() const {
+    Stats stats = m_stats;
+    stats.hitP50Us = percentileUs(m_hitLatency, 50);
+    stats.hitP99Us = percentileUs(m_hitLatency, 99);
+    stats.missP50Us = percentileUs(m_missLatency, 50);
+    stats.missP99Us = percentileUs(m_missLatency, 99);
+    stats.entries = m_cache.size();
+    return stats;
+}
+
+void DnsForwarder::resetStats() {
+    m_stats = Stats();
+    m_hitLatency.clear();
+    m_missLatency.clear();
+}
+
+void DnsForwarder::onQuery() {
+    while (m_socket.hasPendingDatagrams()) {
+        const QNetworkDatagram datagram = m_socket.receiveDatagram();
+        const qint64 receivedNs = m_clock.nsecsElapsed();
+        DnsMessage message;
+        if (!datagram.senderAddress().isLoopback()) continue;
+        if (!DnsMessage::parse(datagram.data(), &message) || message.response || message.question.isEmpty()) continue;
+        m_stats.queries++;
+        const Waiter waiter{ datagram.senderAddress(), quint16(datagram.senderPort()), message.id, receivedNs };
+        const QByteArray key = cacheKey(message);
+
+        const qint64 now = m_clock.elapsed();
+        auto it = m_cache.find(key);
+        if (it != m_cache.end() && it->expiresAt > now) {
+            QByteArray packet = it->packet;
+            DnsMessage::ageTtls(&packet, quint32((now - it->storedAt) / 1000));
+            m_stats.hits++;
+            if (it->negative) m_stats.negativeHits++;
+            if (m_prefetchHits > 0 && ++it->hits >= m_prefetchHits) {
+                m_popular.insert(key);
+                if (now >= it->prefetchAt) forward(key, it->query, nullptr);
+            }
+            reply(waiter, packet);
+            m_hitLatency.push(m_clock.nsecsElapsed() - receivedNs);
+            continue;
+        }
+        forward(key, datagram.data(), &waiter);
+    }
+}
+
+void DnsForwarder::forward(const QByteArray &key, const QByteArray &query, const Waiter *waiter) {
+    auto it = m_pending.find(key);
+    if (it != m_pending.end()) {
+        if (!waiter) return;  // Already being refreshed
+        it->waiters.append(*waiter);
+        m_stats.collapsed++;
+        return;
+    }
+    if (m_servers.isEmpty() || !isListening()) {
+        if (!waiter) return;
+        m_stats.failures++;
+        reply(*waiter, DnsMessage::reply(query, kServFail));
+        m_missLatency.push(m_clock.nsecsElapsed() - waiter->receivedNs);
+        return;
+    }
+
+    // A fresh random id per upstream request; the question is checked too
+    Pending pending;
+    do {
+        pending.id = quint16(QRandomGenerator::global()->bounded(1, 65536));
+    } while (m_pendingIds.contains(pending.id));
+    pending.query = query;
+    DnsMessage::setId(&pending.query, pending.id);
+    if (waiter) pending.waiters.append(*waiter);
+    else m_stats.prefetches++;
+    send(&pending);
+    m_pendingIds.insert(pending.id, key);
+    m_pending.insert(key, pending);
+    if (!m_retry.isActive()) m_retry.start(qMax(25, m_timeoutMs / 4));
+}
+
+void DnsForwarder::send(Pending *pending) {
+    const QHostAddress &server = m_servers[pending->attempts % m_servers.size()];
+    pending->attempts++;
+    pending->sentAt = m_clock.elapsed();
+    m_stats.upstreamQueries++;
+    m_upstream.writeDatagram(pending->query, server, m_serverPort);
+}
+
+bool DnsForwarder::fromUpstream(const QHostAddress &address, quint16 port) const {
+    if (port != m_serverPort) return false;
+    for (const QHostAddress &server : m_servers) {
+        if (server.isEqual(address, QHostAddress::TolerantConversion)) return true;
+    }
+    return false;
+}
+
+void DnsForwarder::onUpstreamReply() {
+    while (m_upstream.hasPendingDatagrams()) {
+        const QNetworkDatagram datagram = m_upstream.receiveDatagram();
+        if (!fromUpstream(datagram.senderAddress(), quint16(datagram.senderPort()))) continue;
+        DnsMessage message;
+        if (!DnsMessage::parse(datagram.data(), &message) || !message.response) continue;
+        const QByteArray key = m_pendingIds.value(message.id);
+        if (key.isEmpty() || key != cacheKey(message)) continue;  // Late, or not what was asked
+
+        const QByteArray packet = datagram.data();
+        emit responseObserved(packet);
+        const bool truncated = packet.size() > 2 && (quint8(packet[2]) & 0x02);
+        const bool negative = message.rcode == kNxDomain || (message.rcode == 0 && message.answers.isEmpty());
+        quint32 ttl = 0;
+        if (!truncated && (message.rcode == 0 || message.rcode == kNxDomain)) {
+            if (!DnsMessage::cacheTtl(packet, &ttl)) ttl = negative ? quint32(m_negativeTtl) : 0;
+            store(key, m_pending.value(key).query, packet, negative, qMin(ttl, quint32(m_maxTtl)));
+        }
+        finish(key, packet);
+    }
+}
+
+void DnsForwarder::store(const QByteArray &key, const QByteArray &query, const QByteArray &packet,
+                         bool negative, quint32 ttl) {
+    if (ttl == 0) return;
+    const qint64 now = m_clock.elapsed();
+    const qint64 lifetimeMs = qint64(ttl) * 1000;
+
+    // Full: the entries closest to expiry go first. This runs before the new
+    // record is pushed so it can never be the one popped; stale records
+    // (entries since refreshed or removed) are discarded on the way
+    if (!m_cache.contains(key)) {
+        while (m_cache.size() >= m_maxEntries && !m_expiry.empty()) {
+            const Expiry top = m_expiry.top();
+            m_expiry.pop();
+            auto it = m_cache.find(top.second);
+            if (it == m_cache.end() || it->expiresAt != top.first) continue;
+            m_popular.remove(top.second);
+            m_cache.erase(it);
+        }
+    }
+
+    Entry &entry = m_cache[key];
+    // Popularity has to be earned again every lifetime, so a name nobody
+    // asks for any more stops being prefetched
+    entry.hits /= 2;
+    if (entry.hits < m_prefetchHits) m_popular.remove(key);
+    entry.query = query;
+    entry.packet = packet;
+    entry.storedAt = now;
+    entry.expiresAt = now + lifetimeMs;
+    entry.prefetchAt = entry.expiresAt - qMin(qMax<qint64>(lifetimeMs / 10, 1000), lifetimeMs / 2);
+    entry.negative = negative;
+    m_expiry.push({ entry.expiresAt, key });
+    if (!m_sweep.isActive()) m_sweep.start();
+}
+
+void DnsForwarder::finish(const QByteArray &key, const QByteArray &packet) {
+    const Pending pending = m_pending.take(key);
+    m_pendingIds.remove(pending.id);
+    for (const Waiter &waiter : pending.waiters) {
+        reply(waiter, packet);
+        m_missLatency.push(m_clock.nsecsElapsed() - waiter.receivedNs);
+    }
+    if (m_pending.isEmpty()) m_retry.stop();
+}
+
+void DnsForwarder::reply(const Waiter &waiter, QByteArray packet) {
+    if (packet.isEmpty()) return;
+    DnsMessage::setId(&packet, waiter.id);
+    m_socket.writeDatagram(packet, waiter.address, waiter.port);
+}
+
+void DnsForwarder::retry() {
+    const qint64 now = m_clock.elapsed();
+    QList<QByteArray> failed;
+    for (auto it = m_pending.begin(); it != m_pending.end(); ++it) {
+        if (now - it->sentAt < m_timeoutMs) continue;
+        if (it->attempts < 2 * m_servers.size()) send(&*it);
+        else failed.append(it.key());
+    }
+    for (const QByteArray &key : qAsConst(failed)) {
+        const QByteArray query = m_pending.value(key).query;
+        m_stats.failures += m_pending.value(key).waiters.size();
+        finish(key, DnsMessage::reply(query, kServFail));
+    }
+}
+
+void DnsForwarder::sweep() {
+    const qint64 now = m_clock.elapsed();
+    while (!m_expiry.empty() && m_expiry.top().first <= now) {
+        const Expiry top = m_expiry.top();
+        m_expiry.pop();
+        auto it = m_cache.find(top.second);
+        if (it == m_cache.end() || it->expiresAt != top.first) continue;  // Refreshed since
+        m_popular.remove(top.second);
+        m_cache.erase(it);
+    }
+    // Popular names are refreshed before they expire even if nobody asks
+    for (const QByteArray &key : qAsConst(m_popular)) {
+        auto entry = m_cache.constFind(key);
+        if (entry != m_cache.constEnd() && now >= entry->prefetchAt) forward(key, entry->query, nullptr);
+    }
+    if (m_cache.isEmpty()) m_sweep.stop();
+}
@@ -0,0 +1,133 @@
+#ifndef DNSFORWARDER_H
+#define DNSFORWARDER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QHostAddress>
+#include <QSet>
+#include <QTimer>
+#include <QUdpSocket>
+#include <QVariantMap>
+#include <QVector>
+#include <queue>
+#include <vector>
+#include "RingBuffer.h"
+
+// Stub resolver for the system while a tunnel is up. It listens on
+// loopback and forwards only to the tunnel's DNS servers, so lookups never
+// leave through the physical interface. Answers are cached as raw packets
+// for their TTL (NXDOMAIN/NODATA for the SOA's negative TTL, RFC 2308) and
+// served with aged TTLs. Identical queries in flight share one upstream
+// request, and names asked for often are fetched again during the last
+// tenth of their lifetime, so they never go cold. Runs on the owner's
+// event loop; nothing in it blocks.
+class DnsForwarder : public QObject {
+    Q_OBJECT
+public:
+    struct Stats {
+        quint64 queries = 0;          // From clients
+        quint64 hits = 0;             // Answered from the cache, negative ones included
+        quint64 negativeHits = 0;
+        quint64 collapsed = 0;        // Joined an upstream request already in flight
+        quint64 upstreamQueries = 0;  // Retries and prefetches included
+        quint64 prefetches = 0;
+        quint64 failures = 0;         // Answered SERVFAIL: no server, or none replied
+        double hitP50Us = 0;          // Query in to answer out
+        double hitP99Us = 0;
+        double missP50Us = 0;
+        double missP99Us = 0;
+        int entries = 0;
+
+        double hitRate() const { return queries ? double(hits) / queries : 0.0; }
+        QVariantMap toVariantMap() const;
+    };
+
+    explicit DnsForwarder(QObject *parent = nullptr);
+
+    bool listen(const QHostAddress &address = QHostAddress::LocalHost, quint16 port = 53);  // Loopback only
+    void close();  // Also drops the cache and anything in flight
+    bool isListening() const { return m_socket.state() == QAbstractSocket::BoundState; }
+    quint16 port() const { return m_socket.localPort(); }
+    QString errorString() const { return m_error; }
+
+    // Nothing is ever sent anywhere else; without servers every miss fails
+    void setUpstreams(const QVector<QHostAddress> &servers, quint16 port = 53);
+    QVector<QHostAddress> upstreams() const { return m_servers; }
+    void setTimeoutMs(int ms) { m_timeoutMs = qMax(50, ms); }  // Per attempt, each server is tried twice
+    void setMaxEntries(int entries) { m_maxEntries = qMax(1, entries); }
+    void setNegativeTtl(int seconds) { m_negativeTtl = seconds; }  // Negative answers without an SOA
+    void setMaxTtl(int seconds) { m_maxTtl = seconds; }
+    void setPrefetchHits(int hits) { m_prefetchHits = hits; }  // Hits per lifetime that make a name popular, 0 = off
+    void clearCache();
+
+    Stats stats() const;
+    void resetStats();
+
+signals:
+    void responseObserved(const QByteArray &packet);  // Every upstream answer, e.g. for DomainPolicy
+
+private slots:
+    void onQuery();
+    void onUpstreamReply();
+    void sweep();
+    void retry();
+
+private:
+    struct Entry {
+        QByteArray query;     // What filled it, reused for prefetching
+        QByteArray packet;    // Response with TTLs as of storedAt
+        qint64 storedAt = 0;  // Clock ms
+        qint64 expiresAt = 0;
+        qint64 prefetchAt = 0;
+        bool negative = false;
+        int hits = 0;
+    };
+    struct Waiter {
+        QHostAddress address;
+        quint16 port;
+        quint16 id;
+        qint64 receivedNs;
+    };
+    struct Pending {
+        QByteArray query;  // Client packet carrying the upstream id
+        quint16 id = 0;
+        int attempts = 0;
+        qint64 sentAt = 0;
+        QVector<Waiter> waiters;  // Empty for a prefetch
+    };
+    using Expiry = std::pair<qint64, QByteArray>;
+
+    QUdpSocket m_socket;    // Clients, on loopback
+    QUdpSocket m_upstream;
+    QString m_error;
+    QVector<QHostAddress> m_servers;
+    quint16 m_serverPort = 53;
+    int m_timeoutMs = 1500;
+    int m_maxEntries = 10000;
+    int m_negativeTtl = 60;
+    int m_maxTtl = 86400;
+    int m_prefetchHits = 3;
+
+    QHash<QByteArray, Entry> m_cache;  // By type + name
+    std::priority_queue<Expiry, std::vector<Expiry>, std::greater<Expiry>> m_expiry;  // Lazy: stale items skipped
+    QSet<QByteArray> m_popular;        // Entries past the prefetch threshold
+    QHash<QByteArray, Pending> m_pending;
+    QHash<quint16, QByteArray> m_pendingIds;
+    QTimer m_sweep;
+    QTimer m_retry;
+    QElapsedTimer m_clock;
+
+    Stats m_stats;
+    RingBuffer<qint64> m_hitLatency;   // Ns
+    RingBuffer<qint64> m_missLatency;
+
+    void forward(const QByteArray &key, const QByteArray &query, const Waiter *waiter);
+    void send(Pending *pending);
+    void finish(const QByteArray &key, const QByteArray &packet);
+    void store(const QByteArray &key, const QByteArray &query, const QByteArray &packet, bool negative, quint32 ttl);
+    void reply(const Waiter &waiter, QByteArray packet);
+    bool fromUpstream(const QHostAddress &address, quint16 port) const;
+};
+
+#endif // DNSFORWARDER_H
@@ -0,0 +1,195 @@
+#include "DnsMessage.h"
+#include <QtEndian>
+
+namespace {
+
+const int kHeaderSize = 12;
+
+quint16 read16(const uchar *p) { return qFromBigEndian<quint16>(p); }
+quint32 read32(const uchar *p) { return qFromBigEndian<quint32>(p); }
+
+// Decodes a possibly compressed name starting at *offset and advances
+// *offset past it in the original position
+bool readName(const uchar *data, int size, int *offset, QByteArray *out) {
+    out->clear();
+    int pos = *offset;
+    int jumps = 0;
+    bool jumped = false;
+    for (;;) {
+        if (pos >= size) return false;
+        const int length = data[pos];
+        if ((length & 0xC0) == 0xC0) {
+            if (pos + 1 >= size || ++jumps > 16) return false;
+            const int target = ((length & 0x3F) << 8) | data[pos + 1];
+            if (!jumped) *offset = pos + 2;
+            jumped = true;
+            if (target >= pos) return false;  // Pointers only go backwards
+            pos = target;
+            continue;
+        }
+        if (length & 0xC0) return false;
+        ++pos;
+        if (length == 0) break;
+        if (pos + length > size || out->size() + length + 1 > 255) return false;
+        if (!out->isEmpty()) out->append('.');
+        for (int i = 0; i < length; ++i) {
+            char c = char(data[pos + i]);
+            if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+            out->append(c);
+        }
+        pos += length;
+    }
+    if (!jumped) *offset = pos;
+    return true;
+}
+
+// Offset just past the question section, -1 if malformed
+int questionEnd(const uchar *data, int size) {
+    if (size < kHeaderSize) return -1;
+    const int questions = read16(data + 4);
+    int offset = kHeaderSize;
+    QByteArray name;
+    for (int i = 0; i < questions; ++i) {
+        if (!readName(data, size, &offset, &name) || offset + 4 > size) return -1;
+        offset += 4;
+    }
+    return offset;
+}
+
+// Calls visit(type, ttlOffset, rdataOffset, rdataLength, inAnswers) for
+// every answer, authority and additional record
+template <typename Visit>
+bool forEachRecord(const uchar *data, int size, Visit visit) {
+    int offset = questionEnd(data, size);
+    if (offset < 0) return false;
+    const int answers = read16(data + 6);
+    const int records = answers + read16(data + 8) + read16(data + 10);
+    QByteArray name;
+    for (int i = 0; i < records; ++i) {
+        if (!readName(data, size, &offset, &name) || offset + 10 > size) return false;
+        const int length = read16(data + offset + 8);
+        if (offset + 10 + length > size) return false;
+        visit(read16(data + offset), offset + 4, offset + 10, length, i < answers);
+        offset += 10 + length;
+    }
+    return true;
+}
+
+} // namespace
+
+bool DnsMessage::parse(const char *bytes, int size, DnsMessage *out) {
+    const uchar *data = reinterpret_cast<const uchar *>(bytes);
+    if (size < kHeaderSize) return false;
+    *out = DnsMessage();
+    out->id = read16(data);
+    const quint16 flags = read16(data + 2);
+    out->response = flags & 0x8000;
+    out->rcode = flags & 0xF;
+    const int questions = read16(data + 4);
+    const int answers = read16(data + 6);
+
+    int offset = kHeaderSize;
+    for (int i = 0; i < questions; ++i) {
+        QByteArray name;
+        if (!readName(data, size, &offset, &name) || offset + 4 > size) return false;
+        if (i == 0) {
+            out->question = name;
+            out->questionType = read16(data + offset);
+        }
+        offset += 4;
+    }
+
+    out->answers.reserve(answers);
+    for (int i = 0; i < answers; ++i) {
+        DnsRecord record;
+        if (!readName(data, size, &offset, &record.name) || offset + 10 > size) return false;
+        record.type = read16(data + offset);
+        record.ttl = read32(data + offset + 4);
+        const int length = read16(data + offset + 8);
+        offset += 10;
+        if (offset + length > size) return false;
+
+        if (record.type == DnsRecord::A && length == 4) {
+            record.address = QHostAddress(read32(data + offset));
+        } else if (record.type == DnsRecord::AAAA && length == 16) {
+            record.address = QHostAddress(data + offset);
+        } else if (record.type == DnsRecord::CNAME) {
+            int target = offset;
+            if (!readName(data, size, &target, &record.target)) return false;
+        }
+        offset += length;
+        out->answers.append(record);
+    }
+    return true;
+}
+
+QByteArray DnsMessage::query(quint16 id, const QByteArray &name, quint16 type) {
+    QByteArray packet(kHeaderSize, '\0');
+    uchar *header = reinterpret_cast<uchar *>(packet.data());
+    qToBigEndian<quint16>(id, header);
+    qToBigEndian<quint16>(0x0100, header + 2);  // RD
+    qToBigEndian<quint16>(1, header + 4);
+
+    for (const QByteArray &label : name.split('.')) {
+        if (label.isEmpty() || label.size() > 63) continue;
+        packet.append(char(label.size()));
+        packet.append(label);
+    }
+    packet.append('\0');
+    uchar tail[4];
+    qToBigEndian<quint16>(type, tail);
+    qToBigEndian<quint16>(1, tail + 2);  // IN
+    packet.append(reinterpret_cast<const char *>(tail), 4);
+    return packet;
+}
+
+bool DnsMessage::cacheTtl(const QByteArray &packet, quint32 *ttl) {
+    const uchar *data = reinterpret_cast<const uchar *>(packet.constData());
+    const int size = packet.size();
+    quint32 answerTtl = 0xFFFFFFFFu;
+    quint32 negativeTtl = 0xFFFFFFFFu;
+    bool answered = false;
+    bool hasSoa = false;
+    const bool walked = forEachRecord(data, size, [&](quint16 type, int ttlAt, int rdataAt, int length, bool inAnswers) {
+        const quint32 recordTtl = read32(data + ttlAt);
+        if (inAnswers) {
+            answerTtl = qMin(answerTtl, recordTtl);
+            answered = true;
+        } else if (type == DnsRecord::SOA && length >= 22) {
+            // The SOA MINIMUM field (its last four bytes) caps the negative TTL
+            negativeTtl = qMin(negativeTtl, qMin(recordTtl, read32(data + rdataAt + length - 4)));
+            hasSoa = true;
+        }
+    });
+    if (!walked) return false;
+    const int rcode = data[3] & 0xF;
+    if (rcode == 0 && answered) *ttl = answerTtl;
+    else if ((rcode == 0 || rcode == 3) && hasSoa) *ttl = negativeTtl;
+    else return false;
+    return true;
+}
+
+bool DnsMessage::ageTtls(QByteArray *packet, quint32 seconds) {
+    uchar *data = reinterpret_cast<uchar *>(packet->data());
+    return forEachRecord(data, packet->size(), [data, seconds](quint16 type, int ttlAt, int, int, bool) {
+        if (type == DnsRecord::OPT) return;  // Its TTL field carries EDNS flags
+        const quint32 ttl = read32(data + ttlAt);
+        qToBigEndian<quint32>(ttl > seconds ? ttl - seconds : 0, data + ttlAt);
+    });
+}
+
+void DnsMessage::setId(QByteArray *packet, quint16 id) {
+    if (packet->size() >= 2) qToBigEndian<quint16>(id, packet->data());
+}
+
+QByteArray DnsMessage::reply(const QByteArray &query, int rcode) {
+    const uchar *data = reinterpret_cast<const uchar *>(query.constData());
+    const int end = questionEnd(data, query.size());
+    if (end < 0) return QByteArray();
+    QByteArray packet = query.left(end);
+    uchar *header = reinterpret_cast<uchar *>(packet.data());
+    // Keep the opcode and RD bit, set QR and RA
+    qToBigEndian<quint16>(quint16((read16(header + 2) & 0x7900) | 0x8080 | (rcode & 0xF)), header + 2);
+    memset(header + 6, 0, 6);
+    return packet;
+}
@@ -0,0 +1,44 @@
+#ifndef DNSMESSAGE_H
+#define DNSMESSAGE_H
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <QVector>
+
+struct DnsRecord {
+    enum Type : quint16 { A = 1, CNAME = 5, SOA = 6, AAAA = 28, OPT = 41 };
+
+    QByteArray name;       // Lowercase, no trailing dot
+    quint16 type = 0;
+    quint32 ttl = 0;       // Seconds
+    QHostAddress address;  // A / AAAA
+    QByteArray target;     // CNAME
+};
+
+// Just enough of RFC 1035 wire format for watching answers and sending
+// simple queries: header, first question and the answer section (with
+// name compression). Authority/additional sections are not decoded.
+struct DnsMessage {
+    quint16 id = 0;
+    bool response = false;
+    int rcode = 0;
+    QByteArray question;   // Lowercase, no trailing dot
+    quint16 questionType = 0;
+    QVector<DnsRecord> answers;
+
+    static bool parse(const char *data, int size, DnsMessage *out);
+    static bool parse(const QByteArray &packet, DnsMessage *out) { return parse(packet.constData(), packet.size(), out); }
+    static QByteArray query(quint16 id, const QByteArray &name, quint16 type);  // Recursion desired
+
+    // For caching raw responses. cacheTtl is the smallest answer TTL, or
+    // for NXDOMAIN/NODATA the SOA's negative TTL (RFC 2308); false if the
+    // packet has neither. ageTtls lowers every record's TTL by the time
+    // spent in the cache, leaving OPT pseudo-records alone.
+    static bool cacheTtl(const QByteArray &packet, quint32 *ttl);
+    static bool ageTtls(QByteArray *packet, quint32 seconds);
+    static void setId(QByteArray *packet, quint16 id);
+    // Header and question of `query` turned into an empty answer with `rcode`
+    static QByteArray reply(const QByteArray &query, int rcode);
+};
+
+#endif // DNSMESSAGE_H
@@ -0,0 +1,257 @@
+#include "DomainPolicy.h"
+#include "DnsMessage.h"
+#include <QNetworkDatagram>
+#include <QRandomGenerator>
+
+namespace {
+
+QByteArray routeKey(const IpPrefix &prefix) {
+    QByteArray key(17, '\0');
+    key[0] = char(prefix.family);
+    memcpy(key.data() + 1, prefix.addr, 16);
+    return key;
+}
+
+IpPrefix hostPrefix(const QHostAddress &address) {
+    IpPrefix prefix;
+    if (address.protocol() == QAbstractSocket::IPv6Protocol) {
+        const Q_IPV6ADDR raw = address.toIPv6Address();
+        prefix.family = 6;
+        prefix.cidr = 128;
+        memcpy(prefix.addr, raw.c, 16);
+    } else {
+        const quint32 v4 = address.toIPv4Address();
+        prefix.family = 4;
+        prefix.cidr = 32;
+        prefix.addr[0] = quint8(v4 >> 24);
+        prefix.addr[1] = quint8(v4 >> 16);
+        prefix.addr[2] = quint8(v4 >> 8);
+        prefix.addr[3] = quint8(v4);
+    }
+    return prefix;
+}
+
+} // namespace
+
+DomainPolicy::DomainPolicy(QObject *parent)
+    : QObject(parent)
+    , m_trie(1)
+    , m_batch(this)
+    , m_sweep(this)
+    , m_socket(this)
+    , m_refresh(this)
+{
+    m_clock.start();
+    m_batch.setSingleShot(true);
+    m_batch.setInterval(200);
+    m_sweep.setInterval(1000);
+    connect(&m_batch, &QTimer::timeout, this, &DomainPolicy::flush);
+    connect(&m_sweep, &QTimer::timeout, this, &DomainPolicy::sweep);
+    connect(&m_refresh, &QTimer::timeout, this, &DomainPolicy::sendQueries);
+    connect(&m_socket, &QUdpSocket::readyRead, this, &DomainPolicy::onReadyRead);
+}
+
+void DomainPolicy::setRules(const TunnelConfig &config) {
+    m_trie = QVector<TrieNode>(1);
+    m_ruleCount = 0;
+    m_apexNames.clear();
+    m_routes.clear();
+    m_expiry = decltype(m_expiry)();
+    m_pending.clear();
+    m_batch.stop();
+    m_sweep.stop();
+    for (int i = 0; i < config.peers.size(); ++i) {
+        for (const QByteArray &pattern : config.peers[i].allowedDomains) addRule(pattern, i);
+    }
+}
+
+void DomainPolicy::addRule(QByteArray pattern, int peer) {
+    const bool wildcard = pattern.startsWith("*.");
+    if (wildcard) pattern.remove(0, 2);
+    if (pattern.isEmpty()) return;
+    if (!wildcard) m_apexNames.append(pattern);
+
+    // Insert labels from the TLD down
+    const QList<QByteArray> labels = pattern.split('.');
+    int node = 0;
+    for (int i = labels.size() - 1; i >= 0; --i) {
+        auto it = m_trie[node].children.constFind(labels[i]);
+        if (it == m_trie[node].children.constEnd()) {
+            m_trie.append(TrieNode());
+            const int next = m_trie.size() - 1;
+            m_trie[node].children.insert(labels[i], next);
+            node = next;
+        } else {
+            node = *it;
+        }
+    }
+    m_trie[node].subdomains = peer;
+    if (!wildcard) m_trie[node].self = peer;
+    m_ruleCount++;
+}
+
+int DomainPolicy::match(const QByteArray &name) const {
+    if (!m_ruleCount || name.isEmpty() || name.size() > 255) return -1;
+    char lower[256];
+    int size = name.size();
+    if (name.endsWith('.')) --size;
+    for (int i = 0; i < size; ++i) {
+        char c = name[i];
+        lower[i] = (c >= 'A' && c <= 'Z') ? char(c + 'a' - 'A') : c;
+    }
+
+    // Walk labels right to left; the deepest matching rule wins
+    int node = 0;
+    int peer = -1;
+    int end = size;
+    while (end > 0) {
+        int start = end;
+        while (start > 0 && lower[start - 1] != '.') --start;
+        auto it = m_trie[node].children.constFind(QByteArray::fromRawData(lower + start, end - start));
+        if (it == m_trie[node].children.constEnd()) break;
+        node = *it;
+        const int candidate = start > 0 ? m_trie[node].subdomains : m_trie[node].self;
+        if (candidate >= 0) peer = candidate;
+        end = start - 1;
+    }
+    return peer;
+}
+
+void DomainPolicy::observe(const QByteArray &name, const QHostAddress &address, quint32 ttlSeconds) {
+    const int peer = match(name);
+    if (peer >= 0) addRoute(peer, address, ttlSeconds);
+}
+
+void DomainPolicy::observeResponse(const QByteArray &packet) {
+    DnsMessage message;
+    if (!m_ruleCount || !DnsMessage::parse(packet, &message) || !message.response) return;
+    observeMessage(message);
+}
+
+void DomainPolicy::observeMessage(const DnsMessage &message) {
+    if (message.rcode != 0) return;
+    // Addresses at the end of a CNAME chain (CDNs) belong to the name that
+    // was asked for, unless their own name matches a rule
+    const int questionPeer = match(message.question);
+    for (const DnsRecord &record : qAsConst(message.answers)) {
+        if (record.type != DnsRecord::A && record.type != DnsRecord::AAAA) continue;
+        int peer = match(record.name);
+        if (peer < 0) peer = questionPeer;
+        if (peer >= 0) addRoute(peer, record.address, record.ttl);
+    }
+}
+
+void DomainPolicy::addRoute(int peer, const QHostAddress &address, quint32 ttlSeconds) {
+    if (address.isNull()) return;
+    const IpPrefix prefix = hostPrefix(address);
+    const QByteArray key = routeKey(prefix);
+    const qint64 expiresAt = m_clock.elapsed() + qMax(qint64(ttlSeconds) * 1000, m_minLifetimeMs);
+
+    auto it = m_routes.find(key);
+    if (it != m_routes.end()) {
+        if (expiresAt > it->expiresAt) {
+            it->expiresAt = expiresAt;
+            m_expiry.push({ expiresAt, key });
+        }
+        return;  // First peer to claim an address keeps it
+    }
+    m_routes.insert(key, { peer, prefix, expiresAt });
+    m_expiry.push({ expiresAt, key });
+    queue({ peer, prefix, true }, key);
+    if (!m_sweep.isActive()) m_sweep.start();
+}
+
+void DomainPolicy::sweep() {
+    const qint64 now = m_clock.elapsed();
+    while (!m_expiry.empty() && m_expiry.top().first <= now) {
+        const Expiry top = m_expiry.top();
+        m_expiry.pop();
+        auto it = m_routes.find(top.second);
+        if (it == m_routes.end() || it->expiresAt != top.first) continue;  // Refreshed since
+        queue({ it->peer, it->prefix, false }, top.second);
+        m_routes.erase(it);
+    }
+    if (m_routes.isEmpty()) m_sweep.stop();
+}
+
+void DomainPolicy::queue(const Change &change, const QByteArray &key) {
+    // An add and a removal of the same address within one batch cancel out
+    auto it = m_pending.find(key);
+    if (it != m_pending.end() && it->added != change.added) {
+        m_pending.erase(it);
+        return;
+    }
+    m_pending.insert(key, change);
+    if (!m_batch.isActive()) m_batch.start();
+}
+
+void DomainPolicy::flush() {
+    if (m_pending.isEmpty()) return;
+    QVector<Change> changes;
+    changes.reserve(m_pending.size());
+    for (const Change &change : qAsConst(m_pending)) changes.append(change);
+    m_pending.clear();
+    emit routesChanged(changes);
+}
+
+QVector<IpPrefix> DomainPolicy::routes(int peer) const {
+    QVector<IpPrefix> out;
+    for (const Route &route : m_routes) {
+        if (route.peer == peer) out.append(route.prefix);
+    }
+    return out;
+}
+
+void DomainPolicy::refresh(const QHostAddress &server, quint16 port) {
+    m_server = server;
+    m_serverPort = port;
+    if (m_apexNames.isEmpty()) return;
+    if (m_socket.state() != QAbstractSocket::BoundState) m_socket.bind(QHostAddress::Any, 0);
+    // Re-ask before the minimum lifetime lapses so live routes stay put
+    m_refresh.start(int(qMax<qint64>(10000, m_minLifetimeMs / 2)));
+    sendQueries();
+}
+
+void DomainPolicy::stopRefresh() {
+    m_refresh.stop();
+    m_server = QHostAddress();
+    m_queries.clear();
+}
+
+void DomainPolicy::sendQueries() {
+    if (m_server.isNull()) return;
+    m_queries.clear();  // Anything unanswered by now is lost
+    for (const QByteArray &name : qAsConst(m_apexNames)) {
+        sendQuery(name, DnsRecord::A);
+        sendQuery(name, DnsRecord::AAAA);
+    }
+}
+
+void DomainPolicy::sendQuery(const QByteArray &name, quint16 type) {
+    // Random ids: a sequence would let anyone on the path guess the next one
+    quint16 id;
+    do {
+        id = quint16(QRandomGenerator::global()->bounded(1u << 16));
+    } while (m_queries.contains(id));
+    const QByteArray lowered = name.toLower();
+    m_queries.insert(id, { lowered, type });
+    m_socket.writeDatagram(DnsMessage::query(id, lowered, type), m_server, m_serverPort);
+}
+
+void DomainPolicy::onReadyRead() {
+    while (m_socket.hasPendingDatagrams()) {
+        const QNetworkDatagram datagram = m_socket.receiveDatagram();
+        if (!datagram.senderAddress().isEqual(m_server, QHostAddress::TolerantConversion)
+                || quint16(datagram.senderPort()) != m_serverPort) {
+            continue;
+        }
+        DnsMessage message;
+        if (!DnsMessage::parse(datagram.data(), &message) || !message.response) continue;
+        auto query = m_queries.find(message.id);
+        if (query == m_queries.end() || query->first != message.question || query->second != message.questionType) {
+            continue;
+        }
+        m_queries.erase(query);
+        if (m_ruleCount) observeMessage(message);
+    }
+}
@@ -0,0 +1,108 @@
+#ifndef DOMAINPOLICY_H
+#define DOMAINPOLICY_H
+
+#include <QObject>
+#include <QHash>
+#include <QHostAddress>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QUdpSocket>
+#include <QVector>
+#include <queue>
+#include <vector>
+#include "TunnelConfig.h"
+
+struct DnsMessage;
+
+// "Tunnel only these domains": peers list domain rules (AllowedDomains)
+// and every DNS answer for a matching name adds its addresses as host
+// routes to that peer until the answer's TTL (floored at a minimum
+// lifetime) runs out. Rules are compiled into a label trie walked from the
+// TLD, so matching costs one hash lookup per label regardless of the rule
+// count. Additions and expirations are collected and emitted as one batch
+// per batch delay, for the manager to push as a single incremental update.
+//
+// Answers arrive through observe()/observeResponse(); refresh() also
+// queries the apex rule names directly at the tunnel's DNS server. Its
+// replies count only if they match an outstanding query's random id and
+// question, so other packets from the server's address are dropped.
+class DomainPolicy : public QObject {
+    Q_OBJECT
+public:
+    struct Change {
+        int peer;
+        IpPrefix prefix;
+        bool added;
+    };
+
+    explicit DomainPolicy(QObject *parent = nullptr);
+
+    // Compiles every peer's AllowedDomains and forgets learned routes.
+    // "example.com" covers the name and its subdomains, "*.example.com"
+    // only the subdomains.
+    void setRules(const TunnelConfig &config);
+    bool hasRules() const { return m_ruleCount > 0; }
+    int ruleCount() const { return m_ruleCount; }
+    int match(const QByteArray &name) const;  // Peer index, -1 = not routed
+
+    void observe(const QByteArray &name, const QHostAddress &address, quint32 ttlSeconds);
+    void observeResponse(const QByteArray &packet);  // Raw DNS response
+    void refresh(const QHostAddress &server, quint16 port = 53);  // Starts periodic apex queries
+    void stopRefresh();
+
+    QVector<IpPrefix> routes(int peer) const;
+    int routeCount() const { return m_routes.size(); }
+
+    void setBatchDelayMs(int ms) { m_batch.setInterval(ms); }
+    void setMinLifetime(int seconds) { m_minLifetimeMs = qint64(seconds) * 1000; }
+
+signals:
+    void routesChanged(const QVector<DomainPolicy::Change> &changes);
+
+private slots:
+    void flush();
+    void sweep();
+    void sendQueries();
+    void onReadyRead();
+
+private:
+    struct TrieNode {
+        QHash<QByteArray, int> children;  // Next label towards the leaf
+        int self = -1;                    // Peer for the name itself
+        int subdomains = -1;              // Peer for names below it
+    };
+    struct Route {
+        int peer;
+        IpPrefix prefix;
+        qint64 expiresAt;
+    };
+    using Expiry = std::pair<qint64, QByteArray>;
+
+    QVector<TrieNode> m_trie;  // [0] is the root
+    int m_ruleCount = 0;
+    QList<QByteArray> m_apexNames;  // Rules without a wildcard, queried by refresh()
+
+    QHash<QByteArray, Route> m_routes;  // By family + address bytes
+    std::priority_queue<Expiry, std::vector<Expiry>, std::greater<Expiry>> m_expiry;  // Lazy: stale items skipped
+    QHash<QByteArray, Change> m_pending;
+    QTimer m_batch;
+    QTimer m_sweep;
+    QElapsedTimer m_clock;
+    qint64 m_minLifetimeMs = 300 * 1000;
+
+    QUdpSocket m_socket;
+    QHostAddress m_server;
+    quint16 m_serverPort = 53;
+    QTimer m_refresh;
+    QHash<quint16, std::pair<QByteArray, quint16>> m_queries;  // Outstanding, id -> name and type
+
+    void addRule(QByteArray pattern, int peer);
+    void addRoute(int peer, const QHostAddress &address, quint32 ttlSeconds);
+    void observeMessage(const DnsMessage &message);
+    void sendQuery(const QByteArray &name, quint16 type);
+    void queue(const Change &change, const QByteArray &key);
+};
+
+Q_DECLARE_METATYPE(DomainPolicy::Change)
+
+#endif // DOMAINPOLICY_H
@@ -0,0 +1,195 @@
+#include "DriverConfig.h"
+#include "Tracer.h"
+#include <QScopeGuard>
+#include <QtEndian>
+#include <cstddef>
+#include <cstring>
+
+// Sizes and offsets of wireguard-nt's records (x86 and x64 alike)
+static_assert(sizeof(DriverConfig::Interface) == 80, "WIREGUARD_INTERFACE layout");
+static_assert(sizeof(DriverConfig::SockaddrInet) == 28, "SOCKADDR_INET layout");
+static_assert(offsetof(DriverConfig::Peer, endpoint) == 76, "WIREGUARD_PEER layout");
+static_assert(offsetof(DriverConfig::Peer, txBytes) == 104, "WIREGUARD_PEER layout");
+static_assert(sizeof(DriverConfig::Peer) == 136, "WIREGUARD_PEER layout");
+static_assert(sizeof(DriverConfig::AllowedIp) == 24, "WIREGUARD_ALLOWED_IP layout");
+
+const quint16 DriverConfig::kFamilyIPv4;
+const quint16 DriverConfig::kFamilyIPv6;
+
+namespace {
+
+bool sendsAllowedIPs(int fields) {
+    return fields & (PeerChange::AllowedIPs | PeerChange::AppendAllowedIPs);
+}
+
+int fieldsOf(const PeerChange &change) {
+    return change.kind == PeerChange::Added ? int(PeerChange::AllFields) : change.fields;
+}
+
+qsizetype countAllowed(const PeerConfig &peer) {
+    qsizetype count = 0;
+    for (const IpPrefix &prefix : peer.allowedIPs) count += (prefix.family == 4 || prefix.family == 6);
+    return count;
+}
+
+void writeEndpoint(const IpPrefix &address, quint16 port, DriverConfig::SockaddrInet *out) {
+    qToBigEndian(port, &out->port);
+    if (address.family == 6) {
+        out->family = DriverConfig::kFamilyIPv6;
+        memcpy(out->address, address.addr, 16);
+    } else {
+        out->family = DriverConfig::kFamilyIPv4;
+        memcpy(&out->flowInfo, address.addr, 4);  // sin_addr follows sin_port
+    }
+}
+
+// Writes one peer record and its allowed IPs at `at`, returns the end
+char *writePeer(char *at, const PeerConfig &config, const PeerChange &change) {
+    DriverConfig::Peer *peer = reinterpret_cast<DriverConfig::Peer *>(at);
+    at += sizeof(DriverConfig::Peer);
+    memcpy(peer->publicKey, config.publicKey, 32);
+    peer->flags = DriverConfig::PeerHasPublicKey;
+    if (change.kind == PeerChange::Updated) peer->flags |= DriverConfig::PeerUpdate;  // Only touch an existing peer
+
+    const int fields = fieldsOf(change);
+    if (fields & PeerChange::PresharedKey) {
+        config.presharedKey.copyTo(peer->presharedKey, 32);  // All-zero clears a previously set one
+        peer->flags |= DriverConfig::PeerHasPresharedKey;
+    }
+    if (fields & PeerChange::PersistentKeepalive) {
+        peer->persistentKeepalive = config.persistentKeepalive;
+        peer->flags |= DriverConfig::PeerHasPersistentKeepalive;
+    }
+    if ((fields & PeerChange::Endpoint) && config.endpointAddress.family) {
+        writeEndpoint(config.endpointAddress, config.endpointPort, &peer->endpoint);
+        peer->flags |= DriverConfig::PeerHasEndpoint;
+    }
+    if (sendsAllowedIPs(fields)) {
+        if (fields & PeerChange::AllowedIPs) peer->flags |= DriverConfig::PeerReplaceAllowedIPs;
+        for (const IpPrefix &prefix : config.allowedIPs) {
+            if (prefix.family != 4 && prefix.family != 6) continue;
+            DriverConfig::AllowedIp *allowed = reinterpret_cast<DriverConfig::AllowedIp *>(at);
+            at += sizeof(DriverConfig::AllowedIp);
+            memcpy(allowed->address, prefix.addr, prefix.family == 6 ? 16 : 4);
+            allowed->family = prefix.family == 6 ? DriverConfig::kFamilyIPv6 : DriverConfig::kFamilyIPv4;
+            allowed->cidr = prefix.cidr;
+            ++peer->allowedIPsCount;
+        }
+    }
+    return at;
+}
+
+} // namespace
+
+qsizetype DriverConfig::sizeFor(const TunnelConfig &next, const ConfigDelta &delta) {
+    qsizetype size = sizeof(Interface) + qsizetype(sizeof(Peer)) * delta.peers.size();
+    for (const PeerChange &change : delta.peers) {
+        if (change.kind != PeerChange::Removed && sendsAllowedIPs(fieldsOf(change))) {
+            size += qsizetype(sizeof(AllowedIp)) * countAllowed(next.peers[change.index]);
+        }
+    }
+    return size;
+}
+
+SecretBuffer DriverConfig::build(const TunnelConfig &next, const ConfigDelta &delta,
+                                 const TunnelConfig &applied, bool replacePeers) {
+    TPN_TRACE_SCOPE("DriverConfig::build");
+    const qsizetype size = sizeFor(next, delta);
+    SecretBuffer buffer(int(size));  // Zero-filled: unset fields and padding stay zero
+    char *at = reinterpret_cast<char *>(buffer.data());
+
+    Interface *iface = reinterpret_cast<Interface *>(at);
+    at += sizeof(Interface);
+    if (replacePeers) iface->flags |= InterfaceReplacePeers;
+    if (delta.privateKeyChanged) {
+        next.iface.privateKey.copyTo(iface->privateKey, 32);
+        iface->flags |= InterfaceHasPrivateKey;
+    }
+    if (delta.listenPortChanged) {
+        iface->listenPort = next.iface.listenPort;
+        iface->flags |= InterfaceHasListenPort;
+    }
+    iface->peersCount = quint32(delta.peers.size());
+
+    for (const PeerChange &change : delta.peers) {
+        if (change.kind == PeerChange::Removed) {
+            Peer *peer = reinterpret_cast<Peer *>(at);
+            at += sizeof(Peer);
+            memcpy(peer->publicKey, applied.peers[change.index].publicKey, 32);
+            peer->flags = PeerHasPublicKey | PeerRemove;
+        } else {
+            at = writePeer(at, next.peers[change.index], change);
+        }
+    }
+    Q_ASSERT(at == reinterpret_cast<char *>(buffer.data()) + size);
+    return buffer;
+}
+
+bool DriverConfig::unpack(const char *data, qsizetype size, TunnelConfig *out,
+                          quint32 *interfaceFlags, QVector<quint32> *peerFlags) {
+    *out = TunnelConfig();
+    if (peerFlags) peerFlags->clear();
+    if (size < qsizetype(sizeof(Interface))) return false;
+
+    // Records are copied out rather than cast in place: the buffer need not be aligned
+    Interface iface;
+    memcpy(&iface, data, sizeof(iface));
+    const auto wipeInterface = qScopeGuard([&iface]() { SecretArena::wipe(&iface, sizeof(iface)); });
+    qsizetype pos = sizeof(Interface);
+    if (interfaceFlags) *interfaceFlags = iface.flags;
+    if (iface.flags & InterfaceHasPrivateKey) {
+        out->iface.privateKey = SecretBuffer(32);
+        memcpy(out->iface.privateKey.data(), iface.privateKey, 32);
+    }
+    if (iface.flags & InterfaceHasListenPort) out->iface.listenPort = iface.listenPort;
+
+    for (quint32 i = 0; i < iface.peersCount; ++i) {
+        if (pos + qsizetype(sizeof(Peer)) > size) return false;
+        Peer peer;
+        memcpy(&peer, data + pos, sizeof(peer));
+        const auto wipePeer = qScopeGuard([&peer]() { SecretArena::wipe(&peer, sizeof(peer)); });
+        pos += sizeof(Peer);
+
+        PeerConfig config;
+        memcpy(config.publicKey, peer.publicKey, 32);
+        if (peer.flags & PeerHasPresharedKey) {
+            config.hasPresharedKey = true;
+            config.presharedKey = SecretBuffer(32);
+            memcpy(config.presharedKey.data(), peer.presharedKey, 32);
+        }
+        if (peer.flags & PeerHasPersistentKeepalive) config.persistentKeepalive = peer.persistentKeepalive;
+        if (peer.flags & PeerHasEndpoint) {
+            config.endpointPort = qFromBigEndian(peer.endpoint.port);
+            IpPrefix &endpoint = config.endpointAddress;
+            if (peer.endpoint.family == kFamilyIPv6) {
+                endpoint.family = 6;
+                endpoint.cidr = 128;
+                memcpy(endpoint.addr, peer.endpoint.address, 16);
+            } else if (peer.endpoint.family == kFamilyIPv4) {
+                endpoint.family = 4;
+                endpoint.cidr = 32;
+                memcpy(endpoint.addr, &peer.endpoint.flowInfo, 4);
+            } else {
+                return false;
+            }
+        }
+        if (peerFlags) peerFlags->append(peer.flags);
+
+        if (pos + qsizetype(sizeof(AllowedIp)) * peer.allowedIPsCount > size) return false;
+        config.allowedIPs.reserve(int(peer.allowedIPsCount));
+        for (quint32 j = 0; j < peer.allowedIPsCount; ++j) {
+            AllowedIp allowed;
+            memcpy(&allowed, data + pos, sizeof(allowed));
+            pos += sizeof(AllowedIp);
+            IpPrefix prefix;
+            if (allowed.family == kFamilyIPv4 && allowed.cidr <= 32) prefix.family = 4;
+            else if (allowed.family == kFamilyIPv6 && allowed.cidr <= 128) prefix.family = 6;
+            else return false;
+            prefix.cidr = allowed.cidr;
+            memcpy(prefix.addr, allowed.address, prefix.family == 6 ? 16 : 4);
+            config.allowedIPs.append(prefix);
+        }
+        out->peers.append(config);
+    }
+    return pos == size;
+}
@@ -0,0 +1,82 @@
+#ifndef DRIVERCONFIG_H
+#define DRIVERCONFIG_H
+
+#include <QtGlobal>
+#include <QVector>
+#include "ConfigDiff.h"
+#include "SecretArena.h"
+#include "TunnelConfig.h"
+
+// Builds the buffer WireGuardSetConfiguration() takes: one interface
+// record, then each peer record directly followed by its allowed IPs, all
+// packed back to back. The records mirror wireguard-nt's
+// WIREGUARD_INTERFACE / WIREGUARD_PEER / WIREGUARD_ALLOWED_IP byte for
+// byte, so the layout can be built and checked on any platform. A sizing
+// pass over the delta precedes a single SecretArena allocation that the
+// records are written into in place; there is no cap on peers or
+// prefixes and both families are carried.
+class DriverConfig {
+public:
+    enum InterfaceFlag : quint32 {
+        InterfaceHasPublicKey = 1 << 0,
+        InterfaceHasPrivateKey = 1 << 1,
+        InterfaceHasListenPort = 1 << 2,
+        InterfaceReplacePeers = 1 << 3
+    };
+    enum PeerFlag : quint32 {
+        PeerHasPublicKey = 1 << 0,
+        PeerHasPresharedKey = 1 << 1,
+        PeerHasPersistentKeepalive = 1 << 2,
+        PeerHasEndpoint = 1 << 3,
+        PeerReplaceAllowedIPs = 1 << 5,
+        PeerRemove = 1 << 6,
+        PeerUpdate = 1 << 7
+    };
+    // Windows ADDRESS_FAMILY values, whatever the build platform
+    static const quint16 kFamilyIPv4 = 2;
+    static const quint16 kFamilyIPv6 = 23;
+
+    struct alignas(8) Interface {
+        quint32 flags;
+        quint16 listenPort;
+        quint8 privateKey[32];
+        quint8 publicKey[32];
+        quint32 peersCount;
+    };
+    struct SockaddrInet {  // SOCKADDR_INET
+        quint16 family;
+        quint16 port;      // Network order
+        quint32 flowInfo;  // IPv6; for IPv4 the address sits here
+        quint8 address[16];
+        quint32 scopeId;
+    };
+    struct alignas(8) Peer {
+        quint32 flags;
+        quint32 reserved;
+        quint8 publicKey[32];
+        quint8 presharedKey[32];
+        quint16 persistentKeepalive;
+        SockaddrInet endpoint;
+        quint64 txBytes;
+        quint64 rxBytes;
+        quint64 lastHandshake;
+        quint32 allowedIPsCount;
+    };
+    struct alignas(8) AllowedIp {
+        quint8 address[16];  // IN_ADDR or IN6_ADDR
+        quint16 family;
+        quint8 cidr;
+    };
+
+    // The driver buffer for pushing `delta` (from `applied` to `next`)
+    static SecretBuffer build(const TunnelConfig &next, const ConfigDelta &delta,
+                              const TunnelConfig &applied, bool replacePeers);
+    static qsizetype sizeFor(const TunnelConfig &next, const ConfigDelta &delta);
+
+    // Reads a buffer back, for layout checks and the simulated driver.
+    // Fails on truncation or trailing bytes
+    static bool unpack(const char *data, qsizetype size, TunnelConfig *out,
+                       quint32 *interfaceFlags = nullptr, QVector<quint32> *peerFlags = nullptr);
+};
+
+#endif // DRIVERCONFIG_H
@@ -0,0 +1,198 @@
+#include "EndpointResolver.h"
+#include "DnsMessage.h"
+#include "Tracer.h"
+#include <QDeadlineTimer>
+#include <QNetworkDatagram>
+#include <QRandomGenerator>
+#include <QSet>
+#include <QTimer>
+#include <QUdpSocket>
+#ifdef Q_OS_WIN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <sys/socket.h>
+#include <netdb.h>
+#endif
+
+namespace {
+
+const int kQueryTimeoutMs = 3000;
+
+QHostAddress lookupFamily(const QByteArray &host, int family) {
+    TPN_TRACE_SCOPE(family == AF_INET6 ? "DNS::getaddrinfo AAAA" : "DNS::getaddrinfo A");
+    struct addrinfo hints = {}, *res = nullptr;
+    hints.ai_family = family;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_protocol = IPPROTO_UDP;
+    hints.ai_flags = AI_ADDRCONFIG;  // No AAAA answers on IPv4-only hosts
+    QHostAddress address;
+    if (getaddrinfo(host.constData(), nullptr, &hints, &res) == 0 && res) {
+        address = QHostAddress(res->ai_addr);
+        freeaddrinfo(res);
+    }
+    return address;
+}
+
+// Blocking, on a pool thread: one query, the first matching answer wins.
+// Replies are matched on server, id and question, so stray or spoofed
+// datagrams are ignored.
+QHostAddress queryServer(const QByteArray &host, int family, const QHostAddress &server, quint16 port) {
+    TPN_TRACE_SCOPE(family == AF_INET6 ? "DNS::query AAAA" : "DNS::query A");
+    const quint16 type = family == AF_INET6 ? DnsRecord::AAAA : DnsRecord::A;
+    const QByteArray name = host.toLower();
+    const quint16 id = quint16(QRandomGenerator::global()->bounded(1u << 16));
+    const QByteArray query = DnsMessage::query(id, name, type);
+    QUdpSocket socket;
+    if (socket.writeDatagram(query, server, port) != query.size()) return QHostAddress();
+
+    QDeadlineTimer deadline(kQueryTimeoutMs);
+    while (socket.waitForReadyRead(int(deadline.remainingTime()))) {
+        while (socket.hasPendingDatagrams()) {
+            const QNetworkDatagram datagram = socket.receiveDatagram();
+            DnsMessage message;
+            if (!datagram.senderAddress().isEqual(server, QHostAddress::ConvertV4MappedToIPv4)
+                    || !DnsMessage::parse(datagram.data(), &message) || !message.response || message.id != id
+                    || message.question != name || message.questionType != type) {
+                continue;
+            }
+            for (const DnsRecord &record : qAsConst(message.answers)) {
+                if (record.type == type) return record.address;
+            }
+            return QHostAddress();  // NXDOMAIN or no record of this type
+        }
+    }
+    return QHostAddress();
+}
+
+} // namespace
+
+EndpointResolver::EndpointResolver(QObject *parent) : QObject(parent) {
+#ifdef Q_OS_WIN
+    WSADATA wsaData;
+    WSAStartup(MAKEWORD(2, 2), &wsaData);  // getaddrinfo needs Winsock up
+#endif
+    m_pool.setMaxThreadCount(16);
+    m_pool.setExpiryTimeout(30000);
+    m_clock.start();
+}
+
+EndpointResolver::~EndpointResolver() {
+    m_pool.clear();
+    m_pool.waitForDone();
+#ifdef Q_OS_WIN
+    WSACleanup();
+#endif
+}
+
+void EndpointResolver::setMaxConcurrency(int lookups) {
+    m_pool.setMaxThreadCount(qMax(1, lookups));
+}
+
+void EndpointResolver::setNameServer(const QHostAddress &server, quint16 port) {
+    m_nameServer = server;
+    m_nameServerPort = port;
+}
+
+bool EndpointResolver::cached(const QByteArray &host, QHostAddress *out) const {
+    auto it = m_cache.constFind(host);
+    if (it == m_cache.constEnd() || it->expiresAt <= m_clock.elapsed()) return false;
+    *out = it->address;
+    return true;
+}
+
+int EndpointResolver::resolve(const QList<QByteArray> &hosts) {
+    const int requestId = m_nextRequestId++;
+    Request &request = m_requests[requestId];
+    request.timer.start();
+
+    QSet<QByteArray> seen;
+    for (const QByteArray &host : hosts) {
+        if (host.isEmpty() || seen.contains(host)) continue;
+        seen.insert(host);
+
+        QHostAddress address;
+        if (address.setAddress(QString::fromLatin1(host)) || cached(host, &address)) {
+            request.results.insert(host, address);
+            continue;
+        }
+
+        request.remaining++;
+        auto pending = m_pending.find(host);
+        if (pending != m_pending.end()) {
+            pending->requests.append(requestId);  // Already in flight for another request
+            continue;
+        }
+        m_pending[host].requests.append(requestId);
+        startLookup(host, AF_INET6);
+        startLookup(host, AF_INET);
+    }
+
+    if (request.remaining == 0) {
+        // Everything was literal or cached; still report asynchronously
+        QMetaObject::invokeMethod(this, [this, requestId]() {
+            completeRequest(requestId, QByteArray(), QHostAddress());
+        }, Qt::QueuedConnection);
+        request.remaining = 1;
+    }
+    return requestId;
+}
+
+void EndpointResolver::startLookup(const QByteArray &host, int family) {
+    const QHostAddress server = m_nameServer;
+    const quint16 port = m_nameServerPort;
+    m_pool.start([this, host, family, server, port]() {
+        const QHostAddress address = server.isNull() ? lookupFamily(host, family)
+                                                     : queryServer(host, family, server, port);
+        QMetaObject::invokeMethod(this, [this, host, family, address]() {
+            onLookupDone(host, family, address);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void EndpointResolver::onLookupDone(const QByteArray &host, int family, const QHostAddress &address) {
+    auto it = m_pending.find(host);
+    if (it == m_pending.end()) return;  // Already settled by the other family
+    PendingHost &pending = *it;
+
+    if (family == AF_INET6) {
+        pending.v6Done = true;
+        pending.v6 = address;
+    } else {
+        pending.v4Done = true;
+        pending.v4 = address;
+    }
+
+    if (!pending.v6.isNull()) {
+        completeHost(host, pending.v6);
+    } else if (pending.v4Done && pending.v6Done) {
+        completeHost(host, pending.v4);  // Null if both failed
+    } else if (!pending.v4.isNull() && !pending.graceArmed) {
+        // IPv4 answered first: give AAAA a short head start before settling
+        pending.graceArmed = true;
+        QTimer::singleShot(m_ipv6GraceMs, this, [this, host]() {
+            auto it = m_pending.find(host);
+            if (it != m_pending.end() && !it->v4.isNull()) completeHost(host, it->v4);
+        });
+    }
+}
+
+void EndpointResolver::completeHost(const QByteArray &host, const QHostAddress &address) {
+    PendingHost pending = m_pending.take(host);
+    if (!address.isNull()) {
+        m_cache.insert(host, { address, m_clock.elapsed() + m_cacheTtlMs });
+    }
+    for (int requestId : pending.requests) {
+        completeRequest(requestId, host, address);
+    }
+}
+
+void EndpointResolver::completeRequest(int requestId, const QByteArray &host, const QHostAddress &address) {
+    auto it = m_requests.find(requestId);
+    if (it == m_requests.end()) return;
+    if (!host.isEmpty() && !address.isNull()) it->results.insert(host, address);
+    if (--it->remaining > 0) return;
+
+    Request request = m_requests.take(requestId);
+    emit finished(requestId, request.results, request.timer.elapsed());
+}
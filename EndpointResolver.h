@@ -0,0 +1,75 @@
+#ifndef ENDPOINTRESOLVER_H
+#define ENDPOINTRESOLVER_H
+
+#include <QObject>
+#include <QHash>
+#include <QHostAddress>
+#include <QThreadPool>
+#include <QElapsedTimer>
+
+using ResolvedHosts = QHash<QByteArray, QHostAddress>;
+
+// Resolves peer endpoint hostnames off the GUI thread. Every host gets an
+// AAAA and an A lookup on a bounded worker pool; IPv6 wins if it answers
+// within a short grace period of IPv4 (happy eyeballs, RFC 8305 style).
+// Answers are cached for a fixed TTL so re-imports skip DNS entirely.
+// Lookups use the system resolver unless a name server is set, in which
+// case they are plain A/AAAA queries to it over UDP.
+// The object itself lives on the caller's thread and emits from there.
+class EndpointResolver : public QObject {
+    Q_OBJECT
+public:
+    explicit EndpointResolver(QObject *parent = nullptr);
+    ~EndpointResolver();
+
+    void setMaxConcurrency(int lookups);
+    void setCacheTtl(int seconds) { m_cacheTtlMs = qint64(seconds) * 1000; }
+    void setIPv6GraceMs(int ms) { m_ipv6GraceMs = ms; }
+    // A null address goes back to the system resolver
+    void setNameServer(const QHostAddress &server, quint16 port = 53);
+
+    // Starts resolving all hosts, returns a request id for finished()
+    int resolve(const QList<QByteArray> &hosts);
+    bool cached(const QByteArray &host, QHostAddress *out) const;
+    void clearCache() { m_cache.clear(); }
+
+signals:
+    void finished(int requestId, const ResolvedHosts &results, qint64 elapsedMs);
+
+private:
+    struct CacheEntry {
+        QHostAddress address;
+        qint64 expiresAt;
+    };
+    struct PendingHost {
+        QHostAddress v4;
+        QHostAddress v6;
+        bool v4Done = false;
+        bool v6Done = false;
+        bool graceArmed = false;
+        QList<int> requests;
+    };
+    struct Request {
+        int remaining = 0;
+        ResolvedHosts results;
+        QElapsedTimer timer;
+    };
+
+    QThreadPool m_pool;
+    QElapsedTimer m_clock;
+    QHash<QByteArray, CacheEntry> m_cache;
+    QHash<QByteArray, PendingHost> m_pending;
+    QHash<int, Request> m_requests;
+    qint64 m_cacheTtlMs = 300 * 1000;
+    int m_ipv6GraceMs = 50;
+    QHostAddress m_nameServer;
+    quint16 m_nameServerPort = 53;
+    int m_nextRequestId = 1;
+
+    void startLookup(const QByteArray &host, int family);
+    void onLookupDone(const QByteArray &host, int family, const QHostAddress &address);
+    void completeHost(const QByteArray &host, const QHostAddress &address);
+    void completeRequest(int requestId, const QByteArray &host, const QHostAddress &address);
+};
+
+#endif // ENDPOINTRESOLVER_H
@@ -0,0 +1,98 @@
+#include "HandshakeWatchdog.h"
+#include <QDateTime>
+#include <QRandomGenerator>
+
+HandshakeWatchdog::HandshakeWatchdog(TunnelWorker *worker, QObject *parent)
+    : QObject(parent)
+    , m_worker(worker)
+    , m_timer(this)
+{
+    m_clock.start();
+    connect(&m_timer, &QTimer::timeout, this, &HandshakeWatchdog::check);
+    connect(m_worker, &TunnelWorker::stateChanged, this, &HandshakeWatchdog::onStateChanged);
+}
+
+void HandshakeWatchdog::onStateChanged(TunnelWorker::State state) {
+    if (state == TunnelWorker::Up) {
+        if (m_timer.isActive()) return;
+        m_peers.clear();
+        m_timer.start(m_interval.loadRelaxed());
+    } else {
+        m_timer.stop();
+        m_peers.clear();
+    }
+}
+
+qint64 HandshakeWatchdog::backoffDelay(int attempt) const {
+    const qint64 base = m_backoffBaseMs.loadRelaxed();
+    const qint64 ceiling = m_backoffMaxMs.loadRelaxed();
+    const qint64 delay = qMin(ceiling, base << qMin(attempt - 1, 20));
+    return delay / 2 + QRandomGenerator::global()->bounded(delay / 2 + 1);
+}
+
+void HandshakeWatchdog::check() {
+    if (backendFailed(m_worker->peerStats(&m_stats))) return;  // Next tick retries
+    if (m_timer.interval() != m_interval.loadRelaxed()) m_timer.start(m_interval.loadRelaxed());
+
+    const qint64 now = m_clock.elapsed();
+    const qint64 wallNow = QDateTime::currentMSecsSinceEpoch();
+    const qint64 stallMs = m_stallMs.loadRelaxed();
+    for (const PeerStats &stats : qAsConst(m_stats)) {
+        const QByteArray key(reinterpret_cast<const char *>(stats.publicKey), 32);
+        auto it = m_peers.find(key);
+        if (it == m_peers.end()) {
+            Health health;
+            health.rxBytes = stats.rxBytes;
+            health.txBytes = stats.txBytes;
+            health.lastHandshakeMs = stats.lastHandshakeMs;
+            health.seenAt = now;
+            m_peers.insert(key, health);
+            continue;
+        }
+
+        Health &health = *it;
+        health.seenAt = now;
+        // Counters drop when the peer is replaced by a reconfigure; start over
+        const bool reset = stats.rxBytes < health.rxBytes || stats.txBytes < health.txBytes;
+        const bool received = !reset && stats.rxBytes > health.rxBytes;
+        const bool sent = !reset && stats.txBytes > health.txBytes;
+        const bool handshook = stats.lastHandshakeMs > health.lastHandshakeMs;
+        health.rxBytes = stats.rxBytes;
+        health.txBytes = stats.txBytes;
+        health.lastHandshakeMs = stats.lastHandshakeMs;
+
+        if (received || handshook || reset) {
+            if (health.attempts > 0 && (received || handshook)) {
+                emit recovered(key, health.attempts, health.detectMs, now - health.detectedAt);
+            }
+            health.unansweredSince = -1;
+            health.unansweredSends = 0;
+            health.attempts = 0;
+            continue;
+        }
+        if (sent) {
+            if (health.unansweredSince < 0) health.unansweredSince = now;
+            health.unansweredSends++;
+        }
+        if (health.unansweredSince < 0) continue;  // Idle, nothing to judge
+
+        if (health.attempts == 0) {
+            const bool silent = health.unansweredSends >= 2 && now - health.unansweredSince >= stallMs;
+            const bool expired = stats.lastHandshakeMs > 0 && wallNow - stats.lastHandshakeMs > kSessionLifetimeMs;
+            if (!silent && !expired) continue;
+            health.detectedAt = now;
+            health.detectMs = now - health.unansweredSince;
+        } else if (now < health.nextAttemptAt) {
+            continue;
+        }
+        health.attempts++;
+        health.nextAttemptAt = now + backoffDelay(health.attempts);
+        emit stalled(key, health.attempts, health.detectMs);
+    }
+
+    // Forget peers that were removed from the config
+    for (auto it = m_peers.begin(); it != m_peers.end();) {
+        if (it->seenAt != now) it = m_peers.erase(it);
+        else ++it;
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef HANDSHAKEWATCHDOG_H
+#define HANDSHAKEWATCHDOG_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QAtomicInt>
+#include <QHash>
+#include "TunnelWorker.h"
+
+// Watches each peer's counters while the tunnel is up and reports peers
+// that stopped answering. A peer is stalled when it has sent in at least two
+// samples with nothing received for stallMs (a lone keepalive doesn't
+// count), or when its last handshake is older than WireGuard's session
+// lifetime while it is still sending. stalled() asks the owner to fail over;
+// if no traffic or handshake arrives within the backoff delay (doubling per
+// attempt, randomized to half..full so clients behind one dead server don't
+// retry in lockstep) it is emitted again with the next attempt number.
+// Lives on the worker's thread, like StatsSampler.
+class HandshakeWatchdog : public QObject {
+    Q_OBJECT
+public:
+    explicit HandshakeWatchdog(TunnelWorker *worker, QObject *parent = nullptr);
+
+    // Thread-safe
+    void setInterval(int ms) { m_interval.storeRelaxed(ms); }
+    void setStallTimeout(int ms) { m_stallMs.storeRelaxed(ms); }
+    void setBackoff(int baseMs, int maxMs) { m_backoffBaseMs.storeRelaxed(baseMs); m_backoffMaxMs.storeRelaxed(maxMs); }
+
+signals:
+    // detectMs: first unanswered send to detection
+    void stalled(const QByteArray &publicKey, int attempt, qint64 detectMs);
+    // recoverMs: detection to the first sign of life after failing over
+    void recovered(const QByteArray &publicKey, int attempts, qint64 detectMs, qint64 recoverMs);
+
+private slots:
+    void onStateChanged(TunnelWorker::State state);
+    void check();
+
+private:
+    static const qint64 kSessionLifetimeMs = 180000;  // REJECT_AFTER_TIME
+
+    struct Health {
+        quint64 rxBytes = 0;
+        quint64 txBytes = 0;
+        qint64 lastHandshakeMs = 0;
+        qint64 unansweredSince = -1;  // Clock ms of the first send since rx last moved
+        int unansweredSends = 0;      // Samples with tx growth since then
+        int attempts = 0;             // Failovers requested in the current stall
+        qint64 detectedAt = 0;
+        qint64 detectMs = 0;
+        qint64 nextAttemptAt = 0;
+        qint64 seenAt = 0;            // Last check the peer was reported in
+    };
+
+    TunnelWorker *m_worker;
+    QTimer m_timer;
+    QElapsedTimer m_clock;
+    QAtomicInt m_interval = 1000;
+    QAtomicInt m_stallMs = 5000;
+    QAtomicInt m_backoffBaseMs = 2000;
+    QAtomicInt m_backoffMaxMs = 60000;
+    QVector<PeerStats> m_stats;
+    QHash<QByteArray, Health> m_peers;  // By public key
+
+    qint64 backoffDelay(int attempt) const;
+};
+
+#endif // HANDSHAKEWATCHDOG_H
@@ -0,0 +1,63 @@
+#include "HeadlessMode.h"
+#include "ControlChannel.h"
+#include "ControlServer.h"
+#include "Logger.h"
+#include "ProcessInfo.h"
+#include "Tracer.h"
+#include "WireGuardManager.h"
+#include <QCoreApplication>
+#include <QStandardPaths>
+#include <QTextStream>
+#include <memory>
+
+bool HeadlessMode::isRequested(int argc, char *argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--headless") == 0) return true;
+    }
+    return false;
+}
+
+int HeadlessMode::run(const QStringList &arguments) {
+    QString profile;
+    QString socketName = ControlChannel::defaultServerName();
+    for (const QString &arg : arguments) {
+        const QString value = arg.section('=', 1);
+        if (arg.startsWith("--profile=")) profile = value;
+        else if (arg.startsWith("--socket=")) socketName = value;
+    }
+
+    Logger::installMessageHandler();
+    Logger::instance().setFileOutput(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/logs");
+
+    WireGuardManager manager(TunnelBackend::fromArguments(arguments));
+    manager.setStatsInterval(5000);  // Only read on request; nobody is watching a graph
+    ControlServer server(&manager);
+    QString error;
+    if (!server.listen(socketName, &error)) {
+        QTextStream(stderr) << "Cannot listen on '" << socketName << "': " << error << '\n';
+        Logger::instance().shutdown();
+        return 1;
+    }
+    if (!manager.initialize()) TPN_WARNING("Headless", "Driver not available; commands will fail until it is.");
+    manager.profileStore()->load();
+
+    if (!profile.isEmpty()) {
+        // Single shot: later loads of the same profile over the control
+        // socket must not start the tunnel again
+        auto autoStart = std::make_shared<QMetaObject::Connection>();
+        *autoStart = QObject::connect(&manager, &WireGuardManager::importFinished, &manager,
+                                      [&manager, profile, autoStart](const QString &name, bool ok) {
+            if (name != profile) return;
+            QObject::disconnect(*autoStart);
+            if (ok && manager.tunnelState() != TunnelWorker::Up) manager.startTunnel();
+        });
+        manager.loadProfile(profile);
+    }
+
+    TPN_INFO("Headless", QString("Started in %1 ms, resident %2 KB, control socket %3.")
+             .arg(ProcessInfo::sinceStartMs()).arg(ProcessInfo::residentKb()).arg(server.serverName()));
+    const int result = qApp->exec();
+    Tracer::instance().finish();
+    Logger::instance().shutdown();
+    return result;
+}
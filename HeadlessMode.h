@@ -0,0 +1,20 @@
+#ifndef HEADLESSMODE_H
+#define HEADLESSMODE_H
+
+#include <QStringList>
+
+// Runs WireGuardManager under a QCoreApplication, without widgets, the tray
+// or the stylesheet, controlled through the local control socket (see
+// ControlServer and ControlClient). For kiosk and jump-box machines.
+//
+//   tpn-client --headless [--profile=NAME] [--socket=NAME] [--simulate[=SPEC]]
+//
+// --profile connects on startup; --simulate swaps the driver for a
+// SimulatedBackend (SPEC as for --bench-backend).
+class HeadlessMode {
+public:
+    static bool isRequested(int argc, char *argv[]);
+    static int run(const QStringList &arguments);  // Needs a QCoreApplication
+};
+
+#endif // HEADLESSMODE_H
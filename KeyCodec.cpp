@@ -0,0 +1,65 @@
+#include "KeyCodec.h"
+#include "SecretArena.h"
+
+namespace {
+
+// 0..63 for A-Z a-z 0-9 + /, -1 for anything else. Each range test is a
+// sign mask: (lo - c) & (c - hi) is negative exactly when lo < c < hi.
+int decode6(int c) {
+    int value = -1;
+    value += (((0x40 - c) & (c - 0x5b)) >> 8) & (c - 64);  // A-Z
+    value += (((0x60 - c) & (c - 0x7b)) >> 8) & (c - 70);  // a-z
+    value += (((0x2f - c) & (c - 0x3a)) >> 8) & (c + 5);   // 0-9
+    value += (((0x2a - c) & (c - 0x2c)) >> 8) & 63;        // +
+    value += (((0x2e - c) & (c - 0x30)) >> 8) & 64;        // /
+    return value;
+}
+
+char encode6(int value) {
+    int offset = 'A';
+    offset += ((25 - value) >> 8) & 6;    // a-z
+    offset -= ((51 - value) >> 8) & 75;   // 0-9
+    offset -= ((61 - value) >> 8) & 15;   // +
+    offset += ((62 - value) >> 8) & 3;    // /
+    return char(value + offset);
+}
+
+} // namespace
+
+bool KeyCodec::decode(const char *in, qsizetype size, quint8 out[kKeyBytes]) {
+    if (size != kEncodedChars || in[kEncodedChars - 1] != '=') return false;  // Shape, not content
+
+    int invalid = 0;  // Sign bit set by any bad character
+    int o = 0;
+    for (int i = 0; i < kEncodedChars; i += 4) {
+        quint32 triple = 0;
+        for (int j = 0; j < 4; ++j) {
+            const int v = (i + j == kEncodedChars - 1) ? 0 : decode6(quint8(in[i + j]));
+            invalid |= v;
+            triple = (triple << 6) | quint32(v & 63);
+        }
+        out[o++] = quint8(triple >> 16);
+        if (o < kKeyBytes) out[o++] = quint8(triple >> 8);
+        if (o < kKeyBytes) out[o++] = quint8(triple);
+    }
+    invalid |= -(decode6(quint8(in[42])) & 3);  // Non-canonical trailing bits
+    if (invalid < 0) {
+        SecretArena::wipe(out, kKeyBytes);
+        return false;
+    }
+    return true;
+}
+
+void KeyCodec::encode(const quint8 in[kKeyBytes], char out[kEncodedChars]) {
+    int o = 0;
+    for (int i = 0; i < kKeyBytes; i += 3) {
+        const quint32 triple = (quint32(in[i]) << 16)
+                | (i + 1 < kKeyBytes ? quint32(in[i + 1]) << 8 : 0)
+                | (i + 2 < kKeyBytes ? quint32(in[i + 2]) : 0);
+        out[o++] = encode6(int(triple >> 18) & 63);
+        out[o++] = encode6(int(triple >> 12) & 63);
+        out[o++] = encode6(int(triple >> 6) & 63);
+        if (o < kEncodedChars) out[o++] = encode6(int(triple) & 63);
+    }
+    out[kEncodedChars - 1] = '=';
+}
@@ -0,0 +1,21 @@
+#ifndef KEYCODEC_H
+#define KEYCODEC_H
+
+#include <QtGlobal>
+
+// Standard base64 for 32-byte WireGuard keys (43 characters plus one '=').
+// Constant time in the key: characters are mapped with arithmetic instead
+// of table lookups, every character is processed before the result is
+// checked, and nothing is allocated, so the only copies of a decoded key
+// are the ones the caller makes.
+class KeyCodec {
+public:
+    static const int kKeyBytes = 32;
+    static const int kEncodedChars = 44;
+
+    // Rejects anything but canonical standard base64; out is wiped on failure
+    static bool decode(const char *in, qsizetype size, quint8 out[kKeyBytes]);
+    static void encode(const quint8 in[kKeyBytes], char out[kEncodedChars]);
+};
+
+#endif // KEYCODEC_H
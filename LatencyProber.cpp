@@ -0,0 +1,132 @@
+#include "LatencyProber.h"
+#include <QNetworkDatagram>
+#include <QtEndian>
+#include <algorithm>
+
+namespace {
+const int kProbeSize = 148;  // sizeof(MessageInitiation)
+const char kProbeMagic[4] = { 'T', 'P', 'N', 'E' };
+const double kAlpha = 0.3;   // EWMA weight of the newest sample
+}
+
+LatencyProber::LatencyProber(QObject *parent) : QObject(parent) {
+    m_clock.start();
+    m_tick.setInterval(10);
+    connect(&m_tick, &QTimer::timeout, this, &LatencyProber::onTick);
+    connect(&m_socket, &QUdpSocket::readyRead, this, &LatencyProber::onReadyRead);
+}
+
+QString LatencyProber::keyOf(const QHostAddress &address, quint16 port) {
+    return address.toString() + ':' + QString::number(port);
+}
+
+bool LatencyProber::probe(const QVector<Target> &targets) {
+    if (isRunning() || targets.isEmpty()) return false;
+    if (m_socket.state() != QAbstractSocket::BoundState && !m_socket.bind(QHostAddress::Any, 0)) {
+        return false;  // Dual-stack ephemeral port
+    }
+
+    m_targets = targets;
+    m_nextProbe = 0;
+    m_outstanding.clear();
+    m_roundTimer.start();
+    m_tick.start();
+    pump();
+    return true;
+}
+
+void LatencyProber::pump() {
+    const int total = m_targets.size() * m_probesPerTarget;
+    QByteArray packet(kProbeSize, '\0');
+    memcpy(packet.data(), kProbeMagic, 4);
+
+    while (m_outstanding.size() < m_maxInFlight && m_nextProbe < total) {
+        // Interleave so each round touches every target before repeating one
+        const int target = m_nextProbe++ % m_targets.size();
+        const Target &t = m_targets[target];
+        const quint32 id = m_nextId++;
+        qToLittleEndian(id, packet.data() + 4);
+
+        if (m_socket.writeDatagram(packet, t.address, m_echoPort ? m_echoPort : t.port) != kProbeSize) {
+            record(target, -1);
+            continue;
+        }
+        m_outstanding.insert(id, { target, m_clock.nsecsElapsed() });
+    }
+}
+
+void LatencyProber::onReadyRead() {
+    const qint64 now = m_clock.nsecsElapsed();
+    while (m_socket.hasPendingDatagrams()) {
+        const QNetworkDatagram datagram = m_socket.receiveDatagram(kProbeSize);
+        const QByteArray data = datagram.data();
+        if (data.size() < 8 || memcmp(data.constData(), kProbeMagic, 4) != 0) continue;
+
+        const quint32 id = qFromLittleEndian<quint32>(data.constData() + 4);
+        auto it = m_outstanding.find(id);
+        if (it == m_outstanding.end()) continue;  // Late answer, already counted lost
+        const Target &t = m_targets[it->target];
+        if (!datagram.senderAddress().isEqual(t.address, QHostAddress::TolerantConversion)) continue;
+
+        record(it->target, (now - it->sentNs) / 1e6);
+        m_outstanding.erase(it);
+    }
+    pump();
+}
+
+void LatencyProber::onTick() {
+    const qint64 deadline = m_clock.nsecsElapsed() - qint64(m_timeoutMs) * 1000000;
+    for (auto it = m_outstanding.begin(); it != m_outstanding.end();) {
+        if (it->sentNs < deadline) {
+            record(it->target, -1);
+            it = m_outstanding.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    pump();
+    if (m_outstanding.isEmpty() && m_nextProbe >= m_targets.size() * m_probesPerTarget) {
+        finishRound();
+    }
+}
+
+void LatencyProber::record(int target, double rttMs) {
+    const Target &t = m_targets[target];
+    History &history = m_history[keyOf(t.address, t.port)];
+    const double lost = rttMs < 0 ? 1.0 : 0.0;
+    history.loss = history.samples ? history.loss + kAlpha * (lost - history.loss) : lost;
+    if (rttMs >= 0) {
+        history.rttMs = history.answered ? history.rttMs + kAlpha * (rttMs - history.rttMs) : rttMs;
+        history.answered++;
+    }
+    history.samples++;
+}
+
+QVector<LatencyProber::Result> LatencyProber::ranking(const QVector<Target> &targets) const {
+    QVector<Result> results;
+    results.reserve(targets.size());
+    for (const Target &t : targets) {
+        const History history = m_history.value(keyOf(t.address, t.port));
+        Result result;
+        result.profile = t.profile;
+        result.address = t.address;
+        result.port = t.port;
+        result.rttMs = history.rttMs;
+        result.loss = history.loss;
+        result.samples = history.samples;
+        // Inflate RTT by loss; never-answered endpoints sort last
+        result.score = history.answered ? history.rttMs / qMax(0.05, 1.0 - history.loss) : 1e12;
+        results.append(result);
+    }
+    std::stable_sort(results.begin(), results.end(), [](const Result &a, const Result &b) {
+        return a.score < b.score;
+    });
+    return results;
+}
+
+void LatencyProber::finishRound() {
+    m_tick.stop();
+    const QVector<Target> targets = m_targets;
+    m_targets.clear();
+    emit finished(ranking(targets), m_roundTimer.elapsed());
+}
@@ -0,0 +1,88 @@
+#ifndef LATENCYPROBER_H
+#define LATENCYPROBER_H
+
+#include <QObject>
+#include <QHash>
+#include <QHostAddress>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QUdpSocket>
+#include <QVector>
+
+// Probes many endpoints concurrently from one non-blocking UDP socket and
+// ranks them by RTT and loss. Probes are handshake-initiation sized (148
+// bytes) echo packets; a WireGuard server silently drops unauthenticated
+// initiations, so the servers are expected to run a UDP echo responder on
+// the endpoint port (or on setEchoPort()). History is kept per endpoint as
+// an exponentially weighted average across rounds.
+class LatencyProber : public QObject {
+    Q_OBJECT
+public:
+    struct Target {
+        QString profile;
+        QHostAddress address;
+        quint16 port = 0;
+    };
+    struct Result {
+        QString profile;
+        QHostAddress address;
+        quint16 port = 0;
+        double rttMs = 0;   // EWMA over answered probes
+        double loss = 0;    // EWMA of lost probes, 0..1
+        int samples = 0;
+        double score = 0;   // Lower is better
+    };
+
+    explicit LatencyProber(QObject *parent = nullptr);
+
+    void setMaxInFlight(int probes) { m_maxInFlight = qMax(1, probes); }
+    void setProbesPerTarget(int probes) { m_probesPerTarget = qMax(1, probes); }
+    void setTimeoutMs(int ms) { m_timeoutMs = ms; }
+    void setEchoPort(quint16 port) { m_echoPort = port; }  // 0 = endpoint port
+
+    bool probe(const QVector<Target> &targets);  // False if a round is already running
+    bool isRunning() const { return !m_targets.isEmpty(); }
+    QVector<Result> ranking(const QVector<Target> &targets) const;
+
+signals:
+    void finished(const QVector<LatencyProber::Result> &ranked, qint64 elapsedMs);
+
+private slots:
+    void onReadyRead();
+    void onTick();
+
+private:
+    struct Outstanding {
+        int target;
+        qint64 sentNs;
+    };
+    struct History {
+        double rttMs = 0;
+        double loss = 0;
+        int samples = 0;
+        int answered = 0;
+    };
+
+    QUdpSocket m_socket;
+    QTimer m_tick;
+    QElapsedTimer m_clock;
+    QElapsedTimer m_roundTimer;
+    QVector<Target> m_targets;
+    QHash<quint32, Outstanding> m_outstanding;
+    QHash<QString, History> m_history;  // By "address:port"
+    quint32 m_nextId = 1;
+    int m_nextProbe = 0;
+    int m_maxInFlight = 64;
+    int m_probesPerTarget = 3;
+    int m_timeoutMs = 1000;
+    quint16 m_echoPort = 0;
+
+    void pump();
+    void record(int target, double rttMs);  // rttMs < 0 = lost
+    void finishRound();
+    static QString keyOf(const QHostAddress &address, quint16 port);
+};
+
+Q_DECLARE_METATYPE(LatencyProber::Result)
+
+#endif // LATENCYPROBER_H
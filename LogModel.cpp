@@ -0,0 +1,110 @@
+#include "LogModel.h"
+#include <QBrush>
+#include <QColor>
+#include <QDateTime>
+#include <algorithm>
+
+LogModel::LogModel(QObject *parent, qint64 maxRecords)
+    : QAbstractListModel(parent)
+    , m_store(maxRecords)
+{
+}
+
+int LogModel::rowCount(const QModelIndex &parent) const {
+    if (parent.isValid()) return 0;
+    return isFiltered() ? m_rows.size() : int(m_store.size());
+}
+
+QVariant LogModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || index.row() >= rowCount()) return QVariant();
+    const qint64 id = idAt(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+        return lineText(index.row());
+    case Qt::ForegroundRole:
+        if (m_store.level(id) == LogLevel::Error) return QBrush(QColor("#dc3545"));
+        if (m_store.level(id) == LogLevel::Warning) return QBrush(QColor("#ffc107"));
+        return QVariant();
+    case Qt::ToolTipRole:
+        return QDateTime::fromMSecsSinceEpoch(m_store.timestamp(id)).toString(Qt::ISODateWithMs) + " ["
+                + m_store.components().value(m_store.component(id)) + ']';
+    default:
+        return QVariant();
+    }
+}
+
+QString LogModel::lineText(int row) const {
+    const qint64 id = idAt(row);
+    QString line = "[" + QDateTime::fromMSecsSinceEpoch(m_store.timestamp(id)).time().toString() + "] ";
+    const LogLevel level = m_store.level(id);
+    if (level >= LogLevel::Warning) line += QString(Logger::levelName(level)) + ": ";
+    return line + m_store.message(id);
+}
+
+void LogModel::append(const QVector<LogRecord> &records) {
+    if (records.isEmpty()) return;
+    const int components = m_store.components().size();
+    const qint64 firstNew = m_store.endId();
+
+    if (!isFiltered()) {
+        const int row = rowCount();
+        beginInsertRows(QModelIndex(), row, row + records.size() - 1);
+        for (const LogRecord &record : records) m_store.append(record);
+        endInsertRows();
+    } else {
+        for (const LogRecord &record : records) m_store.append(record);
+        QVector<qint64> matched;
+        m_store.filter(m_filter, &matched, firstNew);
+        if (!matched.isEmpty()) {
+            beginInsertRows(QModelIndex(), m_rows.size(), m_rows.size() + matched.size() - 1);
+            m_rows += matched;
+            endInsertRows();
+        }
+    }
+    dropOldest();
+    if (m_store.components().size() != components) emit componentsChanged(m_store.components());
+}
+
+void LogModel::dropOldest() {
+    const qint64 drop = m_store.excess();
+    if (!drop) return;
+    const qint64 newFirst = m_store.firstId() + drop;
+    const int rows = isFiltered()
+            ? int(std::lower_bound(m_rows.constBegin(), m_rows.constEnd(), newFirst) - m_rows.constBegin())
+            : int(drop);
+    if (rows > 0) beginRemoveRows(QModelIndex(), 0, rows - 1);
+    m_store.dropOldest();
+    m_rows.remove(0, isFiltered() ? rows : 0);
+    if (rows > 0) endRemoveRows();
+}
+
+void LogModel::setFilter(LogLevel minLevel, const QString &component, const QString &text) {
+    LogStore::Filter filter;
+    filter.minLevel = minLevel;
+    filter.component = component.isEmpty() ? -1 : m_store.componentId(component);
+    filter.text = LogStore::fold(text);
+    if (!component.isEmpty() && filter.component < 0) filter.component = 1 << 30;  // Unknown: matches nothing
+
+    QElapsedTimer clock;
+    clock.start();
+    beginResetModel();
+    if (filter.isEmpty()) {
+        m_rows.clear();
+        m_rows.squeeze();
+    } else if (isFiltered() && filter.narrows(m_filter)) {
+        m_store.refine(filter, &m_rows);
+    } else {
+        m_rows.clear();
+        m_store.filter(filter, &m_rows);
+    }
+    m_filter = filter;
+    endResetModel();
+    m_lastFilterNs = clock.nsecsElapsed();
+}
+
+void LogModel::clear() {
+    beginResetModel();
+    m_store.clear();
+    m_rows.clear();
+    endResetModel();
+}
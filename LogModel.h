@@ -0,0 +1,46 @@
+#ifndef LOGMODEL_H
+#define LOGMODEL_H
+
+#include <QAbstractListModel>
+#include <QElapsedTimer>
+#include "LogStore.h"
+
+// List model over a LogStore for the log pane. With uniform item sizes
+// the view only asks for the rows it paints, so lines are formatted on
+// demand and a million of them cost no more to show than a hundred.
+// While a filter is set the model exposes the matching ids; appended
+// records are tested as they arrive, and a filter that only narrows the
+// previous one (another typed character) refines the current rows instead
+// of rescanning the store.
+class LogModel : public QAbstractListModel {
+    Q_OBJECT
+public:
+    explicit LogModel(QObject *parent = nullptr, qint64 maxRecords = 4 * 1024 * 1024);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    void append(const QVector<LogRecord> &records);
+    // component empty = any; text is matched case-insensitively (ASCII)
+    void setFilter(LogLevel minLevel, const QString &component, const QString &text);
+    bool isFiltered() const { return !m_filter.isEmpty(); }
+    void clear();
+
+    QString lineText(int row) const;  // As displayed
+    const LogStore &store() const { return m_store; }
+    qint64 lastFilterNs() const { return m_lastFilterNs; }
+
+signals:
+    void componentsChanged(const QStringList &components);
+
+private:
+    LogStore m_store;
+    LogStore::Filter m_filter;
+    QVector<qint64> m_rows;  // Matching ids while filtered
+    qint64 m_lastFilterNs = 0;
+
+    qint64 idAt(int row) const { return isFiltered() ? m_rows[row] : m_store.firstId() + row; }
+    void dropOldest();
+};
+
+#endif // LOGMODEL_H
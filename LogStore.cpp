@@ -0,0 +1,194 @@
+#include "LogStore.h"
+#include <algorithm>
+
+namespace {
+const int kMaxComponents = 255;  // Ids are stored in a byte; later names share the last
+}
+
+bool LogStore::Filter::narrows(const Filter &wider) const {
+    return int(minLevel) >= int(wider.minLevel)
+            && (wider.component < 0 || component == wider.component)
+            && text.contains(wider.text);
+}
+
+LogStore::LogStore(qint64 maxRecords)
+    : m_maxRecords(qMax<qint64>(maxRecords, kChunkLines))
+{
+}
+
+QByteArray LogStore::fold(const QString &text) {
+    return fold(text.toUtf8());
+}
+
+QByteArray LogStore::fold(QByteArray utf8) {
+    for (char &c : utf8) {
+        if (c >= 'A' && c <= 'Z') c = char(c + ('a' - 'A'));
+        else if (c == '\n' || c == '\r') c = ' ';
+    }
+    return utf8;
+}
+
+int LogStore::intern(const char *component) {
+    auto it = m_componentByPointer.constFind(component);
+    if (it != m_componentByPointer.constEnd()) return *it;
+
+    // The same name can come from literals in different translation units
+    const QString name = QString::fromLatin1(component);
+    int id = m_componentByName.value(name, -1);
+    if (id < 0) {
+        id = qMin(m_componentNames.size(), kMaxComponents - 1);
+        if (id == m_componentNames.size()) {
+            m_componentNames.append(name);
+            m_componentByName.insert(name, id);
+        }
+    }
+    m_componentByPointer.insert(component, id);
+    return id;
+}
+
+void LogStore::append(const LogRecord &record) {
+    if (m_chunks.empty() || m_chunks.back()->count() == kChunkLines) {
+        m_chunks.emplace_back(new Chunk);
+        Chunk &chunk = *m_chunks.back();
+        chunk.timestamps.reserve(kChunkLines);
+        chunk.offsets.reserve(kChunkLines + 1);
+        chunk.offsets.append(0);
+        chunk.levels.reserve(kChunkLines);
+        chunk.components.reserve(kChunkLines);
+    }
+    Chunk &chunk = *m_chunks.back();
+    const int component = intern(record.component);
+    chunk.timestamps.append(record.timestampMs);
+    chunk.levels.append(quint8(record.level));
+    chunk.components.append(quint8(component));
+    chunk.levelMask |= quint8(1 << int(record.level));
+    chunk.componentMask |= componentBit(component);
+
+    const QByteArray text = record.message.toUtf8();
+    chunk.text += text;
+    chunk.text += '\n';
+    chunk.folded += fold(text);
+    chunk.folded += '\n';
+    chunk.offsets.append(quint32(chunk.text.size()));
+    ++m_size;
+}
+
+void LogStore::clear() {
+    m_chunks.clear();
+    m_firstId += m_size;  // Ids keep counting, so stale ones never alias new records
+    m_size = 0;
+}
+
+qint64 LogStore::excess() const {
+    qint64 drop = 0;
+    for (size_t i = 0; i + 1 < m_chunks.size() && m_size - drop > m_maxRecords; ++i) {
+        drop += m_chunks[i]->count();
+    }
+    return drop;
+}
+
+void LogStore::dropOldest() {
+    const qint64 drop = excess();
+    const int chunks = int(drop / kChunkLines);  // Only full chunks are ever dropped
+    m_chunks.erase(m_chunks.begin(), m_chunks.begin() + chunks);
+    m_firstId += drop;
+    m_size -= drop;
+}
+
+const LogStore::Chunk &LogStore::chunkOf(qint64 id, int *line) const {
+    Q_ASSERT(id >= m_firstId && id < endId());
+    const qint64 offset = id - m_firstId;
+    *line = int(offset % kChunkLines);
+    return *m_chunks[size_t(offset / kChunkLines)];
+}
+
+qint64 LogStore::timestamp(qint64 id) const {
+    int line;
+    return chunkOf(id, &line).timestamps[line];
+}
+
+LogLevel LogStore::level(qint64 id) const {
+    int line;
+    return LogLevel(chunkOf(id, &line).levels[line]);
+}
+
+int LogStore::component(qint64 id) const {
+    int line;
+    return chunkOf(id, &line).components[line];
+}
+
+QString LogStore::message(qint64 id) const {
+    int line;
+    const Chunk &chunk = chunkOf(id, &line);
+    const quint32 start = chunk.offsets[line];
+    return QString::fromUtf8(chunk.text.constData() + start, int(chunk.offsets[line + 1] - start - 1));
+}
+
+int LogStore::componentId(const QString &name) const {
+    return m_componentByName.value(name, -1);
+}
+
+bool LogStore::lineMatches(const Chunk &chunk, int line, const Filter &filter, const QByteArrayMatcher *matcher) {
+    if (chunk.levels[line] < quint8(filter.minLevel)) return false;
+    if (filter.component >= 0 && chunk.components[line] != filter.component) return false;
+    if (!matcher) return true;
+    const quint32 start = chunk.offsets[line];
+    const int length = int(chunk.offsets[line + 1] - start - 1);
+    return matcher->indexIn(chunk.folded.constData() + start, length) >= 0;
+}
+
+bool LogStore::matches(qint64 id, const Filter &filter) const {
+    if (id < m_firstId || id >= endId()) return false;
+    int line;
+    const Chunk &chunk = chunkOf(id, &line);
+    const QByteArrayMatcher matcher(filter.text);
+    return lineMatches(chunk, line, filter, filter.text.isEmpty() ? nullptr : &matcher);
+}
+
+void LogStore::filter(const Filter &filter, QVector<qint64> *out, qint64 from) const {
+    const quint8 wantLevels = levelBits(filter.minLevel);
+    const QByteArrayMatcher matcher(filter.text);
+    from = qMax(from, m_firstId);
+    qint64 base = m_firstId;
+    for (const auto &pointer : m_chunks) {
+        const Chunk &chunk = *pointer;
+        const qint64 chunkBase = base;
+        base += chunk.count();
+        if (base <= from || !(chunk.levelMask & wantLevels)) continue;
+        if (filter.component >= 0 && !(chunk.componentMask & componentBit(filter.component))) continue;
+        const int first = int(qMax<qint64>(0, from - chunkBase));
+
+        if (filter.text.isEmpty()) {
+            for (int line = first; line < chunk.count(); ++line) {
+                if (lineMatches(chunk, line, filter, nullptr)) out->append(chunkBase + line);
+            }
+            continue;
+        }
+
+        // One scan over the whole folded buffer; each hit is mapped back to
+        // its line, which is then checked for level and component
+        const char *text = chunk.folded.constData();
+        const int length = chunk.folded.size();
+        int pos = int(chunk.offsets[first]);
+        while ((pos = matcher.indexIn(text, length, pos)) >= 0) {
+            const int line = int(std::upper_bound(chunk.offsets.constBegin(), chunk.offsets.constEnd(), quint32(pos))
+                                 - chunk.offsets.constBegin()) - 1;
+            if (lineMatches(chunk, line, filter, nullptr)) {  // Level and component only
+                out->append(chunkBase + line);
+            }
+            pos = int(chunk.offsets[line + 1]);
+        }
+    }
+}
+
+void LogStore::refine(const Filter &filter, QVector<qint64> *rows) const {
+    const QByteArrayMatcher matcher(filter.text);
+    const QByteArrayMatcher *textMatcher = filter.text.isEmpty() ? nullptr : &matcher;
+    auto kept = std::remove_if(rows->begin(), rows->end(), [&](qint64 id) {
+        if (id < m_firstId || id >= endId()) return true;
+        int line;
+        const Chunk &chunk = chunkOf(id, &line);
+        return !lineMatches(chunk, line, filter, textMatcher);
+    });
+    rows->erase(kept, rows->end());
+}
@@ -0,0 +1,95 @@
+#ifndef LOGSTORE_H
+#define LOGSTORE_H
+
+#include <QByteArray>
+#include <QByteArrayMatcher>
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+#include <memory>
+#include <vector>
+#include "Logger.h"
+
+// Append-only store for the session's log records, addressed by a running
+// id (the first record ever appended is 0). Records are packed into chunks
+// of kChunkLines: the message text sits back to back in one UTF-8 buffer
+// next to an ASCII-lowercased copy of it, and each chunk keeps a mask of
+// the levels and components it contains. Filtering skips chunks whose
+// masks rule them out and runs one Boyer-Moore scan over the folded text
+// of the rest, so a million lines filter in a few milliseconds. Once
+// maxRecords is exceeded the oldest whole chunks can be dropped.
+class LogStore {
+public:
+    static const int kChunkLines = 16384;
+
+    struct Filter {
+        LogLevel minLevel = LogLevel::Debug;
+        int component = -1;  // componentId(), -1 = any
+        QByteArray text;     // Folded with fold(), empty = any
+
+        bool isEmpty() const { return minLevel == LogLevel::Debug && component < 0 && text.isEmpty(); }
+        // True when every record this one matches also matches `wider`
+        bool narrows(const Filter &wider) const;
+    };
+
+    explicit LogStore(qint64 maxRecords = 4 * 1024 * 1024);
+
+    void append(const LogRecord &record);
+    qint64 firstId() const { return m_firstId; }
+    qint64 endId() const { return m_firstId + m_size; }  // One past the newest
+    qint64 size() const { return m_size; }
+    void clear();
+
+    // Whole chunks past maxRecords; dropOldest() removes exactly these
+    qint64 excess() const;
+    void dropOldest();
+
+    qint64 timestamp(qint64 id) const;
+    LogLevel level(qint64 id) const;
+    int component(qint64 id) const;
+    QString message(qint64 id) const;
+
+    int componentId(const QString &name) const;  // -1 if never seen
+    QStringList components() const { return m_componentNames; }
+
+    // Case-insensitive for ASCII, which is what log text is searched for
+    static QByteArray fold(const QString &text);
+    static QByteArray fold(QByteArray utf8);
+
+    // Ids at or after `from` that match, in order
+    void filter(const Filter &filter, QVector<qint64> *out, qint64 from = 0) const;
+    // Keeps only the ids that also match `filter`; for a filter that narrows
+    // the one `rows` came from
+    void refine(const Filter &filter, QVector<qint64> *rows) const;
+    bool matches(qint64 id, const Filter &filter) const;
+
+private:
+    struct Chunk {
+        QVector<qint64> timestamps;
+        QVector<quint32> offsets;  // Line starts in text, plus the end
+        QVector<quint8> levels;
+        QVector<quint8> components;
+        QByteArray text;    // UTF-8, each line followed by '\n'
+        QByteArray folded;  // Same length; lowercased, line breaks inside messages as spaces
+        quint8 levelMask = 0;
+        quint64 componentMask = 0;  // Bit 63 also stands for ids above 63
+
+        int count() const { return levels.size(); }
+    };
+
+    std::vector<std::unique_ptr<Chunk>> m_chunks;
+    qint64 m_firstId = 0;
+    qint64 m_size = 0;
+    qint64 m_maxRecords;
+    QHash<const char *, int> m_componentByPointer;  // Components are string literals
+    QHash<QString, int> m_componentByName;
+    QStringList m_componentNames;
+
+    int intern(const char *component);
+    const Chunk &chunkOf(qint64 id, int *line) const;
+    static bool lineMatches(const Chunk &chunk, int line, const Filter &filter, const QByteArrayMatcher *matcher);
+    static quint8 levelBits(LogLevel minLevel) { return quint8(0xF << int(minLevel)) & 0xF; }
+    static quint64 componentBit(int component) { return quint64(1) << qMin(component, 63); }
+};
+
+#endif // LOGSTORE_H
@@ -0,0 +1,256 @@
+#include "Logger.h"
+#include <QDateTime>
+#include <QDeadlineTimer>
+#include <QDir>
+#include <QGlobalStatic>
+#include <QStringList>
+#include <QThread>
+#include <cstdlib>
+
+Q_GLOBAL_STATIC(Logger, s_logger)
+
+QAtomicInt Logger::s_level(int(LogLevel::Info));
+
+namespace {
+const int kBatchSize = 1024;
+const int kIdleWaitMs = 20;  // Writer poll period when nobody wakes it
+
+void messageHandler(QtMsgType type, const QMessageLogContext &, const QString &msg) {
+    LogLevel level = LogLevel::Error;
+    switch (type) {
+    case QtDebugMsg: level = LogLevel::Debug; break;
+    case QtInfoMsg: level = LogLevel::Info; break;
+    case QtWarningMsg: level = LogLevel::Warning; break;
+    case QtCriticalMsg:
+    case QtFatalMsg: level = LogLevel::Error; break;
+    }
+    TPN_LOG(level, "Qt", msg);
+    if (type == QtFatalMsg) {
+        Logger::instance().flush();
+        std::abort();
+    }
+}
+}
+
+Logger &Logger::instance() {
+    return *s_logger;
+}
+
+const char *Logger::levelName(LogLevel level) {
+    switch (level) {
+    case LogLevel::Debug: return "DEBUG";
+    case LogLevel::Info: return "INFO";
+    case LogLevel::Warning: return "WARN";
+    case LogLevel::Error: return "ERROR";
+    }
+    return "?";
+}
+
+bool Logger::parseLevel(const QString &name, LogLevel *out) {
+    const QString lower = name.trimmed().toLower();
+    if (lower == "debug") *out = LogLevel::Debug;
+    else if (lower == "info") *out = LogLevel::Info;
+    else if (lower == "warning" || lower == "warn") *out = LogLevel::Warning;
+    else if (lower == "error") *out = LogLevel::Error;
+    else return false;
+    return true;
+}
+
+void Logger::installMessageHandler() {
+    qInstallMessageHandler(messageHandler);
+}
+
+Logger::Logger()
+    : m_slots(new Slot[kCapacity])
+{
+    for (quint32 i = 0; i < kCapacity; ++i) m_slots[i].sequence.storeRelaxed(i);
+
+    LogLevel level;
+    if (parseLevel(qEnvironmentVariable("TPN_LOG_LEVEL"), &level)) setLevel(level);
+
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->setObjectName("Logger");
+    m_thread->start(QThread::LowPriority);
+}
+
+Logger::~Logger() {
+    shutdown();
+}
+
+void Logger::write(LogLevel level, const char *component, QString message) {
+    if (m_stopping.loadRelaxed()) {
+        m_dropped.fetchAndAddRelaxed(1);
+        return;
+    }
+
+    // Bounded MPSC ring: claim a slot by advancing the head, fill it, then
+    // publish it through its sequence number
+    quint32 pos = m_head.loadRelaxed();
+    Slot *slot;
+    for (;;) {
+        slot = &m_slots[pos & (kCapacity - 1)];
+        const qint32 diff = qint32(slot->sequence.loadAcquire() - pos);
+        if (diff == 0) {
+            if (m_head.testAndSetRelaxed(pos, pos + 1, pos)) break;
+        } else if (diff < 0) {
+            m_dropped.fetchAndAddRelaxed(1);  // Full: the writer is behind
+            return;
+        } else {
+            pos = m_head.loadRelaxed();
+        }
+    }
+    slot->record.timestampMs = QDateTime::currentMSecsSinceEpoch();
+    slot->record.level = level;
+    slot->record.component = component;
+    slot->record.message = std::move(message);
+    slot->sequence.storeRelease(pos + 1);
+
+    // Bursts wake the writer early instead of waiting out its poll period
+    if ((pos & (kCapacity / 4 - 1)) == 0) m_wake.wakeOne();
+}
+
+bool Logger::pop(LogRecord *out) {
+    Slot &slot = m_slots[m_tail & (kCapacity - 1)];
+    if (slot.sequence.loadAcquire() != m_tail + 1) return false;
+    *out = std::move(slot.record);
+    slot.record.message.clear();  // Don't keep the text alive until the slot is reused
+    slot.sequence.storeRelease(m_tail + kCapacity);
+    ++m_tail;
+    return true;
+}
+
+void Logger::run() {
+    QVector<LogRecord> batch;
+    batch.reserve(kBatchSize);
+    LogRecord record;
+    for (;;) {
+        while (batch.size() < kBatchSize && pop(&record)) batch.append(std::move(record));
+        if (batch.isEmpty()) {
+            QMutexLocker lock(&m_wakeMutex);
+            m_drained.wakeAll();
+            if (m_stopping.loadAcquire()) return;
+            m_wake.wait(&m_wakeMutex, kIdleWaitMs);
+            continue;
+        }
+
+        writeBatch(batch);
+        m_written.fetchAndAddRelease(quint64(batch.size()));
+        m_drained.wakeAll();
+
+        bool signal = false;
+        {
+            QMutexLocker lock(&m_uiMutex);
+            for (LogRecord &item : batch) m_uiPending.append(std::move(item));
+            if (m_uiPending.size() > kUiBacklog) {
+                const int excess = m_uiPending.size() - kUiBacklog;
+                m_uiPending.erase(m_uiPending.begin(), m_uiPending.begin() + excess);
+                m_uiSkipped += quint64(excess);
+                m_uiDropped.fetchAndAddRelaxed(quint64(excess));
+            }
+            signal = !m_uiSignaled;
+            m_uiSignaled = true;
+        }
+        if (signal) emit batchReady();  // Queued to the receivers' threads
+        batch.clear();
+    }
+}
+
+void Logger::writeBatch(const QVector<LogRecord> &batch) {
+    QMutexLocker lock(&m_fileMutex);
+    if (!m_file.isOpen()) return;
+
+    QByteArray out;
+    out.reserve(batch.size() * 96);
+    for (const LogRecord &record : batch) {
+        out += QDateTime::fromMSecsSinceEpoch(record.timestampMs).toString(Qt::ISODateWithMs).toLatin1();
+        out += ' ';
+        out += levelName(record.level);
+        out += " [";
+        out += record.component;
+        out += "] ";
+        out += record.message.toUtf8();
+        out += '\n';
+    }
+    m_file.write(out);
+    m_file.flush();
+    if (m_file.size() >= m_maxBytes) rotate();
+}
+
+void Logger::rotate() {
+    const QString base = m_file.fileName();
+    m_file.close();
+    QFile::remove(base + '.' + QString::number(m_keepFiles));
+    for (int i = m_keepFiles - 1; i >= 1; --i) {
+        QFile::rename(base + '.' + QString::number(i), base + '.' + QString::number(i + 1));
+    }
+    if (m_keepFiles > 0) QFile::rename(base, base + ".1");
+    m_file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+}
+
+void Logger::setFileOutput(const QString &directory, qint64 maxBytes, int keepFiles) {
+    QMutexLocker lock(&m_fileMutex);
+    m_file.close();
+    m_directory = directory;
+    m_maxBytes = maxBytes;
+    m_keepFiles = keepFiles;
+    if (directory.isEmpty()) return;
+    QDir().mkpath(directory);
+    m_file.setFileName(QDir(directory).absoluteFilePath("tpn.log"));
+    m_file.open(QIODevice::WriteOnly | QIODevice::Append);
+}
+
+bool Logger::flush(int timeoutMs) {
+    if (!m_thread) return false;
+    const quint32 target = m_head.loadAcquire();
+    QDeadlineTimer deadline(timeoutMs);
+    QMutexLocker lock(&m_wakeMutex);
+    while (qint32(quint32(m_written.loadAcquire()) - target) < 0) {
+        m_wake.wakeOne();
+        if (!m_drained.wait(&m_wakeMutex, deadline)) return false;
+    }
+    return true;
+}
+
+void Logger::shutdown() {
+    if (m_stopping.fetchAndStoreAcquire(1)) return;
+    m_wake.wakeOne();
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+    QMutexLocker lock(&m_fileMutex);
+    m_file.close();
+}
+
+int Logger::takeBatch(QVector<LogRecord> *out) {
+    QMutexLocker lock(&m_uiMutex);
+    int count = m_uiPending.size();
+
+    // Losses are reported where they happened, ahead of the records that
+    // survived them, so a gap in the view never looks like a quiet period
+    const quint64 dropped = m_dropped.loadRelaxed();
+    const quint64 ringLost = dropped - m_droppedShown;
+    if (ringLost || m_uiSkipped) {
+        LogRecord notice;
+        notice.timestampMs = m_uiPending.isEmpty() ? QDateTime::currentMSecsSinceEpoch()
+                                                   : m_uiPending.first().timestampMs;
+        notice.level = LogLevel::Warning;
+        notice.component = "Logger";
+        QStringList parts;
+        if (m_uiSkipped) parts.append(QString("%1 record(s) not shown here, the log file has them").arg(m_uiSkipped));
+        if (ringLost) parts.append(QString("%1 record(s) dropped under load").arg(ringLost));
+        notice.message = parts.join("; ") + '.';
+        out->append(std::move(notice));
+        m_droppedShown = dropped;
+        m_uiSkipped = 0;
+        ++count;
+    }
+
+    if (out->isEmpty()) {
+        out->swap(m_uiPending);  // Buffers trade places, neither side reallocates
+    } else {
+        for (LogRecord &record : m_uiPending) out->append(std::move(record));
+        m_uiPending.clear();
+    }
+    m_uiSignaled = false;
+    return count;
+}
@@ -0,0 +1,114 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <QObject>
+#include <QAtomicInteger>
+#include <QFile>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVector>
+#include <memory>
+
+class QThread;
+
+enum class LogLevel : int { Debug, Info, Warning, Error };
+
+// Records below this level are compiled out of TPN_LOG call sites
+#ifndef TPN_LOG_COMPILED_LEVEL
+#define TPN_LOG_COMPILED_LEVEL 0
+#endif
+
+// The message expression is only evaluated when the level is enabled
+#define TPN_LOG(level, component, message) \
+    do { if (Logger::isEnabled(level)) Logger::instance().write(level, component, message); } while (0)
+#define TPN_DEBUG(component, message) TPN_LOG(LogLevel::Debug, component, message)
+#define TPN_INFO(component, message) TPN_LOG(LogLevel::Info, component, message)
+#define TPN_WARNING(component, message) TPN_LOG(LogLevel::Warning, component, message)
+#define TPN_ERROR(component, message) TPN_LOG(LogLevel::Error, component, message)
+
+struct LogRecord {
+    qint64 timestampMs = 0;  // Unix ms
+    LogLevel level = LogLevel::Info;
+    const char *component = "";  // String literal, not copied
+    QString message;
+};
+
+// Process-wide log sink. Producers on any thread push records into a
+// bounded lock-free ring (a full ring drops and counts instead of blocking);
+// one writer thread drains it into rotating, size-capped files and hands
+// the records to the UI in batches. batchReady is emitted once per batch,
+// and takeBatch() collects everything delivered since the last call. If
+// records were lost on the way (ring full, or the UI fell more than
+// kUiBacklog behind) the batch starts with a warning saying how many.
+class Logger : public QObject {
+    Q_OBJECT
+public:
+    static Logger &instance();
+    static bool isEnabled(LogLevel level) {
+        return int(level) >= TPN_LOG_COMPILED_LEVEL && int(level) >= s_level.loadRelaxed();
+    }
+    static void setLevel(LogLevel level) { s_level.storeRelaxed(int(level)); }
+    static LogLevel level() { return LogLevel(s_level.loadRelaxed()); }
+    static const char *levelName(LogLevel level);
+    static bool parseLevel(const QString &name, LogLevel *out);
+    static void installMessageHandler();  // Routes qDebug/qWarning into the logger
+
+    Logger();
+    ~Logger();
+
+    void write(LogLevel level, const char *component, QString message);  // Any thread, never blocks
+    // <directory>/tpn.log, rotated to tpn.log.1 .. tpn.log.<keepFiles>
+    void setFileOutput(const QString &directory, qint64 maxBytes = 1024 * 1024, int keepFiles = 5);
+    bool flush(int timeoutMs = 1000);  // Waits until everything pushed so far is written
+    void shutdown();                   // Flushes and stops the writer; later records are dropped
+
+    int takeBatch(QVector<LogRecord> *out);  // Appends pending UI records, returns the count
+    quint64 dropped() const { return m_dropped.loadRelaxed(); }      // Never reached the file or the UI
+    quint64 uiDropped() const { return m_uiDropped.loadRelaxed(); }  // Written to the file, not to the UI
+    quint64 written() const { return m_written.loadRelaxed(); }
+
+signals:
+    void batchReady();
+
+private:
+    static const quint32 kCapacity = 8192;  // Power of two
+    static const int kUiBacklog = 5000;      // Oldest UI records are dropped past this
+    static QAtomicInt s_level;
+
+    struct Slot {
+        QAtomicInteger<quint32> sequence;
+        LogRecord record;
+    };
+
+    std::unique_ptr<Slot[]> m_slots;
+    QAtomicInteger<quint32> m_head;  // Next position to claim (producers)
+    quint32 m_tail = 0;              // Next position to read (writer thread)
+    QAtomicInteger<quint64> m_dropped;
+    QAtomicInteger<quint64> m_written;
+    QAtomicInt m_stopping;
+
+    QThread *m_thread = nullptr;
+    QMutex m_wakeMutex;
+    QWaitCondition m_wake;      // Writer idles here; flush() waits on m_drained
+    QWaitCondition m_drained;
+
+    QMutex m_fileMutex;
+    QFile m_file;
+    QString m_directory;
+    qint64 m_maxBytes = 0;
+    int m_keepFiles = 0;
+
+    QMutex m_uiMutex;
+    QVector<LogRecord> m_uiPending;
+    bool m_uiSignaled = false;
+    quint64 m_uiSkipped = 0;       // Trimmed since the last takeBatch()
+    quint64 m_droppedShown = 0;    // dropped() as of the last takeBatch()
+    QAtomicInteger<quint64> m_uiDropped;
+
+    bool pop(LogRecord *out);
+    void run();
+    void writeBatch(const QVector<LogRecord> &batch);
+    void rotate();
+};
+
+#endif // LOGGER_H
@@ -0,0 +1,371 @@
+#include "NetSocket.h"
+#include <cstring>
+#ifdef Q_OS_WIN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+socklen_t toSockaddr(const QHostAddress &address, quint16 port, sockaddr_storage *out) {
+    memset(out, 0, sizeof(*out));
+    if (address.protocol() == QAbstractSocket::IPv6Protocol) {
+        sockaddr_in6 *sin6 = reinterpret_cast<sockaddr_in6 *>(out);
+        sin6->sin6_family = AF_INET6;
+        sin6->sin6_port = htons(port);
+        const Q_IPV6ADDR raw = address.toIPv6Address();
+        memcpy(&sin6->sin6_addr, raw.c, 16);
+        return sizeof(sockaddr_in6);
+    }
+    sockaddr_in *sin = reinterpret_cast<sockaddr_in *>(out);
+    sin->sin_family = AF_INET;
+    sin->sin_port = htons(port);
+    sin->sin_addr.s_addr = htonl(address.toIPv4Address());
+    return sizeof(sockaddr_in);
+}
+
+void fromSockaddr(const sockaddr_storage &in, QHostAddress *address, quint16 *port) {
+    if (address) *address = QHostAddress(reinterpret_cast<const sockaddr *>(&in));
+    if (port) {
+        *port = in.ss_family == AF_INET6 ? ntohs(reinterpret_cast<const sockaddr_in6 *>(&in)->sin6_port)
+                                         : ntohs(reinterpret_cast<const sockaddr_in *>(&in)->sin_port);
+    }
+}
+
+int lastSocketError() {
+#ifdef Q_OS_WIN
+    return WSAGetLastError();
+#else
+    return errno;
+#endif
+}
+
+} // namespace
+
+bool NetSocket::startup() {
+#ifdef Q_OS_WIN
+    WSADATA wsaData;
+    return WSAStartup(MAKEWORD(2, 2), &wsaData) == 0;
+#else
+    return true;
+#endif
+}
+
+void NetSocket::cleanup() {
+#ifdef Q_OS_WIN
+    WSACleanup();
+#endif
+}
+
+NetSocket::NetSocket(NetSocket &&other) noexcept
+    : m_fd(other.m_fd)
+    , m_family(other.m_family)
+    , m_error(other.m_error)
+{
+    other.m_fd = kInvalid;
+}
+
+NetSocket &NetSocket::operator=(NetSocket &&other) noexcept {
+    if (this != &other) {
+        close();
+        m_fd = other.m_fd;
+        m_family = other.m_family;
+        m_error = other.m_error;
+        other.m_fd = kInvalid;
+    }
+    return *this;
+}
+
+NetSocket::~NetSocket() {
+    close();
+}
+
+void NetSocket::fail() {
+    m_error = lastSocketError();
+}
+
+bool NetSocket::open(Type type, QAbstractSocket::NetworkLayerProtocol family) {
+    close();
+    m_family = family == QAbstractSocket::IPv6Protocol ? AF_INET6 : AF_INET;
+    m_fd = Handle(::socket(m_family, type == Tcp ? SOCK_STREAM : SOCK_DGRAM, type == Tcp ? IPPROTO_TCP : IPPROTO_UDP));
+    if (m_fd == kInvalid) {
+        fail();
+        return false;
+    }
+#ifndef Q_OS_WIN
+    ::fcntl(m_fd, F_SETFD, FD_CLOEXEC);
+#endif
+    return true;
+}
+
+void NetSocket::close() {
+    if (m_fd == kInvalid) return;
+#ifdef Q_OS_WIN
+    ::closesocket(m_fd);
+#else
+    ::close(m_fd);
+#endif
+    m_fd = kInvalid;
+}
+
+void NetSocket::shutdown() {
+#ifdef Q_OS_WIN
+    if (m_fd != kInvalid) ::shutdown(m_fd, SD_BOTH);
+#else
+    if (m_fd != kInvalid) ::shutdown(m_fd, SHUT_RDWR);
+#endif
+}
+
+void NetSocket::shutdownWrite() {
+#ifdef Q_OS_WIN
+    if (m_fd != kInvalid) ::shutdown(m_fd, SD_SEND);
+#else
+    if (m_fd != kInvalid) ::shutdown(m_fd, SHUT_WR);
+#endif
+}
+
+bool NetSocket::bind(const QHostAddress &address, quint16 port) {
+    const int on = 1;
+    ::setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char *>(&on), sizeof(on));
+    sockaddr_storage storage;
+    const socklen_t length = toSockaddr(address, port, &storage);
+    if (::bind(m_fd, reinterpret_cast<const sockaddr *>(&storage), length) != 0) {
+        fail();
+        return false;
+    }
+    return true;
+}
+
+bool NetSocket::listen(int backlog) {
+    if (::listen(m_fd, backlog) != 0) {
+        fail();
+        return false;
+    }
+    return true;
+}
+
+NetSocket NetSocket::accept() {
+    NetSocket peer;
+    const Handle fd = Handle(::accept(m_fd, nullptr, nullptr));
+    if (fd == kInvalid) {
+        fail();
+        return peer;
+    }
+    peer.m_fd = fd;
+    peer.m_family = m_family;
+    return peer;
+}
+
+bool NetSocket::connect(const QHostAddress &address, quint16 port, int timeoutMs) {
+    sockaddr_storage storage;
+    const socklen_t length = toSockaddr(address, port, &storage);
+    // Non-blocking connect so an unreachable endpoint costs timeoutMs, not the OS default
+#ifdef Q_OS_WIN
+    u_long nonBlocking = 1;
+    ::ioctlsocket(m_fd, FIONBIO, &nonBlocking);
+    int rc = ::connect(m_fd, reinterpret_cast<const sockaddr *>(&storage), length);
+    if (rc != 0 && WSAGetLastError() == WSAEWOULDBLOCK) {
+        fd_set writable, failed;
+        FD_ZERO(&writable);
+        FD_ZERO(&failed);
+        FD_SET(m_fd, &writable);
+        FD_SET(m_fd, &failed);
+        timeval timeout = { timeoutMs / 1000, (timeoutMs % 1000) * 1000 };
+        rc = ::select(0, nullptr, &writable, &failed, &timeout) == 1 && FD_ISSET(m_fd, &writable) ? 0 : -1;
+    }
+    nonBlocking = 0;
+    ::ioctlsocket(m_fd, FIONBIO, &nonBlocking);
+#else
+    const int flags = ::fcntl(m_fd, F_GETFL);
+    ::fcntl(m_fd, F_SETFL, flags | O_NONBLOCK);
+    int rc = ::connect(m_fd, reinterpret_cast<const sockaddr *>(&storage), length);
+    if (rc != 0 && errno == EINPROGRESS) {
+        pollfd pfd = { m_fd, POLLOUT, 0 };
+        int error = 0;
+        socklen_t errorLength = sizeof(error);
+        rc = ::poll(&pfd, 1, timeoutMs) == 1
+                && ::getsockopt(m_fd, SOL_SOCKET, SO_ERROR, &error, &errorLength) == 0 && error == 0 ? 0 : -1;
+        if (rc != 0) errno = error ? error : ETIMEDOUT;
+    }
+    ::fcntl(m_fd, F_SETFL, flags);
+#endif
+    if (rc != 0) {
+        fail();
+        return false;
+    }
+    return true;
+}
+
+quint16 NetSocket::localPort() const {
+    sockaddr_storage storage;
+    socklen_t length = sizeof(storage);
+    if (::getsockname(m_fd, reinterpret_cast<sockaddr *>(&storage), &length) != 0) return 0;
+    quint16 port = 0;
+    fromSockaddr(storage, nullptr, &port);
+    return port;
+}
+
+bool NetSocket::waitReadable(int timeoutMs) {
+#ifdef Q_OS_WIN
+    fd_set readable;
+    FD_ZERO(&readable);
+    FD_SET(m_fd, &readable);
+    timeval timeout = { timeoutMs / 1000, (timeoutMs % 1000) * 1000 };
+    const int rc = ::select(0, &readable, nullptr, nullptr, &timeout);
+#else
+    pollfd pfd = { m_fd, POLLIN, 0 };
+    const int rc = ::poll(&pfd, 1, timeoutMs);
+#endif
+    if (rc < 0) fail();
+    return rc > 0;
+}
+
+void NetSocket::setTimeout(int ms) {
+#ifdef Q_OS_WIN
+    const DWORD timeout = DWORD(ms);
+#else
+    const timeval timeout = { ms / 1000, (ms % 1000) * 1000 };
+#endif
+    ::setsockopt(m_fd, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char *>(&timeout), sizeof(timeout));
+    ::setsockopt(m_fd, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char *>(&timeout), sizeof(timeout));
+}
+
+void NetSocket::setBufferSizes(int bytes) {
+    ::setsockopt(m_fd, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char *>(&bytes), sizeof(bytes));
+    ::setsockopt(m_fd, SOL_SOCKET, SO_SNDBUF, reinterpret_cast<const char *>(&bytes), sizeof(bytes));
+}
+
+void NetSocket::setNoDelay(bool on) {
+    const int value = on ? 1 : 0;
+    ::setsockopt(m_fd, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+bool NetSocket::setDontFragment(bool on) {
+    int rc;
+#ifdef Q_OS_WIN
+    const DWORD value = on ? 1 : 0;
+    rc = m_family == AF_INET6
+            ? ::setsockopt(m_fd, IPPROTO_IPV6, IPV6_DONTFRAG, reinterpret_cast<const char *>(&value), sizeof(value))
+            : ::setsockopt(m_fd, IPPROTO_IP, IP_DONTFRAGMENT, reinterpret_cast<const char *>(&value), sizeof(value));
+#elif defined(IP_MTU_DISCOVER)
+    // PROBE: DF on every datagram, and oversized sends fail instead of being
+    // clamped to a cached path MTU
+    const int value = m_family == AF_INET6 ? (on ? IPV6_PMTUDISC_PROBE : IPV6_PMTUDISC_DONT)
+                                           : (on ? IP_PMTUDISC_PROBE : IP_PMTUDISC_DONT);
+    rc = m_family == AF_INET6
+            ? ::setsockopt(m_fd, IPPROTO_IPV6, IPV6_MTU_DISCOVER, &value, sizeof(value))
+            : ::setsockopt(m_fd, IPPROTO_IP, IP_MTU_DISCOVER, &value, sizeof(value));
+#elif defined(IP_DONTFRAG)
+    const int value = on ? 1 : 0;
+    rc = m_family == AF_INET6 ? ::setsockopt(m_fd, IPPROTO_IPV6, IPV6_DONTFRAG, &value, sizeof(value))
+                              : ::setsockopt(m_fd, IPPROTO_IP, IP_DONTFRAG, &value, sizeof(value));
+#else
+    Q_UNUSED(on);
+    rc = -1;
+#endif
+    if (rc != 0) fail();
+    return rc == 0;
+}
+
+qint64 NetSocket::send(const char *data, qint64 size) {
+    qint64 sent = 0;
+    while (sent < size) {
+        const int chunk = int(qMin<qint64>(size - sent, 1 << 30));
+#ifdef Q_OS_WIN
+        const int n = ::send(m_fd, data + sent, chunk, 0);
+#else
+        const ssize_t n = ::send(m_fd, data + sent, size_t(chunk), MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+#endif
+        if (n <= 0) {
+            fail();
+            return -1;
+        }
+        sent += n;
+    }
+    return sent;
+}
+
+qint64 NetSocket::recv(char *data, qint64 size) {
+    for (;;) {
+        const int chunk = int(qMin<qint64>(size, 1 << 30));
+#ifdef Q_OS_WIN
+        const int n = ::recv(m_fd, data, chunk, 0);
+#else
+        const ssize_t n = ::recv(m_fd, data, size_t(chunk), 0);
+        if (n < 0 && errno == EINTR) continue;
+#endif
+        if (n < 0) fail();
+        return n;
+    }
+}
+
+bool NetSocket::recvAll(char *data, qint64 size) {
+    qint64 received = 0;
+    while (received < size) {
+        const qint64 n = recv(data + received, size - received);
+        if (n <= 0) return false;
+        received += n;
+    }
+    return true;
+}
+
+qint64 NetSocket::sendTo(const char *data, qint64 size, const QHostAddress &address, quint16 port) {
+    sockaddr_storage storage;
+    const socklen_t length = toSockaddr(address, port, &storage);
+    for (;;) {
+#ifdef Q_OS_WIN
+        const int n = ::sendto(m_fd, data, int(size), 0, reinterpret_cast<const sockaddr *>(&storage), length);
+#else
+        const ssize_t n = ::sendto(m_fd, data, size_t(size), 0, reinterpret_cast<const sockaddr *>(&storage), length);
+        if (n < 0 && errno == EINTR) continue;
+#endif
+        if (n < 0) fail();
+        return n;
+    }
+}
+
+qint64 NetSocket::recvFrom(char *data, qint64 size, QHostAddress *address, quint16 *port) {
+    sockaddr_storage storage;
+    for (;;) {
+        socklen_t length = sizeof(storage);
+#ifdef Q_OS_WIN
+        const int n = ::recvfrom(m_fd, data, int(size), 0, reinterpret_cast<sockaddr *>(&storage), &length);
+#else
+        const ssize_t n = ::recvfrom(m_fd, data, size_t(size), 0, reinterpret_cast<sockaddr *>(&storage), &length);
+        if (n < 0 && errno == EINTR) continue;
+#endif
+        if (n < 0) {
+            fail();
+            return n;
+        }
+        fromSockaddr(storage, address, port);
+        return n;
+    }
+}
+
+bool NetSocket::timedOut() const {
+#ifdef Q_OS_WIN
+    return m_error == WSAETIMEDOUT;
+#else
+    return m_error == EAGAIN || m_error == EWOULDBLOCK || m_error == ETIMEDOUT;
+#endif
+}
+
+bool NetSocket::messageTooLarge() const {
+#ifdef Q_OS_WIN
+    return m_error == WSAEMSGSIZE;
+#else
+    return m_error == EMSGSIZE;
+#endif
+}
@@ -0,0 +1,69 @@
+#ifndef NETSOCKET_H
+#define NETSOCKET_H
+
+#include <QHostAddress>
+#include <QtGlobal>
+
+// Thin blocking wrapper over a native TCP or UDP socket for code that runs
+// on its own thread and moves a lot of bytes: send() and recv() go straight
+// between the caller's buffer and the kernel, with none of QAbstractSocket's
+// internal buffering or event loop. Timeouts bound every blocking call.
+// Move-only; the socket is closed on destruction.
+class NetSocket {
+public:
+    enum Type { Tcp, Udp };
+
+    NetSocket() = default;
+    NetSocket(NetSocket &&other) noexcept;
+    NetSocket &operator=(NetSocket &&other) noexcept;
+    NetSocket(const NetSocket &) = delete;
+    NetSocket &operator=(const NetSocket &) = delete;
+    ~NetSocket();
+
+    static bool startup();  // Winsock; harmless to call repeatedly
+    static void cleanup();
+
+    bool open(Type type, QAbstractSocket::NetworkLayerProtocol family);
+    bool isValid() const { return m_fd != kInvalid; }
+    void close();
+    void shutdown();        // Both directions; wakes a thread blocked in accept/recv
+    void shutdownWrite();   // TCP: the peer reads end of stream
+
+    bool bind(const QHostAddress &address, quint16 port);
+    bool listen(int backlog = 16);
+    NetSocket accept();  // Invalid on error or shutdown
+    bool connect(const QHostAddress &address, quint16 port, int timeoutMs);
+    quint16 localPort() const;
+    bool waitReadable(int timeoutMs);  // Data, a connection or end of stream is pending
+
+    void setTimeout(int ms);          // Receive and send, 0 = block indefinitely
+    void setBufferSizes(int bytes);   // SO_RCVBUF / SO_SNDBUF
+    void setNoDelay(bool on);         // TCP
+    bool setDontFragment(bool on);    // UDP: DF set, no local fragmentation
+
+    qint64 send(const char *data, qint64 size);  // All of it, or -1
+    qint64 recv(char *data, qint64 size);        // What one read returns; 0 = closed, -1 = error/timeout
+    bool recvAll(char *data, qint64 size);
+    qint64 sendTo(const char *data, qint64 size, const QHostAddress &address, quint16 port);
+    qint64 recvFrom(char *data, qint64 size, QHostAddress *address = nullptr, quint16 *port = nullptr);
+
+    int lastError() const { return m_error; }  // errno / WSAGetLastError of the last failure
+    bool timedOut() const;
+    bool messageTooLarge() const;  // EMSGSIZE: a DF datagram above the known path MTU
+
+private:
+#ifdef Q_OS_WIN
+    typedef quintptr Handle;
+    static const Handle kInvalid = ~Handle(0);
+#else
+    typedef int Handle;
+    static const Handle kInvalid = -1;
+#endif
+    Handle m_fd = kInvalid;
+    int m_family = 0;
+    int m_error = 0;
+
+    void fail();
+};
+
+#endif // NETSOCKET_H
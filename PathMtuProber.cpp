@@ -0,0 +1,248 @@
+#include "PathMtuProber.h"
+#include "NetSocket.h"
+#include "SelfTestServer.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QNetworkInterface>
+#include <QScopeGuard>
+#include <QSettings>
+#include <QThread>
+#include <QUrl>
+#include <QtEndian>
+#include <algorithm>
+
+namespace {
+const int kUdpHeader = 8;
+const int kWireGuardOverhead = 32;  // Data message header and auth tag
+const int kMinProbeTimeoutMs = 30;
+const int kMaxPayload = 65507;
+
+int ipHeader(QAbstractSocket::NetworkLayerProtocol family) {
+    return family == QAbstractSocket::IPv6Protocol ? 40 : 20;
+}
+}
+
+int PathMtuProber::pathMtu(int payload, QAbstractSocket::NetworkLayerProtocol family) {
+    return payload + kUdpHeader + ipHeader(family);
+}
+
+int PathMtuProber::tunnelMtu(int payload) {
+    // Inner packets are padded to a multiple of 16 before encryption
+    return qMax(0, (payload - kWireGuardOverhead) / 16 * 16);
+}
+
+QString PathMtuProber::networkId(const QStringList &ignoredInterfaces) {
+    QStringList parts;
+    for (const QNetworkInterface &iface : QNetworkInterface::allInterfaces()) {
+        const QNetworkInterface::InterfaceFlags flags = iface.flags();
+        if (!(flags & QNetworkInterface::IsUp) || !(flags & QNetworkInterface::IsRunning)
+                || (flags & QNetworkInterface::IsLoopBack) || (flags & QNetworkInterface::IsPointToPoint)) {
+            continue;
+        }
+        if (ignoredInterfaces.contains(iface.humanReadableName()) || ignoredInterfaces.contains(iface.name())) continue;
+        for (const QNetworkAddressEntry &entry : iface.addressEntries()) {
+            const QHostAddress ip = entry.ip();
+            if (ip.isLinkLocal() || entry.prefixLength() <= 0) continue;
+            const QPair<QHostAddress, int> subnet = QHostAddress::parseSubnet(ip.toString() + '/' + QString::number(entry.prefixLength()));
+            parts.append(iface.hardwareAddress() + ' ' + subnet.first.toString() + '/' + QString::number(subnet.second));
+        }
+    }
+    if (parts.isEmpty()) return "none";
+    parts.sort();
+    return QString::fromLatin1(QCryptographicHash::hash(parts.join('\n').toUtf8(), QCryptographicHash::Sha1).toHex().left(16));
+}
+
+PathMtuProber::PathMtuProber(QObject *parent) : QObject(parent) {
+    qRegisterMetaType<PathMtuProber::Result>();
+}
+
+PathMtuProber::~PathMtuProber() {
+    if (!m_thread) return;
+    cancel();
+    m_thread->wait();
+    delete m_thread;
+}
+
+QString PathMtuProber::cacheKey(const QString &network, const QHostAddress &target, quint16 port) {
+    const QString endpoint = target.toString() + '/' + QString::number(port);
+    return "PathMtu/" + network + '/' + QString::fromLatin1(QUrl::toPercentEncoding(endpoint));
+}
+
+bool PathMtuProber::lookup(const QString &network, const QHostAddress &target, quint16 port, Result *out) const {
+    if (!m_settings) return false;
+    const QVariantMap entry = m_settings->value(cacheKey(network, target, port)).toMap();
+    const int payload = entry.value("payload").toInt();
+    const qint64 probedMs = entry.value("probed_ms").toLongLong();
+    if (payload <= 0 || QDateTime::currentMSecsSinceEpoch() - probedMs > m_cacheLifetimeMs) return false;
+
+    Result result;
+    result.ok = true;
+    result.cached = true;
+    result.target = target;
+    result.port = port;
+    result.payload = payload;
+    result.pathMtu = pathMtu(payload, target.protocol());
+    result.tunnelMtu = tunnelMtu(payload);
+    result.probedMs = probedMs;
+    *out = result;
+    return true;
+}
+
+void PathMtuProber::store(const QString &network, const Result &result) {
+    const QString key = cacheKey(network, result.target, result.port);
+    if (!result.ok) {
+        m_failures.insert(key, result);
+        return;
+    }
+    m_failures.remove(key);
+    if (!m_settings) return;
+    QVariantMap entry;
+    entry["payload"] = result.payload;
+    entry["probed_ms"] = result.probedMs;
+    m_settings->setValue(key, entry);
+}
+
+void PathMtuProber::invalidate(const QString &network, const QHostAddress &target, quint16 port) {
+    if (m_settings) m_settings->remove(cacheKey(network, target, port));
+}
+
+void PathMtuProber::cancel() {
+    m_cancel.storeRelaxed(1);
+}
+
+bool PathMtuProber::start(const QString &network, const Options &options, bool force) {
+    if (m_thread) return false;
+    Result cached;
+    if (!force && lookup(network, options.target, options.port, &cached)) {
+        QMetaObject::invokeMethod(this, [this, cached]() { emit finished(cached); }, Qt::QueuedConnection);
+        return true;
+    }
+    const auto failure = m_failures.constFind(cacheKey(network, options.target, options.port));
+    if (failure != m_failures.constEnd()
+            && QDateTime::currentMSecsSinceEpoch() - failure->probedMs < m_failureLifetimeMs) {
+        cached = *failure;
+        cached.cached = true;
+        cached.probes = 0;
+        cached.elapsedMs = 0;
+        QMetaObject::invokeMethod(this, [this, cached]() { emit finished(cached); }, Qt::QueuedConnection);
+        return true;
+    }
+
+    Options probe = options;
+    if (m_echoPort) probe.port = m_echoPort;
+    const quint16 endpointPort = options.port;
+    m_cancel.storeRelaxed(0);
+    m_thread = QThread::create([this, probe, network, endpointPort]() {
+        Result result = run(probe, &m_cancel);
+        result.port = endpointPort;  // Cached and reported under the endpoint
+        const bool cancelled = m_cancel.loadRelaxed();
+        QMetaObject::invokeMethod(this, [this, result, network, cancelled]() {
+            m_thread->wait();
+            delete m_thread;
+            m_thread = nullptr;
+            if (!cancelled) store(network, result);
+            emit finished(result);
+        }, Qt::QueuedConnection);
+    });
+    m_thread->setObjectName("PathMtuProber");
+    m_thread->start();
+    return true;
+}
+
+PathMtuProber::Result PathMtuProber::run(const Options &options, const QAtomicInt *cancel) {
+    QElapsedTimer elapsed;
+    elapsed.start();
+    Result result;
+    result.target = options.target;
+    result.port = options.port;
+    const QAbstractSocket::NetworkLayerProtocol family = options.target.protocol();
+    const int headers = kUdpHeader + ipHeader(family);
+    const int minPayload = options.minPayload > 0 ? options.minPayload
+                                                  : (family == QAbstractSocket::IPv6Protocol ? 1280 : 576) - headers;
+    const int maxPayload = qBound(minPayload, options.maxPayload > 0 ? options.maxPayload : 1500 - headers, kMaxPayload);
+    auto finish = [&result, &elapsed]() {
+        result.elapsedMs = elapsed.elapsed();
+        result.probedMs = QDateTime::currentMSecsSinceEpoch();
+        return result;
+    };
+
+    NetSocket::startup();
+    const auto cleanup = qScopeGuard([]() { NetSocket::cleanup(); });
+    NetSocket socket;
+    if (options.target.isNull() || !options.port || !socket.open(NetSocket::Udp, family)
+            || (!options.bindAddress.isNull() && !socket.bind(options.bindAddress, 0))) {
+        result.error = QString("Could not open a probe socket (error %1).").arg(socket.lastError());
+        return finish();
+    }
+    // Without DF routers would fragment the probes and every size would fit
+    if (!socket.setDontFragment(true)) {
+        result.error = QString("Don't-fragment is not supported here (error %1).").arg(socket.lastError());
+        return finish();
+    }
+
+    QByteArray probe(maxPayload, '\0');
+    QByteArray reply(kMaxPayload, '\0');
+    probe[0] = SelfTestServer::UdpEcho;
+    quint32 sequence = 0;
+    int timeoutMs = qMax(kMinProbeTimeoutMs, options.timeoutMs);
+    QElapsedTimer clock;
+
+    // 1 = answered, 0 = too big (or lost every time), -1 = cancelled
+    auto fits = [&](int size) {
+        for (int attempt = 0; attempt < qMax(1, options.attempts); ++attempt) {
+            if (cancel && cancel->loadRelaxed()) return -1;
+            qToLittleEndian(++sequence, probe.data() + 1);
+            result.probes++;
+            clock.start();
+            if (socket.sendTo(probe.constData(), size, options.target, options.port) != size) {
+                if (socket.messageTooLarge()) return 0;  // Above an MTU the stack already knows
+                continue;
+            }
+            for (;;) {
+                const int remaining = timeoutMs - int(clock.elapsed());
+                if (remaining <= 0 || !socket.waitReadable(remaining)) break;
+                const qint64 n = socket.recvFrom(reply.data(), reply.size());
+                if (n != size || reply.at(0) != SelfTestServer::UdpEcho
+                        || qFromLittleEndian<quint32>(reply.constData() + 1) != sequence) {
+                    continue;  // Late answer to an earlier probe
+                }
+                // A few RTTs is plenty once the responder is known to answer
+                const int rttMs = int(clock.elapsed());
+                timeoutMs = qBound(kMinProbeTimeoutMs, rttMs * 4 + 20, options.timeoutMs);
+                return 1;
+            }
+        }
+        return 0;
+    };
+
+    int verdict = fits(maxPayload);
+    if (verdict > 0) {
+        result.payload = maxPayload;
+    } else if (verdict == 0) {
+        verdict = maxPayload > minPayload ? fits(minPayload) : 0;
+        if (verdict == 0) {
+            result.error = "No probe answered; is an echo responder running at the endpoint?";
+            return finish();
+        }
+        // Largest size known to fit, smallest known not to
+        int good = minPayload;
+        int bad = maxPayload;
+        while (verdict >= 0 && bad - good > 1) {
+            const int middle = good + (bad - good) / 2;
+            verdict = fits(middle);
+            if (verdict > 0) good = middle;
+            else if (verdict == 0) bad = middle;
+        }
+        result.payload = good;
+    }
+    if (verdict < 0) {
+        result.error = "Cancelled.";
+        return finish();
+    }
+
+    result.ok = true;
+    result.pathMtu = pathMtu(result.payload, family);
+    result.tunnelMtu = tunnelMtu(result.payload);
+    return finish();
+}
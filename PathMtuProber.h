@@ -0,0 +1,95 @@
+#ifndef PATHMTUPROBER_H
+#define PATHMTUPROBER_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QHash>
+#include <QHostAddress>
+#include <QStringList>
+
+class QSettings;
+class QThread;
+
+// Finds the largest UDP payload that reaches a peer endpoint unfragmented:
+// echo probes with DF set, full Ethernet size first (the common case costs
+// one round trip), then a binary search between the family minimum and the
+// largest failing size. Once a probe is answered the per-probe timeout drops
+// to a few RTTs. The tunnel MTU follows from the payload: WireGuard adds 32
+// bytes and pads the inner packet to 16. Like LatencyProber, the endpoint is
+// expected to run an echo responder (SelfTestServer answers these) on its
+// port or on setEchoPort(). Results are cached per network and endpoint in
+// the settings; a failed probe is remembered in memory for a while so an
+// endpoint without a responder is not probed again on every connect.
+// Probing runs on its own thread.
+class PathMtuProber : public QObject {
+    Q_OBJECT
+public:
+    struct Options {
+        QHostAddress target;        // Peer endpoint
+        quint16 port = 0;
+        QHostAddress bindAddress;   // Null = let routing decide
+        int minPayload = 0;         // 0 = the family's minimum MTU (576 / 1280) less headers
+        int maxPayload = 0;         // 0 = Ethernet (1500) less headers
+        int attempts = 3;           // Unanswered probes before a size counts as too big
+        int timeoutMs = 500;        // Per probe, until an answer gives an RTT
+    };
+    struct Result {
+        bool ok = false;
+        bool cached = false;
+        QString error;
+        QHostAddress target;
+        quint16 port = 0;           // Endpoint port, not the echo port
+        int payload = 0;            // Largest UDP payload that got through
+        int pathMtu = 0;            // payload plus UDP and IP headers
+        int tunnelMtu = 0;
+        int probes = 0;
+        qint64 elapsedMs = 0;
+        qint64 probedMs = 0;        // Unix ms of the measurement
+    };
+
+    static int pathMtu(int payload, QAbstractSocket::NetworkLayerProtocol family);
+    static int tunnelMtu(int payload);
+    // Stable id of the attached networks (hardware addresses and subnets of
+    // the interfaces that are up); the tunnel's own adapter goes in ignored
+    static QString networkId(const QStringList &ignoredInterfaces = QStringList());
+
+    explicit PathMtuProber(QObject *parent = nullptr);
+    ~PathMtuProber();  // Cancels and waits for a running probe
+
+    void setSettings(QSettings *settings) { m_settings = settings; }  // Cache; not owned
+    void setCacheLifetime(qint64 ms) { m_cacheLifetimeMs = ms; }
+    void setEchoPort(quint16 port) { m_echoPort = port; }  // 0 = endpoint port
+    quint16 echoPort() const { return m_echoPort; }
+    void setFailureLifetime(qint64 ms) { m_failureLifetimeMs = ms; }
+
+    bool lookup(const QString &network, const QHostAddress &target, quint16 port, Result *out) const;
+    void invalidate(const QString &network, const QHostAddress &target, quint16 port);
+    // Answers from the cache when it can (still through finished), otherwise
+    // probes; false if a probe is already running. A recent failure for the
+    // endpoint is answered again (cached, not ok) even when forced
+    bool start(const QString &network, const Options &options, bool force = false);
+    void cancel();
+    bool isRunning() const { return m_thread != nullptr; }
+
+    // Blocking, ignores the cache and the echo port
+    static Result run(const Options &options, const QAtomicInt *cancel = nullptr);
+
+signals:
+    void finished(const PathMtuProber::Result &result);
+
+private:
+    QSettings *m_settings = nullptr;
+    qint64 m_cacheLifetimeMs = 7LL * 24 * 3600 * 1000;
+    quint16 m_echoPort = 0;
+    qint64 m_failureLifetimeMs = 30LL * 60 * 1000;
+    QHash<QString, Result> m_failures;  // By cache key; probedMs says when
+    QThread *m_thread = nullptr;
+    QAtomicInt m_cancel;
+
+    void store(const QString &network, const Result &result);
+    static QString cacheKey(const QString &network, const QHostAddress &target, quint16 port);
+};
+
+Q_DECLARE_METATYPE(PathMtuProber::Result)
+
+#endif // PATHMTUPROBER_H
@@ -0,0 +1,37 @@
+#include "ProcessInfo.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QList>
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+QElapsedTimer s_start;
+}
+
+void ProcessInfo::markStart() {
+    s_start.start();
+}
+
+qint64 ProcessInfo::sinceStartMs() {
+    return s_start.isValid() ? s_start.elapsed() : 0;
+}
+
+qint64 ProcessInfo::residentKb() {
+#ifdef Q_OS_WIN
+    PROCESS_MEMORY_COUNTERS counters = {};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return qint64(counters.WorkingSetSize / 1024);
+    }
+    return 0;
+#else
+    QFile statm("/proc/self/statm");
+    if (!statm.open(QIODevice::ReadOnly)) return 0;
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    return fields.size() > 1 ? fields[1].toLongLong() * (sysconf(_SC_PAGESIZE) / 1024) : 0;
+#endif
+}
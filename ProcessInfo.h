@@ -0,0 +1,15 @@
+#ifndef PROCESSINFO_H
+#define PROCESSINFO_H
+
+#include <QtGlobal>
+
+// Startup time and memory footprint, reported by both the GUI and the
+// headless service so the two modes can be compared.
+class ProcessInfo {
+public:
+    static void markStart();      // First thing in main()
+    static qint64 sinceStartMs();
+    static qint64 residentKb();   // Working set / RSS, 0 if unavailable
+};
+
+#endif // PROCESSINFO_H
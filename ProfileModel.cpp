@@ -0,0 +1,63 @@
+#include "ProfileModel.h"
+#include "ProfileStore.h"
+
+namespace {
+const int kFetchBatch = 100;
+}
+
+ProfileModel::ProfileModel(ProfileStore *store, QObject *parent)
+    : QAbstractTableModel(parent)
+    , m_store(store)
+{
+    connect(m_store, &ProfileStore::profilesChanged, this, &ProfileModel::onProfilesChanged);
+}
+
+int ProfileModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : m_loaded;
+}
+
+int ProfileModel::columnCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant ProfileModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || index.row() >= m_loaded) return QVariant();
+    if (role != Qt::DisplayRole && role != Qt::ToolTipRole) return QVariant();
+
+    const ProfileStore::Profile &profile = m_store->profile(index.row());
+    if (role == Qt::ToolTipRole) return profile.path;
+    if (index.column() == NameColumn) return profile.name;
+
+    int peers = 0;
+    QString endpoint = m_store->endpointSummary(index.row(), &peers);
+    return peers > 1 ? QString("%1 (+%2)").arg(endpoint).arg(peers - 1) : endpoint;
+}
+
+QVariant ProfileModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) return QVariant();
+    return section == NameColumn ? QString("Configs") : QString("Endpoint");
+}
+
+bool ProfileModel::canFetchMore(const QModelIndex &parent) const {
+    return !parent.isValid() && m_loaded < m_store->count();
+}
+
+void ProfileModel::fetchMore(const QModelIndex &parent) {
+    if (parent.isValid()) return;
+    const int more = qMin(kFetchBatch, m_store->count() - m_loaded);
+    if (more <= 0) return;
+    beginInsertRows(QModelIndex(), m_loaded, m_loaded + more - 1);
+    m_loaded += more;
+    endInsertRows();
+}
+
+QString ProfileModel::profileName(const QModelIndex &index) const {
+    if (!index.isValid() || index.row() >= m_loaded) return QString();
+    return m_store->profile(index.row()).name;
+}
+
+void ProfileModel::onProfilesChanged() {
+    beginResetModel();
+    m_loaded = 0;
+    endResetModel();
+}
@@ -0,0 +1,36 @@
+#ifndef PROFILEMODEL_H
+#define PROFILEMODEL_H
+
+#include <QAbstractTableModel>
+
+class ProfileStore;
+
+// Flat model over ProfileStore for the Configs tree. Rows are exposed in
+// batches through canFetchMore/fetchMore, and with uniform row heights the
+// view only asks for the rows it paints, so only those get their summary
+// decoded.
+class ProfileModel : public QAbstractTableModel {
+    Q_OBJECT
+public:
+    enum Column { NameColumn, EndpointColumn, ColumnCount };
+
+    explicit ProfileModel(ProfileStore *store, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+    QString profileName(const QModelIndex &index) const;
+
+private slots:
+    void onProfilesChanged();
+
+private:
+    ProfileStore *m_store;
+    int m_loaded = 0;
+};
+
+#endif // PROFILEMODEL_H
@@ -0,0 +1,554 @@
+#include "ProfileStore.h"
+#include "ConfigParser.h"
+#include "Logger.h"
+#include "Tracer.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QHash>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QScopeGuard>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+
+namespace {
+
+// Cache file layout (native little-endian):
+//   CacheHeader, CacheEntry[count], then UTF-8 paths and encoded configs
+struct CacheHeader {
+    char magic[4];
+    quint32 version;
+    quint32 count;
+    quint32 reserved;
+};
+
+struct CacheEntry {
+    quint32 pathOffset;
+    quint32 pathBytes;
+    qint64 size;
+    qint64 mtimeMs;
+    quint8 sha1[20];
+    quint32 blobOffset;
+    quint32 blobBytes;
+    quint8 reserved[12];
+};
+
+static_assert(sizeof(CacheHeader) == 16, "cache header layout");
+static_assert(sizeof(CacheEntry) == 64, "cache entry layout");
+
+const char kMagic[4] = { 'T', 'P', 'N', 'P' };
+const quint32 kVersion = 3;  // 2: AllowedIPs stored aggregated, 3: AllowedDomains
+const int kMaxNameChars = 128;  // Leaves room for the directory in MAX_PATH
+
+void writePrefixes(QDataStream &out, const QVector<IpPrefix> &prefixes) {
+    out << quint32(prefixes.size());
+    for (const IpPrefix &prefix : prefixes) {
+        out << prefix.family << prefix.cidr;
+        out.writeRawData(reinterpret_cast<const char *>(prefix.addr), 16);
+    }
+}
+
+bool readPrefixes(QDataStream &in, QVector<IpPrefix> *prefixes) {
+    quint32 n = 0;
+    in >> n;
+    if (in.status() != QDataStream::Ok) return false;
+    prefixes->resize(int(n));
+    for (IpPrefix &prefix : *prefixes) {
+        in >> prefix.family >> prefix.cidr;
+        if (in.readRawData(reinterpret_cast<char *>(prefix.addr), 16) != 16) return false;
+    }
+    return in.status() == QDataStream::Ok;
+}
+
+// Keys are stored as 32 raw bytes; an unset one as zeros
+void writeSecret(QDataStream &out, const SecretBuffer &key) {
+    if (key.size() == 32) {
+        out.writeRawData(reinterpret_cast<const char *>(key.constData()), 32);
+    } else {
+        const char zeros[32] = {};
+        out.writeRawData(zeros, 32);
+    }
+}
+
+bool readSecret(QDataStream &in, SecretBuffer *key) {
+    *key = SecretBuffer(32);
+    return in.readRawData(reinterpret_cast<char *>(key->data()), 32) == 32;
+}
+
+// Upper bound of encodeConfig()'s output, so the blob is allocated once:
+// every reallocation would leave a copy of the keys in freed heap
+int encodedSizeBound(const TunnelConfig &config) {
+    const auto listBytes = [](const QList<QByteArray> &list) {
+        int bytes = 4;
+        for (const QByteArray &item : list) bytes += 4 + item.size();
+        return bytes;
+    };
+    int bytes = 64 + 32 + 2 * 2 + (config.iface.addresses.size() + config.iface.dns.size()) * 18 + 8
+            + listBytes(config.iface.dnsSearch);
+    if (!config.peers.isEmpty()) bytes += 2 * (config.peers.first().endpointHost.size() + 6);  // Summary
+    for (const PeerConfig &peer : config.peers) {
+        bytes += 32 + 32 + 1 + 2 + 4 + peer.endpointHost.size() + 2 + 4 + peer.allowedIPs.size() * 18
+                + listBytes(peer.allowedDomains);
+    }
+    return bytes;
+}
+
+// Zeroes a blob's heap bytes before it is released. Raw views into the
+// cache map or the fallback copy own nothing, and a blob someone else
+// still holds is left to its last owner.
+void wipeOwned(QByteArray *blob) {
+    if (blob->capacity() > 0 && blob->isDetached()) SecretArena::wipe(blob->data(), size_t(blob->size()));
+}
+
+QByteArray encodeConfig(const TunnelConfig &config) {
+    QByteArray blob;
+    blob.reserve(encodedSizeBound(config));
+    QDataStream out(&blob, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_15);
+
+    // Summary first so list views can show a row without decoding peers
+    QString summary;
+    if (!config.peers.isEmpty()) {
+        summary = QString("%1:%2").arg(QString::fromUtf8(config.peers.first().endpointHost))
+                                  .arg(config.peers.first().endpointPort);
+    }
+    out << summary << quint32(config.peers.size());
+
+    writeSecret(out, config.iface.privateKey);
+    out << config.iface.listenPort << config.iface.mtu;
+    writePrefixes(out, config.iface.addresses);
+    writePrefixes(out, config.iface.dns);
+    out << config.iface.dnsSearch;
+
+    for (const PeerConfig &peer : config.peers) {
+        out.writeRawData(reinterpret_cast<const char *>(peer.publicKey), 32);
+        writeSecret(out, peer.presharedKey);
+        out << peer.hasPresharedKey << peer.persistentKeepalive << peer.endpointHost << peer.endpointPort;
+        writePrefixes(out, peer.allowedIPs);
+        out << peer.allowedDomains;
+    }
+    return blob;
+}
+
+bool decodeConfig(const QByteArray &blob, TunnelConfig *config) {
+    QDataStream in(blob);
+    in.setVersion(QDataStream::Qt_5_15);
+    *config = TunnelConfig();
+
+    QString summary;
+    quint32 peerCount = 0;
+    in >> summary >> peerCount;
+    if (!readSecret(in, &config->iface.privateKey)) return false;
+    in >> config->iface.listenPort >> config->iface.mtu;
+    if (!readPrefixes(in, &config->iface.addresses) || !readPrefixes(in, &config->iface.dns)) return false;
+    in >> config->iface.dnsSearch;
+
+    config->peers.resize(int(peerCount));
+    for (PeerConfig &peer : config->peers) {
+        if (in.readRawData(reinterpret_cast<char *>(peer.publicKey), 32) != 32) return false;
+        if (!readSecret(in, &peer.presharedKey)) return false;
+        in >> peer.hasPresharedKey >> peer.persistentKeepalive >> peer.endpointHost >> peer.endpointPort;
+        if (!peer.hasPresharedKey) peer.presharedKey.clear();
+        if (!readPrefixes(in, &peer.allowedIPs)) return false;
+        in >> peer.allowedDomains;
+    }
+    return in.status() == QDataStream::Ok;
+}
+
+} // namespace
+
+ProfileStore::ProfileStore(QObject *parent)
+    : QObject(parent)
+    , m_directory(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/profiles")
+{
+}
+
+ProfileStore::~ProfileStore() {
+    unmapCache();
+    for (Profile &profile : m_profiles) wipeOwned(&profile.blob);
+    m_profiles.clear();
+    wipeOwned(&m_fallback);
+}
+
+void ProfileStore::setDirectory(const QString &directory) {
+    unmapCache();
+    for (Profile &profile : m_profiles) wipeOwned(&profile.blob);
+    m_profiles.clear();
+    wipeOwned(&m_fallback);
+    m_fallback.clear();
+    m_directory = directory;
+}
+
+QString ProfileStore::cachePath() const {
+    return QDir(m_directory).filePath("profiles.cache");
+}
+
+bool ProfileStore::mapCache() {
+    unmapCache();
+    m_cacheFile.setFileName(cachePath());
+    if (!m_cacheFile.open(QIODevice::ReadOnly)) return false;
+
+    m_mapSize = m_cacheFile.size();
+    if (m_mapSize >= qint64(sizeof(CacheHeader))) m_map = m_cacheFile.map(0, m_mapSize);
+    if (!m_map) {
+        m_cacheFile.close();
+        return false;
+    }
+
+    const CacheHeader *header = reinterpret_cast<const CacheHeader *>(m_map);
+    if (memcmp(header->magic, kMagic, 4) != 0 || header->version != kVersion
+        || qint64(sizeof(CacheHeader)) + qint64(header->count) * qint64(sizeof(CacheEntry)) > m_mapSize) {
+        unmapCache();  // Foreign or truncated: treat as no cache
+        return false;
+    }
+    return true;
+}
+
+void ProfileStore::unmapCache() {
+    if (m_map) {
+        m_cacheFile.unmap(m_map);
+        m_map = nullptr;
+    }
+    m_mapSize = 0;
+    m_cacheFile.close();
+}
+
+bool ProfileStore::load() {
+    TPN_TRACE_SCOPE("Profiles::load");
+    QElapsedTimer timer;
+    timer.start();
+    QDir().mkpath(m_directory);
+
+    // Index the existing cache by path; nothing is decoded here
+    QHash<QString, const CacheEntry *> cached;
+    if (mapCache()) {
+        const CacheHeader *header = reinterpret_cast<const CacheHeader *>(m_map);
+        const CacheEntry *entries = reinterpret_cast<const CacheEntry *>(m_map + sizeof(CacheHeader));
+        cached.reserve(int(header->count));
+        for (quint32 i = 0; i < header->count; ++i) {
+            const CacheEntry &entry = entries[i];
+            if (qint64(entry.pathOffset) + entry.pathBytes > m_mapSize
+                || qint64(entry.blobOffset) + entry.blobBytes > m_mapSize) continue;
+            cached.insert(QString::fromUtf8(reinterpret_cast<const char *>(m_map) + entry.pathOffset, int(entry.pathBytes)), &entry);
+        }
+    }
+
+    const QFileInfoList files = QDir(m_directory).entryInfoList(QStringList() << "*.conf", QDir::Files, QDir::Name);
+    QVector<Profile> profiles;
+    profiles.reserve(files.size());
+    bool dirty = cached.size() != files.size();
+    int reparsed = 0;
+
+    for (const QFileInfo &info : files) {
+        Profile profile;
+        profile.name = info.completeBaseName();
+        profile.path = info.absoluteFilePath();
+        profile.size = info.size();
+        profile.mtimeMs = info.lastModified().toMSecsSinceEpoch();
+
+        const CacheEntry *entry = cached.value(profile.path);
+        QByteArray cachedHash;
+        QByteArray cachedBlob;
+        if (entry) {
+            cachedHash = QByteArray(reinterpret_cast<const char *>(entry->sha1), 20);
+            cachedBlob = QByteArray::fromRawData(reinterpret_cast<const char *>(m_map) + entry->blobOffset, int(entry->blobBytes));
+        }
+
+        if (entry && entry->size == profile.size && entry->mtimeMs == profile.mtimeMs) {
+            profile.hash = cachedHash;
+            profile.blob = cachedBlob;
+        } else {
+            QString error;
+            dirty = true;
+            if (!parseProfile(&profile, entry ? &cachedHash : nullptr, cachedBlob, &error)) {
+                TPN_WARNING("Profiles", QString("Skipping profile '%1': %2").arg(profile.name, error));
+                continue;
+            }
+            reparsed++;
+        }
+        profiles.append(profile);
+    }
+
+    m_profiles = profiles;
+    m_reparsed = reparsed;
+    if (dirty) saveCache();
+    TPN_INFO("Profiles", QString("Profile store: %1 profile(s), %2 reparsed, %3 ms.")
+             .arg(m_profiles.size()).arg(reparsed).arg(timer.elapsed()));
+    emit profilesChanged();
+    return true;
+}
+
+bool ProfileStore::parseProfile(Profile *profile, const QByteArray *cachedHash, const QByteArray &cachedBlob, QString *error) {
+    QByteArray bytes;
+    {
+        TPN_TRACE_SCOPE("Config::read");
+        QFile file(profile->path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            *error = "Failed to open config file.";
+            return false;
+        }
+        bytes = file.readAll();
+        profile->hash = QCryptographicHash::hash(bytes, QCryptographicHash::Sha1);
+    }
+    // The text holds the keys in base64; don't leave it in freed heap
+    const auto wipeText = qScopeGuard([&bytes]() { SecretArena::wipe(bytes.data(), size_t(bytes.size())); });
+    if (cachedHash && *cachedHash == profile->hash && !cachedBlob.isEmpty()) {
+        profile->blob = cachedBlob;  // Touched but unchanged
+        return true;
+    }
+
+    return compile(bytes, profile, error);
+}
+
+bool ProfileStore::compile(const QByteArray &text, Profile *profile, QString *error) {
+    ConfigParser parser;
+    TunnelConfig config;
+    if (!parser.parse(text.constData(), text.size(), &config)) {
+        *error = parser.errorString();
+        return false;
+    }
+    TPN_TRACE_SCOPE("Config::encode");
+    profile->blob = encodeConfig(config);
+    return true;
+}
+
+bool ProfileStore::isValidName(const QString &name, QString *error) {
+    if (name.isEmpty() || name.size() > kMaxNameChars) {
+        *error = QString("Profile names must be 1 to %1 characters.").arg(kMaxNameChars);
+        return false;
+    }
+    if (name.contains(QLatin1String(".."))) {
+        *error = QString("Profile name '%1' contains '..'.").arg(name);
+        return false;
+    }
+    for (const QChar c : name) {
+        if (c.unicode() < 0x20 || c.unicode() == 0x7f || QStringLiteral("\\/:*?\"<>|").contains(c)) {
+            *error = QString("Profile name '%1' contains a character that is not allowed in file names.").arg(name);
+            return false;
+        }
+    }
+    if (name.endsWith(' ') || name.endsWith('.')) {
+        *error = QString("Profile name '%1' ends with a space or a dot.").arg(name);
+        return false;
+    }
+    // Windows opens the device for these whatever the extension
+    static const QRegularExpression reserved("^(CON|PRN|AUX|NUL|COM[1-9]|LPT[1-9])(\\..*)?$",
+                                             QRegularExpression::CaseInsensitiveOption);
+    if (reserved.match(name).hasMatch()) {
+        *error = QString("Profile name '%1' is reserved by Windows.").arg(name);
+        return false;
+    }
+    return true;
+}
+
+bool ProfileStore::prepareImport(const QString &name, const QByteArray &text, Import *out, QString *error) {
+    if (!isValidName(name, error)) return false;
+    out->profile.name = name;
+    out->profile.hash = QCryptographicHash::hash(text, QCryptographicHash::Sha1);
+    out->text = text;
+    return compile(text, &out->profile, error);
+}
+
+bool ProfileStore::commitImports(const QVector<Import> &imports, QString *error, QStringList *replaced) {
+    // Stage every file first, then swap them in; if any rename fails the
+    // ones already swapped are rolled back, so the store ends up with all
+    // of the imports or none of them
+    for (const Import &import : imports) {
+        if (!isValidName(import.profile.name, error)) return false;
+    }
+    QDir().mkpath(m_directory);
+    const QDir dir(m_directory);
+    QTemporaryDir staging(dir.filePath(".import-XXXXXX"));
+    if (!staging.isValid()) {
+        *error = "Failed to create a staging directory in the profile store.";
+        return false;
+    }
+    for (int i = 0; i < imports.size(); ++i) {
+        QFile file(staging.filePath(QString::number(i) + ".conf"));
+        if (!file.open(QIODevice::WriteOnly) || file.write(imports[i].text) != imports[i].text.size() || !file.flush()) {
+            *error = QString("Failed to write '%1' into the profile store.").arg(imports[i].profile.name);
+            return false;
+        }
+    }
+
+    struct Swap {
+        QString dest;
+        QString backup;  // Empty if nothing was replaced
+    };
+    QVector<Swap> done;
+    done.reserve(imports.size());
+    bool failed = false;
+    for (int i = 0; i < imports.size() && !failed; ++i) {
+        Swap swap = { dir.absoluteFilePath(imports[i].profile.name + ".conf"), QString() };
+        if (QFile::exists(swap.dest)) {
+            swap.backup = staging.filePath(QString::number(i) + ".old");
+            if (!QFile::rename(swap.dest, swap.backup)) {
+                failed = true;
+                break;
+            }
+        }
+        if (!QFile::rename(staging.filePath(QString::number(i) + ".conf"), swap.dest)) {
+            if (!swap.backup.isEmpty()) QFile::rename(swap.backup, swap.dest);
+            failed = true;
+            break;
+        }
+        done.append(swap);
+    }
+    if (failed) {
+        for (int i = done.size() - 1; i >= 0; --i) {
+            QFile::remove(done[i].dest);
+            if (!done[i].backup.isEmpty()) QFile::rename(done[i].backup, done[i].dest);
+        }
+        *error = "Failed to move the imported profiles into place; nothing was changed.";
+        return false;
+    }
+
+    if (replaced) {
+        for (int i = 0; i < imports.size(); ++i) {
+            if (!done[i].backup.isEmpty()) replaced->append(imports[i].profile.name);
+        }
+    }
+
+    QHash<QString, int> byName;
+    byName.reserve(m_profiles.size() + imports.size());
+    for (int i = 0; i < m_profiles.size(); ++i) byName.insert(m_profiles[i].name, i);
+    for (int i = 0; i < imports.size(); ++i) {
+        Profile profile = imports[i].profile;
+        const QFileInfo stored(done[i].dest);
+        profile.path = stored.absoluteFilePath();
+        profile.size = stored.size();
+        profile.mtimeMs = stored.lastModified().toMSecsSinceEpoch();
+        const int index = byName.value(profile.name, -1);
+        if (index >= 0) {
+            m_profiles[index] = profile;
+        } else {
+            byName.insert(profile.name, m_profiles.size());
+            m_profiles.append(profile);
+        }
+    }
+    saveCache();
+    emit profilesChanged();
+    return true;
+}
+
+bool ProfileStore::saveCache() {
+    const int count = m_profiles.size();
+    const int tableBytes = int(sizeof(CacheHeader) + sizeof(CacheEntry) * size_t(count));
+    int totalBytes = tableBytes;
+    for (const Profile &profile : qAsConst(m_profiles)) {
+        totalBytes += profile.path.toUtf8().size() + profile.blob.size();
+    }
+
+    QByteArray out(tableBytes, '\0');
+    out.reserve(totalBytes);
+    CacheHeader header = {};
+    memcpy(header.magic, kMagic, 4);
+    header.version = kVersion;
+    header.count = quint32(count);
+    memcpy(out.data(), &header, sizeof(header));
+
+    QVector<quint32> blobOffsets(count);
+    for (int i = 0; i < count; ++i) {
+        const Profile &profile = m_profiles[i];
+        const QByteArray path = profile.path.toUtf8();
+        CacheEntry entry = {};
+        entry.pathOffset = quint32(out.size());
+        entry.pathBytes = quint32(path.size());
+        out.append(path);
+        entry.size = profile.size;
+        entry.mtimeMs = profile.mtimeMs;
+        memcpy(entry.sha1, profile.hash.constData(), qMin(20, profile.hash.size()));
+        entry.blobOffset = quint32(out.size());
+        entry.blobBytes = quint32(profile.blob.size());
+        out.append(profile.blob);
+        memcpy(out.data() + sizeof(CacheHeader) + sizeof(CacheEntry) * size_t(i), &entry, sizeof(entry));
+        blobOffsets[i] = entry.blobOffset;
+    }
+
+    // Point blobs at the new buffer before the old mapping goes away; the
+    // compiled ones and an earlier fallback are wiped as they are dropped
+    wipeOwned(&m_fallback);
+    m_fallback = out;
+    for (int i = 0; i < count; ++i) {
+        const int size = m_profiles[i].blob.size();
+        wipeOwned(&m_profiles[i].blob);
+        m_profiles[i].blob = QByteArray::fromRawData(m_fallback.constData() + blobOffsets[i], size);
+    }
+    unmapCache();
+
+    QSaveFile file(cachePath());
+    if (!file.open(QIODevice::WriteOnly) || file.write(out) != out.size() || !file.commit()) {
+        TPN_WARNING("Profiles", "Failed to write profile cache.");
+        return false;
+    }
+
+    if (mapCache()) {
+        for (int i = 0; i < count; ++i) {
+            m_profiles[i].blob = QByteArray::fromRawData(reinterpret_cast<const char *>(m_map) + blobOffsets[i], m_profiles[i].blob.size());
+        }
+        m_fallback.clear();
+    }
+    wipeOwned(&out);  // Unless it still backs the blobs as the fallback
+    return true;
+}
+
+int ProfileStore::indexOf(const QString &name) const {
+    for (int i = 0; i < m_profiles.size(); ++i) {
+        if (m_profiles[i].name == name) return i;
+    }
+    return -1;
+}
+
+bool ProfileStore::config(int index, TunnelConfig *out) const {
+    if (index < 0 || index >= m_profiles.size()) return false;
+    return decodeConfig(m_profiles[index].blob, out);
+}
+
+QString ProfileStore::endpointSummary(int index, int *peerCount) const {
+    QDataStream in(m_profiles.at(index).blob);
+    in.setVersion(QDataStream::Qt_5_15);
+    QString summary;
+    quint32 peers = 0;
+    in >> summary >> peers;
+    if (peerCount) *peerCount = int(peers);
+    return summary;
+}
+
+int ProfileStore::addProfile(const QString &sourcePath, QString *error) {
+    // Validate before touching the store so a bad file never replaces a good one
+    const QFileInfo source(sourcePath);
+    Profile profile;
+    profile.name = source.completeBaseName();
+    profile.path = source.absoluteFilePath();
+    if (!isValidName(profile.name, error)) return -1;
+    if (!parseProfile(&profile, nullptr, QByteArray(), error)) return -1;
+
+    QDir().mkpath(m_directory);
+    const QString dest = QDir(m_directory).absoluteFilePath(profile.name + ".conf");
+    if (QFileInfo(dest) != source) {
+        QFile::remove(dest);
+        if (!QFile::copy(sourcePath, dest)) {
+            *error = "Failed to copy config into the profile store.";
+            return -1;
+        }
+    }
+    const QFileInfo stored(dest);
+    profile.path = stored.absoluteFilePath();
+    profile.size = stored.size();
+    profile.mtimeMs = stored.lastModified().toMSecsSinceEpoch();
+
+    int index = indexOf(profile.name);
+    if (index >= 0) {
+        m_profiles[index] = profile;
+    } else {
+        index = m_profiles.size();
+        m_profiles.append(profile);
+    }
+    saveCache();
+    emit profilesChanged();
+    return index;
+}
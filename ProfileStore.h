@@ -0,0 +1,78 @@
+#ifndef PROFILESTORE_H
+#define PROFILESTORE_H
+
+#include <QObject>
+#include <QFile>
+#include <QStringList>
+#include <QVector>
+#include "TunnelConfig.h"
+
+// Keeps the user's .conf profiles in one directory plus a binary cache of
+// their parsed TunnelConfig. The cache is memory-mapped and keyed by path,
+// size, mtime and SHA-1, so startup only stats the files and reparses the
+// stale ones; encoded configs are decoded on demand straight from the map.
+class ProfileStore : public QObject {
+    Q_OBJECT
+public:
+    struct Profile {
+        QString name;
+        QString path;
+        qint64 size = 0;
+        qint64 mtimeMs = 0;
+        QByteArray hash;  // SHA-1 of the file
+        QByteArray blob;  // Encoded config; a raw view into the cache map when clean
+    };
+
+    explicit ProfileStore(QObject *parent = nullptr);
+    ~ProfileStore();
+
+    void setDirectory(const QString &directory);  // Defaults to <AppData>/profiles
+    QString directory() const { return m_directory; }
+
+    bool load();
+    int reparsed() const { return m_reparsed; }  // By the last load(); the rest came from the cache
+    int count() const { return m_profiles.size(); }
+    const Profile &profile(int index) const { return m_profiles.at(index); }
+    int indexOf(const QString &name) const;
+    bool config(int index, TunnelConfig *out) const;
+    QString endpointSummary(int index, int *peerCount = nullptr) const;  // Cheap: reads the blob header only
+
+    int addProfile(const QString &sourcePath, QString *error);  // Copies into the store, returns the index
+
+    // A name becomes <directory>/<name>.conf, so it must be a single plain
+    // file name on every platform: no separators, drive colons, "..",
+    // control characters or reserved Windows device names
+    static bool isValidName(const QString &name, QString *error);
+
+    // Bulk import: prepareImport() validates and encodes one file's text and
+    // may run on any thread; commitImports() then adds all of them at once
+    struct Import {
+        Profile profile;  // Name, hash and blob; the path is set on commit
+        QByteArray text;  // Written to <directory>/<name>.conf
+    };
+    static bool prepareImport(const QString &name, const QByteArray &text, Import *out, QString *error);
+    // All or nothing, names must be unique; replaced gets the names that
+    // overwrote a profile already in the store
+    bool commitImports(const QVector<Import> &imports, QString *error, QStringList *replaced = nullptr);
+
+signals:
+    void profilesChanged();
+
+private:
+    QString m_directory;
+    QFile m_cacheFile;
+    uchar *m_map = nullptr;
+    qint64 m_mapSize = 0;
+    QByteArray m_fallback;  // Backs blobs while the cache file is being rewritten
+    QVector<Profile> m_profiles;
+    int m_reparsed = 0;
+
+    QString cachePath() const;
+    bool mapCache();
+    void unmapCache();
+    bool parseProfile(Profile *profile, const QByteArray *cachedHash, const QByteArray &cachedBlob, QString *error);
+    static bool compile(const QByteArray &text, Profile *profile, QString *error);
+    bool saveCache();
+};
+
+#endif // PROFILESTORE_H
@@ -0,0 +1,33 @@
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <QVector>
+
+// Fixed-capacity FIFO over storage allocated once; pushing into a full
+// buffer overwrites the oldest element. Index 0 is the oldest.
+template <typename T>
+class RingBuffer {
+public:
+    explicit RingBuffer(int capacity = 0) : m_items(capacity) {}
+
+    int capacity() const { return m_items.size(); }
+    int size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+
+    void push(const T &item) {
+        m_items[(m_first + m_size) % m_items.size()] = item;
+        if (m_size < m_items.size()) m_size++;
+        else m_first = (m_first + 1) % m_items.size();
+    }
+    const T &at(int i) const { return m_items.at((m_first + i) % m_items.size()); }
+    const T &first() const { return at(0); }
+    const T &last() const { return at(m_size - 1); }
+    void clear() { m_first = m_size = 0; }
+
+private:
+    QVector<T> m_items;
+    int m_first = 0;
+    int m_size = 0;
+};
+
+#endif // RINGBUFFER_H
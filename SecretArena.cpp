@@ -0,0 +1,163 @@
+#include "SecretArena.h"
+#include <QGlobalStatic>
+#include <QMutexLocker>
+#include <cstring>
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+Q_GLOBAL_STATIC(SecretArena, s_arena)
+
+SecretArena &SecretArena::instance() {
+    return *s_arena;
+}
+
+void SecretArena::wipe(void *data, size_t bytes) {
+    if (!data) return;
+#ifdef Q_OS_WIN
+    SecureZeroMemory(data, bytes);
+#else
+    volatile quint8 *p = static_cast<volatile quint8 *>(data);
+    while (bytes--) *p++ = 0;
+#endif
+}
+
+bool SecretArena::equal(const void *a, const void *b, size_t bytes) {
+    if (bytes == 0) return true;
+    const volatile quint8 *x = static_cast<const volatile quint8 *>(a);
+    const volatile quint8 *y = static_cast<const volatile quint8 *>(b);
+    quint8 diff = 0;
+    for (size_t i = 0; i < bytes; ++i) diff |= x[i] ^ y[i];
+    return diff == 0;
+}
+
+SecretArena::~SecretArena() {
+    for (void *chunk : qAsConst(m_chunks)) {
+        wipe(chunk, kChunkBytes);
+        unmapPages(chunk, kChunkBytes);
+    }
+}
+
+size_t SecretArena::pageRound(size_t bytes) {
+#ifdef Q_OS_WIN
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    const size_t page = info.dwPageSize;
+#else
+    const size_t page = size_t(sysconf(_SC_PAGESIZE));
+#endif
+    return (bytes + page - 1) / page * page;
+}
+
+void *SecretArena::mapPages(size_t bytes) {
+#ifdef Q_OS_WIN
+    void *pages = VirtualAlloc(nullptr, bytes, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (!pages) return nullptr;
+    const bool locked = VirtualLock(pages, bytes);
+#else
+    void *pages = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pages == MAP_FAILED) return nullptr;
+    const bool locked = mlock(pages, bytes) == 0;
+#ifdef MADV_DONTDUMP
+    madvise(pages, bytes, MADV_DONTDUMP);  // Keep keys out of core dumps
+#endif
+#endif
+    if (locked) m_lockedBytes += bytes;
+    else m_lockFailed = true;
+    return pages;
+}
+
+void SecretArena::unmapPages(void *data, size_t bytes) {
+#ifdef Q_OS_WIN
+    VirtualUnlock(data, bytes);  // Fails harmlessly if the lock never took
+    VirtualFree(data, 0, MEM_RELEASE);
+#else
+    munlock(data, bytes);
+    munmap(data, bytes);
+#endif
+}
+
+void *SecretArena::allocate(size_t bytes) {
+    QMutexLocker lock(&m_mutex);
+    ++m_live;
+    if (bytes > size_t(kSlotBytes)) {
+        const size_t size = pageRound(bytes);
+        void *pages = mapPages(size);
+        if (!pages) qFatal("SecretArena: out of memory");
+        return pages;  // Fresh anonymous pages are already zero
+    }
+    if (m_freeSlots.isEmpty()) {
+        void *chunk = mapPages(kChunkBytes);
+        if (!chunk) qFatal("SecretArena: out of memory");
+        m_chunks.append(chunk);
+        m_freeSlots.reserve(m_freeSlots.size() + kChunkBytes / kSlotBytes);
+        for (int offset = kChunkBytes - kSlotBytes; offset >= 0; offset -= kSlotBytes) {
+            m_freeSlots.append(static_cast<char *>(chunk) + offset);
+        }
+    }
+    return m_freeSlots.takeLast();  // Wiped on release
+}
+
+void SecretArena::release(void *data, size_t bytes) {
+    if (!data) return;
+    if (bytes > size_t(kSlotBytes)) {
+        const size_t size = pageRound(bytes);
+        wipe(data, size);
+        QMutexLocker lock(&m_mutex);
+        unmapPages(data, size);
+        if (m_lockedBytes >= size) m_lockedBytes -= size;
+        --m_live;
+        return;
+    }
+    wipe(data, kSlotBytes);
+    QMutexLocker lock(&m_mutex);
+    m_freeSlots.append(data);
+    --m_live;
+}
+
+bool SecretArena::isLocked() const {
+    QMutexLocker lock(&m_mutex);
+    return !m_lockFailed;
+}
+
+quint64 SecretArena::lockedBytes() const {
+    QMutexLocker lock(&m_mutex);
+    return m_lockedBytes;
+}
+
+int SecretArena::liveAllocations() const {
+    QMutexLocker lock(&m_mutex);
+    return m_live;
+}
+
+SecretBuffer::SecretBuffer(int size) {
+    if (size > 0) d = new Data(size);
+}
+
+void SecretBuffer::copyTo(void *out, int bytes) const {
+    const int n = qMin(bytes, size());
+    if (n > 0) memcpy(out, constData(), size_t(n));
+    if (n < bytes) memset(static_cast<char *>(out) + n, 0, size_t(bytes - n));
+}
+
+SecretBuffer::Data::Data(int n)
+    : bytes(static_cast<quint8 *>(SecretArena::instance().allocate(size_t(n))))
+    , size(n)
+{
+}
+
+SecretBuffer::Data::Data(const Data &other)
+    : QSharedData(other)
+    , bytes(static_cast<quint8 *>(SecretArena::instance().allocate(size_t(other.size))))
+    , size(other.size)
+{
+    memcpy(bytes, other.bytes, size_t(size));
+}
+
+SecretBuffer::Data::~Data() {
+    // A buffer outliving the arena (static destruction) was already wiped with its chunk
+    if (!s_arena.isDestroyed()) s_arena->release(bytes, size_t(size));
+}
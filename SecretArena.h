@@ -0,0 +1,85 @@
+#ifndef SECRETARENA_H
+#define SECRETARENA_H
+
+#include <QByteArray>
+#include <QMutex>
+#include <QSharedData>
+#include <QVector>
+
+// Page-locked home for key material. Secrets up to kSlotBytes (keys) come
+// from slots carved out of locked chunks and are recycled; larger ones
+// (serialized driver configs) get locked pages of their own. Memory is
+// wiped before it is released or reused. Locking is best effort: when the
+// OS refuses (RLIMIT_MEMLOCK, working-set quota) the memory is still
+// wiped, just swappable, and isLocked() turns false.
+class SecretArena {
+public:
+    static const int kSlotBytes = 32;
+
+    static SecretArena &instance();
+    static void wipe(void *data, size_t bytes);  // Not elided by the optimizer
+    static bool equal(const void *a, const void *b, size_t bytes);  // Constant time
+
+    void *allocate(size_t bytes);            // Zero-filled
+    void release(void *data, size_t bytes);  // Wipes, then frees or recycles
+
+    bool isLocked() const;
+    quint64 lockedBytes() const;
+    int liveAllocations() const;
+
+    SecretArena() = default;
+    ~SecretArena();
+
+private:
+    static const int kChunkBytes = 64 * 1024;
+
+    mutable QMutex m_mutex;
+    QVector<void *> m_chunks;     // Never returned; their slots are recycled
+    QVector<void *> m_freeSlots;
+    quint64 m_lockedBytes = 0;
+    bool m_lockFailed = false;
+    int m_live = 0;
+
+    void *mapPages(size_t bytes);  // Locked if the OS allows
+    void unmapPages(void *data, size_t bytes);
+    static size_t pageRound(size_t bytes);
+};
+
+// Implicitly shared byte buffer in the SecretArena: copies share until one
+// side writes, and the last owner wipes the memory. An empty buffer owns
+// nothing, so configs without a preshared key don't take arena space.
+class SecretBuffer {
+public:
+    SecretBuffer() = default;
+    explicit SecretBuffer(int size);  // Zero-filled
+
+    int size() const { return d ? d->size : 0; }
+    bool isEmpty() const { return size() == 0; }
+    const quint8 *constData() const { return d ? d->bytes : nullptr; }
+    quint8 *data() { return d ? d->bytes : nullptr; }  // Detaches
+    // Copies the first `bytes` bytes, zero-filling past the end (or all of
+    // them when empty); for fixed-size driver and cache fields
+    void copyTo(void *out, int bytes) const;
+    // Non-owning; valid while this buffer is alive and unmodified
+    QByteArray view() const { return QByteArray::fromRawData(reinterpret_cast<const char *>(constData()), size()); }
+    void clear() { d.reset(); }
+
+    // Constant time in the contents; sizes are not secret
+    friend bool operator==(const SecretBuffer &a, const SecretBuffer &b) {
+        return a.size() == b.size() && SecretArena::equal(a.constData(), b.constData(), size_t(a.size()));
+    }
+    friend bool operator!=(const SecretBuffer &a, const SecretBuffer &b) { return !(a == b); }
+
+private:
+    struct Data : QSharedData {
+        explicit Data(int n);
+        Data(const Data &other);
+        ~Data();
+        Data &operator=(const Data &) = delete;
+        quint8 *bytes;
+        int size;
+    };
+    QSharedDataPointer<Data> d;
+};
+
+#endif // SECRETARENA_H
@@ -0,0 +1,366 @@
+#include "SelfTest.h"
+#include "NetSocket.h"
+#include "SelfTestServer.h"
+#include "Statistics.h"
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHostInfo>
+#include <QRandomGenerator>
+#include <QScopeGuard>
+#include <QThread>
+#include <QtEndian>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const int kPingSize = 64;
+const int kPingTimeoutMs = 1000;
+const int kStreamBuffer = 256 * 1024;   // Per stream, allocated once
+const int kSocketBuffer = 4 * 1024 * 1024;
+const int kQueryAttempts = 3;
+
+struct Stream {
+    QByteArray buffer;
+    quint64 bytes = 0;      // Delivered to the other end
+    quint64 sent = 0;       // UDP datagrams
+    quint64 received = 0;
+    qint64 elapsedNs = 0;
+    QString error;
+};
+
+bool isCancelled(const QAtomicInt *cancel) {
+    return cancel && cancel->loadRelaxed();
+}
+
+bool openSocket(NetSocket *socket, NetSocket::Type type, const QHostAddress &target, const SelfTest::Options &options) {
+    if (!socket->open(type, target.protocol())) return false;
+    if (!options.bindAddress.isNull() && !socket->bind(options.bindAddress, 0)) return false;
+    socket->setBufferSizes(kSocketBuffer);
+    return true;
+}
+
+// One thread per stream, all started before any is waited for
+template<typename Fn>
+void runStreams(QVector<Stream> *streams, Fn fn) {
+    QVector<QThread *> threads;
+    for (int i = 0; i < streams->size(); ++i) {
+        Stream *stream = &(*streams)[i];
+        QThread *thread = QThread::create([stream, fn]() { fn(stream); });
+        thread->setObjectName("SelfTestStream");
+        thread->start();
+        threads.append(thread);
+    }
+    for (QThread *thread : qAsConst(threads)) {
+        thread->wait();
+        delete thread;
+    }
+}
+
+QString firstError(const QVector<Stream> &streams) {
+    for (const Stream &stream : streams) {
+        if (!stream.error.isEmpty()) return stream.error;
+    }
+    return QString();
+}
+
+// Bits per second over the slowest stream's time: what the streams moved together
+double aggregateMbps(const QVector<Stream> &streams) {
+    quint64 bytes = 0;
+    qint64 elapsedNs = 0;
+    for (const Stream &stream : streams) {
+        bytes += stream.bytes;
+        elapsedNs = qMax(elapsedNs, stream.elapsedNs);
+    }
+    return elapsedNs ? bytes * 8.0 * 1000.0 / elapsedNs : 0.0;
+}
+
+bool measureRtt(const QHostAddress &target, const SelfTest::Options &options, const QAtomicInt *cancel,
+                SelfTest::Result *result) {
+    NetSocket socket;
+    if (!openSocket(&socket, NetSocket::Udp, target, options)) {
+        result->error = QString("Could not open a UDP socket (error %1).").arg(socket.lastError());
+        return false;
+    }
+    char packet[kPingSize] = {};
+    char reply[kPingSize];
+    packet[0] = SelfTestServer::UdpEcho;
+    QVector<double> rtts;
+    rtts.reserve(options.pings);
+    double jitterSum = 0;
+    QElapsedTimer clock;
+    for (int i = 0; i < options.pings && !isCancelled(cancel); ++i) {
+        const quint32 sequence = quint32(i);
+        qToLittleEndian(sequence, packet + 1);
+        clock.start();
+        result->pingsSent++;
+        if (socket.sendTo(packet, kPingSize, target, options.port) != kPingSize) continue;
+        // Wait for this sequence; late answers to earlier pings are dropped
+        for (;;) {
+            const int remaining = kPingTimeoutMs - int(clock.elapsed());
+            if (remaining <= 0 || !socket.waitReadable(remaining)) break;
+            if (socket.recvFrom(reply, kPingSize) < SelfTestServer::kUdpHeader) continue;
+            if (reply[0] != SelfTestServer::UdpEcho || qFromLittleEndian<quint32>(reply + 1) != sequence) continue;
+            const double rtt = clock.nsecsElapsed() / 1e6;
+            if (!rtts.isEmpty()) jitterSum += std::fabs(rtt - rtts.last());
+            rtts.append(rtt);
+            break;
+        }
+        if (options.pingIntervalMs > 0) QThread::msleep(ulong(options.pingIntervalMs));
+    }
+
+    result->pingsReceived = rtts.size();
+    if (rtts.isEmpty()) {
+        result->error = "No echo from the test endpoint.";
+        return false;
+    }
+    result->jitterMs = rtts.size() > 1 ? jitterSum / (rtts.size() - 1) : 0.0;
+    std::sort(rtts.begin(), rtts.end());
+    result->rttMinMs = rtts.first();
+    result->rttP50Ms = percentile(rtts, 50);
+    result->rttP99Ms = percentile(rtts, 99);
+    return true;
+}
+
+void tcpDownload(Stream *stream, const QHostAddress &target, const SelfTest::Options &options, const QAtomicInt *cancel) {
+    NetSocket socket;
+    if (!openSocket(&socket, NetSocket::Tcp, target, options) || !socket.connect(target, options.port, options.timeoutMs)) {
+        stream->error = QString("TCP connect failed (error %1).").arg(socket.lastError());
+        return;
+    }
+    socket.setTimeout(options.timeoutMs);
+    char header[SelfTestServer::kTcpHeader];
+    header[0] = SelfTestServer::TcpSource;
+    qToLittleEndian(quint32(options.durationMs), header + 1);
+    QElapsedTimer clock;
+    clock.start();
+    if (socket.send(header, sizeof(header)) < 0) {
+        stream->error = QString("TCP send failed (error %1).").arg(socket.lastError());
+        return;
+    }
+    char *data = stream->buffer.data();
+    while (!isCancelled(cancel)) {
+        const qint64 n = socket.recv(data, kStreamBuffer);
+        if (n == 0) break;  // Server finished its timed send
+        if (n < 0) {
+            stream->error = QString("TCP receive failed (error %1).").arg(socket.lastError());
+            return;
+        }
+        stream->bytes += quint64(n);
+    }
+    stream->elapsedNs = clock.nsecsElapsed();
+}
+
+void tcpUpload(Stream *stream, const QHostAddress &target, const SelfTest::Options &options, const QAtomicInt *cancel) {
+    NetSocket socket;
+    if (!openSocket(&socket, NetSocket::Tcp, target, options) || !socket.connect(target, options.port, options.timeoutMs)) {
+        stream->error = QString("TCP connect failed (error %1).").arg(socket.lastError());
+        return;
+    }
+    socket.setTimeout(options.timeoutMs);
+    char *data = stream->buffer.data();
+    memset(data, 0xA5, kStreamBuffer);
+    data[0] = SelfTestServer::TcpSink;
+    qToLittleEndian(quint32(0), data + 1);
+    QElapsedTimer clock;
+    clock.start();
+    // The header rides in front of the first write; later writes resend the same buffer
+    while (clock.elapsed() < options.durationMs && !isCancelled(cancel)) {
+        if (socket.send(data, kStreamBuffer) < 0) {
+            stream->error = QString("TCP send failed (error %1).").arg(socket.lastError());
+            return;
+        }
+    }
+    // The server's count is what actually crossed the tunnel
+    socket.shutdownWrite();
+    char reply[8];
+    if (!socket.recvAll(reply, sizeof(reply))) {
+        stream->error = QString("No byte count from the test endpoint (error %1).").arg(socket.lastError());
+        return;
+    }
+    stream->bytes = qFromLittleEndian<quint64>(reply);  // Not counting the header
+    stream->elapsedNs = clock.nsecsElapsed();
+}
+
+void udpBulk(Stream *stream, const QHostAddress &target, const SelfTest::Options &options, const QAtomicInt *cancel) {
+    NetSocket socket;
+    if (!openSocket(&socket, NetSocket::Udp, target, options)) {
+        stream->error = QString("Could not open a UDP socket (error %1).").arg(socket.lastError());
+        return;
+    }
+    const quint32 session = QRandomGenerator::global()->generate();
+    const int payload = qBound(int(SelfTestServer::kUdpHeader), options.udpPayload, kStreamBuffer);
+    char *data = stream->buffer.data();
+    memset(data, 0xC3, payload);
+    data[0] = SelfTestServer::UdpBulk;
+    qToLittleEndian(session, data + 1);
+    QElapsedTimer clock;
+    clock.start();
+    while (clock.elapsed() < options.durationMs && !isCancelled(cancel)) {
+        if (socket.sendTo(data, payload, target, options.port) == payload) stream->sent++;
+    }
+    stream->elapsedNs = clock.nsecsElapsed();
+
+    // Ask the server how much of it arrived
+    char query[SelfTestServer::kUdpHeader];
+    query[0] = SelfTestServer::UdpQuery;
+    qToLittleEndian(session, query + 1);
+    for (int attempt = 0; attempt < kQueryAttempts && !isCancelled(cancel); ++attempt) {
+        QThread::msleep(100);  // Let queued datagrams land first
+        socket.sendTo(query, sizeof(query), target, options.port);
+        QElapsedTimer wait;
+        wait.start();
+        while (wait.elapsed() < options.timeoutMs && socket.waitReadable(options.timeoutMs - int(wait.elapsed()))) {
+            const qint64 n = socket.recvFrom(data, kStreamBuffer);
+            if (n != SelfTestServer::kUdpQueryReply || data[0] != SelfTestServer::UdpQuery
+                    || qFromLittleEndian<quint32>(data + 1) != session) {
+                continue;
+            }
+            stream->bytes = qFromLittleEndian<quint64>(data + 5);
+            stream->received = qFromLittleEndian<quint64>(data + 13);
+            return;
+        }
+    }
+    stream->error = "No UDP counters from the test endpoint.";
+}
+
+} // namespace
+
+QString SelfTest::Result::summary() const {
+    if (!ok) return error.isEmpty() ? QString("Self-test failed.") : error;
+    return QString("RTT %1 ms (p99 %2, jitter %3)   TCP down %4 / up %5 Mbps   UDP %6 Mbps, %7% loss")
+        .arg(rttP50Ms, 0, 'f', 1).arg(rttP99Ms, 0, 'f', 1).arg(jitterMs, 0, 'f', 1)
+        .arg(tcpDownMbps, 0, 'f', 1).arg(tcpUpMbps, 0, 'f', 1)
+        .arg(udpMbps, 0, 'f', 1).arg(udpLoss * 100, 0, 'f', 1);
+}
+
+QVariantMap SelfTest::Result::toVariantMap() const {
+    QVariantMap map;
+    map["ok"] = ok;
+    map["error"] = error;
+    map["finished_ms"] = finishedMs;
+    map["pings_sent"] = pingsSent;
+    map["pings_received"] = pingsReceived;
+    map["rtt_min_ms"] = rttMinMs;
+    map["rtt_p50_ms"] = rttP50Ms;
+    map["rtt_p99_ms"] = rttP99Ms;
+    map["jitter_ms"] = jitterMs;
+    map["tcp_down_mbps"] = tcpDownMbps;
+    map["tcp_up_mbps"] = tcpUpMbps;
+    map["udp_mbps"] = udpMbps;
+    map["udp_loss"] = udpLoss;
+    map["streams"] = streams;
+    return map;
+}
+
+SelfTest::Result SelfTest::Result::fromVariantMap(const QVariantMap &map) {
+    Result result;
+    result.ok = map.value("ok").toBool();
+    result.error = map.value("error").toString();
+    result.finishedMs = map.value("finished_ms").toLongLong();
+    result.pingsSent = map.value("pings_sent").toInt();
+    result.pingsReceived = map.value("pings_received").toInt();
+    result.rttMinMs = map.value("rtt_min_ms").toDouble();
+    result.rttP50Ms = map.value("rtt_p50_ms").toDouble();
+    result.rttP99Ms = map.value("rtt_p99_ms").toDouble();
+    result.jitterMs = map.value("jitter_ms").toDouble();
+    result.tcpDownMbps = map.value("tcp_down_mbps").toDouble();
+    result.tcpUpMbps = map.value("tcp_up_mbps").toDouble();
+    result.udpMbps = map.value("udp_mbps").toDouble();
+    result.udpLoss = map.value("udp_loss").toDouble();
+    result.streams = map.value("streams").toInt();
+    return result;
+}
+
+SelfTest::SelfTest(QObject *parent) : QObject(parent) {
+    qRegisterMetaType<SelfTest::Result>();
+}
+
+SelfTest::~SelfTest() {
+    if (!m_thread) return;
+    cancel();
+    m_thread->wait();
+    delete m_thread;
+}
+
+void SelfTest::cancel() {
+    m_cancel.storeRelaxed(1);
+}
+
+bool SelfTest::start(const Options &options) {
+    if (m_thread) return false;
+    m_cancel.storeRelaxed(0);
+    m_thread = QThread::create([this, options]() {
+        const Result result = run(options, &m_cancel);
+        QMetaObject::invokeMethod(this, [this, result]() {
+            m_thread->wait();
+            delete m_thread;
+            m_thread = nullptr;
+            emit finished(result);
+        }, Qt::QueuedConnection);
+    });
+    m_thread->setObjectName("SelfTest");
+    m_thread->start();
+    return true;
+}
+
+SelfTest::Result SelfTest::run(const Options &options, const QAtomicInt *cancel) {
+    Result result;
+    result.streams = qMax(1, options.streams);
+    auto finish = [&result]() {
+        result.finishedMs = QDateTime::currentMSecsSinceEpoch();
+        return result;
+    };
+
+    QHostAddress target(options.host);
+    if (target.isNull()) {
+        const QList<QHostAddress> addresses = QHostInfo::fromName(options.host).addresses();
+        if (!addresses.isEmpty()) target = addresses.first();
+    }
+    if (target.isNull() || !options.port) {
+        result.error = "Test endpoint " + options.host + " could not be resolved.";
+        return finish();
+    }
+
+    NetSocket::startup();
+    const auto cleanup = qScopeGuard([]() { NetSocket::cleanup(); });
+    if (!measureRtt(target, options, cancel, &result)) return finish();
+
+    // Buffers are allocated once here and reused by every phase
+    QVector<Stream> streams(result.streams);
+    auto resetStreams = [&streams]() {
+        for (Stream &stream : streams) {
+            stream.buffer.resize(kStreamBuffer);
+            stream.bytes = stream.sent = stream.received = 0;
+            stream.elapsedNs = 0;
+            stream.error.clear();
+        }
+    };
+
+    resetStreams();
+    runStreams(&streams, [&](Stream *stream) { tcpDownload(stream, target, options, cancel); });
+    result.error = firstError(streams);
+    if (!result.error.isEmpty() || isCancelled(cancel)) return finish();
+    result.tcpDownMbps = aggregateMbps(streams);
+
+    resetStreams();
+    runStreams(&streams, [&](Stream *stream) { tcpUpload(stream, target, options, cancel); });
+    result.error = firstError(streams);
+    if (!result.error.isEmpty() || isCancelled(cancel)) return finish();
+    result.tcpUpMbps = aggregateMbps(streams);
+
+    resetStreams();
+    runStreams(&streams, [&](Stream *stream) { udpBulk(stream, target, options, cancel); });
+    result.error = firstError(streams);
+    if (!result.error.isEmpty() || isCancelled(cancel)) return finish();
+    result.udpMbps = aggregateMbps(streams);
+    quint64 sent = 0, received = 0;
+    for (const Stream &stream : qAsConst(streams)) {
+        sent += stream.sent;
+        received += stream.received;
+    }
+    result.udpLoss = sent ? 1.0 - double(qMin(received, sent)) / sent : 0.0;
+
+    result.ok = true;
+    return finish();
+}
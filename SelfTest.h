@@ -0,0 +1,72 @@
+#ifndef SELFTEST_H
+#define SELFTEST_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QHostAddress>
+#include <QVariantMap>
+
+class QThread;
+
+// Latency and throughput check through the tunnel against a test endpoint
+// running SelfTestServer. UDP echoes give the RTT distribution, then TCP
+// download, TCP upload and UDP bulk run for a fixed time each over several
+// parallel streams. Every stream owns one preallocated buffer that goes
+// straight to the socket (NetSocket, no Qt buffering or per-call copies),
+// so the client is not what limits the numbers. Runs on its own thread.
+class SelfTest : public QObject {
+    Q_OBJECT
+public:
+    struct Options {
+        QString host;               // Address literal or name of the test endpoint
+        quint16 port = 0;
+        QHostAddress bindAddress;   // Tunnel interface address; null = let routing decide
+        int pings = 200;
+        int pingIntervalMs = 10;
+        int streams = 4;
+        int durationMs = 3000;      // Per throughput phase
+        int udpPayload = 1200;      // Below typical tunnel MTUs, so no fragmentation
+        int timeoutMs = 2000;       // Per blocking call
+    };
+    struct Result {
+        bool ok = false;
+        QString error;
+        qint64 finishedMs = 0;      // Unix ms
+        int pingsSent = 0;
+        int pingsReceived = 0;
+        double rttMinMs = 0;
+        double rttP50Ms = 0;
+        double rttP99Ms = 0;
+        double jitterMs = 0;        // Mean difference between consecutive RTTs
+        double tcpDownMbps = 0;
+        double tcpUpMbps = 0;
+        double udpMbps = 0;         // As received by the server
+        double udpLoss = 0;         // 0..1
+        int streams = 0;
+
+        QString summary() const;
+        QVariantMap toVariantMap() const;
+        static Result fromVariantMap(const QVariantMap &map);  // ok = false if empty
+    };
+
+    explicit SelfTest(QObject *parent = nullptr);
+    ~SelfTest();  // Cancels and waits for a running test
+
+    bool start(const Options &options);  // False if one is already running
+    void cancel();
+    bool isRunning() const { return m_thread != nullptr; }
+
+    // Blocking; cancel (optional) is polled between and during phases
+    static Result run(const Options &options, const QAtomicInt *cancel = nullptr);
+
+signals:
+    void finished(const SelfTest::Result &result);
+
+private:
+    QThread *m_thread = nullptr;
+    QAtomicInt m_cancel;
+};
+
+Q_DECLARE_METATYPE(SelfTest::Result)
+
+#endif // SELFTEST_H
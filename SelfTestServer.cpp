@@ -0,0 +1,231 @@
+#include "SelfTestServer.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QTextStream>
+#include <QThread>
+#include <QtEndian>
+
+namespace {
+const int kPollMs = 200;         // How often blocked threads look at the stop flag
+const int kIdleLimitMs = 15000;  // Connections silent for longer are dropped
+const int kBufferSize = 256 * 1024;
+const int kMaxSourceMs = 60000;
+const int kMaxSessions = 4096;   // UDP bulk sessions remembered at once
+}
+
+SelfTestServer::~SelfTestServer() {
+    close();
+}
+
+bool SelfTestServer::listen(const QHostAddress &address, quint16 port) {
+    close();
+    m_stopping.storeRelaxed(0);
+    NetSocket::startup();
+    const QAbstractSocket::NetworkLayerProtocol family = address.protocol() == QAbstractSocket::IPv6Protocol
+            ? QAbstractSocket::IPv6Protocol : QAbstractSocket::IPv4Protocol;
+    if (!m_listener.open(NetSocket::Tcp, family) || !m_listener.bind(address, port) || !m_listener.listen(64)) {
+        m_error = QString("TCP listen failed (error %1).").arg(m_listener.lastError());
+        m_listener.close();
+        NetSocket::cleanup();
+        return false;
+    }
+    m_port = m_listener.localPort();
+    // UDP on the same port number the TCP side got
+    if (!m_udp.open(NetSocket::Udp, family) || !m_udp.bind(address, m_port)) {
+        m_error = QString("UDP bind failed (error %1).").arg(m_udp.lastError());
+        m_listener.close();
+        m_udp.close();
+        NetSocket::cleanup();
+        return false;
+    }
+    m_udp.setBufferSizes(4 * 1024 * 1024);
+
+    m_acceptThread = QThread::create([this]() { acceptLoop(); });
+    m_acceptThread->setObjectName("SelfTestAccept");
+    m_acceptThread->start();
+    m_udpThread = QThread::create([this]() { udpLoop(); });
+    m_udpThread->setObjectName("SelfTestUdp");
+    m_udpThread->start();
+    return true;
+}
+
+void SelfTestServer::close() {
+    if (!m_acceptThread) return;
+    m_stopping.storeRelaxed(1);
+    {
+        QMutexLocker lock(&m_mutex);
+        for (NetSocket *socket : qAsConst(m_open)) socket->shutdown();  // Unblocks their recv/send
+    }
+    m_acceptThread->wait();
+    m_udpThread->wait();
+    delete m_acceptThread;
+    delete m_udpThread;
+    m_acceptThread = m_udpThread = nullptr;
+
+    // Nothing adds connections any more
+    for (QThread *thread : qAsConst(m_connections)) {
+        thread->wait();
+        delete thread;
+    }
+    m_connections.clear();
+    m_listener.close();
+    m_udp.close();
+    m_sessions.clear();
+    m_port = 0;
+    NetSocket::cleanup();
+}
+
+void SelfTestServer::acceptLoop() {
+    while (!m_stopping.loadRelaxed()) {
+        if (!m_listener.waitReadable(kPollMs)) continue;
+        NetSocket accepted = m_listener.accept();
+        if (!accepted.isValid()) continue;
+
+        NetSocket *socket = new NetSocket(std::move(accepted));
+        QMutexLocker lock(&m_mutex);
+        // Reap finished connections so a long-running server stays flat
+        for (int i = m_connections.size() - 1; i >= 0; --i) {
+            if (m_connections[i]->isFinished()) delete m_connections.takeAt(i);
+        }
+        m_open.append(socket);
+        QThread *thread = QThread::create([this, socket]() { serve(socket); });
+        thread->setObjectName("SelfTestConnection");
+        m_connections.append(thread);
+        thread->start();
+    }
+}
+
+void SelfTestServer::serve(NetSocket *socket) {
+    socket->setTimeout(kPollMs);
+    socket->setBufferSizes(kBufferSize * 4);
+    socket->setNoDelay(true);
+    QByteArray buffer(kBufferSize, '\0');  // One buffer per connection, reused for every call
+    char *data = buffer.data();
+
+    // Header: mode byte, then the source duration
+    int have = 0;
+    QElapsedTimer idle;
+    idle.start();
+    while (have < kTcpHeader && !m_stopping.loadRelaxed() && idle.elapsed() < kIdleLimitMs) {
+        const qint64 n = socket->recv(data + have, kTcpHeader - have);
+        if (n == 0 || (n < 0 && !socket->timedOut())) break;
+        if (n > 0) have += int(n);
+    }
+
+    if (have == kTcpHeader && data[0] == TcpSink) {
+        quint64 total = 0;
+        idle.start();
+        while (!m_stopping.loadRelaxed() && idle.elapsed() < kIdleLimitMs) {
+            const qint64 n = socket->recv(data, kBufferSize);
+            if (n == 0) {
+                // Client is done sending: report what arrived
+                char reply[8];
+                qToLittleEndian(total, reply);
+                socket->send(reply, sizeof(reply));
+                break;
+            }
+            if (n < 0) {
+                if (socket->timedOut()) continue;
+                break;
+            }
+            total += quint64(n);
+            idle.start();
+        }
+    } else if (have == kTcpHeader && data[0] == TcpSource) {
+        const int durationMs = qBound(1, int(qFromLittleEndian<quint32>(data + 1)), kMaxSourceMs);
+        memset(data, 0x5A, kBufferSize);
+        QElapsedTimer clock;
+        clock.start();
+        while (!m_stopping.loadRelaxed() && clock.elapsed() < durationMs) {
+            if (socket->send(data, kBufferSize) < 0 && !socket->timedOut()) break;
+        }
+        socket->shutdownWrite();
+        // Let the client drain before the close turns into a reset
+        while (!m_stopping.loadRelaxed() && socket->recv(data, kBufferSize) > 0) {}
+    }
+
+    QMutexLocker lock(&m_mutex);
+    m_open.removeOne(socket);
+    delete socket;
+}
+
+void SelfTestServer::udpLoop() {
+    QByteArray buffer(65536, '\0');
+    char *data = buffer.data();
+    QHostAddress from;
+    quint16 fromPort = 0;
+    while (!m_stopping.loadRelaxed()) {
+        if (!m_udp.waitReadable(kPollMs)) continue;
+        const qint64 n = m_udp.recvFrom(data, buffer.size(), &from, &fromPort);
+        if (n < kUdpHeader) continue;
+        const int maxDatagram = m_maxDatagram.loadRelaxed();
+        if (maxDatagram > 0 && n > maxDatagram) continue;
+        const quint32 id = qFromLittleEndian<quint32>(data + 1);
+        switch (data[0]) {
+        case UdpEcho:
+            m_udp.sendTo(data, n, from, fromPort);
+            break;
+        case UdpBulk: {
+            auto it = m_sessions.find(id);
+            if (it == m_sessions.end()) {
+                if (m_sessions.size() >= kMaxSessions) m_sessions.clear();  // Abandoned sessions
+                it = m_sessions.insert(id, Session());
+            }
+            it->bytes += quint64(n);
+            it->datagrams++;
+            break;
+        }
+        case UdpQuery: {
+            const Session session = m_sessions.value(id);
+            char reply[kUdpQueryReply];
+            reply[0] = UdpQuery;
+            qToLittleEndian(id, reply + 1);
+            qToLittleEndian(session.bytes, reply + 5);
+            qToLittleEndian(session.datagrams, reply + 13);
+            m_udp.sendTo(reply, sizeof(reply), from, fromPort);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+bool SelfTestServer::isRequested(int argc, char *argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        if (qstrncmp(argv[i], "--selftest-server", 17) == 0) return true;
+    }
+    return false;
+}
+
+int SelfTestServer::run(const QStringList &arguments) {
+    QHostAddress address = QHostAddress::Any;
+    quint16 port = 0;
+    for (const QString &arg : arguments) {
+        if (!arg.startsWith("--selftest-server=")) continue;
+        const QString value = arg.section('=', 1);
+        const int colon = value.lastIndexOf(':');
+        if (colon > 0 && !value.endsWith(']') && value.count(':') == 1) {
+            address = QHostAddress(value.left(colon));
+            port = quint16(value.mid(colon + 1).toUInt());
+        } else if (value.startsWith('[') && colon > 0) {
+            address = QHostAddress(value.mid(1, value.lastIndexOf(']') - 1));
+            port = quint16(value.mid(colon + 1).toUInt());
+        } else {
+            port = quint16(value.toUInt());
+        }
+    }
+    if (address.isNull()) {
+        QTextStream(stderr) << "Invalid --selftest-server address\n";
+        return 1;
+    }
+
+    SelfTestServer server;
+    if (!server.listen(address, port)) {
+        QTextStream(stderr) << server.errorString() << '\n';
+        return 1;
+    }
+    QTextStream(stdout) << "Self-test server on " << address.toString() << " port " << server.port() << Qt::endl;
+    return QCoreApplication::exec();
+}
@@ -0,0 +1,68 @@
+#ifndef SELFTESTSERVER_H
+#define SELFTESTSERVER_H
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QHostAddress>
+#include <QMutex>
+#include <QVector>
+#include "NetSocket.h"
+
+class QThread;
+
+// Counterpart of SelfTest, run on the test endpoint (or on loopback by the
+// benchmark): TCP and UDP on the same port. A TCP connection starts with a
+// mode byte: 'S' sinks everything until the client shuts down its side and
+// answers with the byte count, 'R' sends for the requested time and closes.
+// UDP datagrams are echoed ('E'), counted per session ('B') or answer with
+// a session's count ('Q'). One blocking thread per connection. Echoes also
+// answer PathMtuProber; setMaxDatagram() stands in for a narrow path.
+//
+//   tpn-client --selftest-server=[address:]port
+class SelfTestServer {
+public:
+    // Wire format shared with SelfTest
+    enum : char { TcpSink = 'S', TcpSource = 'R', UdpEcho = 'E', UdpBulk = 'B', UdpQuery = 'Q' };
+    static const int kTcpHeader = 5;       // Mode, quint32 LE duration ms (source)
+    static const int kUdpHeader = 5;       // Type, quint32 LE sequence or session
+    static const int kUdpQueryReply = 21;  // 'Q', session, quint64 LE bytes, quint64 LE datagrams
+
+    SelfTestServer() = default;
+    ~SelfTestServer();
+    SelfTestServer(const SelfTestServer &) = delete;
+    SelfTestServer &operator=(const SelfTestServer &) = delete;
+
+    bool listen(const QHostAddress &address, quint16 port = 0);  // 0 = ephemeral, see port()
+    quint16 port() const { return m_port; }
+    QString errorString() const { return m_error; }
+    void setMaxDatagram(int bytes) { m_maxDatagram.storeRelaxed(bytes); }  // Larger UDP is dropped, 0 = off
+    void close();  // Stops every thread, waits for them
+
+    static bool isRequested(int argc, char *argv[]);
+    static int run(const QStringList &arguments);  // Serves until killed
+
+private:
+    struct Session {
+        quint64 bytes = 0;
+        quint64 datagrams = 0;
+    };
+
+    NetSocket m_listener;
+    NetSocket m_udp;
+    quint16 m_port = 0;
+    QString m_error;
+    QThread *m_acceptThread = nullptr;
+    QThread *m_udpThread = nullptr;
+    QMutex m_mutex;  // Guards the two lists below
+    QVector<QThread *> m_connections;
+    QVector<NetSocket *> m_open;
+    QHash<quint32, Session> m_sessions;  // UDP thread only
+    QAtomicInt m_stopping;
+    QAtomicInt m_maxDatagram;
+
+    void acceptLoop();
+    void udpLoop();
+    void serve(NetSocket *socket);
+};
+
+#endif // SELFTESTSERVER_H
@@ -0,0 +1,240 @@
+#include "SimulatedBackend.h"
+#include "DriverConfig.h"
+#include <QMutexLocker>
+#include <QDateTime>
+#include <QHostAddress>
+#include <QRandomGenerator>
+#include <QStringList>
+#include <QThread>
+
+namespace {
+const long kSimulatedFailure = long(qint32(0x80004005u));  // E_FAIL
+const long kNotFound = long(qint32(0x80070002u));          // HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND)
+const long kInvalidArg = long(qint32(0x80070057u));        // E_INVALIDARG
+}
+
+SimulatedBackend::SimulatedBackend(const Profile &profile)
+    : m_profile(profile)
+{
+    m_clock.start();
+}
+
+SimulatedBackend::Profile SimulatedBackend::parseProfile(const QString &spec, bool *ok) {
+    Profile profile;
+    bool allOk = true;
+    for (const QString &item : spec.split(',', Qt::SkipEmptyParts)) {
+        const QString key = item.section('=', 0, 0).trimmed().toLower();
+        const QString value = item.section('=', 1).trimmed();
+        bool valueOk = false;
+        if (key == "fail") {
+            profile.failureRate = qBound(0.0, value.toDouble(&valueOk), 1.0);
+        } else if (key == "rx" || key == "tx") {
+            (key == "rx" ? profile.rxRate : profile.txRate) = value.toLongLong(&valueOk);
+        } else {
+            int ms = value.toInt(&valueOk);
+            if (key == "load") profile.loadMs = ms;
+            else if (key == "create") profile.createMs = ms;
+            else if (key == "open") profile.openMs = ms;
+            else if (key == "config") profile.configMs = ms;
+            else if (key == "state") profile.stateMs = ms;
+            else if (key == "jitter") profile.jitterMs = ms;
+            else valueOk = false;
+        }
+        allOk = allOk && valueOk;
+    }
+    if (ok) *ok = allOk;
+    return profile;
+}
+
+QString SimulatedBackend::describe() const {
+    return QString("load=%1,create=%2,open=%3,config=%4,state=%5,jitter=%6,fail=%7,rx=%8,tx=%9")
+        .arg(m_profile.loadMs).arg(m_profile.createMs).arg(m_profile.openMs)
+        .arg(m_profile.configMs).arg(m_profile.stateMs).arg(m_profile.jitterMs)
+        .arg(m_profile.failureRate).arg(m_profile.rxRate).arg(m_profile.txRate);
+}
+
+bool SimulatedBackend::simulate(int latencyMs) {
+    m_calls.fetchAndAddRelaxed(1);
+    QRandomGenerator *rng = QRandomGenerator::global();
+    if (m_profile.jitterMs > 0) latencyMs += rng->bounded(m_profile.jitterMs + 1);
+    if (latencyMs > 0) QThread::msleep(quint32(latencyMs));
+    return m_profile.failureRate <= 0.0 || rng->generateDouble() >= m_profile.failureRate;
+}
+
+bool SimulatedBackend::load(QString *error) {
+    if (m_profile.loadMs > 0) QThread::msleep(quint32(m_profile.loadMs));
+    Q_UNUSED(error);
+    return true;
+}
+
+long SimulatedBackend::createAdapter(const QString &name, const QUuid &guid, AdapterHandle *out) {
+    Q_UNUSED(guid);
+    *out = nullptr;
+    if (!simulate(m_profile.createMs)) return kSimulatedFailure;
+    QMutexLocker lock(&m_mutex);
+    AdapterHandle adapter = reinterpret_cast<AdapterHandle>(m_nextHandle++);
+    m_adapters.insert(adapter);
+    m_byName.insert(name, adapter);
+    *out = adapter;
+    return 0;
+}
+
+long SimulatedBackend::openAdapter(const QString &name, AdapterHandle *out) {
+    *out = nullptr;
+    if (!simulate(m_profile.openMs)) return kSimulatedFailure;
+    QMutexLocker lock(&m_mutex);
+    AdapterHandle adapter = m_byName.value(name);
+    if (!adapter || !m_adapters.contains(adapter)) return kNotFound;
+    *out = adapter;
+    return 0;
+}
+
+void SimulatedBackend::closeAdapter(AdapterHandle adapter) {
+    m_calls.fetchAndAddRelaxed(1);
+    QMutexLocker lock(&m_mutex);
+    m_adapters.remove(adapter);
+    setUpLocked(adapter, false);
+}
+
+long SimulatedBackend::setConfiguration(AdapterHandle adapter, const QByteArray &config) {
+    if (!simulate(m_profile.configMs)) return kSimulatedFailure;
+    if (m_failConfigs.loadRelaxed() > 0 && m_failConfigs.fetchAndSubRelaxed(1) > 0) return kSimulatedFailure;
+    TunnelConfig parsed;  // The real driver rejects a malformed buffer too
+    if (!DriverConfig::unpack(config.constData(), config.size(), &parsed)) return kInvalidArg;
+    QMutexLocker lock(&m_mutex);
+    if (!m_adapters.contains(adapter)) return kNotFound;
+    if (m_frozenAt >= 0 && m_thawAfter > 0 && --m_thawAfter == 0) thawLocked();
+    return 0;
+}
+
+long SimulatedBackend::setAdapterState(AdapterHandle adapter, bool up) {
+    if (!simulate(m_profile.stateMs)) return kSimulatedFailure;
+    QMutexLocker lock(&m_mutex);
+    if (!m_adapters.contains(adapter)) return kNotFound;
+    setUpLocked(adapter, up);
+    return 0;
+}
+
+void SimulatedBackend::setUpLocked(AdapterHandle adapter, bool up) {
+    const qint64 nowMs = m_clock.elapsed();
+    if (!up) {
+        if (m_upSince.remove(adapter) && m_upSince.isEmpty()) {
+            m_downSince = nowMs;
+            m_outages++;
+        }
+        return;
+    }
+    if (m_upSince.contains(adapter)) return;
+    m_upSince.insert(adapter, nowMs);
+    if (m_frozenAt < 0) m_frozenTotalMs = 0;  // Earlier spans predate this session
+    if (m_downSince >= 0) m_longestOutageMs = qMax(m_longestOutageMs, nowMs - m_downSince);
+    m_downSince = -1;
+}
+
+long SimulatedBackend::setMtu(AdapterHandle adapter, int mtu) {
+    if (!simulate(m_profile.configMs)) return kSimulatedFailure;
+    QMutexLocker lock(&m_mutex);
+    if (!m_adapters.contains(adapter)) return kNotFound;
+    if (mtu < 576 || mtu > 65535) return kInvalidArg;
+    m_mtu.storeRelaxed(mtu);
+    return 0;
+}
+
+long SimulatedBackend::setDnsServers(AdapterHandle adapter, const QStringList &servers) {
+    if (!simulate(m_profile.configMs)) return kSimulatedFailure;
+    QMutexLocker lock(&m_mutex);
+    if (!m_adapters.contains(adapter)) return kNotFound;
+    for (const QString &server : servers) {
+        if (QHostAddress(server).protocol() != QAbstractSocket::IPv4Protocol) return kInvalidArg;
+    }
+    m_dnsServers = servers;
+    return 0;
+}
+
+QStringList SimulatedBackend::dnsServers() const {
+    QMutexLocker lock(&m_mutex);
+    return m_dnsServers;
+}
+
+long SimulatedBackend::getAdapterState(AdapterHandle adapter, bool *up) {
+    m_calls.fetchAndAddRelaxed(1);
+    QMutexLocker lock(&m_mutex);
+    if (!m_adapters.contains(adapter)) return kNotFound;
+    *up = m_upSince.contains(adapter);
+    return 0;
+}
+
+long SimulatedBackend::getPeerStats(AdapterHandle adapter, QVector<PeerStats> *out) {
+    m_calls.fetchAndAddRelaxed(1);
+    QMutexLocker lock(&m_mutex);
+    if (!m_adapters.contains(adapter)) return kNotFound;
+    auto upSince = m_upSince.constFind(adapter);
+    if (upSince == m_upSince.constEnd()) {
+        out->clear();
+        return 0;
+    }
+
+    const qint64 nowMs = m_clock.elapsed();
+    const qint64 upMs = nowMs - *upSince;
+    const qint64 frozenMs = m_frozenTotalMs + (m_frozenAt >= 0 ? nowMs - m_frozenAt : 0);
+    const qint64 handshakeFrom = qMax(*upSince, m_thawedAt);
+    const qint64 handshakeAt = m_frozenAt >= 0 && m_frozenAt >= handshakeFrom
+        ? m_frozenAt - (m_frozenAt - handshakeFrom) % 120000
+        : nowMs - (nowMs - handshakeFrom) % 120000;
+    out->resize(1);
+    PeerStats &peer = (*out)[0];
+    memset(peer.publicKey, 0, sizeof(peer.publicKey));
+    peer.rxBytes = quint64(m_profile.rxRate * qMax<qint64>(0, upMs - frozenMs) / 1000);
+    peer.txBytes = quint64(m_profile.txRate * upMs / 1000);
+    peer.lastHandshakeMs = QDateTime::currentMSecsSinceEpoch() - (nowMs - handshakeAt);
+    return 0;
+}
+
+void SimulatedBackend::freezeHandshakes(int thawAfterConfigs) {
+    QMutexLocker lock(&m_mutex);
+    if (m_frozenAt < 0) m_frozenAt = m_clock.elapsed();
+    m_thawAfter = thawAfterConfigs;
+}
+
+void SimulatedBackend::failConfigs(int count) {
+    m_failConfigs.storeRelaxed(count);
+}
+
+int SimulatedBackend::outages() const {
+    QMutexLocker lock(&m_mutex);
+    return m_outages;
+}
+
+qint64 SimulatedBackend::longestOutageMs() const {
+    QMutexLocker lock(&m_mutex);
+    return m_downSince >= 0 ? qMax(m_longestOutageMs, m_clock.elapsed() - m_downSince) : m_longestOutageMs;
+}
+
+void SimulatedBackend::resetOutages() {
+    QMutexLocker lock(&m_mutex);
+    m_outages = 0;
+    m_longestOutageMs = 0;
+    if (m_downSince >= 0) m_downSince = m_clock.elapsed();
+}
+
+void SimulatedBackend::thawHandshakes() {
+    QMutexLocker lock(&m_mutex);
+    if (m_frozenAt >= 0) thawLocked();
+}
+
+void SimulatedBackend::thawLocked() {
+    m_thawedAt = m_clock.elapsed();
+    m_frozenTotalMs += m_thawedAt - m_frozenAt;
+    m_frozenAt = -1;
+    m_thawAfter = 0;
+}
+
+bool SimulatedBackend::handshakesFrozen() const {
+    QMutexLocker lock(&m_mutex);
+    return m_frozenAt >= 0;
+}
+
+int SimulatedBackend::openAdapters() const {
+    QMutexLocker lock(&m_mutex);
+    return m_adapters.size();
+}
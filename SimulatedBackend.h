@@ -0,0 +1,91 @@
+#ifndef SIMULATEDBACKEND_H
+#define SIMULATEDBACKEND_H
+
+#include <QMutex>
+#include <QSet>
+#include <QHash>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include "TunnelBackend.h"
+
+// In-process stand-in for wireguard.dll with configurable per-call latency
+// and failure rates. Used by the connect benchmark and for running the UI
+// on machines without the driver. An up adapter reports one peer whose
+// counters grow at exactly rxRate/txRate and that handshakes every two
+// minutes, so sampler output can be checked against known values.
+// freezeHandshakes() simulates a dead server: received bytes and handshakes
+// stop while sends continue, until enough config pushes (failovers) arrive.
+// Outages are the spans with no adapter up after one had been: the packets
+// a real tunnel would drop while being rebuilt.
+class SimulatedBackend : public TunnelBackend {
+public:
+    struct Profile {
+        int loadMs = 0;
+        int createMs = 40;
+        int openMs = 5;
+        int configMs = 5;
+        int stateMs = 10;
+        int jitterMs = 0;
+        double failureRate = 0.0;  // Per driver call, 0..1
+        qint64 rxRate = 1250000;   // Synthetic bytes/s while up
+        qint64 txRate = 250000;
+    };
+
+    explicit SimulatedBackend(const Profile &profile = Profile());
+
+    // "create=40,open=5,config=5,state=10,jitter=2,fail=0.01,load=0,rx=1250000,tx=250000"
+    static Profile parseProfile(const QString &spec, bool *ok = nullptr);
+    QString describe() const;
+
+    bool load(QString *error) override;
+    long createAdapter(const QString &name, const QUuid &guid, AdapterHandle *out) override;
+    long openAdapter(const QString &name, AdapterHandle *out) override;
+    void closeAdapter(AdapterHandle adapter) override;
+    long setConfiguration(AdapterHandle adapter, const QByteArray &config) override;
+    long setAdapterState(AdapterHandle adapter, bool up) override;
+    long getAdapterState(AdapterHandle adapter, bool *up) override;
+    long setMtu(AdapterHandle adapter, int mtu) override;
+    long setDnsServers(AdapterHandle adapter, const QStringList &servers) override;
+    long getPeerStats(AdapterHandle adapter, QVector<PeerStats> *out) override;
+
+    // Thread-safe. thawAfterConfigs = 0 stays frozen until thawHandshakes()
+    void freezeHandshakes(int thawAfterConfigs = 1);
+    void thawHandshakes();
+    bool handshakesFrozen() const;
+    void failConfigs(int count);  // The next `count` setConfiguration() calls fail
+    // Thread-safe. One still in progress counts up to now
+    int outages() const;
+    qint64 longestOutageMs() const;
+    void resetOutages();
+
+    int openAdapters() const;
+    int mtu() const { return m_mtu.loadRelaxed(); }  // Last set on any adapter, 0 = never
+    QStringList dnsServers() const;                    // Likewise, empty = never or cleared
+    int driverCalls() const { return m_calls.loadRelaxed(); }
+
+private:
+    Profile m_profile;
+    mutable QMutex m_mutex;
+    QSet<AdapterHandle> m_adapters;
+    QHash<AdapterHandle, qint64> m_upSince;  // Clock ms when brought up
+    QElapsedTimer m_clock;
+    qint64 m_frozenAt = -1;      // Clock ms, -1 = live
+    qint64 m_frozenTotalMs = 0;  // Earlier frozen spans, excluded from rx
+    qint64 m_thawedAt = 0;       // Handshakes restart from here
+    int m_thawAfter = 0;
+    qint64 m_downSince = -1;  // Clock ms the last up adapter went down, -1 = one is up or none ever was
+    int m_outages = 0;
+    qint64 m_longestOutageMs = 0;
+    QAtomicInt m_failConfigs;
+    QHash<QString, AdapterHandle> m_byName;
+    quintptr m_nextHandle = 1;
+    QAtomicInt m_calls;
+    QAtomicInt m_mtu;
+    QStringList m_dnsServers;
+
+    bool simulate(int latencyMs);
+    void thawLocked();
+    void setUpLocked(AdapterHandle adapter, bool up);
+};
+
+#endif // SIMULATEDBACKEND_H
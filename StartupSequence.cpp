@@ -0,0 +1,106 @@
+#include "StartupSequence.h"
+#include "Logger.h"
+#include "ProcessInfo.h"
+#include "WireGuardManager.h"
+#include <QThread>
+
+StartupSequence::StartupSequence(WireGuardManager *manager, QObject *parent)
+    : QObject(parent)
+    , m_manager(manager)
+    , m_endpointBudget(this)
+{
+    m_clock.start();
+    m_startedAt[Window] = 0;
+    m_endpointBudget.setSingleShot(true);
+    connect(&m_endpointBudget, &QTimer::timeout, this, [this]() {
+        // Lookups keep filling the cache; Connect just stops waiting for them
+        TPN_WARNING("Startup", QString("Endpoint pre-resolution still running after %1 ms.").arg(kEndpointBudgetMs));
+        finish(Endpoints, false);
+    });
+    connect(m_manager, &WireGuardManager::initialized, this, [this](bool ok) { finish(Driver, ok); });
+    connect(m_manager, &WireGuardManager::endpointsPrefetched, this, [this](int hosts, qint64) {
+        if (isFinished(Endpoints)) return;
+        m_endpointBudget.stop();
+        TPN_INFO("Startup", QString("Pre-resolved %1 endpoint(s).").arg(hosts));
+        finish(Endpoints, true);
+    });
+}
+
+StartupSequence::~StartupSequence() {
+    if (m_loader) {
+        m_loader->wait();  // It writes into the profile store
+        delete m_loader;
+    }
+}
+
+const char *StartupSequence::phaseName(Phase phase) {
+    switch (phase) {
+    case Window: return "window";
+    case Driver: return "driver";
+    case Profiles: return "profiles";
+    case Endpoints: return "endpoints";
+    case PhaseCount: break;
+    }
+    return "?";
+}
+
+void StartupSequence::start() {
+    if (m_started) return;
+    m_started = true;
+
+    begin(Driver);
+    m_manager->initializeAsync();
+
+    // The store is not touched by anyone else until Profiles finishes: the
+    // window keeps its model detached and imports disabled until then
+    begin(Profiles);
+    ProfileStore *store = m_manager->profileStore();
+    m_loader = QThread::create([this, store]() {
+        const bool ok = store->load();
+        QMetaObject::invokeMethod(this, [this, ok]() {
+            begin(Endpoints);  // Before Profiles ends, so ready() can't fire in between
+            finish(Profiles, ok);
+            startEndpoints();
+        }, Qt::QueuedConnection);
+    });
+    m_loader->setObjectName("ProfileLoader");
+    m_loader->start();
+}
+
+void StartupSequence::startEndpoints() {
+    if (!m_manager->prefetchEndpoints(m_manager->recentProfiles())) {
+        finish(Endpoints, true);  // Nothing recent to resolve
+        return;
+    }
+    m_endpointBudget.start(kEndpointBudgetMs);
+}
+
+void StartupSequence::markFirstPaint() {
+    if (m_firstPaintMs >= 0) return;
+    m_firstPaintMs = ProcessInfo::sinceStartMs();
+    m_ms[Window] = m_clock.elapsed();
+    m_ok[Window] = true;
+    TPN_INFO("Startup", QString("First paint %1 ms after start (window %2 ms).").arg(m_firstPaintMs).arg(m_ms[Window]));
+    emit phaseFinished(Window, true, m_ms[Window]);
+}
+
+void StartupSequence::begin(Phase phase) {
+    m_startedAt[phase] = m_clock.elapsed();
+    ++m_running;
+}
+
+void StartupSequence::finish(Phase phase, bool ok) {
+    if (isFinished(phase)) return;
+    m_ms[phase] = m_clock.elapsed() - m_startedAt[phase];
+    m_ok[phase] = ok;
+    --m_running;
+    TPN_LOG(ok ? LogLevel::Info : LogLevel::Warning, "Startup",
+            QString("Phase %1 %2 in %3 ms.").arg(phaseName(phase)).arg(ok ? "done" : "failed").arg(m_ms[phase]));
+    emit phaseFinished(phase, ok, m_ms[phase]);
+
+    if (isReady()) {
+        m_readyMs = ProcessInfo::sinceStartMs();
+        TPN_INFO("Startup", QString("Ready %1 ms after start.").arg(m_readyMs));
+        emit ready();
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef STARTUPSEQUENCE_H
+#define STARTUPSEQUENCE_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QTimer>
+
+class QThread;
+class WireGuardManager;
+
+// Startup work that used to run inside the window's constructor, split into
+// phases so the window and tray icon paint first:
+//   Window     construction to first paint, reported by the window
+//   Driver     backend load and symbol resolution, on the tunnel worker
+//   Profiles   profile store scan and cache check, on a loader thread
+//   Endpoints  DNS for the recently used profiles, into the resolver cache
+// Driver and Profiles run side by side; Endpoints follows Profiles and is
+// capped so an offline resolver can't hold up the UI. ready() fires once
+// every background phase has finished, whatever its outcome.
+class StartupSequence : public QObject {
+    Q_OBJECT
+public:
+    enum Phase { Window, Driver, Profiles, Endpoints, PhaseCount };
+    Q_ENUM(Phase)
+
+    explicit StartupSequence(WireGuardManager *manager, QObject *parent = nullptr);
+    ~StartupSequence();
+
+    void start();
+    void markFirstPaint();  // Ends the Window phase; later calls are ignored
+
+    bool isReady() const { return m_running == 0 && m_started; }
+    bool isFinished(Phase phase) const { return m_ms[phase] >= 0; }
+    bool succeeded(Phase phase) const { return m_ok[phase]; }
+    qint64 phaseMs(Phase phase) const { return m_ms[phase]; }  // -1 = still running
+    qint64 firstPaintMs() const { return m_firstPaintMs; }     // Since process start, -1 = not yet
+    qint64 readyMs() const { return m_readyMs; }               // Since process start, -1 = not yet
+    static const char *phaseName(Phase phase);
+
+signals:
+    void phaseFinished(StartupSequence::Phase phase, bool ok, qint64 ms);
+    void ready();
+
+private:
+    static const int kEndpointBudgetMs = 2000;
+
+    WireGuardManager *m_manager;
+    QThread *m_loader = nullptr;
+    QElapsedTimer m_clock;
+    qint64 m_startedAt[PhaseCount] = {};
+    qint64 m_ms[PhaseCount] = { -1, -1, -1, -1 };
+    bool m_ok[PhaseCount] = {};
+    int m_running = 0;
+    bool m_started = false;
+    qint64 m_firstPaintMs = -1;
+    qint64 m_readyMs = -1;
+    QTimer m_endpointBudget;
+
+    void begin(Phase phase);
+    void finish(Phase phase, bool ok);
+    void startEndpoints();
+};
+
+#endif // STARTUPSEQUENCE_H
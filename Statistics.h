@@ -0,0 +1,24 @@
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+#include <QVector>
+#include <algorithm>
+#include <cmath>
+
+// Nearest-rank percentile of an ascending sample; `p` is in percent.
+// An empty sample gives 0.
+template <typename T>
+double percentile(const QVector<T> &sorted, double p) {
+    if (sorted.isEmpty()) return 0.0;
+    const int rank = int(std::ceil(p / 100.0 * sorted.size())) - 1;
+    return double(sorted.at(qBound(0, rank, sorted.size() - 1)));
+}
+
+// Same, for a sample in any order
+template <typename T>
+double unsortedPercentile(QVector<T> values, double p) {
+    std::sort(values.begin(), values.end());
+    return percentile(values, p);
+}
+
+#endif // STATISTICS_H
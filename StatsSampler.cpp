@@ -0,0 +1,91 @@
+#include "StatsSampler.h"
+#include <QMetaType>
+
+StatsSampler::StatsSampler(TunnelWorker *worker, QObject *parent)
+    : QObject(parent)
+    , m_worker(worker)
+    , m_timer(this)
+    , m_series(kWindow)
+{
+    qRegisterMetaType<TrafficStats>();
+    m_clock.start();
+    connect(&m_timer, &QTimer::timeout, this, &StatsSampler::sample);
+    connect(m_worker, &TunnelWorker::stateChanged, this, &StatsSampler::onStateChanged);
+}
+
+void StatsSampler::setInterval(int ms) {
+    const int previous = m_interval.fetchAndStoreRelaxed(ms);
+    QMetaObject::invokeMethod(this, [this, previous, ms]() {
+        if (!m_timer.isActive()) return;
+        m_timer.start(ms);
+        if (ms < previous) sample();  // Coming back into view: refresh now
+    }, Qt::QueuedConnection);
+}
+
+void StatsSampler::onStateChanged(TunnelWorker::State state) {
+    if (state == TunnelWorker::Up) {
+        if (m_timer.isActive()) return;
+        reset();
+        m_timer.start(m_interval.loadRelaxed());
+        sample();
+    } else if (m_timer.isActive()) {
+        m_timer.stop();
+        reset();
+        emit sampled(TrafficStats());
+    }
+}
+
+void StatsSampler::reset() {
+    m_series.clear();
+    m_current.clear();
+    m_previous.clear();
+    m_rxTotal = m_txTotal = 0;
+}
+
+const PeerStats *StatsSampler::previousFor(const PeerStats &peer, int index) const {
+    // Peers come back in the same order unless the set changed
+    if (index < m_previous.size() && memcmp(m_previous[index].publicKey, peer.publicKey, 32) == 0) {
+        return &m_previous[index];
+    }
+    for (const PeerStats &previous : m_previous) {
+        if (memcmp(previous.publicKey, peer.publicKey, 32) == 0) return &previous;
+    }
+    return nullptr;
+}
+
+void StatsSampler::sample() {
+    QElapsedTimer cost;
+    cost.start();
+    if (backendFailed(m_worker->peerStats(&m_current))) return;  // Next tick retries
+
+    // Sum per-peer deltas so peers joining, leaving or resetting their
+    // counters (reconfigure) never show up as negative or doubled traffic
+    TrafficStats stats;
+    for (int i = 0; i < m_current.size(); ++i) {
+        const PeerStats &peer = m_current[i];
+        const PeerStats *previous = previousFor(peer, i);
+        const bool continued = previous && peer.rxBytes >= previous->rxBytes && peer.txBytes >= previous->txBytes;
+        m_rxTotal += continued ? peer.rxBytes - previous->rxBytes : peer.rxBytes;
+        m_txTotal += continued ? peer.txBytes - previous->txBytes : peer.txBytes;
+        stats.lastHandshakeMs = qMax(stats.lastHandshakeMs, peer.lastHandshakeMs);
+    }
+    m_previous.swap(m_current);
+    m_series.push({ m_clock.elapsed(), m_rxTotal, m_txTotal });
+
+    stats.rxBytes = m_rxTotal;
+    stats.txBytes = m_txTotal;
+    stats.peers = m_previous.size();
+    if (m_series.size() >= 2) {
+        const Sample &last = m_series.last();
+        const Sample &before = m_series.at(m_series.size() - 2);
+        const Sample &first = m_series.first();
+        const double lastSeconds = qMax<qint64>(1, last.ms - before.ms) / 1000.0;
+        const double windowSeconds = qMax<qint64>(1, last.ms - first.ms) / 1000.0;
+        stats.rxRate = (last.rx - before.rx) / lastSeconds;
+        stats.txRate = (last.tx - before.tx) / lastSeconds;
+        stats.rxAverage = (last.rx - first.rx) / windowSeconds;
+        stats.txAverage = (last.tx - first.tx) / windowSeconds;
+    }
+    stats.sampleCostNs = cost.nsecsElapsed();
+    emit sampled(stats);
+}
@@ -0,0 +1,67 @@
+#ifndef STATSSAMPLER_H
+#define STATSSAMPLER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QAtomicInt>
+#include "RingBuffer.h"
+#include "TunnelWorker.h"
+
+struct TrafficStats {
+    quint64 rxBytes = 0;       // Since the tunnel came up, all peers
+    quint64 txBytes = 0;
+    double rxRate = 0;         // Bytes/s over the last interval
+    double txRate = 0;
+    double rxAverage = 0;      // Bytes/s over the sample window
+    double txAverage = 0;
+    qint64 lastHandshakeMs = 0;  // Unix ms of the newest handshake, 0 = never
+    int peers = 0;
+    qint64 sampleCostNs = 0;   // Driver call plus bookkeeping for this sample
+};
+Q_DECLARE_METATYPE(TrafficStats)
+
+// Polls the worker's adapter for peer counters while the tunnel is up and
+// keeps a fixed window of aggregate samples. Lives on the worker's thread so
+// driver calls never touch the UI thread; the interval can be changed from
+// any thread (fast while the window is visible, slow from the tray).
+class StatsSampler : public QObject {
+    Q_OBJECT
+public:
+    static const int kWindow = 120;  // Samples kept for the averaged rate
+
+    explicit StatsSampler(TunnelWorker *worker, QObject *parent = nullptr);
+
+    void setInterval(int ms);  // Thread-safe
+
+signals:
+    void sampled(const TrafficStats &stats);
+
+private slots:
+    void onStateChanged(TunnelWorker::State state);
+    void sample();
+
+private:
+    struct Sample {
+        qint64 ms;
+        quint64 rx;
+        quint64 tx;
+    };
+
+    TunnelWorker *m_worker;
+    QTimer m_timer;
+    QElapsedTimer m_clock;
+    QAtomicInt m_interval = 1000;
+    RingBuffer<Sample> m_series;
+    // Two counter snapshots swapped every sample; capacity is kept, so a
+    // stable peer set samples without allocating
+    QVector<PeerStats> m_current;
+    QVector<PeerStats> m_previous;
+    quint64 m_rxTotal = 0;
+    quint64 m_txTotal = 0;
+
+    const PeerStats *previousFor(const PeerStats &peer, int index) const;
+    void reset();
+};
+
+#endif // STATSSAMPLER_H
@@ -0,0 +1,166 @@
+#include "Tracer.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QGlobalStatic>
+#include <QThread>
+
+Q_GLOBAL_STATIC(Tracer, s_tracer)
+
+QAtomicInt Tracer::s_enabled;
+
+// Hands the buffer back when the owning thread exits; the spans stay
+// exportable until the next recording starts
+struct ThreadBufferHandle {
+    Tracer::ThreadBuffer *buffer = nullptr;
+    ~ThreadBufferHandle() {
+        if (buffer && !s_tracer.isDestroyed()) s_tracer->retire(buffer);
+    }
+};
+
+namespace {
+thread_local ThreadBufferHandle t_buffer;
+
+void appendEscaped(QByteArray *out, const QByteArray &text) {
+    for (char c : text) {
+        if (c == '"' || c == '\\') out->append('\\');
+        if (uchar(c) >= 0x20) out->append(c);
+    }
+}
+}
+
+Tracer &Tracer::instance() {
+    return *s_tracer;
+}
+
+Tracer::Tracer() {
+    m_clock.start();
+}
+
+Tracer::~Tracer() {
+    s_enabled.storeRelaxed(0);
+    qDeleteAll(m_buffers);
+}
+
+void Tracer::setEnabled(bool enabled) {
+    if (enabled && !s_enabled.loadRelaxed()) {
+        // New recording: buffers restart lazily when their thread next records
+        m_generation.fetchAndAddRelaxed(1);
+        m_dropped.storeRelaxed(0);
+        QMutexLocker lock(&m_mutex);
+        for (int i = m_buffers.size() - 1; i >= 0; --i) {
+            if (!m_buffers[i]->retired) continue;
+            delete m_buffers[i];
+            m_buffers.remove(i);
+        }
+    }
+    s_enabled.storeRelease(enabled ? 1 : 0);
+}
+
+void Tracer::applyEnvironment() {
+    const QString value = qEnvironmentVariable("TPN_TRACE");
+    if (value.isEmpty() || value == "0") return;
+    if (value != "1") m_exitPath = value;
+    setEnabled(true);
+}
+
+void Tracer::finish() {
+    if (m_exitPath.isEmpty()) return;
+    setEnabled(false);
+    save(m_exitPath);
+}
+
+Tracer::ThreadBuffer *Tracer::threadBuffer() {
+    ThreadBuffer *buffer = t_buffer.buffer;
+    if (!buffer) {
+        buffer = new ThreadBuffer;
+        QThread *thread = QThread::currentThread();
+        QMutexLocker lock(&m_mutex);
+        buffer->tid = m_nextTid++;
+        if (thread && !thread->objectName().isEmpty()) buffer->threadName = thread->objectName();
+        else if (qApp && thread == qApp->thread()) buffer->threadName = "Main";
+        else buffer->threadName = QString("Thread %1").arg(buffer->tid);
+        m_buffers.append(buffer);
+        t_buffer.buffer = buffer;
+    }
+    const int generation = m_generation.loadRelaxed();
+    if (buffer->generation.loadRelaxed() != generation) {
+        buffer->count.storeRelease(0);  // Before the generation, so exports never see stale spans
+        buffer->generation.storeRelease(generation);
+    }
+    return buffer;
+}
+
+void Tracer::retire(ThreadBuffer *buffer) {
+    QMutexLocker lock(&m_mutex);
+    buffer->retired = true;
+}
+
+void Tracer::record(const char *name, qint64 startNs, qint64 endNs) {
+    ThreadBuffer *buffer = threadBuffer();
+    const int index = buffer->count.loadRelaxed();
+    if (index >= kBufferSpans) {
+        m_dropped.fetchAndAddRelaxed(1);
+        return;
+    }
+    buffer->spans[index] = { name, startNs, endNs - startNs };
+    buffer->count.storeRelease(index + 1);
+}
+
+int Tracer::spanCount() {
+    const int generation = m_generation.loadRelaxed();
+    QMutexLocker lock(&m_mutex);
+    int total = 0;
+    for (ThreadBuffer *buffer : qAsConst(m_buffers)) {
+        if (buffer->generation.loadAcquire() == generation) total += buffer->count.loadAcquire();
+    }
+    return total;
+}
+
+QByteArray Tracer::toChromeJson() {
+    const int generation = m_generation.loadRelaxed();
+    QByteArray out;
+    out.reserve(64 + spanCount() * 96);
+    out += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    auto separator = [&out, &first]() {
+        if (!first) out += ",\n";
+        first = false;
+    };
+
+    QMutexLocker lock(&m_mutex);
+    for (ThreadBuffer *buffer : qAsConst(m_buffers)) {
+        if (buffer->generation.loadAcquire() != generation) continue;
+        const int count = buffer->count.loadAcquire();
+        if (!count) continue;
+        separator();
+        out += "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":";
+        out += QByteArray::number(buffer->tid);
+        out += ",\"args\":{\"name\":\"";
+        appendEscaped(&out, buffer->threadName.toUtf8());
+        out += "\"}}";
+        for (int i = 0; i < count; ++i) {
+            const Span &span = buffer->spans[i];
+            separator();
+            out += "{\"ph\":\"X\",\"cat\":\"tpn\",\"name\":\"";
+            appendEscaped(&out, QByteArray::fromRawData(span.name, int(qstrlen(span.name))));
+            out += "\",\"pid\":1,\"tid\":";
+            out += QByteArray::number(buffer->tid);
+            out += ",\"ts\":";
+            out += QByteArray::number(double(span.startNs) / 1000.0, 'f', 3);
+            out += ",\"dur\":";
+            out += QByteArray::number(double(span.durationNs) / 1000.0, 'f', 3);
+            out += '}';
+        }
+    }
+    out += "]}\n";
+    return out;
+}
+
+bool Tracer::save(const QString &path, QString *error) {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(toChromeJson()) < 0) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,94 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QString>
+#include <QVector>
+
+// Records the enclosing scope as one span when tracing is on. When it is
+// off a span costs one relaxed atomic load.
+#define TPN_TRACE_CONCAT2(a, b) a##b
+#define TPN_TRACE_CONCAT(a, b) TPN_TRACE_CONCAT2(a, b)
+#define TPN_TRACE_SCOPE(name) TraceScope TPN_TRACE_CONCAT(tpnTraceScope, __LINE__)(name)
+
+// Process-wide span recorder. Every thread appends to its own fixed-size
+// buffer, so recording takes no lock and never allocates after a thread's
+// first span; spans past a buffer's capacity are counted and dropped.
+// Recording is switched at runtime (tray menu, TPN_TRACE, the control
+// socket's "trace" command) and exported as Chrome trace JSON, which
+// chrome://tracing and ui.perfetto.dev open directly.
+class Tracer {
+public:
+    struct Span {
+        const char *name;  // String literal, not copied
+        qint64 startNs;
+        qint64 durationNs;
+    };
+
+    static Tracer &instance();
+    static bool isEnabled() { return s_enabled.loadRelaxed(); }
+
+    // Starting discards the previous recording. TPN_TRACE=1 records from
+    // startup; any other value is also the path written by finish()
+    void setEnabled(bool enabled);
+    void applyEnvironment();
+    void finish();  // Saves to the TPN_TRACE path, if one was given
+
+    void record(const char *name, qint64 startNs, qint64 endNs);
+    qint64 nowNs() const { return m_clock.nsecsElapsed(); }
+
+    QByteArray toChromeJson();  // Call with recording stopped for a consistent snapshot
+    bool save(const QString &path, QString *error = nullptr);
+    int spanCount();
+    quint64 dropped() const { return m_dropped.loadRelaxed(); }
+
+    Tracer();
+    ~Tracer();
+
+private:
+    static const int kBufferSpans = 16384;  // Per thread, 384 KB
+    static QAtomicInt s_enabled;
+
+    struct ThreadBuffer {
+        Span spans[kBufferSpans];
+        QAtomicInt count;       // Published with release, read with acquire
+        QAtomicInt generation;  // Recording the spans belong to
+        int tid = 0;
+        QString threadName;
+        bool retired = false;   // Owner thread has exited
+    };
+    friend struct ThreadBufferHandle;
+
+    QElapsedTimer m_clock;
+    QAtomicInt m_generation;
+    QAtomicInteger<quint64> m_dropped;
+    QMutex m_mutex;                  // Guards m_buffers; taken once per thread and on export
+    QVector<ThreadBuffer *> m_buffers;
+    int m_nextTid = 1;
+    QString m_exitPath;
+
+    ThreadBuffer *threadBuffer();
+    void retire(ThreadBuffer *buffer);
+};
+
+class TraceScope {
+public:
+    explicit TraceScope(const char *name)
+        : m_name(name)
+        , m_startNs(Tracer::isEnabled() ? Tracer::instance().nowNs() : -1)
+    {
+    }
+    ~TraceScope() {
+        if (m_startNs >= 0) Tracer::instance().record(m_name, m_startNs, Tracer::instance().nowNs());
+    }
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+    const char *m_name;
+    qint64 m_startNs;
+};
+
+#endif // TRACER_H
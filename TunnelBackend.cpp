@@ -0,0 +1,18 @@
+#include "TunnelBackend.h"
+#include "SimulatedBackend.h"
+#ifdef Q_OS_WIN
+#include "WireGuardDriver.h"
+#endif
+
+TunnelBackend *TunnelBackend::fromArguments(const QStringList &arguments) {
+    for (const QString &arg : arguments) {
+        if (arg == "--simulate" || arg.startsWith("--simulate=")) {
+            return new SimulatedBackend(SimulatedBackend::parseProfile(arg.section('=', 1)));
+        }
+    }
+#ifdef Q_OS_WIN
+    return new WireGuardDriver;
+#else
+    return new SimulatedBackend;
+#endif
+}
@@ -0,0 +1,51 @@
+#ifndef TUNNELBACKEND_H
+#define TUNNELBACKEND_H
+
+#include <QString>
+#include <QByteArray>
+#include <QStringList>
+#include <QUuid>
+#include <QVector>
+
+using AdapterHandle = void *;
+
+// Live per-peer counters as reported by the driver
+struct PeerStats {
+    quint8 publicKey[32];
+    quint64 rxBytes;
+    quint64 txBytes;
+    qint64 lastHandshakeMs;  // Unix ms, 0 = never
+};
+Q_DECLARE_TYPEINFO(PeerStats, Q_PRIMITIVE_TYPE);
+
+// Driver entry points used by the tunnel worker. Results are HRESULT
+// compatible (negative = failure) so driver codes pass through unchanged.
+// WireGuardDriver is the real implementation; anything else (simulators,
+// fakes) can be handed to WireGuardManager instead.
+class TunnelBackend {
+public:
+    virtual ~TunnelBackend() = default;
+
+    virtual bool load(QString *error) = 0;
+    virtual long createAdapter(const QString &name, const QUuid &guid, AdapterHandle *out) = 0;
+    virtual long openAdapter(const QString &name, AdapterHandle *out) = 0;
+    virtual void closeAdapter(AdapterHandle adapter) = 0;
+    virtual long setConfiguration(AdapterHandle adapter, const QByteArray &config) = 0;
+    virtual long setAdapterState(AdapterHandle adapter, bool up) = 0;
+    virtual long getAdapterState(AdapterHandle adapter, bool *up) = 0;
+    // Interface MTU for both families; IPv6 is left alone below its 1280 minimum
+    virtual long setMtu(AdapterHandle adapter, int mtu) = 0;
+    // Resolvers Windows uses for the adapter (IPv4 addresses, always port
+    // 53); an empty list clears them
+    virtual long setDnsServers(AdapterHandle adapter, const QStringList &servers) = 0;
+    // Fills out with one entry per peer; callers reuse out between calls
+    virtual long getPeerStats(AdapterHandle adapter, QVector<PeerStats> *out) = 0;
+
+    // --simulate[=spec] gives a SimulatedBackend, otherwise the platform's
+    // driver; there is none off Windows, so the simulator stands in there
+    static TunnelBackend *fromArguments(const QStringList &arguments);
+};
+
+inline bool backendFailed(long result) { return result < 0; }
+
+#endif // TUNNELBACKEND_H
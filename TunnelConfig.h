@@ -0,0 +1,55 @@
+#ifndef TUNNELCONFIG_H
+#define TUNNELCONFIG_H
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QList>
+#include <QVector>
+#include <cstring>
+#include "SecretArena.h"
+
+// Parsed, driver-independent form of a wg-quick style .conf file.
+// Addresses are kept in network byte order so they can be copied straight
+// into sockaddr / driver structures. Private and preshared keys live in the
+// locked SecretArena (32 bytes once set); public keys are not secret.
+
+struct IpPrefix {
+    quint8 family = 0;      // 4 or 6
+    quint8 cidr = 0;
+    quint8 addr[16] = {};   // IPv4 uses the first 4 bytes
+};
+Q_DECLARE_TYPEINFO(IpPrefix, Q_PRIMITIVE_TYPE);
+
+struct PeerConfig {
+    quint8 publicKey[32] = {};
+    SecretBuffer presharedKey;
+    bool hasPresharedKey = false;
+    quint16 persistentKeepalive = 0;
+    QByteArray endpointHost;  // Hostname or address literal, brackets stripped
+    quint16 endpointPort = 0;
+    IpPrefix endpointAddress; // Filled in by resolution; family 0 = unresolved
+    QVector<IpPrefix> allowedIPs;
+    QList<QByteArray> allowedDomains;  // "example.com" / "*.example.com", lowercase
+};
+Q_DECLARE_TYPEINFO(PeerConfig, Q_MOVABLE_TYPE);
+
+struct InterfaceConfig {
+    SecretBuffer privateKey;
+    quint16 listenPort = 0;
+    quint16 mtu = 0;                // 0 = not set
+    QVector<IpPrefix> addresses;
+    QVector<IpPrefix> dns;          // DNS server addresses (host prefixes)
+    QList<QByteArray> dnsSearch;    // Non-address DNS entries are search domains
+};
+
+inline bool operator==(const IpPrefix &a, const IpPrefix &b) {
+    return a.family == b.family && a.cidr == b.cidr && memcmp(a.addr, b.addr, sizeof(a.addr)) == 0;
+}
+inline bool operator!=(const IpPrefix &a, const IpPrefix &b) { return !(a == b); }
+
+struct TunnelConfig {
+    InterfaceConfig iface;
+    QVector<PeerConfig> peers;
+};
+
+#endif // TUNNELCONFIG_H
@@ -0,0 +1,35 @@
+#include "TunnelInstance.h"
+
+TunnelInstance::TunnelInstance(TunnelBackend *backend, QObject *parent)
+    : QObject(parent)
+    , m_worker(new TunnelWorker(backend))
+    , m_sampler(new StatsSampler(m_worker))
+    , m_watchdog(new HandshakeWatchdog(m_worker))
+{
+    // Driver calls can take seconds; keep them off the owner's event loop
+    m_thread.setObjectName("TunnelWorker");
+    m_worker->moveToThread(&m_thread);
+    m_sampler->moveToThread(&m_thread);
+    m_watchdog->moveToThread(&m_thread);
+    m_thread.start();
+}
+
+TunnelInstance::~TunnelInstance() {
+    QMetaObject::invokeMethod(m_worker, "shutdown", Qt::BlockingQueuedConnection);
+    m_thread.quit();
+    m_thread.wait();
+    delete m_sampler;
+    delete m_watchdog;
+    delete m_worker;
+}
+
+void TunnelInstance::setRoutes(const TunnelConfig &config) {
+    m_routes.clear();
+    for (const PeerConfig &peer : config.peers) m_routes.insert(peer.allowedIPs);
+    m_routeList = m_routes.prefixes();
+}
+
+void TunnelInstance::clearRoutes() {
+    m_routes.clear();
+    m_routeList.clear();
+}
@@ -0,0 +1,46 @@
+#ifndef TUNNELINSTANCE_H
+#define TUNNELINSTANCE_H
+
+#include <QObject>
+#include <QThread>
+#include "CidrSet.h"
+#include "HandshakeWatchdog.h"
+#include "StatsSampler.h"
+#include "TunnelConfig.h"
+#include "TunnelWorker.h"
+
+// One tunnel: its own worker thread carrying the adapter and state machine
+// (TunnelWorker), traffic counters (StatsSampler) and stall detection
+// (HandshakeWatchdog). Nothing is shared with other instances but the
+// backend, so commands on different tunnels run in parallel. The object
+// itself lives on the owner's thread; routes() is the instance's claim on
+// the routing table, checked by TunnelRegistry.
+class TunnelInstance : public QObject {
+    Q_OBJECT
+public:
+    explicit TunnelInstance(TunnelBackend *backend, QObject *parent = nullptr);  // Backend not owned
+    ~TunnelInstance();  // Closes the adapter and joins the thread
+
+    QString name() const { return m_name; }  // Adapter/profile name, empty until set
+    void setName(const QString &name) { m_name = name; }
+    TunnelWorker *worker() const { return m_worker; }
+    StatsSampler *sampler() const { return m_sampler; }
+    HandshakeWatchdog *watchdog() const { return m_watchdog; }
+    TunnelWorker::State state() const { return m_worker->state(); }
+
+    const CidrSet &routes() const { return m_routes; }
+    QVector<IpPrefix> routeList() const { return m_routeList; }  // Minimal form of routes()
+    void setRoutes(const TunnelConfig &config);  // Union of every peer's AllowedIPs
+    void clearRoutes();
+
+private:
+    QThread m_thread;
+    TunnelWorker *m_worker;
+    StatsSampler *m_sampler;
+    HandshakeWatchdog *m_watchdog;
+    QString m_name;
+    CidrSet m_routes;
+    QVector<IpPrefix> m_routeList;
+};
+
+#endif // TUNNELINSTANCE_H
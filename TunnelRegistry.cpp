@@ -0,0 +1,99 @@
+#include "TunnelRegistry.h"
+#include <QHostAddress>
+#include <QtEndian>
+#include "ConfigDiff.h"
+#include "DriverConfig.h"
+
+namespace {
+
+QString prefixText(const IpPrefix &prefix) {
+    const QHostAddress address = prefix.family == 6 ? QHostAddress(prefix.addr)
+                                                    : QHostAddress(qFromBigEndian<quint32>(prefix.addr));
+    return address.toString() + '/' + QString::number(prefix.cidr);
+}
+
+} // namespace
+
+TunnelRegistry::TunnelRegistry(TunnelBackend *backend, QObject *parent)
+    : QObject(parent)
+    , m_backend(backend)
+{
+    qRegisterMetaType<TunnelRegistry::Overlap>();
+}
+
+TunnelRegistry::~TunnelRegistry() {
+    // Queue every shutdown first so the adapters close side by side; each
+    // destructor then only waits for its own
+    for (TunnelInstance *instance : qAsConst(m_instances)) {
+        QMetaObject::invokeMethod(instance->worker(), "shutdown", Qt::QueuedConnection);
+    }
+    qDeleteAll(m_instances);
+}
+
+TunnelInstance *TunnelRegistry::add() {
+    TunnelInstance *instance = new TunnelInstance(m_backend);
+    m_instances.append(instance);
+    return instance;
+}
+
+void TunnelRegistry::remove(TunnelInstance *instance) {
+    if (m_instances.removeOne(instance)) delete instance;
+}
+
+TunnelInstance *TunnelRegistry::find(const QString &name) const {
+    for (TunnelInstance *instance : m_instances) {
+        if (!name.isEmpty() && instance->name() == name) return instance;
+    }
+    return nullptr;
+}
+
+QVector<TunnelRegistry::Overlap> TunnelRegistry::overlaps(const TunnelConfig &config, const TunnelInstance *except) const {
+    QVector<Overlap> out;
+    CidrSet requested;
+    for (const PeerConfig &peer : config.peers) requested.insert(peer.allowedIPs);
+    const QVector<IpPrefix> prefixes = requested.prefixes();
+    for (const TunnelInstance *other : m_instances) {
+        if (other == except || other->routes().isEmpty()) continue;
+        for (const IpPrefix &prefix : prefixes) {
+            if (!other->routes().intersects(prefix)) continue;
+            Overlap overlap;
+            overlap.tunnel = other->name();
+            overlap.prefix = prefix;
+            overlap.exact = other->routeList().contains(prefix);
+            out.append(overlap);
+        }
+    }
+    return out;
+}
+
+bool TunnelRegistry::claim(TunnelInstance *instance, const QString &name, const TunnelConfig &config, QString *error) {
+    const TunnelInstance *owner = find(name);
+    if (name.isEmpty() || (owner && owner != instance)) {
+        if (error) *error = name.isEmpty() ? QString("Tunnel needs a name.") : QString("Tunnel '%1' is already open.").arg(name);
+        return false;
+    }
+    const QVector<Overlap> found = overlaps(config, instance);
+    for (const Overlap &overlap : found) {
+        if (!overlap.exact) continue;
+        if (error) *error = describe(overlap);
+        return false;
+    }
+    instance->setName(name);
+    instance->setRoutes(config);
+    if (!found.isEmpty()) emit overlapDetected(name, found);
+    return true;
+}
+
+bool TunnelRegistry::create(TunnelInstance *instance, const QString &name, const TunnelConfig &config,
+                            const QUuid &guid, QString *error) {
+    if (!claim(instance, name, config, error)) return false;
+    instance->worker()->post(TunnelWorker::Create, name,
+                             DriverConfig::build(config, fullConfigDelta(config), TunnelConfig(), true), guid);
+    return true;
+}
+
+QString TunnelRegistry::describe(const Overlap &overlap) {
+    return overlap.exact
+            ? QString("%1 is already routed by tunnel '%2'.").arg(prefixText(overlap.prefix), overlap.tunnel)
+            : QString("%1 overlaps routes of tunnel '%2'; the longest prefix wins.").arg(prefixText(overlap.prefix), overlap.tunnel);
+}
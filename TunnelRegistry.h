@@ -0,0 +1,55 @@
+#ifndef TUNNELREGISTRY_H
+#define TUNNELREGISTRY_H
+
+#include <QObject>
+#include <QUuid>
+#include <QVector>
+#include "TunnelInstance.h"
+
+// Owns any number of TunnelInstances on one backend. The registry itself
+// is only touched from its owner's thread and holds no lock: each command
+// goes straight into that instance's worker queue, so bringing up or
+// tearing down many tunnels runs them all in parallel. Before a tunnel is
+// created its AllowedIPs are checked against every other instance's
+// routes: a range another tunnel claims exactly is ambiguous and refused,
+// partial overlaps (one range inside another, decided by longest prefix)
+// are reported through overlapDetected.
+class TunnelRegistry : public QObject {
+    Q_OBJECT
+public:
+    struct Overlap {
+        QString tunnel;   // The other instance
+        IpPrefix prefix;  // Requested range
+        bool exact = false;
+    };
+
+    explicit TunnelRegistry(TunnelBackend *backend, QObject *parent = nullptr);  // Backend not owned
+    ~TunnelRegistry();  // Shuts every instance down in parallel
+
+    TunnelInstance *add();                   // Idle and unnamed
+    void remove(TunnelInstance *instance);   // Closes its adapter; blocks until it is gone
+    TunnelInstance *find(const QString &name) const;
+    const QVector<TunnelInstance *> &instances() const { return m_instances; }
+    int count() const { return m_instances.size(); }
+
+    QVector<Overlap> overlaps(const TunnelConfig &config, const TunnelInstance *except = nullptr) const;
+    // Names the instance, claims its routes and posts Create; false (with a
+    // reason) on a name clash or an exact route conflict
+    bool create(TunnelInstance *instance, const QString &name, const TunnelConfig &config,
+                const QUuid &guid = QUuid(), QString *error = nullptr);
+    // Checks only, for tunnels whose adapter is created elsewhere
+    bool claim(TunnelInstance *instance, const QString &name, const TunnelConfig &config, QString *error = nullptr);
+
+    static QString describe(const Overlap &overlap);
+
+signals:
+    void overlapDetected(const QString &name, const QVector<TunnelRegistry::Overlap> &overlaps);
+
+private:
+    TunnelBackend *m_backend;
+    QVector<TunnelInstance *> m_instances;
+};
+
+Q_DECLARE_METATYPE(TunnelRegistry::Overlap)
+
+#endif // TUNNELREGISTRY_H
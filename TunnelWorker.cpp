@@ -0,0 +1,313 @@
+#include "TunnelWorker.h"
+#include <QMutexLocker>
+#include "Tracer.h"
+#include <algorithm>
+
+TunnelWorker::TunnelWorker(TunnelBackend *backend, QObject *parent)
+    : QObject(parent)
+    , m_backend(backend)
+{
+    m_clock.start();
+}
+
+void TunnelWorker::post(Command command, const QString &name, const SecretBuffer &config, const QUuid &guid, int tag) {
+    QMutexLocker lock(&m_queueMutex);
+    const PendingCommand cmd = { command, name, config, guid, m_clock.elapsed(), tag, false };
+
+    if (command == Close) {
+        // Everything but a pending driver load is moot once the adapter goes;
+        // a SetDns still runs first, so the adapter isn't left on a resolver
+        m_queue.erase(std::remove_if(m_queue.begin(), m_queue.end(), [](const PendingCommand &pending) {
+            return pending.command != Load && pending.command != SetDns;
+        }), m_queue.end());
+        m_queue.append(cmd);
+    } else if (command == Create) {
+        // A newer config replaces any pending one; keep only the latest
+        // power request and replay it after the new Create, along with the
+        // latest SetMtu and SetDns (they push whatever is current when they
+        // run). The rest are answered as dropped, in their place, so nobody
+        // waits on them.
+        const PendingCommand *power = nullptr;
+        const PendingCommand *mtu = nullptr;
+        const PendingCommand *dns = nullptr;
+        for (const PendingCommand &pending : m_queue) {
+            if (pending.dropped) continue;
+            if (pending.command == Start || pending.command == Stop) power = &pending;
+            else if (pending.command == SetMtu) mtu = &pending;
+            else if (pending.command == SetDns) dns = &pending;
+        }
+        QVector<PendingCommand> replay;
+        if (mtu) replay.append(*mtu);
+        if (dns) replay.append(*dns);
+        if (power) replay.append(*power);
+        auto replayed = [](const PendingCommand &pending) {
+            return pending.command == Start || pending.command == Stop || pending.command == SetMtu
+                    || pending.command == SetDns;
+        };
+        for (PendingCommand &pending : m_queue) {
+            if (pending.command == Close || pending.command == Load || replayed(pending) || pending.dropped) continue;
+            pending.dropped = true;
+            pending.config.clear();
+        }
+        m_queue.erase(std::remove_if(m_queue.begin(), m_queue.end(), [&replayed](const PendingCommand &pending) {
+            return !pending.dropped && replayed(pending);
+        }), m_queue.end());
+        m_queue.append(cmd);
+        m_queue += replay;
+    } else if (command == Start || command == Stop) {
+        // Only the last power request since the last other command matters
+        while (!m_queue.isEmpty() && (m_queue.last().command == Start || m_queue.last().command == Stop)) {
+            m_queue.removeLast();
+        }
+        m_queue.append(cmd);
+    } else {
+        m_queue.append(cmd);  // Reconfigure/Warm/Load run in order
+    }
+
+    if (!m_drainScheduled) {
+        m_drainScheduled = true;
+        QMetaObject::invokeMethod(this, [this]() { drain(); }, Qt::QueuedConnection);
+    }
+}
+
+void TunnelWorker::drain() {
+    for (;;) {
+        PendingCommand cmd;
+        {
+            QMutexLocker lock(&m_queueMutex);
+            if (m_queue.isEmpty()) {
+                m_drainScheduled = false;
+                return;
+            }
+            cmd = m_queue.takeFirst();
+        }
+
+        const qint64 startedAt = m_clock.elapsed();
+        if (cmd.dropped) {
+            emit commandFinished(cmd.command, false, startedAt - cmd.postedAt, -1, cmd.tag);
+            continue;
+        }
+        bool ok = execute(cmd);
+        emit commandFinished(cmd.command, ok, startedAt - cmd.postedAt, m_clock.elapsed() - startedAt, cmd.tag);
+    }
+}
+
+bool TunnelWorker::execute(const PendingCommand &cmd) {
+    static const char *const spanNames[] = {
+        "Worker::Create", "Worker::Reconfigure", "Worker::Start", "Worker::Stop", "Worker::Close", "Worker::Warm",
+        "Worker::Load", "Worker::SetMtu", "Worker::SetDns"
+    };
+    TPN_TRACE_SCOPE(spanNames[cmd.command]);
+    switch (cmd.command) {
+    case Create:
+        return createAdapter(cmd.name, cmd.guid, cmd.config);
+
+    case Warm:
+        return warmAdapter(cmd.name, cmd.guid);
+
+    case Reconfigure: {
+        if (!m_adapter) {
+            log("No adapter to reconfigure.", LogLevel::Warning);
+            return false;
+        }
+        long hr = m_backend->setConfiguration(m_adapter, cmd.config.view());
+        if (backendFailed(hr)) {
+            log(QString("Failed to update configuration: HRESULT 0x%1").arg(quint32(hr), 0, 16), LogLevel::Warning);
+            return false;
+        }
+        return true;
+    }
+
+    case Start: {
+        if (!m_adapter) {
+            log("No adapter created.", LogLevel::Warning);
+            return false;
+        }
+        if (state() == Up) return true;  // Coalesced: already there
+        setState(Starting);
+        long hr = m_backend->setAdapterState(m_adapter, true);
+        if (backendFailed(hr)) {
+            log(QString("Failed to start tunnel: HRESULT 0x%1").arg(quint32(hr), 0, 16), LogLevel::Warning);
+            setState(Configured);
+            return false;
+        }
+        setState(Up);
+        log("Tunnel started.");
+        return true;
+    }
+
+    case Stop: {
+        if (!m_adapter || state() != Up) return true;  // Already stopped
+        setState(Stopping);
+        long hr = m_backend->setAdapterState(m_adapter, false);
+        if (backendFailed(hr)) {
+            log(QString("Failed to stop tunnel: HRESULT 0x%1").arg(quint32(hr), 0, 16), LogLevel::Warning);
+            setState(Up);
+            return false;
+        }
+        setState(Configured);
+        log("Tunnel stopped.");
+        return true;
+    }
+
+    case Close:
+        closeAdapter();
+        return true;
+
+    case Load: {
+        QString error;
+        if (!m_backend->load(&error)) {
+            log(error, LogLevel::Warning);
+            return false;
+        }
+        return true;
+    }
+
+    case SetMtu:
+        return !m_adapter || applyMtu();  // Without one, the next Create applies it
+
+    case SetDns:
+        return !m_adapter || applyDns();
+    }
+    return false;
+}
+
+bool TunnelWorker::createAdapter(const QString &name, const QUuid &guid, const SecretBuffer &config) {
+    QElapsedTimer timer;
+    timer.start();
+    closeAdapter();  // Close existing if any
+    setState(Creating);
+
+    bool warm = false;
+    m_adapter = acquireAdapter(name, guid, &warm);
+    if (!m_adapter) {
+        setState(Idle);
+        return false;
+    }
+
+    long hr = m_backend->setConfiguration(m_adapter, config.view());
+    if (backendFailed(hr)) {
+        log("Failed to apply configuration.", LogLevel::Warning);
+        closeAdapter();
+        return false;
+    }
+
+    applyMtu();  // A failure keeps the adapter's default; not worth failing the connect
+    m_tunnelName = name;
+    setState(Configured);
+    emit adapterAcquired(name, warm, timer.elapsed());
+    log(QString("Tunnel '%1' created and configured.").arg(name));
+    return true;
+}
+
+AdapterHandle TunnelWorker::acquireAdapter(const QString &name, const QUuid &guid, bool *warm) {
+    AdapterHandle adapter = m_warm.take(name);
+    if (adapter) {
+        m_warmOrder.removeOne(name);
+        *warm = true;
+        return adapter;
+    }
+
+    // Left over from a previous run under the same identity: reuse it, but
+    // make sure it starts out down so the state machine matches
+    if (!backendFailed(m_backend->openAdapter(name, &adapter)) && adapter) {
+        m_backend->setAdapterState(adapter, false);
+        *warm = true;
+        return adapter;
+    }
+
+    *warm = false;
+    long hr = m_backend->createAdapter(name, guid.isNull() ? QUuid::createUuid() : guid, &adapter);
+    if (backendFailed(hr)) {
+        log(QString("Failed to create adapter '%1': HRESULT 0x%2").arg(name).arg(quint32(hr), 0, 16), LogLevel::Warning);
+        return nullptr;
+    }
+    return adapter;
+}
+
+bool TunnelWorker::warmAdapter(const QString &name, const QUuid &guid) {
+    const int poolSize = qMax(0, m_poolSize.loadRelaxed());
+    while (m_warm.size() > poolSize) {
+        m_backend->closeAdapter(m_warm.take(m_warmOrder.takeFirst()));
+    }
+    if (name.isEmpty() || poolSize == 0) return true;
+    if (m_warm.contains(name) || (m_adapter && name == m_tunnelName)) return true;
+    if (m_warm.size() == poolSize) {
+        m_backend->closeAdapter(m_warm.take(m_warmOrder.takeFirst()));
+    }
+
+    bool reused = false;
+    AdapterHandle adapter = acquireAdapter(name, guid, &reused);
+    if (!adapter) return false;
+    m_warm.insert(name, adapter);
+    m_warmOrder.append(name);
+    log(QString("Adapter '%1' warmed (%2).").arg(name).arg(reused ? "reopened" : "created"));
+    return true;
+}
+
+bool TunnelWorker::applyMtu() {
+    const int mtu = m_mtu.loadRelaxed();
+    if (mtu <= 0) return true;
+    long hr = m_backend->setMtu(m_adapter, mtu);
+    if (backendFailed(hr)) {
+        log(QString("Failed to set MTU %1: HRESULT 0x%2").arg(mtu).arg(quint32(hr), 0, 16), LogLevel::Warning);
+        return false;
+    }
+    return true;
+}
+
+void TunnelWorker::setDnsServers(const QStringList &servers) {
+    QMutexLocker lock(&m_dnsMutex);
+    m_dnsServers = servers;
+}
+
+bool TunnelWorker::applyDns() {
+    QStringList servers;
+    {
+        QMutexLocker lock(&m_dnsMutex);
+        servers = m_dnsServers;
+    }
+    long hr = m_backend->setDnsServers(m_adapter, servers);
+    if (backendFailed(hr)) {
+        log(QString("Failed to set DNS servers '%1': HRESULT 0x%2").arg(servers.join(',')).arg(quint32(hr), 0, 16),
+            LogLevel::Warning);
+        return false;
+    }
+    return true;
+}
+
+void TunnelWorker::closeAdapter() {
+    if (m_adapter) {
+        m_backend->closeAdapter(m_adapter);
+        m_adapter = nullptr;
+    }
+    setState(Idle);
+}
+
+long TunnelWorker::peerStats(QVector<PeerStats> *out) {
+    if (!m_adapter) return -1;
+    return m_backend->getPeerStats(m_adapter, out);
+}
+
+void TunnelWorker::shutdown() {
+    {
+        QMutexLocker lock(&m_queueMutex);
+        m_queue.clear();
+    }
+    closeAdapter();
+    for (AdapterHandle adapter : qAsConst(m_warm)) {
+        m_backend->closeAdapter(adapter);
+    }
+    m_warm.clear();
+    m_warmOrder.clear();
+}
+
+void TunnelWorker::setState(State state) {
+    if (m_state.fetchAndStoreRelease(state) != state) {
+        emit stateChanged(state);
+    }
+}
+
+void TunnelWorker::log(const QString &msg, LogLevel level) {
+    TPN_LOG(level, "Worker", msg);
+}
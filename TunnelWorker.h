@@ -0,0 +1,99 @@
+#ifndef TUNNELWORKER_H
+#define TUNNELWORKER_H
+
+#include <QObject>
+#include <QMutex>
+#include <QVector>
+#include <QElapsedTimer>
+#include <QAtomicInt>
+#include <QHash>
+#include <QStringList>
+#include "TunnelBackend.h"
+#include "SecretArena.h"
+#include "Logger.h"
+
+// Owns one adapter and drives it through
+//   Idle -> Creating -> Configured -> Starting -> Up -> Stopping -> Configured
+// on whatever thread it lives in. Reconfigure pushes a (partial) config to
+// the live adapter without touching its state. Warm pre-creates down-state
+// adapters for likely profiles so a later Create is just a config push, and
+// first closes the oldest past the pool size (a nameless Warm only trims). Load
+// runs the backend's (possibly slow) driver load off the caller's thread.
+// SetMtu pushes the value from setMtu() to the live adapter; every Create
+// applies it as well. SetDns pushes setDnsServers() the same way, but only
+// when posted.
+// Commands are posted from any thread into a queue that coalesces redundant
+// power requests (connect, disconnect, connect collapses to one connect) and
+// results come back as signals with timings. A command's tag is the
+// caller's own and comes back with its result, so callers need not track
+// what each outstanding post was for. A Create drops the pending commands
+// its full config makes moot; each is still answered, in queue order, as
+// failed with a runMs of -1. The latest SetMtu, SetDns and power request
+// are replayed after it instead.
+class TunnelWorker : public QObject {
+    Q_OBJECT
+public:
+    enum State { Idle, Creating, Configured, Starting, Up, Stopping };
+    Q_ENUM(State)
+    enum Command { Create, Reconfigure, Start, Stop, Close, Warm, Load, SetMtu, SetDns };
+    Q_ENUM(Command)
+
+    explicit TunnelWorker(TunnelBackend *backend, QObject *parent = nullptr);
+
+    // Thread-safe
+    void post(Command command, const QString &name = QString(), const SecretBuffer &config = SecretBuffer(),
+              const QUuid &guid = QUuid(), int tag = 0);
+    State state() const { return State(m_state.loadAcquire()); }
+    void setWarmPoolSize(int size) { m_poolSize.storeRelaxed(size); }
+    void setMtu(int mtu) { m_mtu.storeRelaxed(mtu); }  // 0 = leave the adapter's as is
+    int mtu() const { return m_mtu.loadRelaxed(); }
+    void setDnsServers(const QStringList &servers);  // Empty clears the adapter's
+    long peerStats(QVector<PeerStats> *out);  // Worker thread only
+
+public slots:
+    void shutdown();  // Drops pending commands, closes the adapter and the warm pool
+
+signals:
+    void stateChanged(TunnelWorker::State state);
+    void commandFinished(TunnelWorker::Command command, bool ok, qint64 queuedMs, qint64 runMs, int tag);  // runMs -1: dropped
+    void adapterAcquired(const QString &name, bool warm, qint64 ms);
+
+private:
+    struct PendingCommand {
+        Command command;
+        QString name;
+        SecretBuffer config;  // Serialized driver config, holds the keys
+        QUuid guid;
+        qint64 postedAt;
+        int tag;
+        bool dropped;  // Superseded by a later Create: answered, not run
+    };
+
+    TunnelBackend *m_backend;
+    QMutex m_queueMutex;
+    QVector<PendingCommand> m_queue;
+    bool m_drainScheduled = false;
+    QElapsedTimer m_clock;
+    QAtomicInt m_state = Idle;
+    AdapterHandle m_adapter = nullptr;
+    QString m_tunnelName;
+    QHash<QString, AdapterHandle> m_warm;  // Down-state adapters by name
+    QStringList m_warmOrder;               // Oldest first, for eviction
+    QAtomicInt m_poolSize = 2;
+    QAtomicInt m_mtu;
+    QMutex m_dnsMutex;
+    QStringList m_dnsServers;
+
+    void drain();
+    bool execute(const PendingCommand &cmd);
+    bool createAdapter(const QString &name, const QUuid &guid, const SecretBuffer &config);
+    AdapterHandle acquireAdapter(const QString &name, const QUuid &guid, bool *warm);
+    bool warmAdapter(const QString &name, const QUuid &guid);
+    void closeAdapter();
+    bool applyMtu();
+    bool applyDns();
+    void setState(State state);
+    void log(const QString &msg, LogLevel level = LogLevel::Info);
+};
+
+#endif // TUNNELWORKER_H
@@ -0,0 +1,171 @@
+#include "WireGuardDriver.h"
+#include <QCoreApplication>
+#include <QScopeGuard>
+#include <ws2tcpip.h>
+#include <iphlpapi.h>  // Interface MTU and DNS; link iphlpapi
+#include "DriverConfig.h"
+#include "SecretArena.h"
+#include "Tracer.h"
+
+bool WireGuardDriver::load(QString *error) {
+    TPN_TRACE_SCOPE("Driver::load");
+    m_library.setFileName(QCoreApplication::applicationDirPath() + "/wireguard.dll");
+    if (!m_library.load()) {
+        *error = "Failed to load wireguard.dll. Ensure it's in the exe directory.";
+        return false;
+    }
+
+    *(void **)&m_createAdapter = m_library.resolve("WireGuardCreateAdapter");
+    *(void **)&m_openAdapter = m_library.resolve("WireGuardOpenAdapter");
+    *(void **)&m_closeAdapter = m_library.resolve("WireGuardCloseAdapter");
+    *(void **)&m_setState = m_library.resolve("WireGuardSetAdapterState");
+    *(void **)&m_setConfig = m_library.resolve("WireGuardSetConfiguration");
+    *(void **)&m_getState = m_library.resolve("WireGuardGetAdapterState");
+    *(void **)&m_getConfig = m_library.resolve("WireGuardGetConfiguration");
+    *(void **)&m_getLuid = m_library.resolve("WireGuardGetAdapterLUID");
+
+    if (!m_createAdapter || !m_openAdapter || !m_closeAdapter || !m_setState || !m_setConfig || !m_getState
+        || !m_getConfig || !m_getLuid) {
+        *error = "Failed to resolve one or more DLL functions.";
+        return false;
+    }
+    return true;
+}
+
+long WireGuardDriver::createAdapter(const QString &name, const QUuid &guid, AdapterHandle *out) {
+    TPN_TRACE_SCOPE("Driver::createAdapter");
+    GUID requested = guid;
+    WIREGUARD_ADAPTER_HANDLE adapter = nullptr;
+    HRESULT hr = m_createAdapter(reinterpret_cast<const wchar_t*>(name.utf16()), L"WireGuard", &requested, &adapter);
+    *out = adapter;
+    return hr;
+}
+
+long WireGuardDriver::openAdapter(const QString &name, AdapterHandle *out) {
+    TPN_TRACE_SCOPE("Driver::openAdapter");
+    WIREGUARD_ADAPTER_HANDLE adapter = nullptr;
+    HRESULT hr = m_openAdapter(reinterpret_cast<const wchar_t*>(name.utf16()), &adapter);
+    *out = adapter;
+    return hr;
+}
+
+void WireGuardDriver::closeAdapter(AdapterHandle adapter) {
+    m_closeAdapter(static_cast<WIREGUARD_ADAPTER_HANDLE>(adapter));
+}
+
+long WireGuardDriver::setConfiguration(AdapterHandle adapter, const QByteArray &config) {
+    TPN_TRACE_SCOPE("Driver::setConfiguration");
+    return m_setConfig(static_cast<WIREGUARD_ADAPTER_HANDLE>(adapter), config.constData(), static_cast<DWORD>(config.size()));
+}
+
+long WireGuardDriver::setAdapterState(AdapterHandle adapter, bool up) {
+    TPN_TRACE_SCOPE("Driver::setAdapterState");
+    return m_setState(static_cast<WIREGUARD_ADAPTER_HANDLE>(adapter), up ? WireGuardAdapterStateUp : WireGuardAdapterStateDown);
+}
+
+long WireGuardDriver::getAdapterState(AdapterHandle adapter, bool *up) {
+    WIREGUARD_ADAPTER_STATE state;
+    HRESULT hr = m_getState(static_cast<WIREGUARD_ADAPTER_HANDLE>(adapter), &state);
+    if (SUCCEEDED(hr)) *up = (state == WireGuardAdapterStateUp);
+    return hr;
+}
+
+long WireGuardDriver::setMtu(AdapterHandle adapter, int mtu) {
+    TPN_TRACE_SCOPE("Driver::setMtu");
+    // The driver has no MTU setting; it is a property of the IP interfaces
+    NET_LUID luid;
+    m_getLuid(static_cast<WIREGUARD_ADAPTER_HANDLE>(adapter), &luid);
+    for (ADDRESS_FAMILY family : { ADDRESS_FAMILY(AF_INET), ADDRESS_FAMILY(AF_INET6) }) {
+        if (family == AF_INET6 && mtu < 1280) continue;
+        MIB_IPINTERFACE_ROW row;
+        InitializeIpInterfaceEntry(&row);
+        row.Family = family;
+        row.InterfaceLuid = luid;
+        DWORD error = GetIpInterfaceEntry(&row);
+        if (error == ERROR_NOT_FOUND) continue;  // Family not bound to the adapter
+        if (error == NO_ERROR) {
+            row.NlMtu = ULONG(mtu);
+            row.SitePrefixLength = 0;  // Must be 0 for SetIpInterfaceEntry on IPv4
+            error = SetIpInterfaceEntry(&row);
+        }
+        if (error != NO_ERROR) return HRESULT_FROM_WIN32(error);
+    }
+    return S_OK;
+}
+
+long WireGuardDriver::setDnsServers(AdapterHandle adapter, const QStringList &servers) {
+    TPN_TRACE_SCOPE("Driver::setDnsServers");
+    // Also a property of the IP interface, keyed by its GUID. The call only
+    // exists from Windows 10 2004 on, so it is looked up rather than linked
+    using SetDnsSettings = DWORD (WINAPI *)(GUID, const DNS_INTERFACE_SETTINGS *);
+    static const SetDnsSettings setDnsSettings = reinterpret_cast<SetDnsSettings>(
+            GetProcAddress(GetModuleHandleW(L"iphlpapi.dll"), "SetInterfaceDnsSettings"));
+    if (!setDnsSettings) return HRESULT_FROM_WIN32(ERROR_PROC_NOT_FOUND);
+
+    NET_LUID luid;
+    m_getLuid(static_cast<WIREGUARD_ADAPTER_HANDLE>(adapter), &luid);
+    GUID guid;
+    DWORD error = ConvertInterfaceLuidToGuid(&luid, &guid);
+    if (error != NO_ERROR) return HRESULT_FROM_WIN32(error);
+
+    std::wstring nameServers = servers.join(',').toStdWString();
+    DNS_INTERFACE_SETTINGS settings = {};
+    settings.Version = DNS_INTERFACE_SETTINGS_VERSION1;
+    settings.Flags = DNS_SETTING_NAMESERVER;
+    settings.NameServer = &nameServers[0];  // Empty clears them
+    error = setDnsSettings(guid, &settings);
+    return error == NO_ERROR ? S_OK : HRESULT_FROM_WIN32(error);
+}
+
+long WireGuardDriver::getPeerStats(AdapterHandle adapter, QVector<PeerStats> *out) {
+    // The buffer is kept between calls, so steady-state sampling does not
+    // allocate; one per thread, since every tunnel samples on its own worker.
+    // The dump carries the private and preshared keys, so it lives in the
+    // arena and is wiped as soon as the counters are out
+    thread_local SecretBuffer buffer;
+    DWORD bytes = static_cast<DWORD>(buffer.size());
+    HRESULT hr = m_getConfig(static_cast<WIREGUARD_ADAPTER_HANDLE>(adapter), buffer.data(), &bytes);
+    if (hr == HRESULT_FROM_WIN32(ERROR_MORE_DATA)) {
+        buffer = SecretBuffer(int(bytes));
+        hr = m_getConfig(static_cast<WIREGUARD_ADAPTER_HANDLE>(adapter), buffer.data(), &bytes);
+    }
+    const auto wipe = qScopeGuard([]() { SecretArena::wipe(buffer.data(), size_t(buffer.size())); });
+    if (FAILED(hr)) return hr;
+
+    // Same packed layout the configuration is set with: each peer record is
+    // followed by its allowed IPs, which are skipped here
+    const char *at = reinterpret_cast<const char *>(buffer.constData());
+    const char *end = at + bytes;
+    // Sizes are checked against what the driver wrote before anything is
+    // read or skipped; a short dump yields the peers that fit
+    if (bytes < sizeof(DriverConfig::Interface)) {
+        out->clear();
+        return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+    }
+    const DriverConfig::Interface *config = reinterpret_cast<const DriverConfig::Interface*>(at);
+    at += sizeof(DriverConfig::Interface);
+    const size_t maxPeers = size_t(end - at) / sizeof(DriverConfig::Peer);
+    out->resize(int(qMin<size_t>(config->peersCount, maxPeers)));
+    for (int i = 0; i < out->size(); ++i) {
+        if (size_t(end - at) < sizeof(DriverConfig::Peer)) {
+            out->resize(i);
+            break;
+        }
+        const DriverConfig::Peer &peer = *reinterpret_cast<const DriverConfig::Peer*>(at);
+        at += sizeof(DriverConfig::Peer);
+        const size_t allowedBytes = size_t(end - at);
+        if (peer.allowedIPsCount > allowedBytes / sizeof(DriverConfig::AllowedIp)) {
+            out->resize(i + 1);  // This peer's counters are whole; the next one can't be found
+            at = end;
+        } else {
+            at += sizeof(DriverConfig::AllowedIp) * peer.allowedIPsCount;
+        }
+        PeerStats &stats = (*out)[i];
+        memcpy(stats.publicKey, peer.publicKey, 32);
+        stats.rxBytes = peer.rxBytes;
+        stats.txBytes = peer.txBytes;
+        // FILETIME ticks (100 ns since 1601) to Unix ms
+        stats.lastHandshakeMs = peer.lastHandshake ? qint64(peer.lastHandshake / 10000) - 11644473600000LL : 0;
+    }
+    return hr;
+}
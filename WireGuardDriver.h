@@ -0,0 +1,36 @@
+#ifndef WIREGUARDDRIVER_H
+#define WIREGUARDDRIVER_H
+
+#include <QLibrary>
+#include <windows.h>
+#include "wireguard.h"
+#include "TunnelBackend.h"
+
+// TunnelBackend on top of wireguard.dll, resolved at runtime.
+class WireGuardDriver : public TunnelBackend {
+public:
+    bool load(QString *error) override;
+    long createAdapter(const QString &name, const QUuid &guid, AdapterHandle *out) override;
+    long openAdapter(const QString &name, AdapterHandle *out) override;
+    void closeAdapter(AdapterHandle adapter) override;
+    long setConfiguration(AdapterHandle adapter, const QByteArray &config) override;
+    long setAdapterState(AdapterHandle adapter, bool up) override;
+    long getAdapterState(AdapterHandle adapter, bool *up) override;
+    long setMtu(AdapterHandle adapter, int mtu) override;
+    long setDnsServers(AdapterHandle adapter, const QStringList &servers) override;
+    long getPeerStats(AdapterHandle adapter, QVector<PeerStats> *out) override;
+
+private:
+    QLibrary m_library;
+    // Function pointers (from wireguard.h)
+    decltype(&WireGuardCreateAdapter) m_createAdapter = nullptr;
+    decltype(&WireGuardOpenAdapter) m_openAdapter = nullptr;
+    decltype(&WireGuardCloseAdapter) m_closeAdapter = nullptr;
+    decltype(&WireGuardSetAdapterState) m_setState = nullptr;
+    decltype(&WireGuardSetConfiguration) m_setConfig = nullptr;
+    decltype(&WireGuardGetAdapterState) m_getState = nullptr;
+    decltype(&WireGuardGetConfiguration) m_getConfig = nullptr;
+    decltype(&WireGuardGetAdapterLUID) m_getLuid = nullptr;
+};
+
+#endif // WIREGUARDDRIVER_H
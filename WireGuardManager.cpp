@@ -1,230 +1,900 @@
 #include "WireGuardManager.h"
 #include <QDebug>
-#include <QUuid>
-#include <QFile>
-#include <QTextStream>
+#include <QMetaEnum>
+#include <QUrl>
+#include <QFileInfo>
+#include <QHash>
+#include <QSet>
+#include <QtEndian>
+#include <algorithm>
+#include "ConfigParser.h"
+#include "ConfigDiff.h"
+#include "CidrSet.h"
+#include "DriverConfig.h"
+#include "Tracer.h"
 
-WireGuardManager::WireGuardManager(QObject *parent) : QObject(parent) {}
+WireGuardManager::WireGuardManager(TunnelBackend *backend, QObject *parent)
+    : QObject(parent)
+    , m_backend(backend)
+    , m_tunnels(new TunnelRegistry(backend, this))
+    , m_primary(m_tunnels->add())
+    , m_worker(m_primary->worker())
+    , m_sampler(m_primary->sampler())
+    , m_watchdog(m_primary->watchdog())
+    , m_connection(new ConnectionState(this))
+    , m_resolver(new EndpointResolver(this))
+    , m_settings(new QSettings(QSettings::defaultFormat(), QSettings::UserScope, "TPN", "Client", this))
+    , m_profiles(new ProfileStore(this))
+    , m_importer(new BulkImporter(m_profiles, this))
+    , m_prober(new LatencyProber(this))
+    , m_domains(new DomainPolicy(this))
+    , m_selfTest(new SelfTest(this))
+    , m_pathMtu(new PathMtuProber(this))
+    , m_dns(new DnsForwarder(this))
+{
+    connect(m_sampler, &StatsSampler::sampled, this, &WireGuardManager::statsUpdated);
+    connect(m_watchdog, &HandshakeWatchdog::stalled, this, &WireGuardManager::onPeerStalled);
+    connect(m_watchdog, &HandshakeWatchdog::recovered, this, &WireGuardManager::onPeerRecovered);
+    connect(m_worker, &TunnelWorker::stateChanged, this, &WireGuardManager::onWorkerStateChanged);
+    connect(m_worker, &TunnelWorker::commandFinished, this, &WireGuardManager::onWorkerCommandFinished);
+    connect(m_worker, &TunnelWorker::adapterAcquired, this, &WireGuardManager::onAdapterAcquired);
+    connect(m_resolver, &EndpointResolver::finished, this, &WireGuardManager::onEndpointsResolved);
+    connect(m_prober, &LatencyProber::finished, this, &WireGuardManager::onProbeFinished);
+    connect(m_domains, &DomainPolicy::routesChanged, this, &WireGuardManager::onDomainRoutesChanged);
+    connect(m_importer, &BulkImporter::progressChanged, this, &WireGuardManager::progressChanged);
+    connect(m_selfTest, &SelfTest::finished, this, &WireGuardManager::onSelfTestFinished);
+    connect(m_pathMtu, &PathMtuProber::finished, this, &WireGuardManager::onPathMtuFinished);
+    connect(m_tunnels, &TunnelRegistry::overlapDetected, this, &WireGuardManager::onRouteOverlap);
+    connect(m_dns, &DnsForwarder::responseObserved, m_domains, &DomainPolicy::observeResponse);
+    applySettings();
+}
 
 WireGuardManager::~WireGuardManager() {
-    cleanup();
+    delete m_tunnels;  // Every adapter is closed before the backend goes
+    delete m_backend;
 }
 
 bool WireGuardManager::initialize() {
-    m_library.setFileName(QCoreApplication::applicationDirPath() + "/wireguard.dll");
-    if (!m_library.load()) {
-        log("Failed to load wireguard.dll. Ensure it's in the exe directory.");
-        return false;
-    }
-    if (!loadFunctions()) {
+    TPN_TRACE_SCOPE("Manager::initialize");
+    QString error;
+    if (!m_backend->load(&error)) {
+        log(error, LogLevel::Warning);
         return false;
     }
     log("WireGuard DLL initialized successfully.");
+    warmAdapters();
     return true;
 }
 
-bool WireGuardManager::loadFunctions() {
-    *(void **)&m_createAdapter = m_library.resolve("WireGuardCreateAdapter");
-    *(void **)&m_openAdapter = m_library.resolve("WireGuardOpenAdapter");
-    *(void **)&m_closeAdapter = m_library.resolve("WireGuardCloseAdapter");
-    *(void **)&m_setState = m_library.resolve("WireGuardSetAdapterState");
-    *(void **)&m_setConfig = m_library.resolve("WireGuardSetConfiguration");
-    *(void **)&m_getState = m_library.resolve("WireGuardGetAdapterState");
+void WireGuardManager::initializeAsync() {
+    m_worker->post(TunnelWorker::Load);
+}
 
-    if (!m_createAdapter || !m_openAdapter || !m_closeAdapter || !m_setState || !m_setConfig || !m_getState) {
-        log("Failed to resolve one or more DLL functions.");
-        return false;
+void WireGuardManager::createTunnel(const QString &name, const SecretBuffer &configData) {
+    m_worker->post(TunnelWorker::Create, name, configData, adapterGuid(name));
+    rememberProfile(name);
+}
+
+QUuid WireGuardManager::adapterGuid(const QString &profile) {
+    // One stable GUID per profile, so Windows keeps a single adapter/network
+    // identity for it across imports and restarts
+    const QString key = "Adapters/" + profileKey(profile) + "/guid";
+    QUuid guid(m_settings->value(key).toString());
+    if (guid.isNull()) {
+        guid = QUuid::createUuid();
+        m_settings->setValue(key, guid.toString());
     }
-    return true;
+    return guid;
 }
 
-bool WireGuardManager::createTunnel(const QString &name, const QByteArray &configData) {
-    cleanup();  // Close existing if any
+QString WireGuardManager::profileKey(const QString &profile) {
+    return QString::fromLatin1(QUrl::toPercentEncoding(profile));
+}
 
-    GUID guid;
-    CoCreateGuid(&guid);  // Or use QUuid, but for simplicity
+QStringList WireGuardManager::recentProfiles() const {
+    return m_settings->value("Adapters/recent").toStringList();
+}
 
-    HRESULT hr = m_createAdapter(reinterpret_cast<const wchar_t*>(name.utf16()), L"WireGuard", &guid, &m_adapter);
-    if (FAILED(hr)) {
-        log(QString("Failed to create adapter '%1': HRESULT 0x%2").arg(name).arg(hr, 0, 16));
-        return false;
+void WireGuardManager::rememberProfile(const QString &profile) {
+    QStringList recent = m_settings->value("Adapters/recent").toStringList();
+    recent.removeAll(profile);
+    recent.prepend(profile);
+    while (recent.size() > 8) recent.removeLast();
+    m_settings->setValue("Adapters/recent", recent);
+}
+
+void WireGuardManager::warmAdapters(int count) {
+    // Pre-create down-state adapters for the most recently used profiles;
+    // connecting to one of them skips adapter creation entirely
+    m_worker->setWarmPoolSize(count);
+    if (count <= 0) m_worker->post(TunnelWorker::Warm);  // Releases the pool
+    const QStringList recent = recentProfiles();
+    for (int i = 0; i < recent.size() && i < count; ++i) {
+        m_worker->post(TunnelWorker::Warm, recent[i], SecretBuffer(), adapterGuid(recent[i]));
     }
+}
 
-    hr = m_setConfig(m_adapter, configData.constData(), static_cast<DWORD>(configData.size()));
-    if (FAILED(hr)) {
-        log("Failed to apply configuration.");
-        cleanup();
-        return false;
+void WireGuardManager::onAdapterAcquired(const QString &name, bool warm, qint64 ms) {
+    AcquireStats &stats = warm ? m_warmStats : m_coldStats;
+    stats.count++;
+    stats.totalMs += ms;
+    log(QString("Adapter '%1' ready in %2 ms (%3). Average warm %4 ms over %5, cold %6 ms over %7.")
+        .arg(name).arg(ms).arg(warm ? "warm" : "cold")
+        .arg(m_warmStats.averageMs()).arg(m_warmStats.count)
+        .arg(m_coldStats.averageMs()).arg(m_coldStats.count));
+    emit adapterAcquired(name, warm, ms);
+}
+
+void WireGuardManager::startTunnel() {
+    // A known path MTU goes in before the first packet; unknown ones are
+    // probed once the tunnel is up, if Mtu/echoPort names a responder
+    QHostAddress target;
+    quint16 port = 0;
+    PathMtuProber::Result cached;
+    if (!m_static.iface.mtu && mtuTarget(&target, &port)
+            && m_pathMtu->lookup(PathMtuProber::networkId({ m_tunnelName }), target, port, &cached)) {
+        setMtu(cached.tunnelMtu);
     }
+    m_worker->post(TunnelWorker::Start);
+}
 
-    m_tunnelName = name;
-    emit statusChanged("Ready");
-    log(QString("Tunnel '%1' created and configured.").arg(name));
-    return true;
+void WireGuardManager::stopTunnel() {
+    m_worker->post(TunnelWorker::Stop);
+}
+
+void WireGuardManager::closeTunnel() {
+    m_hasApplied = false;  // Next apply creates a fresh adapter
+    m_importOnCreate = false;
+    m_primary->setName(QString());
+    m_primary->clearRoutes();
+    // Stop already does this once it completes; a close without a stop
+    // must not leave the forwarder serving or the adapter pointed at it
+    m_domains->stopRefresh();
+    m_dns->close();
+    m_worker->setDnsServers(QStringList());
+    m_worker->post(TunnelWorker::SetDns);
+    m_worker->post(TunnelWorker::Close);
+}
+
+void WireGuardManager::setStatsInterval(int ms) {
+    m_sampler->setInterval(ms);
+}
+
+void WireGuardManager::setSettings(QSettings *settings) {
+    m_settings = settings;
+    applySettings();
+}
+
+void WireGuardManager::applySettings() {
+    // Read once the settings object is known: at construction and again by
+    // setSettings(); everything else reads m_settings when it needs a value
+    m_pathMtu->setSettings(m_settings);
+    // WireGuard itself never answers probes, so discovery needs a responder
+    // the server runs on purpose; without one it stays off
+    m_pathMtu->setEchoPort(quint16(m_settings->value("Mtu/echoPort", 0).toUInt()));
+    m_resolver->setNameServer(QHostAddress(m_settings->value("Dns/endpointServer").toString()),
+                              quint16(m_settings->value("Dns/endpointServerPort", 53).toUInt()));
+}
+
+static ConnectionSnapshot::State connectionState(TunnelWorker::State state) {
+    switch (state) {
+    case TunnelWorker::Idle: return ConnectionSnapshot::Inactive;
+    case TunnelWorker::Creating: return ConnectionSnapshot::Creating;
+    case TunnelWorker::Configured: return ConnectionSnapshot::Disconnected;
+    case TunnelWorker::Starting: return ConnectionSnapshot::Connecting;
+    case TunnelWorker::Up: return ConnectionSnapshot::Connected;
+    case TunnelWorker::Stopping: return ConnectionSnapshot::Disconnecting;
+    }
+    return ConnectionSnapshot::Inactive;
+}
+
+static QString endpointText(const TunnelConfig &config) {
+    for (const PeerConfig &peer : config.peers) {
+        if (!peer.endpointHost.isEmpty()) return QString::fromUtf8(peer.endpointHost) + ':' + QString::number(peer.endpointPort);
+    }
+    return QString();
 }
 
-bool WireGuardManager::startTunnel() {
-    if (!m_adapter) {
-        log("No adapter created.");
+static QHostAddress prefixAddress(const IpPrefix &prefix) {
+    return prefix.family == 6 ? QHostAddress(prefix.addr) : QHostAddress(qFromBigEndian<quint32>(prefix.addr));
+}
+
+void WireGuardManager::onWorkerStateChanged(TunnelWorker::State state) {
+    // Results drive the settled states; only surface transitions here
+    if (state == TunnelWorker::Creating || state == TunnelWorker::Starting || state == TunnelWorker::Stopping) {
+        m_connection->setState(connectionState(state));
+    }
+}
+
+void WireGuardManager::onWorkerCommandFinished(TunnelWorker::Command command, bool ok, qint64 queuedMs, qint64 runMs, int tag) {
+    if (runMs < 0) {
+        // Dropped unrun for a Create, whose full config carries this change
+        // too: nothing to recover, but an import waiting on it gets its
+        // answer from that Create
+        log(QString("%1 superseded by a recreate.").arg(QMetaEnum::fromType<TunnelWorker::Command>().valueToKey(command)));
+        if (tag == ProfileUpdate) m_importOnCreate = true;
+        return;
+    }
+    log(QString("%1 %2 (queued %3 ms, driver %4 ms).")
+        .arg(QMetaEnum::fromType<TunnelWorker::Command>().valueToKey(command))
+        .arg(ok ? "done" : "failed").arg(queuedMs).arg(runMs));
+
+    switch (command) {
+    case TunnelWorker::Create:
+        if (ok) {
+            m_connection->setState(ConnectionSnapshot::Ready);
+            m_connection->setError(QString());
+        } else {
+            m_hasApplied = false;  // Next apply creates from scratch
+            m_connection->setState(ConnectionSnapshot::Inactive);
+            m_connection->setError("Failed to create tunnel.");
+        }
+        // A recovery recreate answers no import, unless it dropped one
+        if (tag == ProfileUpdate || m_importOnCreate) {
+            m_importOnCreate = false;
+            emit importFinished(m_import.name, ok, ok ? QString() : QString("Failed to create tunnel."));
+        }
+        break;
+    case TunnelWorker::Reconfigure:
+        if (!ok) {
+            // Driver state is unknown after a failed partial push: rebuild
+            // from the full config and bring it back up if it was. A failed
+            // profile update is answered by the recreate instead.
+            log("Incremental update failed, recreating adapter.", LogLevel::Warning);
+            const bool wasUp = m_worker->state() == TunnelWorker::Up;
+            m_applied = withDomainRoutes(m_static);
+            m_worker->post(TunnelWorker::Create, m_tunnelName,
+                           serializeConfig(m_applied, fullConfigDelta(m_applied), TunnelConfig(), true),
+                           adapterGuid(m_tunnelName), tag == ProfileUpdate ? ProfileUpdate : Recovery);
+            if (wasUp) startTunnel();
+            break;
+        }
+        if (tag == ProfileUpdate) emit importFinished(m_import.name, ok, QString());
+        break;
+    case TunnelWorker::Start:
+        emit progressChanged(ok ? 100 : 0);
+        m_connection->setState(ok ? ConnectionSnapshot::Connected : connectionState(m_worker->state()));
+        m_connection->setError(ok ? QString() : QString("Failed to start tunnel."));
+        if (ok && m_domains->hasRules() && !m_static.iface.dns.isEmpty()) {
+            // Learn the rule names' addresses through the tunnel's resolver
+            m_domains->refresh(prefixAddress(m_static.iface.dns.first()));
+        }
+        if (ok) startDns();
+        if (ok) discoverMtu(false);
+        if (ok && !selfTestEndpoint().isEmpty()) runSelfTest();
+        break;
+    case TunnelWorker::Stop:
+        m_domains->stopRefresh();
+        m_dns->close();
+        m_worker->setDnsServers(QStringList());
+        m_worker->post(TunnelWorker::SetDns);
+        m_selfTest->cancel();
+        m_pathMtu->cancel();
+        m_connection->setState(ok ? ConnectionSnapshot::Disconnected : connectionState(m_worker->state()));
+        m_connection->setError(ok ? QString() : QString("Failed to stop tunnel."));
+        break;
+    case TunnelWorker::Load:
+        if (ok) {
+            log("WireGuard DLL initialized successfully.");
+            warmAdapters();  // Queued behind the load, so the driver is there
+        }
+        emit initialized(ok);
+        break;
+    case TunnelWorker::Close:
+        m_connection->setState(connectionState(m_worker->state()));
+        break;
+    case TunnelWorker::SetDns:
+        // Nothing would send lookups to a forwarder the adapter can't point at
+        if (!ok && m_dns->isListening()) {
+            m_dns->close();
+            log("DNS forwarder stopped: the adapter could not be pointed at it.", LogLevel::Warning);
+        }
+        break;
+    case TunnelWorker::Warm:
+    case TunnelWorker::SetMtu:
+        break;
+    }
+    emit tunnelCommandFinished(command, ok, queuedMs, runMs);
+}
+
+void WireGuardManager::importConfig(const QString &filePath) {
+    // The store validates, copies and caches the profile; the tunnel is then
+    // brought up from the cached config like any other profile
+    QString error;
+    const int index = m_profiles->addProfile(filePath, &error);
+    if (index < 0) {
+        log(error, LogLevel::Warning);
+        emit importFinished(QFileInfo(filePath).completeBaseName(), false, "Invalid config file. Check logs.");
+        return;
+    }
+    loadProfile(m_profiles->profile(index).name);
+}
+
+bool WireGuardManager::importBundle(const QStringList &paths) {
+    return m_importer->start(paths);
+}
+
+static QByteArray peerKey(const PeerConfig &peer) {
+    return QByteArray(reinterpret_cast<const char *>(peer.publicKey), 32);
+}
+
+static IpPrefix endpointPrefix(const QHostAddress &address) {
+    IpPrefix prefix;
+    if (address.protocol() == QAbstractSocket::IPv6Protocol) {
+        Q_IPV6ADDR raw = address.toIPv6Address();
+        prefix.family = 6;
+        prefix.cidr = 128;
+        memcpy(prefix.addr, raw.c, 16);
+    } else {
+        prefix.family = 4;
+        prefix.cidr = 32;
+        qToBigEndian<quint32>(address.toIPv4Address(), prefix.addr);
+    }
+    return prefix;
+}
+
+bool WireGuardManager::loadProfile(const QString &name) {
+    TPN_TRACE_SCOPE("Manager::loadProfile");
+    TunnelConfig config;
+    if (!m_profiles->config(m_profiles->indexOf(name), &config)) {
+        log(QString("Profile '%1' not found.").arg(name), LogLevel::Warning);
+        emit importFinished(name, false, "Unknown profile.");
         return false;
     }
-    HRESULT hr = m_setState(m_adapter, WireGuardAdapterStateUp);
-    if (SUCCEEDED(hr)) {
-        emit progressChanged(100);
-        emit statusChanged("Connected");
-        log("Tunnel started.");
-        return true;
+    log(QString("Profile '%1': 1 interface, %2 peers.").arg(name).arg(config.peers.size()));
+
+    QList<QByteArray> hosts;
+    StandbyMap standbys;
+    for (const PeerConfig &peer : config.peers) {
+        if (peer.endpointHost.isEmpty()) continue;
+        hosts.append(peer.endpointHost);
+        standbys.insert(peerKey(peer), { { name, peer.endpointHost, peer.endpointPort, IpPrefix() } });
     }
-    else 
-    {
-        emit progressChanged(0);  // Fail
+
+    // Other profiles for the same server key are its standby endpoints;
+    // resolving them now makes a later failover a plain endpoint update
+    for (int i = 0; i < m_profiles->count() && !standbys.isEmpty(); ++i) {
+        TunnelConfig other;
+        if (m_profiles->profile(i).name == name || !m_profiles->config(i, &other)) continue;
+        for (const PeerConfig &peer : qAsConst(other.peers)) {
+            auto it = standbys.find(peerKey(peer));
+            if (it == standbys.end() || peer.endpointHost.isEmpty()) continue;
+            bool known = false;
+            for (const Standby &standby : qAsConst(*it)) {
+                known = known || (standby.host == peer.endpointHost && standby.port == peer.endpointPort);
+            }
+            if (known) continue;
+            it->append({ m_profiles->profile(i).name, peer.endpointHost, peer.endpointPort, IpPrefix() });
+            hosts.append(peer.endpointHost);
+        }
     }
-    log(QString("Failed to start tunnel: HRESULT 0x%1").arg(hr, 0, 16));
-    return false;
+
+    // Endpoint DNS runs on the resolver pool; the tunnel is created once all
+    // hosts are settled (a newer request supersedes a pending one)
+    m_import.name = name;
+    m_import.config = config;
+    m_import.standbys = standbys;
+    m_import.startedNs = Tracer::isEnabled() ? Tracer::instance().nowNs() : -1;
+    m_import.requestId = m_resolver->resolve(hosts);
+    return true;
 }
 
-bool WireGuardManager::stopTunnel() {
-    if (!m_adapter) return true;  // Already stopped
-    HRESULT hr = m_setState(m_adapter, WireGuardAdapterStateDown);
-    if (SUCCEEDED(hr)) {
-        emit statusChanged("Disconnected");
-        log("Tunnel stopped.");
-        return true;
+bool WireGuardManager::prefetchEndpoints(const QStringList &profiles) {
+    QList<QByteArray> hosts;
+    for (const QString &name : profiles) {
+        TunnelConfig config;
+        if (!m_profiles->config(m_profiles->indexOf(name), &config)) continue;
+        for (const PeerConfig &peer : qAsConst(config.peers)) {
+            if (!peer.endpointHost.isEmpty()) hosts.append(peer.endpointHost);
+        }
     }
-    log(QString("Failed to stop tunnel: HRESULT 0x%1").arg(hr, 0, 16));
-    return false;
+    if (hosts.isEmpty()) return false;
+    m_prefetchRequestId = m_resolver->resolve(hosts);
+    return true;
 }
 
-QString WireGuardManager::getStatus() const {
-    if (!m_adapter) return "Inactive";
-    WIREGUARD_ADAPTER_STATE state;
-    HRESULT hr = m_getState(m_adapter, &state);
-    if (SUCCEEDED(hr)) {
-        switch (state) {
-        case WireGuardAdapterStateDown: return "Disconnected";
-        case WireGuardAdapterStateUp: return "Connected";
-        default: return "Unknown";
+void WireGuardManager::onEndpointsResolved(int requestId, const ResolvedHosts &results, qint64 elapsedMs) {
+    if (requestId == m_probe.requestId) {
+        startProbe(results);
+        return;
+    }
+    if (requestId == m_prefetchRequestId) {
+        m_prefetchRequestId = 0;
+        emit endpointsPrefetched(results.size(), elapsedMs);
+        return;
+    }
+    if (m_extraRequests.contains(requestId)) {
+        startExtraTunnel(m_extraRequests.take(requestId), results);
+        return;
+    }
+    if (requestId != m_import.requestId) return;
+    m_import.requestId = 0;
+    TPN_TRACE_SCOPE("Manager::onEndpointsResolved");
+    if (m_import.startedNs >= 0 && Tracer::isEnabled()) {
+        // The lookups ran on the resolver pool; this span covers the wait
+        Tracer::instance().record("DNS::resolveEndpoints", m_import.startedNs, Tracer::instance().nowNs());
+    }
+    log(QString("Resolved %1 endpoint(s) in %2 ms.").arg(results.size()).arg(elapsedMs));
+
+    TunnelConfig config = m_import.config;
+    m_import.config = TunnelConfig();
+    for (PeerConfig &peer : config.peers) {
+        if (peer.endpointHost.isEmpty()) continue;
+        auto address = results.constFind(peer.endpointHost);
+        if (address == results.constEnd()) {
+            log(QString("Failed to resolve endpoint '%1'.").arg(QString::fromUtf8(peer.endpointHost)), LogLevel::Warning);
+            continue;
+        }
+        peer.endpointAddress = endpointPrefix(*address);
+    }
+
+    // Keep the standbys that resolved, fastest first when a probe ranked them
+    auto score = [this](const QString &profile) {
+        for (const LatencyProber::Result &result : qAsConst(m_ranking)) {
+            if (result.profile == profile) return result.score;
+        }
+        return 1e12;
+    };
+    m_standbys.clear();
+    for (auto it = m_import.standbys.begin(); it != m_import.standbys.end(); ++it) {
+        QVector<Standby> resolved;
+        for (Standby standby : qAsConst(*it)) {
+            auto address = results.constFind(standby.host);
+            if (address == results.constEnd()) continue;
+            standby.address = endpointPrefix(*address);
+            resolved.append(standby);
         }
+        if (resolved.size() > 2) {
+            std::stable_sort(resolved.begin() + 1, resolved.end(), [&score](const Standby &a, const Standby &b) {
+                return score(a.profile) < score(b.profile);
+            });
+        }
+        if (resolved.size() > 1) m_standbys.insert(it.key(), resolved);
     }
-    return "Error querying state";
+    m_import.standbys.clear();
+
+    // importFinished is emitted once the worker reports the result
+    applyConfig(m_import.name, config);
 }
 
-QByteArray WireGuardManager::parseConfigFile(const QString &filePath) {
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        log("Failed to open config file.");
-        return QByteArray();
+void WireGuardManager::applyConfig(const QString &name, const TunnelConfig &profileConfig) {
+    TPN_TRACE_SCOPE("Manager::applyConfig");
+    QString conflict;
+    if (!m_tunnels->claim(m_primary, name, profileConfig, &conflict)) {
+        log(QString("Profile '%1' not applied: %2").arg(name, conflict), LogLevel::Warning);
+        emit importFinished(name, false, conflict);
+        return;
+    }
+    // Learned domain routes survive re-applying the same rules (endpoint
+    // switches, recovery) and are dropped when the rules change
+    bool sameRules = profileConfig.peers.size() == m_static.peers.size();
+    for (int i = 0; sameRules && i < profileConfig.peers.size(); ++i) {
+        sameRules = profileConfig.peers[i].allowedDomains == m_static.peers[i].allowedDomains;
     }
+    if (!sameRules || name != m_tunnelName) m_domains->setRules(profileConfig);
+    // A pinned MTU always wins; switching profiles drops a discovered one
+    const bool mtuChanged = profileConfig.iface.mtu != m_static.iface.mtu;
+    if (profileConfig.iface.mtu || name != m_tunnelName) m_worker->setMtu(profileConfig.iface.mtu);
+    m_static = profileConfig;
+    m_connection->setProfile(name, endpointText(profileConfig));
+    const TunnelConfig config = withDomainRoutes(profileConfig);
 
-    QTextStream in(&file);
-    WireGuardConfiguration config = {};
-    bool inInterface = false;
-    bool inPeer = false;
-    WireGuardPeer peer = {};  // Assume single peer for MVP
-    config.NumPeers = 0;
+    if (!m_hasApplied) {
+        m_applied = config;
+        m_hasApplied = true;
+        m_tunnelName = name;
+        createTunnel(name, serializeConfig(config, fullConfigDelta(config), TunnelConfig(), true));
+        return;
+    }
 
-    while (!in.atEnd()) {
-        QString line = in.readLine().trimmed();
-        if (line.isEmpty() || line.startsWith('#')) continue;
+    // The adapter (and its routes) stays up; only changed fields and peers
+    // are pushed with the driver's update/remove flags
+    ConfigDelta delta = diffConfigs(m_applied, config);
+    TunnelConfig previous = m_applied;
+    m_applied = config;
+    m_tunnelName = name;
+    if (mtuChanged && profileConfig.iface.mtu) m_worker->post(TunnelWorker::SetMtu);
+    if (delta.isEmpty()) {
+        log("Configuration unchanged, adapter kept as is.");
+        emit importFinished(name, true, QString());
+        return;
+    }
+    log(QString("Reconfiguring in place: %1 added, %2 removed, %3 updated peer(s).")
+        .arg(delta.count(PeerChange::Added)).arg(delta.count(PeerChange::Removed))
+        .arg(delta.count(PeerChange::Updated)));
+    m_worker->post(TunnelWorker::Reconfigure, name, serializeConfig(config, delta, previous, false), QUuid(),
+                   ProfileUpdate);
+}
 
-        if (line == "[Interface]") {
-            inInterface = true;
-            inPeer = false;
-            continue;
-        } else if (line == "[Peer]") {
-            inInterface = false;
-            inPeer = true;
-            continue;
+TunnelConfig WireGuardManager::withDomainRoutes(const TunnelConfig &config) const {
+    TunnelConfig out = config;
+    if (!m_domains->routeCount()) return out;
+    for (int i = 0; i < out.peers.size(); ++i) {
+        const QVector<IpPrefix> routes = m_domains->routes(i);
+        if (!routes.isEmpty()) out.peers[i].allowedIPs = CidrSet::aggregate(out.peers[i].allowedIPs + routes);
+    }
+    return out;
+}
+
+void WireGuardManager::onPeerStalled(const QByteArray &publicKey, int attempt, qint64 detectMs) {
+    int index = -1;
+    for (int i = 0; i < m_static.peers.size() && index < 0; ++i) {
+        if (peerKey(m_static.peers[i]) == publicKey) index = i;
+    }
+    if (!m_hasApplied || index < 0) return;
+
+    const QString peerName = QString::fromLatin1(publicKey.toBase64().left(8));
+    if (attempt == 1) m_connection->setState(ConnectionSnapshot::Reconnecting);
+    // Sends without answers can be a path that shrank (black-holed DF
+    // packets); measure it again rather than trust the cache
+    if (attempt == 1) discoverMtu(true);
+    emit failoverStarted(attempt, detectMs);
+    const QVector<Standby> endpoints = m_standbys.value(publicKey);
+    if (endpoints.isEmpty()) {
+        log(QString("Peer %1 stalled (detected in %2 ms), no standby endpoint to switch to.")
+            .arg(peerName).arg(detectMs), LogLevel::Warning);
+        return;
+    }
+
+    // Rotate from whichever endpoint is live now (an earlier failover may
+    // already have moved it) and push only the endpoint; the adapter stays
+    PeerConfig &peer = m_static.peers[index];
+    int current = 0;
+    for (int i = 0; i < endpoints.size(); ++i) {
+        if (endpoints[i].address == peer.endpointAddress && endpoints[i].port == peer.endpointPort) current = i;
+    }
+    const Standby &next = endpoints[(current + 1) % endpoints.size()];
+    peer.endpointHost = next.host;
+    peer.endpointPort = next.port;
+    peer.endpointAddress = next.address;
+    m_connection->setEndpoint(endpointText(m_static));
+    log(QString("Peer %1 stalled (detected in %2 ms), attempt %3: switching to %4:%5 from '%6'.")
+        .arg(peerName).arg(detectMs).arg(attempt).arg(QString::fromUtf8(next.host)).arg(next.port)
+        .arg(next.profile), LogLevel::Warning);
+
+    const TunnelConfig previous = m_applied;
+    m_applied = withDomainRoutes(m_static);
+    ConfigDelta delta;
+    delta.peers.append({ PeerChange::Updated, index, PeerChange::Endpoint });
+    m_worker->post(TunnelWorker::Reconfigure, m_tunnelName, serializeConfig(m_applied, delta, previous, false), QUuid(),
+                   Failover);
+}
+
+void WireGuardManager::onPeerRecovered(const QByteArray &publicKey, int attempts, qint64 detectMs, qint64 recoverMs) {
+    log(QString("Peer %1 recovered after %2 failover(s): detected in %3 ms, recovered in %4 ms.")
+        .arg(QString::fromLatin1(publicKey.toBase64().left(8))).arg(attempts).arg(detectMs).arg(recoverMs));
+    if (m_worker->state() == TunnelWorker::Up) m_connection->setState(ConnectionSnapshot::Connected);
+    emit failoverFinished(attempts, detectMs, recoverMs);
+}
+
+void WireGuardManager::onDomainRoutesChanged(const QVector<DomainPolicy::Change> &changes) {
+    if (!m_hasApplied) return;  // Picked up by the next Create
+
+    // The driver can append to a peer's AllowedIPs but not remove single
+    // entries: peers that only gained routes get just the new ones, peers
+    // that lost any get their whole list replaced
+    QHash<int, QVector<IpPrefix>> added;
+    QSet<int> shrunk;
+    int additions = 0;
+    for (const DomainPolicy::Change &change : changes) {
+        if (change.peer >= m_static.peers.size()) continue;
+        if (change.added) {
+            added[change.peer].append(change.prefix);
+            additions++;
+        } else {
+            shrunk.insert(change.peer);
         }
+    }
 
-        QStringList parts = line.split('=');
-        if (parts.size() != 2) continue;
-        QString key = parts[0].trimmed().toLower();
-        QString value = parts[1].trimmed();
-
-        if (inInterface) {
-            if (key == "privatekey") {
-                QByteArray keyBytes = QByteArray::fromBase64(value.toUtf8(), QByteArray::Base64UrlEncoding);
-                if (keyBytes.size() == 32) {
-                    memcpy(config.PrivateKey, keyBytes.constData(), 32);
-                } else {
-                    log("Invalid PrivateKey length.");
-                    return QByteArray();
-                }
-            } else if (key == "address") {
-                // Parse IP/CIDR for Interface.Address (IPv4CIDR array)
-                // For MVP, skip or set default
-            } else if (key == "listenport") {
-                config.ListenPort = value.toUShort();
-            }
-        } else if (inPeer) {
-            if (key == "publickey") {
-                QByteArray keyBytes = QByteArray::fromBase64(value.toUtf8(), QByteArray::Base64UrlEncoding);
-                if (keyBytes.size() == 32) {
-                    memcpy(peer.PublicKey, keyBytes.constData(), 32);
-                } else {
-                    log("Invalid PublicKey length.");
-                    return QByteArray();
-                }
-            } else if (key == "endpoint") {
-                // Parse "host:port" to peer.Endpoint (sockaddr_storage)
-                QStringList hostPort = value.split(':');
-                if (hostPort.size() >= 2) {
-                    QString host = hostPort[0];
-                    quint16 port = hostPort[1].toUShort();
-                    struct addrinfo hints = {}, *res = nullptr;
-                    hints.ai_family = AF_INET;
-                    hints.ai_socktype = SOCK_DGRAM;
-                    hints.ai_protocol = IPPROTO_UDP;
-                    getaddrinfo(host.toUtf8().constData(), nullptr, &hints, &res);
-                    if (res) {
-                        memcpy(&peer.Endpoint, res->ai_addr, res->ai_addrlen);
-                        ((struct sockaddr_in*)&peer.Endpoint)->sin_port = htons(port);
-                        freeaddrinfo(res);
-                    }
-                }
-            } else if (key == "allowedips") {
-                // Parse CIDR list to peer.AllowedIPs (IPv4CIDR array)
-                // For MVP: Assume "0.0.0.0/0" full tunnel
-                if (value.contains("0.0.0.0/0")) {
-                    peer.AllowedIPs[0].Address = 0;
-                    peer.AllowedIPs[0].CIDR = 0;
-                    peer.NumAllowedIPs = 1;
-                }
-                // Extend for multi-CIDR/IPv6
+    TunnelConfig next = withDomainRoutes(m_static);
+    TunnelConfig push = next;
+    ConfigDelta delta;
+    for (int peer = 0; peer < next.peers.size(); ++peer) {
+        if (shrunk.contains(peer)) {
+            if (next.peers[peer].allowedIPs != m_applied.peers[peer].allowedIPs)
+                delta.peers.append({ PeerChange::Updated, peer, PeerChange::AllowedIPs });
+        } else if (added.contains(peer)) {
+            CidrSet current;
+            current.insert(m_applied.peers[peer].allowedIPs);
+            QVector<IpPrefix> fresh;
+            for (const IpPrefix &prefix : qAsConst(added[peer])) {
+                if (!current.contains(prefix)) fresh.append(prefix);  // Static ranges already route it
             }
-            // PresharedKey, PersistentKeepalive, etc., can be added similarly
+            if (fresh.isEmpty()) continue;
+            push.peers[peer].allowedIPs = fresh;
+            delta.peers.append({ PeerChange::Updated, peer, PeerChange::AppendAllowedIPs });
         }
     }
+    const TunnelConfig previous = m_applied;
+    m_applied = next;
+    if (delta.isEmpty()) return;
 
-    if (memcmp(config.PrivateKey, "\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0", 32) == 0) {
-        log("No PrivateKey found.");
-        return QByteArray();
+    log(QString("Domain routes: %1 added, %2 removed, %3 active, %4 peer(s) updated.")
+        .arg(additions).arg(changes.size() - additions).arg(m_domains->routeCount()).arg(delta.peers.size()),
+        LogLevel::Debug);
+    m_worker->post(TunnelWorker::Reconfigure, m_tunnelName, serializeConfig(push, delta, previous, false), QUuid(),
+                   DomainRoutes);
+}
+
+bool WireGuardManager::probeProfiles(bool loadBest) {
+    if (m_probe.requestId || m_prober->isRunning()) {
+        m_probe.loadBest |= loadBest;  // Joins the round in progress
+        return true;
     }
 
-    // Add peer if valid
-    if (memcmp(peer.PublicKey, "\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0", 32) != 0) {
-        config.Peers[config.NumPeers++] = peer;
-    } else {
-        log("No valid Peer found.");
-        return QByteArray();
+    m_probe.loadBest = loadBest;
+    m_probe.endpoints.clear();
+    QList<QByteArray> hosts;
+    for (int i = 0; i < m_profiles->count(); ++i) {
+        TunnelConfig config;
+        if (!m_profiles->config(i, &config)) continue;
+        for (const PeerConfig &peer : config.peers) {
+            if (peer.endpointHost.isEmpty()) continue;
+            m_probe.endpoints.append(qMakePair(m_profiles->profile(i).name, peer));
+            if (!hosts.contains(peer.endpointHost)) hosts.append(peer.endpointHost);
+        }
+    }
+    if (m_probe.endpoints.isEmpty()) {
+        log("No profile endpoints to probe.");
+        return false;
+    }
+    // Most hosts are already in the resolver cache from earlier loads
+    m_probe.requestId = m_resolver->resolve(hosts);
+    return true;
+}
+
+void WireGuardManager::startProbe(const ResolvedHosts &results) {
+    m_probe.requestId = 0;
+    QVector<LatencyProber::Target> targets;
+    targets.reserve(m_probe.endpoints.size());
+    for (const auto &endpoint : qAsConst(m_probe.endpoints)) {
+        auto address = results.constFind(endpoint.second.endpointHost);
+        if (address == results.constEnd()) continue;
+        LatencyProber::Target target;
+        target.profile = endpoint.first;
+        target.address = *address;
+        target.port = endpoint.second.endpointPort;
+        targets.append(target);
+    }
+    m_probe.endpoints.clear();
+    if (!m_prober->probe(targets)) {
+        log("No resolvable profile endpoints to probe.");
+        emit probeFinished(QVector<LatencyProber::Result>());
+        if (m_probe.loadBest) emit importFinished(QString(), false, "No server could be resolved.");
+        m_probe.loadBest = false;
+    }
+}
+
+void WireGuardManager::onProbeFinished(const QVector<LatencyProber::Result> &ranked, qint64 elapsedMs) {
+    m_ranking = ranked;
+    log(QString("Probed %1 endpoint(s) in %2 ms.").arg(ranked.size()).arg(elapsedMs));
+    for (const LatencyProber::Result &result : ranked) {
+        log(QString("  %1 %2:%3  rtt %4 ms, loss %5%")
+            .arg(result.profile, result.address.toString()).arg(result.port)
+            .arg(result.rttMs, 0, 'f', 1).arg(result.loss * 100, 0, 'f', 0));
+    }
+    emit probeFinished(ranked);
+
+    const bool loadBest = m_probe.loadBest;
+    m_probe.loadBest = false;
+    if (!loadBest) return;
+    const QString best = fastestProfile();
+    if (best.isEmpty()) {
+        log("No endpoint answered, keeping the current profile.", LogLevel::Warning);
+        emit importFinished(QString(), false, "No server answered the latency probe.");
+        return;
+    }
+    log(QString("Fastest profile: '%1'.").arg(best));
+    loadProfile(best);
+}
+
+QString WireGuardManager::fastestProfile() const {
+    // Results are sorted best first; a lost-only endpoint never wins
+    if (m_ranking.isEmpty() || m_ranking.first().loss >= 1.0) return QString();
+    return m_ranking.first().profile;
+}
+
+void WireGuardManager::setSelfTestEndpoint(const QString &endpoint) {
+    m_settings->setValue("SelfTest/endpoint", endpoint.trimmed());
+}
+
+QString WireGuardManager::selfTestEndpoint() const {
+    return m_settings->value("SelfTest/endpoint").toString();
+}
+
+bool WireGuardManager::runSelfTest() {
+    if (m_selfTest->isRunning() || m_worker->state() != TunnelWorker::Up) return false;
+    const QString endpoint = selfTestEndpoint();
+    const int colon = endpoint.lastIndexOf(':');
+    if (colon <= 0) return false;
+    SelfTest::Options options;
+    options.host = endpoint.left(colon);
+    if (options.host.startsWith('[') && options.host.endsWith(']')) options.host = options.host.mid(1, options.host.size() - 2);
+    options.port = quint16(endpoint.mid(colon + 1).toUInt());
+    if (!options.port) return false;
+
+    // Source the traffic from the tunnel address so it can only take the tunnel;
+    // a loopback endpoint (local test server) is reachable from nowhere else
+    const QHostAddress target(options.host);
+    const quint8 family = target.protocol() == QAbstractSocket::IPv6Protocol ? 6 : 4;
+    if (!target.isLoopback()) {
+        for (const IpPrefix &address : m_static.iface.addresses) {
+            if (address.family != family) continue;
+            options.bindAddress = prefixAddress(address);
+            break;
+        }
     }
 
-    // Serialize to config buffer (flexible array for Peers)
-    DWORD configSize = offsetof(WireGuardConfiguration, Peers) + (sizeof(WireGuardPeer) * config.NumPeers);
-    QByteArray data(reinterpret_cast<const char*>(&config), configSize);
-    log("Config parsed: 1 interface, " + QString::number(config.NumPeers) + " peers.");
-    return data;
+    m_selfTestProfile = m_tunnelName;
+    log(QString("Self-test against %1 started.").arg(endpoint));
+    emit selfTestStarted(m_selfTestProfile);
+    return m_selfTest->start(options);
 }
 
-void WireGuardManager::log(const QString &msg) {
-    qDebug() << "[WG] " << msg;
-    emit logMessage(msg);
+SelfTest::Result WireGuardManager::lastSelfTest(const QString &profile) const {
+    return SelfTest::Result::fromVariantMap(m_settings->value("Profiles/" + profileKey(profile) + "/selftest").toMap());
 }
 
-void WireGuardManager::cleanup() {
-    if (m_adapter) {
-        m_closeAdapter(m_adapter);
-        m_adapter = nullptr;
+bool WireGuardManager::mtuTarget(QHostAddress *address, quint16 *port) const {
+    for (const PeerConfig &peer : m_static.peers) {
+        if (!peer.endpointAddress.family || !peer.endpointPort) continue;
+        *address = prefixAddress(peer.endpointAddress);
+        *port = peer.endpointPort;
+        return true;
+    }
+    return false;
+}
+
+bool WireGuardManager::discoverMtu(bool force) {
+    PathMtuProber::Options options;
+    if (m_static.iface.mtu || !m_pathMtu->echoPort() || m_pathMtu->isRunning()
+            || !mtuTarget(&options.target, &options.port)) {
+        return false;
+    }
+    const QString network = PathMtuProber::networkId({ m_tunnelName });
+    if (force) m_pathMtu->invalidate(network, options.target, options.port);
+    PathMtuProber::Result cached;
+    if (!force && m_pathMtu->lookup(network, options.target, options.port, &cached)) return false;  // Applied at start
+    return m_pathMtu->start(network, options, force);
+}
+
+void WireGuardManager::setMtu(int mtu) {
+    if (mtu == m_worker->mtu()) return;
+    m_worker->setMtu(mtu);
+    m_worker->post(TunnelWorker::SetMtu);
+}
+
+void WireGuardManager::onPathMtuFinished(const PathMtuProber::Result &result) {
+    if (!result.ok) {
+        // Said once; until the failure expires reconnects skip the probe
+        if (!result.cached) log("Path MTU discovery failed: " + result.error, LogLevel::Warning);
+        emit pathMtuFinished(result);
+        return;
+    }
+    log(QString("Path MTU to %1 is %2 (%3 probes, %4 ms%5), tunnel MTU %6.")
+        .arg(result.target.toString()).arg(result.pathMtu).arg(result.probes).arg(result.elapsedMs)
+        .arg(result.cached ? ", cached" : "").arg(result.tunnelMtu));
+    // Only if it still describes the live endpoint and nothing was pinned meanwhile
+    QHostAddress target;
+    quint16 port = 0;
+    if (!m_static.iface.mtu && mtuTarget(&target, &port) && target == result.target && port == result.port) {
+        setMtu(result.tunnelMtu);
+    }
+    emit pathMtuFinished(result);
+}
+
+bool WireGuardManager::openExtraTunnel(const QString &profile) {
+    TPN_TRACE_SCOPE("Manager::openExtraTunnel");
+    TunnelConfig config;
+    if (!m_profiles->config(m_profiles->indexOf(profile), &config)) {
+        emit extraTunnelFinished(profile, false, "Unknown profile.");
+        return false;
+    }
+    if (m_tunnels->find(profile)) {
+        emit extraTunnelFinished(profile, false, "Tunnel is already open.");
+        return false;
+    }
+    QList<QByteArray> hosts;
+    for (const PeerConfig &peer : qAsConst(config.peers)) {
+        if (!peer.endpointHost.isEmpty()) hosts.append(peer.endpointHost);
+    }
+    m_extraRequests.insert(m_resolver->resolve(hosts), profile);
+    return true;
+}
+
+void WireGuardManager::startExtraTunnel(const QString &profile, const ResolvedHosts &results) {
+    TunnelConfig config;
+    if (!m_profiles->config(m_profiles->indexOf(profile), &config)) {
+        emit extraTunnelFinished(profile, false, "Unknown profile.");
+        return;
     }
-}
\ No newline at end of file
+    for (PeerConfig &peer : config.peers) {
+        auto address = results.constFind(peer.endpointHost);
+        if (!peer.endpointHost.isEmpty() && address != results.constEnd()) peer.endpointAddress = endpointPrefix(*address);
+    }
+
+    TunnelInstance *instance = m_tunnels->add();
+    QString error;
+    if (!m_tunnels->create(instance, profile, config, adapterGuid(profile), &error)) {
+        m_tunnels->remove(instance);
+        log(QString("Tunnel '%1' not opened: %2").arg(profile, error), LogLevel::Warning);
+        emit extraTunnelFinished(profile, false, error);
+        return;
+    }
+    // The instance goes away once its adapter is closed, or failed to come up
+    connect(instance->worker(), &TunnelWorker::commandFinished, this,
+            [this, instance, profile](TunnelWorker::Command command, bool ok, qint64, qint64 runMs) {
+        if (runMs < 0) return;  // Dropped for a later Create, which answers instead
+        const bool closed = command == TunnelWorker::Close;
+        if (!closed && command != TunnelWorker::Start && (ok || command != TunnelWorker::Create)) return;
+        if (closed || !ok) {
+            QMetaObject::invokeMethod(this, [this, instance]() { m_tunnels->remove(instance); }, Qt::QueuedConnection);
+        }
+        if (closed) return;
+        log(QString("Tunnel '%1' %2.").arg(profile, ok ? "up" : "failed to come up"), ok ? LogLevel::Info : LogLevel::Warning);
+        emit extraTunnelFinished(profile, ok, ok ? QString() : QString("%1 failed.").arg(QMetaEnum::fromType<TunnelWorker::Command>().valueToKey(command)));
+    });
+    instance->worker()->post(TunnelWorker::Start);
+}
+
+void WireGuardManager::closeExtraTunnel(const QString &profile) {
+    TunnelInstance *instance = m_tunnels->find(profile);
+    if (!instance || instance == m_primary) return;
+    // Name and routes are free again right away; the adapter closes on its worker
+    instance->setName(QString());
+    instance->clearRoutes();
+    instance->worker()->post(TunnelWorker::Close);
+}
+
+void WireGuardManager::onRouteOverlap(const QString &name, const QVector<TunnelRegistry::Overlap> &overlaps) {
+    for (const TunnelRegistry::Overlap &overlap : overlaps) {
+        log(QString("Tunnel '%1': %2").arg(name, TunnelRegistry::describe(overlap)), LogLevel::Warning);
+    }
+}
+
+void WireGuardManager::startDns() {
+    // Only the profile's own servers are asked; without DNS lines the
+    // adapter gets none and the system resolver is left alone. Windows
+    // sends an adapter's lookups to port 53 only, so the forwarder runs
+    // just there; otherwise the adapter is given the tunnel servers as is
+    QVector<QHostAddress> servers;
+    for (const IpPrefix &dns : qAsConst(m_static.iface.dns)) servers.append(prefixAddress(dns));
+    m_dns->close();
+    QStringList adapterServers;
+    const quint16 port = quint16(m_settings->value("Dns/port", 53).toUInt());
+    if (!servers.isEmpty()) {
+        m_dns->setUpstreams(servers);
+        if (port == 53 && m_dns->listen(QHostAddress::LocalHost, port)) {
+            adapterServers.append(QHostAddress(QHostAddress::LocalHost).toString());
+            log(QString("DNS forwarder on 127.0.0.1:53 for %1 tunnel server(s).").arg(servers.size()));
+        } else {
+            log("DNS forwarder not started: " + (port == 53 ? m_dns->errorString()
+                                                            : QString("the adapter can only use port 53.")),
+                LogLevel::Warning);
+            for (const QHostAddress &server : qAsConst(servers)) {
+                if (server.protocol() == QAbstractSocket::IPv4Protocol) adapterServers.append(server.toString());
+            }
+        }
+    }
+    m_worker->setDnsServers(adapterServers);
+    m_worker->post(TunnelWorker::SetDns);
+}
+
+void WireGuardManager::onSelfTestFinished(const SelfTest::Result &result) {
+    log("Self-test: " + result.summary(), result.ok ? LogLevel::Info : LogLevel::Warning);
+    // A cancelled run (tunnel stopped) says nothing about the profile
+    if (result.ok || m_worker->state() == TunnelWorker::Up) {
+        m_settings->setValue("Profiles/" + profileKey(m_selfTestProfile) + "/selftest", result.toVariantMap());
+    }
+    emit selfTestFinished(m_selfTestProfile, result);
+}
+
+SecretBuffer WireGuardManager::serializeConfig(const TunnelConfig &next, const ConfigDelta &delta,
+                                             const TunnelConfig &applied, bool replacePeers) {
+    TPN_TRACE_SCOPE("Manager::serializeConfig");
+    return DriverConfig::build(next, delta, applied, replacePeers);
+}
+
+void WireGuardManager::log(const QString &msg, LogLevel level) {
+    TPN_LOG(level, "WG", msg);
+}
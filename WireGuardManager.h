@@ -2,48 +2,198 @@
 #define WIREGUARDMANAGER_H
 
 #include <QObject>
-#include <QLibrary>
+#include <QThread>
 #include <QString>
 #include <QByteArray>
 #include <QSettings>
-#include <QRegExp>
-#include <windows.h>
-#include <ws2tcpip.h>  // For sockaddr
-#include "wireguard.h"  // Download and include this
+#include <QPair>
+#include "TunnelConfig.h"
+#include "ConfigDiff.h"
+#include "EndpointResolver.h"
+#include "ProfileStore.h"
+#include "LatencyProber.h"
+#include "TunnelWorker.h"
+#include "StatsSampler.h"
+#include "HandshakeWatchdog.h"
+#include "DomainPolicy.h"
+#include "BulkImporter.h"
+#include "ConnectionState.h"
+#include "SelfTest.h"
+#include "PathMtuProber.h"
+#include "TunnelRegistry.h"
+#include "DnsForwarder.h"
 
 class WireGuardManager : public QObject {
     Q_OBJECT
 public:
-    explicit WireGuardManager(QObject *parent = nullptr);
+    explicit WireGuardManager(TunnelBackend *backend, QObject *parent = nullptr);  // Takes ownership
     ~WireGuardManager();
 
-    bool initialize();
-    bool createTunnel(const QString &name, const QByteArray &configData);
-    bool startTunnel();
-    bool stopTunnel();
-    QString getStatus() const;
-    QByteArray parseConfigFile(const QString &filePath);
+    bool initialize();       // Loads the driver on the calling thread
+    void initializeAsync();  // Loads it on the worker thread instead, see initialized
+    // Tunnel commands are queued to the worker thread; results arrive via
+    // tunnelCommandFinished and are reflected in connection()
+    void createTunnel(const QString &name, const SecretBuffer &configData);
+    void startTunnel();
+    void stopTunnel();
+    void closeTunnel();
+    // Typed state, profile, endpoint and last error for every consumer;
+    // reading or subscribing to it never reaches the driver
+    ConnectionState *connection() const { return m_connection; }
+    TunnelWorker::State tunnelState() const { return m_worker->state(); }
+    QString tunnelName() const { return m_tunnelName; }  // Last applied profile
+    void warmAdapters(int count = 2);  // Called by initialize(); 0 closes the warm ones
+    void setSettings(QSettings *settings);  // Where adapter identities persist; not owned
+    QStringList recentProfiles() const;     // Most recently created first
+    // Fills the resolver cache with the endpoints of these profiles so loading
+    // one of them later skips DNS; false if there was nothing to resolve
+    bool prefetchEndpoints(const QStringList &profiles);
+    // Endpoint lookups; the Dns/endpointServer setting points them at one
+    // server instead of the system resolver
+    EndpointResolver *resolver() const { return m_resolver; }
+    ProfileStore *profileStore() const { return m_profiles; }
+    void importConfig(const QString &filePath);  // Adds to the profile store, then loadProfile()
+    // Directories and .zip bundles of configs into the store, without loading
+    // any; progress comes through progressChanged, the result from bulkImporter()
+    bool importBundle(const QStringList &paths);
+    BulkImporter *bulkImporter() const { return m_importer; }
+    bool loadProfile(const QString &name);       // Async, see importFinished
+    // Creates the adapter on first use, afterwards diffs against the applied
+    // config and updates the live adapter in place
+    void applyConfig(const QString &name, const TunnelConfig &config);
+    // Probes every endpoint in the profile store; with loadBest the fastest
+    // answering profile is then loaded as if the user had picked it
+    bool probeProfiles(bool loadBest = false);
+    QString fastestProfile() const;  // From the last probe round, empty if none answered
+    LatencyProber *prober() const { return m_prober; }
+    void setStatsInterval(int ms);  // Traffic sampling period while connected
+    DomainPolicy *domainPolicy() const { return m_domains; }
+    // Stalled peers fail over to the same server key's endpoint in other
+    // profiles, resolved when the profile is loaded
+    HandshakeWatchdog *watchdog() const { return m_watchdog; }
+    // Throughput/latency self-test against a SelfTestServer at host:port (or
+    // [v6]:port), run automatically after every successful start; empty
+    // turns it off. Results are kept per profile
+    void setSelfTestEndpoint(const QString &endpoint);
+    QString selfTestEndpoint() const;
+    bool runSelfTest();  // False without an endpoint, a connection, or while one runs
+    SelfTest::Result lastSelfTest(const QString &profile) const;
+    // Profiles without an MTU line get the path MTU to their endpoint: from
+    // the cache before connecting, otherwise probed once the tunnel is up,
+    // and probed again when the watchdog sees a peer stall. Probing needs
+    // the Mtu/echoPort setting: the server's echo responder, not WireGuard
+    PathMtuProber *pathMtu() const { return m_pathMtu; }
+    // Further tunnels next to the one above, each with its own adapter,
+    // worker thread and stats. A profile routing AllowedIPs that another
+    // open tunnel already routes is refused; partial overlaps are logged
+    TunnelRegistry *tunnels() const { return m_tunnels; }
+    // While the tunnel is up and its profile has DNS servers, a caching
+    // forwarder to them listens on 127.0.0.1:53 and the adapter's DNS points
+    // at it; the names it resolves also feed domainPolicy(). If 53 is taken,
+    // or the "Dns/port" setting names another port, the adapter is pointed
+    // at the tunnel servers directly instead
+    DnsForwarder *dnsForwarder() const { return m_dns; }
+    bool openExtraTunnel(const QString &profile);  // Async, see extraTunnelFinished
+    void closeExtraTunnel(const QString &profile);
 
 signals:
-    void statusChanged(const QString &status);
-    void logMessage(const QString &msg);
+    void initialized(bool ok);
+    void endpointsPrefetched(int hosts, qint64 ms);
     void progressChanged(int value);  // New: For UI feedback
+    void importFinished(const QString &tunnelName, bool ok, const QString &error);
+    void tunnelCommandFinished(TunnelWorker::Command command, bool ok, qint64 queuedMs, qint64 runMs);
+    void adapterAcquired(const QString &name, bool warm, qint64 ms);  // Cold vs warm create timing
+    void probeFinished(const QVector<LatencyProber::Result> &ranked);
+    void statsUpdated(const TrafficStats &stats);
+    void failoverStarted(int attempt, qint64 detectMs);
+    void failoverFinished(int attempts, qint64 detectMs, qint64 recoverMs);
+    void selfTestStarted(const QString &profile);
+    void selfTestFinished(const QString &profile, const SelfTest::Result &result);
+    void pathMtuFinished(const PathMtuProber::Result &result);
+    void extraTunnelFinished(const QString &profile, bool ok, const QString &error);
+
+private slots:
+    void onEndpointsResolved(int requestId, const ResolvedHosts &results, qint64 elapsedMs);
+    void onWorkerStateChanged(TunnelWorker::State state);
+    void onWorkerCommandFinished(TunnelWorker::Command command, bool ok, qint64 queuedMs, qint64 runMs, int tag);
+    void onAdapterAcquired(const QString &name, bool warm, qint64 ms);
+    void onProbeFinished(const QVector<LatencyProber::Result> &ranked, qint64 elapsedMs);
+    void onDomainRoutesChanged(const QVector<DomainPolicy::Change> &changes);
+    void onPeerStalled(const QByteArray &publicKey, int attempt, qint64 detectMs);
+    void onPeerRecovered(const QByteArray &publicKey, int attempts, qint64 detectMs, qint64 recoverMs);
+    void onSelfTestFinished(const SelfTest::Result &result);
+    void onPathMtuFinished(const PathMtuProber::Result &result);
+    void onRouteOverlap(const QString &name, const QVector<TunnelRegistry::Overlap> &overlaps);
 
 private:
-    QLibrary m_library;
-    WIREGUARD_ADAPTER_HANDLE m_adapter = nullptr;
+    struct Standby {
+        QString profile;
+        QByteArray host;
+        quint16 port;
+        IpPrefix address;
+    };
+    using StandbyMap = QHash<QByteArray, QVector<Standby>>;  // By peer public key, [0] = own endpoint
+    // Why a Create/Reconfigure was posted; travels with it as the worker tag
+    enum ChangeKind { ProfileUpdate, DomainRoutes, Failover, Recovery };
+
+    TunnelBackend *m_backend;
+    TunnelRegistry *m_tunnels;
+    TunnelInstance *m_primary;  // The tunnel the profile/connect API drives
+    TunnelWorker *m_worker;     // m_primary's
+    StatsSampler *m_sampler;
+    HandshakeWatchdog *m_watchdog;
+    QHash<int, QString> m_extraRequests;  // Resolver request id -> extra tunnel profile
+    ConnectionState *m_connection;
+    EndpointResolver *m_resolver;
+    QSettings *m_settings;
+    ProfileStore *m_profiles;
+    BulkImporter *m_importer;
+    struct PendingImport {
+        int requestId = 0;
+        QString name;
+        TunnelConfig config;
+        StandbyMap standbys;  // Unresolved
+        qint64 startedNs = -1;  // Tracer clock, -1 = not tracing
+    } m_import;
+    StandbyMap m_standbys;    // Resolved, for the applied profile
+    int m_prefetchRequestId = 0;
+    LatencyProber *m_prober;
+    struct PendingProbe {
+        int requestId = 0;
+        bool loadBest = false;
+        QVector<QPair<QString, PeerConfig>> endpoints;  // Profile, peer
+    } m_probe;
+    QVector<LatencyProber::Result> m_ranking;
+    DomainPolicy *m_domains;
+    SelfTest *m_selfTest;
+    QString m_selfTestProfile;  // Profile the running test belongs to
+    PathMtuProber *m_pathMtu;
+    DnsForwarder *m_dns;
+    TunnelConfig m_static;    // Profile config as passed to applyConfig()
+    TunnelConfig m_applied;   // Last config pushed to the adapter (m_static plus domain routes)
+    bool m_hasApplied = false;
+    bool m_importOnCreate = false;  // A dropped profile update is answered by the Create that dropped it
     QString m_tunnelName;
-    // Function pointers (from wireguard.h)
-    decltype(&WireGuardCreateAdapter) m_createAdapter = nullptr;
-    decltype(&WireGuardOpenAdapter) m_openAdapter = nullptr;
-    decltype(&WireGuardCloseAdapter) m_closeAdapter = nullptr;
-    decltype(&WireGuardSetAdapterState) m_setState = nullptr;
-    decltype(&WireGuardSetConfiguration) m_setConfig = nullptr;
-    decltype(&WireGuardGetAdapterState) m_getState = nullptr;  // Optional for status
-
-    bool loadFunctions();
-    void log(const QString &msg);
-    void cleanup();
+    struct AcquireStats {
+        int count = 0;
+        qint64 totalMs = 0;
+        qint64 averageMs() const { return count ? totalMs / count : 0; }
+    } m_warmStats, m_coldStats;
+
+    SecretBuffer serializeConfig(const TunnelConfig &next, const ConfigDelta &delta,
+                               const TunnelConfig &applied, bool replacePeers);
+    TunnelConfig withDomainRoutes(const TunnelConfig &config) const;
+    void startProbe(const ResolvedHosts &results);
+    QUuid adapterGuid(const QString &profile);
+    void applySettings();  // Pushes the settings helpers read once into them
+    static QString profileKey(const QString &profile);
+    bool mtuTarget(QHostAddress *address, quint16 *port) const;  // First resolved endpoint
+    bool discoverMtu(bool force);
+    void setMtu(int mtu);
+    void rememberProfile(const QString &profile);
+    void startExtraTunnel(const QString &profile, const ResolvedHosts &results);
+    void startDns();
+    void log(const QString &msg, LogLevel level = LogLevel::Info);
 };
 
 #endif // WIREGUARDMANAGER_H
\ No newline at end of file
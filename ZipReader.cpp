@@ -0,0 +1,134 @@
+#include "ZipReader.h"
+#include <QtEndian>
+#include <zlib.h>
+
+namespace {
+const quint32 kLocalMagic = 0x04034b50;
+const quint32 kCentralMagic = 0x02014b50;
+const quint32 kEndMagic = 0x06054b50;
+const int kLocalHeaderBytes = 30;
+const int kCentralHeaderBytes = 46;
+const int kEndRecordBytes = 22;
+const quint32 kMaxEntryBytes = 16 * 1024 * 1024;  // Far beyond any config; bounds a zip bomb
+
+quint16 u16(const uchar *p) { return qFromLittleEndian<quint16>(p); }
+quint32 u32(const uchar *p) { return qFromLittleEndian<quint32>(p); }
+}
+
+ZipReader::~ZipReader() {
+    if (m_data) m_file.unmap(const_cast<uchar *>(m_data));
+}
+
+bool ZipReader::open(const QString &path, QString *error) {
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        *error = "Cannot open archive.";
+        return false;
+    }
+    m_size = m_file.size();
+    if (m_size < kEndRecordBytes || !(m_data = m_file.map(0, m_size))) {
+        *error = "Not a zip archive.";
+        return false;
+    }
+
+    // The end record sits in the last 22 bytes plus an optional comment
+    qint64 end = -1;
+    for (qint64 pos = m_size - kEndRecordBytes; pos >= qMax<qint64>(0, m_size - kEndRecordBytes - 0xFFFF); --pos) {
+        if (u32(m_data + pos) == kEndMagic) {
+            end = pos;
+            break;
+        }
+    }
+    if (end < 0) {
+        *error = "Not a zip archive.";
+        return false;
+    }
+    const quint16 count = u16(m_data + end + 10);
+    const quint32 directoryOffset = u32(m_data + end + 16);
+    if (u16(m_data + end + 4) != 0 || count == 0xFFFF || directoryOffset == 0xFFFFFFFFu) {
+        *error = "Multi-disk and zip64 archives are not supported.";
+        return false;
+    }
+
+    m_entries.reserve(count);
+    qint64 pos = directoryOffset;
+    for (int i = 0; i < count; ++i) {
+        if (pos + kCentralHeaderBytes > end || u32(m_data + pos) != kCentralMagic) {
+            *error = "Corrupt zip directory.";
+            return false;
+        }
+        const uchar *h = m_data + pos;
+        const quint16 nameBytes = u16(h + 28);
+        const quint16 extraBytes = u16(h + 30);
+        const quint16 commentBytes = u16(h + 32);
+        if (pos + kCentralHeaderBytes + nameBytes > end) {
+            *error = "Corrupt zip directory.";
+            return false;
+        }
+        Entry entry;
+        entry.method = u16(h + 10);
+        entry.crc = u32(h + 16);
+        entry.compressedSize = u32(h + 20);
+        entry.size = u32(h + 24);
+        entry.localOffset = u32(h + 42);
+        const char *name = reinterpret_cast<const char *>(h + kCentralHeaderBytes);
+        // Bit 11: UTF-8 names; older tools write CP437, close enough as Latin-1
+        entry.name = (u16(h + 8) & 0x800) ? QString::fromUtf8(name, nameBytes) : QString::fromLatin1(name, nameBytes);
+        if (u16(h + 8) & 0x1) entry.method = 0xFFFF;  // Encrypted: read() refuses it
+        m_entries.append(entry);
+        pos += kCentralHeaderBytes + nameBytes + extraBytes + commentBytes;
+    }
+    return true;
+}
+
+bool ZipReader::read(const Entry &entry, QByteArray *out, QString *error) const {
+    if (entry.method != 0 && entry.method != 8) {
+        *error = "Unsupported compression or encrypted entry.";
+        return false;
+    }
+    if (entry.size > kMaxEntryBytes) {
+        *error = "Entry too large.";
+        return false;
+    }
+    const qint64 local = entry.localOffset;
+    if (local + kLocalHeaderBytes > m_size || u32(m_data + local) != kLocalMagic) {
+        *error = "Corrupt zip entry.";
+        return false;
+    }
+    const qint64 dataOffset = local + kLocalHeaderBytes + u16(m_data + local + 26) + u16(m_data + local + 28);
+    if (dataOffset + entry.compressedSize > m_size) {
+        *error = "Truncated zip entry.";
+        return false;
+    }
+    const uchar *data = m_data + dataOffset;
+
+    out->resize(int(entry.size));
+    if (entry.method == 0) {
+        if (entry.compressedSize != entry.size) {
+            *error = "Corrupt zip entry.";
+            return false;
+        }
+        memcpy(out->data(), data, entry.size);
+    } else {
+        z_stream stream = {};
+        if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {  // Raw deflate, no zlib header
+            *error = "Inflate failed.";
+            return false;
+        }
+        stream.next_in = const_cast<Bytef *>(data);
+        stream.avail_in = entry.compressedSize;
+        stream.next_out = reinterpret_cast<Bytef *>(out->data());
+        stream.avail_out = entry.size;
+        const int result = inflate(&stream, Z_FINISH);
+        inflateEnd(&stream);
+        if (result != Z_STREAM_END || stream.total_out != entry.size) {
+            *error = "Corrupt compressed entry.";
+            return false;
+        }
+    }
+    if (crc32(0, reinterpret_cast<const Bytef *>(out->constData()), uInt(out->size())) != entry.crc) {
+        *error = "CRC mismatch.";
+        return false;
+    }
+    return true;
+}
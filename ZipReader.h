@@ -0,0 +1,36 @@
+#ifndef ZIPREADER_H
+#define ZIPREADER_H
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+// Read-only access to the entries of a .zip archive: stored and deflated
+// entries, no encryption, spanning or zip64. That covers the profile
+// bundles providers hand out. The archive is memory-mapped, so once open()
+// has returned, read() may be called from several threads at once.
+class ZipReader {
+public:
+    struct Entry {
+        QString name;  // Path inside the archive, '/' separated
+        quint16 method = 0;
+        quint32 crc = 0;
+        quint32 compressedSize = 0;
+        quint32 size = 0;
+        quint32 localOffset = 0;
+    };
+
+    ~ZipReader();
+
+    bool open(const QString &path, QString *error);
+    const QVector<Entry> &entries() const { return m_entries; }
+    bool read(const Entry &entry, QByteArray *out, QString *error) const;  // Checks size and CRC
+
+private:
+    QFile m_file;
+    const uchar *m_data = nullptr;
+    qint64 m_size = 0;
+    QVector<Entry> m_entries;
+};
+
+#endif // ZIPREADER_H
@@ -0,0 +1,52 @@
+#include "AllocationCounter.h"
+#include <atomic>
+#include <cstddef>
+
+#if defined(__GLIBC__)
+
+namespace {
+std::atomic<quint64> g_allocations{ 0 };
+}
+
+// glibc exports its allocator under these names too, so the wrappers can
+// forward without dlsym (which itself allocates)
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *pointer, size_t size);
+
+void *malloc(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(pointer, size);
+}
+}
+
+bool AllocationCounter::isAvailable() {
+    return true;
+}
+
+quint64 AllocationCounter::count() {
+    return g_allocations.load(std::memory_order_relaxed);
+}
+
+#else
+
+bool AllocationCounter::isAvailable() {
+    return false;
+}
+
+quint64 AllocationCounter::count() {
+    return 0;
+}
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <QtGlobal>
+
+// Counts heap allocations made through malloc, calloc and realloc in this
+// process, Qt containers included. Only where the executable can interpose
+// the C library's allocator (glibc); elsewhere isAvailable() is false and
+// the count stays 0.
+namespace AllocationCounter {
+
+bool isAvailable();
+quint64 count();
+
+} // namespace AllocationCounter
+
+#endif // ALLOCATIONCOUNTER_H
@@ -0,0 +1,87 @@
+#include "BenchUtil.h"
+#include <QFile>
+#include <QJsonDocument>
+#include <QRandomGenerator>
+#include <QTextStream>
+
+namespace Bench {
+
+namespace {
+
+// Value of the last `name=...` argument; null when there is none
+QString lookup(const QStringList &arguments, const QString &name) {
+    const QString prefix = name + QLatin1Char('=');
+    QString value;
+    for (const QString &arg : arguments) {
+        if (arg.startsWith(prefix)) value = arg.mid(prefix.size());
+        else if (arg == name) value = QLatin1String("");
+    }
+    return value;
+}
+
+} // namespace
+
+bool hasOption(const QStringList &arguments, const QString &name) {
+    return !lookup(arguments, name).isNull();
+}
+
+QString option(const QStringList &arguments, const QString &name, const QString &fallback) {
+    const QString value = lookup(arguments, name);
+    return value.isEmpty() ? fallback : value;
+}
+
+int intOption(const QStringList &arguments, const QString &name, int fallback, int minimum) {
+    bool ok = false;
+    const int value = lookup(arguments, name).toInt(&ok);
+    return ok ? qMax(minimum, value) : fallback;
+}
+
+QVector<int> intListOption(const QStringList &arguments, const QString &name, const QVector<int> &fallback,
+                           int minimum) {
+    QVector<int> values;
+    for (const QString &item : lookup(arguments, name).split(',', Qt::SkipEmptyParts)) {
+        values.append(qMax(minimum, item.toInt()));
+    }
+    return values.isEmpty() ? fallback : values;
+}
+
+int writeReport(const QJsonObject &report, const QString &outputPath) {
+    const QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+    if (outputPath.isEmpty()) {
+        QTextStream(stdout) << json;
+        return 0;
+    }
+    QFile file(outputPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        QTextStream(stderr) << "Failed to write " << outputPath << '\n';
+        return 1;
+    }
+    file.write(json);
+    return 0;
+}
+
+int writeReport(const QJsonObject &report, const QStringList &arguments) {
+    return writeReport(report, option(arguments, "--bench-out"));
+}
+
+bool allPassed(const QJsonObject &checks) {
+    for (auto it = checks.constBegin(); it != checks.constEnd(); ++it) {
+        if (!it.value().toBool()) return false;
+    }
+    return true;
+}
+
+int finish(const QJsonObject &report, const QStringList &arguments, bool passed, const QString &failure) {
+    if (writeReport(report, arguments) != 0) return 1;
+    if (passed) return 0;
+    QTextStream(stderr) << failure << '\n';
+    return 1;
+}
+
+QString randomKey() {
+    quint32 words[8];
+    QRandomGenerator::global()->fillRange(words);
+    return QString::fromLatin1(QByteArray(reinterpret_cast<const char *>(words), 32).toBase64());
+}
+
+} // namespace Bench
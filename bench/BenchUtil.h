@@ -0,0 +1,47 @@
+#ifndef BENCHUTIL_H
+#define BENCHUTIL_H
+
+#include "Statistics.h"
+#include <QEventLoop>
+#include <QJsonObject>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+
+// Shared plumbing for the benchmark modes: `--name=value` options, the
+// JSON report and waiting on a signal. Options are looked up by their full
+// flag; the last occurrence wins.
+namespace Bench {
+
+bool hasOption(const QStringList &arguments, const QString &name);
+QString option(const QStringList &arguments, const QString &name, const QString &fallback = QString());
+int intOption(const QStringList &arguments, const QString &name, int fallback, int minimum = 0);
+// Comma-separated list, each value clamped to at least `minimum`
+QVector<int> intListOption(const QStringList &arguments, const QString &name, const QVector<int> &fallback,
+                           int minimum = 1);
+
+// Writes the report to `outputPath`, or stdout when it is empty. Returns
+// the exit code: 1 when the file could not be written.
+int writeReport(const QJsonObject &report, const QString &outputPath);
+int writeReport(const QJsonObject &report, const QStringList &arguments);  // To --bench-out
+
+// True when every check in the object passed
+bool allPassed(const QJsonObject &checks);
+// Writes the report; a failed check prints `failure` and exits 1 as well
+int finish(const QJsonObject &report, const QStringList &arguments, bool passed, const QString &failure);
+
+// Random 32-byte key, base64 as in a config file
+QString randomKey();
+
+// Runs the event loop until `signal` fires, or the timeout passes
+template <typename Sender, typename Signal>
+bool waitFor(const Sender *sender, Signal signal, int timeoutMs) {
+    QEventLoop loop;
+    QObject::connect(sender, signal, &loop, [&loop]() { loop.quit(); });
+    QTimer::singleShot(timeoutMs, &loop, [&loop]() { loop.exit(1); });
+    return loop.exec() == 0;
+}
+
+} // namespace Bench
+
+#endif // BENCHUTIL_H
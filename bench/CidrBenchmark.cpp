@@ -0,0 +1,209 @@
+#include "CidrBenchmark.h"
+#include "BenchUtil.h"
+#include "CidrSet.h"
+#include "ConfigParser.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QSet>
+#include <QTextStream>
+#include <QtEndian>
+#include <vector>
+
+namespace {
+
+const int kRuns = 5;
+const int kOracleTrials = 300;
+const int kUniverseBits = 16;  // Oracle addresses: 10.0.0.0/16 and fd00::/112
+
+// Random prefixes inside the oracle universe of one family, so coverage
+// can be checked address by address
+IpPrefix universePrefix(QRandomGenerator *rng, quint8 family) {
+    IpPrefix prefix;
+    prefix.family = family;
+    const int base = family == 6 ? 128 - kUniverseBits : 32 - kUniverseBits;
+    prefix.cidr = quint8(base + rng->bounded(kUniverseBits + 1));
+    const quint32 low = rng->bounded(1u << kUniverseBits);
+    if (family == 6) {
+        prefix.addr[0] = 0xfd;
+        qToBigEndian(quint16(low), prefix.addr + 14);
+    } else {
+        qToBigEndian(0x0a000000u | low, prefix.addr);
+    }
+    return prefix;
+}
+
+int universeBase(quint8 family) { return family == 6 ? 128 - kUniverseBits : 32 - kUniverseBits; }
+
+quint32 universeOffset(const IpPrefix &prefix) {
+    return prefix.family == 6 ? qFromBigEndian<quint16>(prefix.addr + 14)
+                              : qFromBigEndian<quint32>(prefix.addr) & 0xffffu;
+}
+
+// Marks the addresses a prefix covers; false if it leaves the universe
+bool paint(const IpPrefix &prefix, std::vector<int> *cover, int add) {
+    const int hostBits = (prefix.family == 6 ? 128 : 32) - prefix.cidr;
+    if (prefix.cidr < universeBase(prefix.family) || hostBits > kUniverseBits) return false;
+    const quint32 first = universeOffset(prefix) & ~((1u << hostBits) - 1);
+    for (quint32 i = 0; i < (1u << hostBits); ++i) (*cover)[first + i] += add;
+    return true;
+}
+
+// Output covers exactly `expected`, each address once, in canonical
+// prefixes (no host bits) with no two siblings that should have merged
+bool matchesOracle(const QVector<IpPrefix> &output, quint8 family, const std::vector<int> &expected) {
+    std::vector<int> cover(expected.size(), 0);
+    QSet<QPair<quint32, int>> seen;
+    for (const IpPrefix &prefix : output) {
+        if (prefix.family != family || !paint(prefix, &cover, 1)) return false;
+        const int hostBits = (family == 6 ? 128 : 32) - prefix.cidr;
+        const quint32 offset = universeOffset(prefix);
+        if (offset & ((1u << hostBits) - 1)) return false;
+        seen.insert(qMakePair(offset, int(prefix.cidr)));
+    }
+    for (size_t i = 0; i < expected.size(); ++i) {
+        if (cover[i] != (expected[i] > 0 ? 1 : 0)) return false;
+    }
+    for (const auto &entry : qAsConst(seen)) {
+        if (entry.second <= universeBase(family)) continue;
+        const quint32 sibling = entry.first ^ (1u << ((family == 6 ? 128 : 32) - entry.second));
+        if (seen.contains(qMakePair(sibling, entry.second))) return false;
+    }
+    return true;
+}
+
+// aggregate() and CidrSet::subtract() against a brute-force address map on
+// random, overlapping and duplicated prefix sets of both families
+QJsonObject checkOracle(bool *ok) {
+    QRandomGenerator rng(20240602);
+    int aggregateFailures = 0;
+    int subtractFailures = 0;
+    for (int trial = 0; trial < kOracleTrials; ++trial) {
+        const quint8 family = trial % 2 ? 6 : 4;
+        QVector<IpPrefix> include;
+        QVector<IpPrefix> exclude;
+        const int includes = 1 + rng.bounded(40);
+        for (int i = 0; i < includes; ++i) {
+            include.append(universePrefix(&rng, family));
+            if (rng.bounded(4) == 0) include.append(include.last());  // Duplicates
+        }
+        const int excludes = rng.bounded(12);
+        for (int i = 0; i < excludes; ++i) exclude.append(universePrefix(&rng, family));
+
+        std::vector<int> inA(1u << kUniverseBits, 0);
+        std::vector<int> inB(1u << kUniverseBits, 0);
+        for (const IpPrefix &prefix : qAsConst(include)) paint(prefix, &inA, 1);
+        for (const IpPrefix &prefix : qAsConst(exclude)) paint(prefix, &inB, 1);
+        std::vector<int> difference(inA.size());
+        for (size_t i = 0; i < inA.size(); ++i) difference[i] = inA[i] > 0 && inB[i] == 0;
+
+        if (!matchesOracle(CidrSet::aggregate(include), family, inA)
+                || !matchesOracle(CidrSet::aggregate(include, exclude), family, difference)) {
+            ++aggregateFailures;
+        }
+        CidrSet set;
+        set.insert(include);
+        set.subtract(exclude);
+        if (!matchesOracle(set.prefixes(), family, difference)) ++subtractFailures;
+    }
+    *ok = aggregateFailures == 0 && subtractFailures == 0;
+    QJsonObject out;
+    out["trials"] = kOracleTrials;
+    out["aggregate_failures"] = aggregateFailures;
+    out["subtract_failures"] = subtractFailures;
+    return out;
+}
+
+// Country-style input: runs of neighbouring IPv4 blocks out of a limited
+// set of /16s with some duplicates and overlaps, plus IPv6 allocations
+QByteArray syntheticList(int count) {
+    QRandomGenerator rng(20240601);
+    QVector<quint32> blocks(2000);
+    for (quint32 &block : blocks) block = rng.bounded(1u, 223u) << 24 | rng.bounded(256u) << 16;
+
+    QByteArray text;
+    text.reserve(count * 20);
+    for (int i = 0; i < count; ++i) {
+        if (rng.bounded(5) == 0) {
+            text += QString("2a%1:%2::/%3")
+                .arg(rng.bounded(0x10u, 0xffu), 2, 16, QLatin1Char('0'))
+                .arg(rng.bounded(0x400u), 0, 16).arg(rng.bounded(29, 49)).toLatin1();
+        } else {
+            const int cidr = rng.bounded(18, 25);
+            const quint32 address = blocks[rng.bounded(blocks.size())] | rng.bounded(256u) << 8;
+            text += QString("%1.%2.%3.0/%4").arg(address >> 24).arg((address >> 16) & 0xff)
+                .arg((address >> 8) & 0xff).arg(cidr).toLatin1();
+        }
+        text += i % 8 == 7 ? '\n' : ',';
+    }
+    return text;
+}
+
+double median(const QVector<double> &values) {
+    return unsortedPercentile(values, 50);
+}
+
+} // namespace
+
+int CidrBenchmark::run(const QStringList &arguments) {
+    const int count = Bench::intOption(arguments, "--bench-cidr", 100000, 1);
+    const QString inputPath = Bench::option(arguments, "--bench-cidr-file");
+    const bool excludeLan = Bench::hasOption(arguments, "--bench-exclude-lan");
+
+    QByteArray text;
+    if (inputPath.isEmpty()) {
+        text = syntheticList(count);
+    } else {
+        QFile file(inputPath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            QTextStream(stderr) << "Failed to read " << inputPath << '\n';
+            return 1;
+        }
+        text = file.readAll();
+    }
+    const QVector<IpPrefix> exclude = excludeLan ? CidrSet::localPrefixes() : QVector<IpPrefix>();
+
+    QVector<double> parseMs, aggregateMs;
+    QVector<IpPrefix> input, output;
+    for (int run = 0; run < kRuns; ++run) {
+        input.clear();
+        QElapsedTimer timer;
+        timer.start();
+        if (!ConfigParser::parsePrefixes(text.constData(), text.size(), &input)) {
+            QTextStream(stderr) << "Invalid prefix in input\n";
+            return 1;
+        }
+        parseMs.append(timer.nsecsElapsed() / 1e6);
+        timer.restart();
+        output = CidrSet::aggregate(input, exclude);
+        aggregateMs.append(timer.nsecsElapsed() / 1e6);
+    }
+
+    int inputV6 = 0, outputV6 = 0;
+    for (const IpPrefix &prefix : qAsConst(input)) inputV6 += prefix.family == 6;
+    for (const IpPrefix &prefix : qAsConst(output)) outputV6 += prefix.family == 6;
+
+    QJsonObject root;
+    root["input"] = inputPath.isEmpty() ? QString("synthetic") : inputPath;
+    root["input_prefixes"] = input.size();
+    root["input_ipv6"] = inputV6;
+    root["output_prefixes"] = output.size();
+    root["output_ipv6"] = outputV6;
+    root["shrink_ratio"] = input.isEmpty() ? 0.0 : double(output.size()) / input.size();
+    root["exclude_lan"] = excludeLan;
+    root["parse_ms"] = median(parseMs);
+    root["aggregate_ms"] = median(aggregateMs);
+    root["total_ms"] = median(parseMs) + median(aggregateMs);
+    root["runs"] = kRuns;
+
+    bool oracleOk = false;
+    root["oracle"] = checkOracle(&oracleOk);
+    QJsonObject checks;
+    checks["matchesOracle"] = oracleOk;
+    checks["outputNotLarger"] = output.size() <= input.size() || excludeLan;
+    const bool allPassed = Bench::allPassed(checks);
+    checks["allPassed"] = allPassed;
+    root["checks"] = checks;
+    return Bench::finish(root, arguments, allPassed, "CIDR check failed");
+}
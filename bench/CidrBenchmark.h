@@ -0,0 +1,21 @@
+#ifndef CIDRBENCHMARK_H
+#define CIDRBENCHMARK_H
+
+#include <QStringList>
+
+// Parses and aggregates a large AllowedIPs list and reports parse and
+// aggregation time (median of several runs) and how far the entry count
+// shrinks. Uses a synthetic country-style list unless a file is given.
+// Correctness is checked against a brute-force address map on random
+// prefix sets inside a /16 of each family: aggregate() and subtract() must
+// cover exactly A, or A minus B, with a minimal list (no overlaps, no host
+// bits, no siblings left unmerged). Exits non-zero on any mismatch.
+//
+//   tpn-bench --bench-cidr=100000 [--bench-cidr-file=ranges.txt]
+//             [--bench-exclude-lan] [--bench-out=cidr.json]
+class CidrBenchmark {
+public:
+    static int run(const QStringList &arguments);  // Needs a QCoreApplication
+};
+
+#endif // CIDRBENCHMARK_H
@@ -0,0 +1,240 @@
+#include "ConnectBenchmark.h"
+#include "BenchUtil.h"
+#include "SimulatedBackend.h"
+#include "Logger.h"
+#include "ProcessInfo.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonObject>
+#include <QTextStream>
+#include <algorithm>
+
+namespace {
+
+void quietMessageHandler(QtMsgType type, const QMessageLogContext &, const QString &msg) {
+    if (type == QtDebugMsg || type == QtInfoMsg) return;
+    QTextStream(stderr) << msg << '\n';
+}
+
+} // namespace
+
+int ConnectBenchmark::run(const QStringList &arguments) {
+    Options options;
+    options.cycles = Bench::intOption(arguments, "--bench-connect", options.cycles, 1);
+    options.peers = Bench::intOption(arguments, "--bench-peers", options.peers, 1);
+    options.backendSpec = Bench::option(arguments, "--bench-backend");
+    options.outputPath = Bench::option(arguments, "--bench-out");
+    options.reuseAdapter = Bench::hasOption(arguments, "--bench-reuse");
+    options.warm = Bench::hasOption(arguments, "--bench-warm");
+
+    qInstallMessageHandler(quietMessageHandler);
+    Logger::setLevel(LogLevel::Warning);  // Per-command lines would dominate the timings
+    ConnectBenchmark bench(options);
+    QObject::connect(&bench, &ConnectBenchmark::finished, qApp, &QCoreApplication::exit);
+    QTimer::singleShot(0, &bench, &ConnectBenchmark::start);
+    return qApp->exec();
+}
+
+ConnectBenchmark::ConnectBenchmark(const Options &options, QObject *parent)
+    : QObject(parent)
+    , m_options(options)
+    , m_backend(new SimulatedBackend(SimulatedBackend::parseProfile(options.backendSpec)))
+    , m_manager(new WireGuardManager(m_backend, this))
+    , m_settings(new QSettings(m_dir.filePath("bench.ini"), QSettings::IniFormat, this))
+{
+    m_manager->setSettings(m_settings);
+    connect(m_manager, &WireGuardManager::importFinished, this, &ConnectBenchmark::onImportFinished);
+    connect(m_manager, &WireGuardManager::tunnelCommandFinished, this, &ConnectBenchmark::onCommandFinished);
+    connect(m_manager, &WireGuardManager::adapterAcquired, this, [this](const QString &, bool warm, qint64 ms) {
+        record(warm ? "acquire_warm" : "acquire_cold", double(ms), true);
+    });
+
+    m_heartbeat.setInterval(1);
+    m_heartbeat.setTimerType(Qt::PreciseTimer);
+    connect(&m_heartbeat, &QTimer::timeout, this, &ConnectBenchmark::onHeartbeat);
+}
+
+bool ConnectBenchmark::writeConfig() {
+    m_configPath = m_dir.filePath("bench.conf");
+    QFile file(m_configPath);
+    if (!m_dir.isValid() || !file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+
+    QTextStream out(&file);
+    out << "[Interface]\nPrivateKey = " << Bench::randomKey() << "\nAddress = 10.200.0.2/32\n";
+    for (int i = 0; i < m_options.peers; ++i) {
+        // Literal endpoints keep DNS out of the measured path
+        out << "\n[Peer]\nPublicKey = " << Bench::randomKey()
+            << "\nEndpoint = 192.0.2." << (i % 254 + 1) << ":51820"
+            << "\nAllowedIPs = 10." << (i / 256 % 256) << '.' << (i % 256) << ".0/24"
+            << "\nPersistentKeepalive = 25\n";
+    }
+    return true;
+}
+
+void ConnectBenchmark::start() {
+    if (!writeConfig()) {
+        QTextStream(stderr) << "Failed to write benchmark config.\n";
+        emit finished(1);
+        return;
+    }
+    m_manager->profileStore()->setDirectory(m_dir.filePath("profiles"));
+    m_manager->profileStore()->load();
+    m_manager->initialize();
+    m_rssStartKb = ProcessInfo::residentKb();
+    m_runTimer.start();
+    m_heartbeat.start();
+    m_lastBeatNs = m_runTimer.nsecsElapsed();
+    nextCycle();
+}
+
+void ConnectBenchmark::nextCycle() {
+    if (m_cycleFailed) m_failedCycles++;
+    m_cycleFailed = false;
+    if (m_cycle == qMin(10, m_options.cycles)) m_rssWarmKb = ProcessInfo::residentKb();  // Past allocator warm-up
+    if (m_cycle++ >= m_options.cycles) {
+        finish();
+        return;
+    }
+
+    m_phaseTimer.start();
+    QElapsedTimer call;
+    call.start();
+    m_manager->importConfig(m_configPath);
+    record("import_call", call.nsecsElapsed() / 1e6, true);  // Synchronous part on this thread
+}
+
+void ConnectBenchmark::onImportFinished(const QString &tunnelName, bool ok, const QString &error) {
+    Q_UNUSED(tunnelName);
+    Q_UNUSED(error);
+    record("import", m_phaseTimer.nsecsElapsed() / 1e6, ok);
+    if (!ok) {
+        nextCycle();
+        return;
+    }
+    m_phaseTimer.start();
+    m_manager->startTunnel();
+}
+
+void ConnectBenchmark::onCommandFinished(TunnelWorker::Command command, bool ok, qint64 queuedMs, qint64 runMs) {
+    Q_UNUSED(queuedMs);
+    switch (command) {
+    case TunnelWorker::Create:
+        record("create_driver", double(runMs), ok);
+        break;
+    case TunnelWorker::Start:
+        record("connect", m_phaseTimer.nsecsElapsed() / 1e6, ok);
+        if (!ok) {
+            nextCycle();
+            break;
+        }
+        m_phaseTimer.start();
+        m_manager->stopTunnel();
+        break;
+    case TunnelWorker::Stop:
+        record("disconnect", m_phaseTimer.nsecsElapsed() / 1e6, ok);
+        if (!m_options.reuseAdapter) {
+            m_manager->closeTunnel();  // Exercise the close/recreate path
+            if (m_options.warm) m_manager->warmAdapters(1);
+        }
+        nextCycle();
+        break;
+    case TunnelWorker::Reconfigure:
+    case TunnelWorker::Close:
+    case TunnelWorker::Warm:
+        if (m_finishing) report();  // Posted last by finish(), so everything is closed
+        break;
+    case TunnelWorker::Load:
+    case TunnelWorker::SetMtu:
+    case TunnelWorker::SetDns:
+        break;
+    }
+}
+
+void ConnectBenchmark::onHeartbeat() {
+    const qint64 now = m_runTimer.nsecsElapsed();
+    const qint64 stall = now - m_lastBeatNs - 1000000;  // Beyond the 1 ms interval
+    if (stall > 1000000) {
+        m_stallTotalNs += stall;
+        m_stallMaxNs = qMax(m_stallMaxNs, stall);
+    }
+    m_lastBeatNs = now;
+}
+
+void ConnectBenchmark::record(const QString &phase, double ms, bool ok) {
+    if (ok) {
+        m_samples[phase].append(ms);
+    } else {
+        m_failures[phase]++;
+        m_cycleFailed = true;
+    }
+}
+
+void ConnectBenchmark::finish() {
+    m_heartbeat.stop();
+    // Close the tunnel and release the warm pool, so whatever is still open
+    // after that is a leak
+    m_finishing = true;
+    m_manager->closeTunnel();
+    m_manager->warmAdapters(0);
+}
+
+void ConnectBenchmark::report() {
+    QJsonObject root = summary();
+    QJsonObject checks;
+    checks["noFailedCycles"] = m_failedCycles == 0;
+    checks["noAdaptersLeft"] = m_backend->openAdapters() == 0;
+    const bool allPassed = Bench::allPassed(checks);
+    checks["allPassed"] = allPassed;
+    root["checks"] = checks;
+    const int written = Bench::writeReport(root, m_options.outputPath);
+    if (written) {
+        emit finished(written);
+        return;
+    }
+    if (!allPassed) QTextStream(stderr) << "Connect check failed.\n";
+    emit finished(allPassed ? 0 : 1);
+}
+
+QJsonObject ConnectBenchmark::summary() const {
+    QJsonObject phases;
+    QStringList names = m_samples.keys() + m_failures.keys();
+    names.removeDuplicates();
+    names.sort();
+    for (const QString &name : names) {
+        QVector<double> sorted = m_samples.value(name);
+        std::sort(sorted.begin(), sorted.end());
+        QJsonObject phase;
+        phase["count"] = sorted.size();
+        phase["failures"] = m_failures.value(name);
+        phase["p50_ms"] = percentile(sorted, 50);
+        phase["p95_ms"] = percentile(sorted, 95);
+        phase["p99_ms"] = percentile(sorted, 99);
+        phase["max_ms"] = sorted.isEmpty() ? 0.0 : sorted.last();
+        phases[name] = phase;
+    }
+
+    QJsonObject uiThread;
+    uiThread["stall_total_ms"] = m_stallTotalNs / 1e6;
+    uiThread["stall_max_ms"] = m_stallMaxNs / 1e6;
+
+    const qint64 rssEnd = ProcessInfo::residentKb();
+    QJsonObject memory;
+    memory["rss_start_kb"] = m_rssStartKb;
+    memory["rss_warm_kb"] = m_rssWarmKb;
+    memory["rss_end_kb"] = rssEnd;
+    memory["growth_after_warmup_kb"] = rssEnd - m_rssWarmKb;
+
+    QJsonObject root;
+    root["cycles"] = m_options.cycles;
+    root["peers"] = m_options.peers;
+    root["backend"] = m_backend->describe();
+    root["mode"] = m_options.reuseAdapter ? "reuse" : (m_options.warm ? "warm" : "cold");
+    root["wall_ms"] = m_runTimer.elapsed();
+    root["failed_cycles"] = m_failedCycles;
+    root["driver_calls"] = m_backend->driverCalls();
+    root["adapters_open_at_end"] = m_backend->openAdapters();  // After close and pool release: leaks
+    root["phases"] = phases;
+    root["ui_thread"] = uiThread;
+    root["memory"] = memory;
+    return root;
+}
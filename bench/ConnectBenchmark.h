@@ -0,0 +1,84 @@
+#ifndef CONNECTBENCHMARK_H
+#define CONNECTBENCHMARK_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QHash>
+#include <QJsonObject>
+#include <QVector>
+#include "WireGuardManager.h"
+
+class SimulatedBackend;
+
+// Drives import -> create -> start -> stop cycles through WireGuardManager on
+// a SimulatedBackend and reports per-phase p50/p95/p99, event loop stalls on
+// the calling (UI) thread and resident memory growth as JSON, so numbers can
+// be diffed between builds. The run fails if any cycle fails (injected
+// failures included) or an adapter is still open once the tunnel is closed
+// and the warm pool released.
+//
+//   tpn-bench --bench-connect=2000 --bench-peers=10
+//             --bench-backend=create=40,state=10,jitter=2 --bench-out=run.json
+//             [--bench-reuse | --bench-warm]
+class ConnectBenchmark : public QObject {
+    Q_OBJECT
+public:
+    struct Options {
+        int cycles = 1000;
+        int peers = 1;
+        QString backendSpec;
+        QString outputPath;  // Empty = stdout
+        bool reuseAdapter = false;  // Keep the adapter between cycles (in-place path)
+        bool warm = false;          // Re-warm the adapter after each close
+    };
+
+    static int run(const QStringList &arguments);  // Needs a QCoreApplication
+
+    explicit ConnectBenchmark(const Options &options, QObject *parent = nullptr);
+
+    void start();
+
+signals:
+    void finished(int exitCode);
+
+private slots:
+    void onImportFinished(const QString &tunnelName, bool ok, const QString &error);
+    void onCommandFinished(TunnelWorker::Command command, bool ok, qint64 queuedMs, qint64 runMs);
+    void onHeartbeat();
+
+private:
+    Options m_options;
+    SimulatedBackend *m_backend;  // Owned by m_manager
+    WireGuardManager *m_manager;
+    QTemporaryDir m_dir;
+    QSettings *m_settings;  // Scratch store, keeps adapter identities out of the user's settings
+    QString m_configPath;
+    int m_cycle = 0;
+    int m_failedCycles = 0;
+    bool m_cycleFailed = false;
+    bool m_finishing = false;  // Waiting for the teardown before reporting
+    QElapsedTimer m_runTimer;
+    QElapsedTimer m_phaseTimer;
+
+    // Event loop stall detection on this thread
+    QTimer m_heartbeat;
+    qint64 m_lastBeatNs = 0;
+    qint64 m_stallTotalNs = 0;
+    qint64 m_stallMaxNs = 0;
+
+    QHash<QString, QVector<double>> m_samples;  // Phase -> ms
+    QHash<QString, int> m_failures;
+    qint64 m_rssStartKb = 0;
+    qint64 m_rssWarmKb = 0;
+
+    bool writeConfig();
+    void nextCycle();
+    void record(const QString &phase, double ms, bool ok);
+    void finish();
+    void report();
+    QJsonObject summary() const;
+};
+
+#endif // CONNECTBENCHMARK_H
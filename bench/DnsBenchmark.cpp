@@ -0,0 +1,295 @@
+#include "DnsBenchmark.h"
+#include "BenchUtil.h"
+#include "DnsForwarder.h"
+#include "DnsMessage.h"
+#include "Logger.h"
+#include "SimulatedBackend.h"
+#include "StubDnsServer.h"
+#include "WireGuardManager.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonObject>
+#include <QNetworkDatagram>
+#include <QRandomGenerator>
+#include <QSet>
+#include <QSettings>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QTimer>
+#include <QUdpSocket>
+#include <algorithm>
+#include <memory>
+
+namespace {
+
+const int kTimeoutMs = 5000;
+const int kBatch = 50;           // Queries in flight at once in the workload
+
+void sleepEvents(int ms) {
+    QEventLoop loop;
+    QTimer::singleShot(ms, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+struct Lookup {
+    bool answered = false;
+    int rcode = -1;
+    int answers = 0;
+    quint32 ttl = 0;  // First answer's
+    qint64 us = 0;
+};
+
+// Sends every query from its own socket at once and waits for all answers
+QVector<Lookup> resolveAll(quint16 port, const QList<QByteArray> &names, quint16 type = DnsRecord::A) {
+    QVector<Lookup> out(names.size());
+    std::vector<std::unique_ptr<QUdpSocket>> sockets;
+    QEventLoop loop;
+    QElapsedTimer clock;
+    clock.start();
+    int remaining = names.size();
+    for (int i = 0; i < names.size(); ++i) {
+        sockets.emplace_back(new QUdpSocket);
+        QUdpSocket *socket = sockets.back().get();
+        QObject::connect(socket, &QUdpSocket::readyRead, &loop, [&, socket, i]() {
+            while (socket->hasPendingDatagrams()) {
+                DnsMessage message;
+                if (!DnsMessage::parse(socket->receiveDatagram().data(), &message) || out[i].answered) continue;
+                out[i].answered = true;
+                out[i].rcode = message.rcode;
+                out[i].answers = message.answers.size();
+                out[i].ttl = message.answers.isEmpty() ? 0 : message.answers.first().ttl;
+                out[i].us = clock.nsecsElapsed() / 1000;
+                if (--remaining == 0) loop.quit();
+            }
+        });
+        socket->bind(QHostAddress::LocalHost, 0);
+        socket->writeDatagram(DnsMessage::query(quint16(i + 1), names[i], type), QHostAddress::LocalHost, port);
+    }
+    QTimer::singleShot(kTimeoutMs, &loop, &QEventLoop::quit);
+    if (remaining > 0) loop.exec();
+    return out;
+}
+
+Lookup resolve(quint16 port, const QByteArray &name, quint16 type = DnsRecord::A) {
+    return resolveAll(port, { name }, type).first();
+}
+
+// Zipf(1) over names: a few popular ones, a long tail
+QJsonObject runWorkload(DnsForwarder *forwarder, StubDnsServer *upstream, int queries, int names, bool *ok) {
+    QVector<double> cumulative(names);
+    double sum = 0;
+    for (int i = 0; i < names; ++i) cumulative[i] = (sum += 1.0 / (i + 1));
+    QRandomGenerator rng(53);
+    QList<QByteArray> workload;
+    QSet<QByteArray> distinct;
+    for (int i = 0; i < queries; ++i) {
+        const double pick = rng.generateDouble() * sum;
+        const int index = int(std::lower_bound(cumulative.begin(), cumulative.end(), pick) - cumulative.begin());
+        workload.append("name" + QByteArray::number(qMin(index, names - 1)) + ".example");
+        distinct.insert(workload.last());
+    }
+
+    forwarder->resetStats();
+    const int before = upstream->total;
+    QElapsedTimer timer;
+    timer.start();
+    int answered = 0;
+    for (int i = 0; i < workload.size(); i += kBatch) {
+        for (const Lookup &lookup : resolveAll(forwarder->port(), workload.mid(i, kBatch))) {
+            answered += lookup.answered && lookup.rcode == 0 && lookup.answers == 1;
+        }
+    }
+    const DnsForwarder::Stats stats = forwarder->stats();
+    const int upstreamQueries = upstream->total - before;
+    *ok = answered == queries && upstreamQueries == distinct.size()
+            && stats.hits + stats.collapsed + quint64(distinct.size()) == quint64(queries);
+
+    QJsonObject out = QJsonObject::fromVariantMap(stats.toVariantMap());
+    out["names"] = names;
+    out["distinct"] = distinct.size();
+    out["answered"] = answered;
+    out["upstream"] = upstreamQueries;
+    out["ms"] = timer.elapsed();
+    out["ok"] = *ok;
+    return out;
+}
+
+bool waitForCommand(WireGuardManager *manager, TunnelWorker::Command command) {
+    QEventLoop loop;
+    QObject::connect(manager, &WireGuardManager::tunnelCommandFinished, &loop,
+                     [&loop, command](TunnelWorker::Command finished) {
+        if (finished == command) loop.quit();
+    });
+    QTimer::singleShot(kTimeoutMs, &loop, [&loop]() { loop.exit(1); });
+    return loop.exec() == 0;
+}
+
+// The adapter's resolvers on a simulated driver: the forwarder when it got
+// port 53, the profile's IPv4 servers when it didn't, nothing once stopped
+QJsonObject checkAdapterDns() {
+    QJsonObject checks;
+    QTemporaryDir dir;
+    SimulatedBackend *backend = new SimulatedBackend(SimulatedBackend::parseProfile("create=0,open=0,config=0,state=0"));
+    WireGuardManager manager(backend);
+    QSettings settings(dir.filePath("bench.ini"), QSettings::IniFormat);
+    settings.setValue("Dns/port", 5353);
+    manager.setSettings(&settings);
+    manager.profileStore()->setDirectory(dir.filePath("profiles"));
+    manager.profileStore()->load();
+    manager.initialize();
+
+    QFile config(dir.filePath("dns.conf"));
+    const QString text = QString("[Interface]\nPrivateKey = %1\nAddress = 10.206.0.2/32\nDNS = 10.53.0.1, fd53::1\n\n"
+                                 "[Peer]\nPublicKey = %2\nEndpoint = 198.51.100.9:51820\nAllowedIPs = 0.0.0.0/0\n")
+            .arg(Bench::randomKey()).arg(Bench::randomKey());
+    if (!dir.isValid() || !config.open(QIODevice::WriteOnly) || config.write(text.toUtf8()) < 0) {
+        checks["adapter_setup"] = false;
+        return checks;
+    }
+    config.close();
+    manager.importConfig(config.fileName());
+    if (!Bench::waitFor(&manager, &WireGuardManager::importFinished, kTimeoutMs)) {
+        checks["adapter_setup"] = false;
+        return checks;
+    }
+
+    // Off port 53 nothing can reach a forwarder, so none runs
+    manager.startTunnel();
+    waitForCommand(&manager, TunnelWorker::SetDns);
+    checks["adapter_direct_off_53"] = !manager.dnsForwarder()->isListening()
+            && backend->dnsServers() == QStringList({ "10.53.0.1" });
+    manager.stopTunnel();
+    waitForCommand(&manager, TunnelWorker::SetDns);
+    checks["adapter_cleared_on_stop"] = backend->dnsServers().isEmpty();
+
+    // On 53 the adapter points at the forwarder, unless 53 is taken here
+    settings.setValue("Dns/port", 53);
+    manager.startTunnel();
+    waitForCommand(&manager, TunnelWorker::SetDns);
+    checks["adapter_on_forwarder"] = manager.dnsForwarder()->isListening()
+            ? backend->dnsServers() == QStringList({ "127.0.0.1" })
+            : backend->dnsServers() == QStringList({ "10.53.0.1" });
+    manager.stopTunnel();
+    waitForCommand(&manager, TunnelWorker::SetDns);
+    return checks;
+}
+
+} // namespace
+
+int DnsBenchmark::run(const QStringList &arguments) {
+    const int queries = Bench::intOption(arguments, "--bench-dns", 2000, 1);
+    const int names = Bench::intOption(arguments, "--bench-names", 200, 1);
+    const int delayMs = Bench::intOption(arguments, "--bench-delay", 50);
+    Logger::setLevel(LogLevel::Warning);
+
+    StubDnsServer upstream;
+    upstream.delayMs = delayMs;
+    DnsForwarder forwarder;
+    if (!upstream.start() || !forwarder.listen(QHostAddress::LocalHost, 0)) {
+        QTextStream(stderr) << "Failed to bind on loopback: " << forwarder.errorString() << '\n';
+        return 1;
+    }
+    forwarder.setUpstreams({ QHostAddress::LocalHost }, upstream.port());
+    const quint16 port = forwarder.port();
+
+    QJsonObject checks;
+    bool workloadOk = false;
+    const QJsonObject workload = runWorkload(&forwarder, &upstream, queries, names, &workloadOk);
+    checks["workload"] = workloadOk;
+
+    // Cold, then warm
+    const Lookup cold = resolve(port, "single.example");
+    const Lookup warm = resolve(port, "single.example");
+    checks["miss_then_hit"] = cold.answered && warm.answered && upstream.asked.value("single.example") == 1
+            && cold.us >= delayMs * 1000 && warm.us < qMax(1000, delayMs * 500);
+
+    // A burst for one name is one upstream request
+    forwarder.resetStats();
+    QList<QByteArray> burst;
+    for (int i = 0; i < kBatch; ++i) burst.append("burst.example");
+    int burstAnswered = 0;
+    for (const Lookup &lookup : resolveAll(port, burst)) burstAnswered += lookup.answered && lookup.answers == 1;
+    checks["collapsed"] = burstAnswered == kBatch && upstream.asked.value("burst.example") == 1
+            && forwarder.stats().collapsed == quint64(kBatch - 1);
+
+    // NXDOMAIN and NODATA are cached as well
+    forwarder.resetStats();
+    const Lookup nx1 = resolve(port, "nx.example");
+    const Lookup nx2 = resolve(port, "nx.example");
+    const Lookup nodata1 = resolve(port, "single.example", DnsRecord::AAAA);
+    const Lookup nodata2 = resolve(port, "single.example", DnsRecord::AAAA);
+    checks["negative"] = nx1.rcode == 3 && nx2.rcode == 3 && upstream.asked.value("nx.example") == 1
+            && nodata1.rcode == 0 && nodata2.rcode == 0 && !nodata2.answers
+            && upstream.asked.value("single.example") == 2 && forwarder.stats().negativeHits == 2;
+
+    // TTLs: ageing, expiry, and a popular name prefetched before it expires
+    forwarder.resetStats();
+    resolve(port, "t1.expire.example");
+    resolve(port, "t3.aged.example");
+    for (int i = 0; i < 4; ++i) resolve(port, "t4.popular.example");
+    sleepEvents(1200);
+    resolve(port, "t1.expire.example");
+    const Lookup aged = resolve(port, "t3.aged.example");
+    checks["expired"] = upstream.asked.value("t1.expire.example") == 2;
+    checks["ttl_aged"] = aged.answered && aged.ttl >= 1 && aged.ttl <= 2 && upstream.asked.value("t3.aged.example") == 1;
+    sleepEvents(2300);  // Past the start of t4's last second, before it expires
+    const int prefetched = upstream.asked.value("t4.popular.example");
+    sleepEvents(800);   // Past the original expiry
+    const Lookup popular = resolve(port, "t4.popular.example");
+    checks["prefetch"] = prefetched == 2 && popular.answered && popular.answers == 1
+            && upstream.asked.value("t4.popular.example") == 2 && forwarder.stats().prefetches == 1;
+    const QJsonObject ttlStats = QJsonObject::fromVariantMap(forwarder.stats().toVariantMap());
+
+    // Silent server: SERVFAIL once both attempts have timed out
+    upstream.silent = true;
+    forwarder.setTimeoutMs(100);
+    const Lookup timedOut = resolve(port, "silent.example");
+    checks["timeout_servfail"] = timedOut.answered && timedOut.rcode == 2 && upstream.asked.value("silent.example") == 2;
+    upstream.silent = false;
+
+    // No tunnel servers: nothing goes anywhere else
+    const int sent = upstream.total;
+    forwarder.setUpstreams({});
+    const Lookup none = resolve(port, "leak.example");
+    checks["no_upstream"] = none.answered && none.rcode == 2 && upstream.total == sent;
+
+    DnsForwarder exposed;
+    checks["loopback_only"] = !exposed.listen(QHostAddress::Any, 0);
+
+    // Full cache: the entry closest to expiry goes, even when it is the one
+    // just stored, and it stays tracked so a later store can evict it
+    DnsForwarder small;
+    small.setMaxEntries(2);
+    small.setUpstreams({ QHostAddress::LocalHost }, upstream.port());
+    if (small.listen(QHostAddress::LocalHost, 0)) {
+        const quint16 smallPort = small.port();
+        resolve(smallPort, "t300.kept.example");
+        resolve(smallPort, "t200.dropped.example");
+        resolve(smallPort, "t5.soon.example");    // Evicts dropped, then expires first itself
+        resolve(smallPort, "t300.late.example");  // Must evict soon, not kept
+        resolve(smallPort, "t300.kept.example");
+        resolve(smallPort, "t5.soon.example");
+        checks["eviction_order"] = upstream.asked.value("t300.kept.example") == 1
+                && upstream.asked.value("t5.soon.example") == 2;
+    } else {
+        checks["eviction_order"] = false;
+    }
+
+    const QJsonObject adapterChecks = checkAdapterDns();
+    for (auto it = adapterChecks.begin(); it != adapterChecks.end(); ++it) checks[it.key()] = it.value();
+
+    const bool allPassed = Bench::allPassed(checks);
+    checks["allPassed"] = allPassed;
+
+    QJsonObject root;
+    root["queries"] = queries;
+    root["delay_ms"] = delayMs;
+    root["workload"] = workload;
+    root["ttl_phase"] = ttlStats;
+    root["cold_us"] = cold.us;
+    root["warm_us"] = warm.us;
+    root["checks"] = checks;
+    return Bench::finish(root, arguments, allPassed, "DNS forwarder check failed");
+}
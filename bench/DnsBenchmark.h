@@ -0,0 +1,24 @@
+#ifndef DNSBENCHMARK_H
+#define DNSBENCHMARK_H
+
+#include <QStringList>
+
+// DnsForwarder on loopback in front of a fake upstream that answers after
+// a fixed delay. A Zipf-distributed workload over a set of names reports
+// the hit rate and hit/miss latency, and must cost exactly one upstream
+// query per distinct name. Further checks cover a burst of identical
+// queries (one upstream request), negative caching, TTL ageing and expiry,
+// prefetching a popular name before it expires, SERVFAIL on a silent
+// upstream or none at all, refusing to listen off loopback, evicting the
+// entry closest to expiry from a full cache, and a simulated connect
+// pointing the adapter's DNS at the forwarder (or at the profile's servers
+// when port 53 is unavailable) and clearing it on disconnect.
+// Exits non-zero if any check fails.
+//
+//   tpn-bench --bench-dns=2000 [--bench-names=200] [--bench-delay=50] [--bench-out=dns.json]
+class DnsBenchmark {
+public:
+    static int run(const QStringList &arguments);  // Needs a QCoreApplication
+};
+
+#endif // DNSBENCHMARK_H
@@ -0,0 +1,256 @@
+#include "DomainsBenchmark.h"
+#include "BenchUtil.h"
+#include "DnsMessage.h"
+#include "DomainPolicy.h"
+#include "DriverConfig.h"
+#include "Logger.h"
+#include "ProfileStore.h"
+#include "SimulatedBackend.h"
+#include "StubDnsServer.h"
+#include "WireGuardManager.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSettings>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QTimer>
+#include <QtEndian>
+#include <functional>
+
+namespace {
+
+const int kTimeoutMs = 10000;
+const int kPeers = 4;
+const int kBatchMs = 200;  // DomainPolicy's default batch delay
+const int kDelayMs = 5;    // Stub server answer delay
+
+// Records every config push that reached the simulated driver
+class RecordingBackend : public SimulatedBackend {
+public:
+    struct Push {
+        qint64 ms;        // On clock()
+        int allowedIPs;   // Entries in the pushed peers, all peers
+    };
+
+    explicit RecordingBackend(const Profile &profile) : SimulatedBackend(profile) { m_clock.start(); }
+
+    long setConfiguration(AdapterHandle adapter, const QByteArray &config) override {
+        const long hr = SimulatedBackend::setConfiguration(adapter, config);
+        TunnelConfig parsed;
+        if (!backendFailed(hr) && DriverConfig::unpack(config.constData(), config.size(), &parsed)) {
+            int allowedIPs = 0;
+            for (const PeerConfig &peer : qAsConst(parsed.peers)) allowedIPs += peer.allowedIPs.size();
+            QMutexLocker lock(&m_mutex);
+            m_pushes.append({ m_clock.elapsed(), allowedIPs });
+        }
+        return hr;
+    }
+
+    QVector<Push> pushes() const {
+        QMutexLocker lock(&m_mutex);
+        return m_pushes;
+    }
+    void clearPushes() {
+        QMutexLocker lock(&m_mutex);
+        m_pushes.clear();
+    }
+    qint64 now() const { return m_clock.elapsed(); }
+
+private:
+    mutable QMutex m_mutex;
+    QElapsedTimer m_clock;
+    QVector<Push> m_pushes;
+};
+
+// Rule i goes to peer i % kPeers; every fifth one is a wildcard
+QByteArray ruleName(int i) { return (i % 5 == 0 ? "w" : "r") + QByteArray::number(i) + ".example"; }
+
+QJsonObject benchMatching(int rules, bool *correct) {
+    TunnelConfig config;
+    config.peers.resize(kPeers);
+    for (int i = 0; i < rules; ++i) {
+        config.peers[i % kPeers].allowedDomains.append((i % 5 == 0 ? "*." : "") + ruleName(i));
+    }
+    DomainPolicy policy;
+    policy.setRules(config);
+
+    // Per rule: the apex, a subdomain and a miss
+    QVector<QByteArray> names;
+    QVector<int> expected;
+    names.reserve(rules * 3);
+    expected.reserve(rules * 3);
+    for (int i = 0; i < rules; ++i) {
+        const bool wildcard = i % 5 == 0;
+        names.append(ruleName(i));
+        expected.append(wildcard ? -1 : i % kPeers);
+        names.append("Www.Cdn." + ruleName(i) + '.');
+        expected.append(i % kPeers);
+        names.append("miss" + QByteArray::number(i) + ".example");
+        expected.append(-1);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    int hits = 0;
+    bool ok = true;
+    for (int i = 0; i < names.size(); ++i) {
+        const int peer = policy.match(names[i]);
+        ok = ok && peer == expected[i];
+        hits += peer >= 0;
+    }
+    const qint64 ns = timer.nsecsElapsed();
+    *correct = *correct && ok;
+
+    QJsonObject entry;
+    entry["rules"] = rules;
+    entry["lookups"] = names.size();
+    entry["hits"] = hits;
+    entry["ns_per_match"] = names.isEmpty() ? 0.0 : double(ns) / names.size();
+    return entry;
+}
+
+bool waitUntil(const std::function<bool()> &done, int timeoutMs) {
+    QElapsedTimer timer;
+    timer.start();
+    while (!done()) {
+        if (timer.elapsed() > timeoutMs) return false;
+        QEventLoop loop;
+        QTimer::singleShot(10, &loop, &QEventLoop::quit);
+        loop.exec();
+    }
+    return true;
+}
+
+bool connectTunnel(WireGuardManager *manager, const QString &path) {
+    bool imported = false;
+    bool started = false;
+    const QMetaObject::Connection onImport = QObject::connect(manager, &WireGuardManager::importFinished, manager,
+                                                              [&](const QString &, bool ok) {
+        imported = ok;
+        if (ok) manager->startTunnel();
+    });
+    const QMetaObject::Connection onCommand = QObject::connect(manager, &WireGuardManager::tunnelCommandFinished, manager,
+                                                               [&](TunnelWorker::Command command, bool ok) {
+        if (command == TunnelWorker::Start) started = ok;
+    });
+    manager->importConfig(path);
+    const bool done = waitUntil([&]() { return started; }, kTimeoutMs);
+    QObject::disconnect(onImport);
+    QObject::disconnect(onCommand);
+    return done && imported;
+}
+
+} // namespace
+
+int DomainsBenchmark::run(const QStringList &arguments) {
+    const int rules = Bench::intOption(arguments, "--bench-domains", 10000, 100);
+    const int names = Bench::intOption(arguments, "--bench-names", 20, 1);
+    const int expiring = qMax(1, names / 4);
+    Logger::setLevel(LogLevel::Warning);
+
+    bool matchCorrect = true;
+    const QJsonObject small = benchMatching(100, &matchCorrect);
+    const QJsonObject large = benchMatching(rules, &matchCorrect);
+
+    StubDnsServer server;
+    server.delayMs = kDelayMs;
+    QTemporaryDir dir;
+    if (!server.start() || !dir.isValid()) {
+        QTextStream(stderr) << "Failed to set up the stub DNS server.\n";
+        return 1;
+    }
+
+    // Long-lived names and ones answering with a 1 s TTL ("t1." per the stub)
+    QList<QByteArray> lasting;
+    QList<QByteArray> shortLived;
+    QByteArray domains;
+    for (int i = 0; i < names + expiring; ++i) {
+        const QByteArray name = i < names ? "site" + QByteArray::number(i) + ".bench.test"
+                                          : "t1.gone" + QByteArray::number(i) + ".bench.test";
+        (i < names ? lasting : shortLived).append(name);
+        domains += (i ? ", " : "") + name;
+    }
+    const QString path = QDir(dir.path()).filePath("domains.conf");
+    const QByteArray text = "[Interface]\nPrivateKey = " + Bench::randomKey().toLatin1()
+            + "\nAddress = 10.205.0.2/32\n\n[Peer]\nPublicKey = " + Bench::randomKey().toLatin1()
+            + "\nEndpoint = 198.51.100.7:51820\nAllowedIPs = 10.205.0.0/16\nAllowedDomains = " + domains + '\n';
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(text) != text.size()) {
+        QTextStream(stderr) << "Failed to write " << path << '\n';
+        return 1;
+    }
+    file.close();
+
+    RecordingBackend *backend = new RecordingBackend(SimulatedBackend::parseProfile("create=0,open=0,config=0,state=0"));
+    WireGuardManager manager(backend);
+    QSettings settings(QDir(dir.path()).filePath("bench.ini"), QSettings::IniFormat);
+    manager.setSettings(&settings);
+    manager.profileStore()->setDirectory(QDir(dir.path()).filePath("profiles"));
+    manager.profileStore()->load();
+    manager.initialize();
+    DomainPolicy *policy = manager.domainPolicy();
+    policy->setMinLifetime(1);  // Let the TTL decide, down to a second
+    if (!connectTunnel(&manager, path)) {
+        QTextStream(stderr) << "Failed to connect the benchmark tunnel.\n";
+        return 1;
+    }
+
+    // The profile has no DNS line, so the refresh is pointed at the stub here
+    backend->clearPushes();
+    const qint64 refreshedAt = backend->now();
+    policy->refresh(QHostAddress::LocalHost, server.port());
+    const bool added = waitUntil([&]() { return !backend->pushes().isEmpty(); }, kTimeoutMs);
+    // Anything else arriving within another batch window would be a split
+    waitUntil([]() { return false; }, kBatchMs + 100);
+    const QVector<RecordingBackend::Push> addPushes = backend->pushes();
+    const int routesAfterAdd = policy->routeCount();
+    QVector<IpPrefix> learned = policy->routes(0);
+
+    bool addressesRight = learned.size() == names + expiring;
+    for (const QByteArray &name : lasting + shortLived) {
+        const QHostAddress expected = StubDnsServer::addressFor(name, DnsRecord::A);
+        bool found = false;
+        for (const IpPrefix &prefix : qAsConst(learned)) {
+            found = found || QHostAddress(qFromBigEndian<quint32>(prefix.addr)) == expected;
+        }
+        addressesRight = addressesRight && found;
+    }
+
+    // The sweep runs every second, then one more batch delay
+    const bool expired = waitUntil([&]() { return policy->routeCount() == names; }, 4000);
+    waitUntil([&]() { return backend->pushes().size() > addPushes.size(); }, kBatchMs * 3);
+    const QVector<RecordingBackend::Push> allPushes = backend->pushes();
+
+    const qint64 firstPushMs = addPushes.isEmpty() ? -1 : addPushes.first().ms - refreshedAt;
+    const qint64 expiryPushMs = allPushes.size() > addPushes.size() ? allPushes[addPushes.size()].ms - refreshedAt : -1;
+
+    QJsonObject checks;
+    checks["trieMatchesRules"] = matchCorrect;
+    checks["burstIsOnePush"] = added && addPushes.size() == 1 && addPushes.first().allowedIPs >= names + expiring;
+    checks["pushWaitsForBatch"] = firstPushMs >= kBatchMs - 10 && firstPushMs < kBatchMs + 500;
+    checks["learnedAddressesRight"] = routesAfterAdd == names + expiring && addressesRight;
+    checks["expiredRoutesWithdrawn"] = expired && allPushes.size() == addPushes.size() + 1 && expiryPushMs >= 1000;
+    checks["oneQueryPerNameAndType"] = server.total == 2 * (names + expiring);
+    const bool allPassed = Bench::allPassed(checks);
+    checks["allPassed"] = allPassed;
+
+    QJsonObject endToEnd;
+    endToEnd["names"] = names + expiring;
+    endToEnd["expiring"] = expiring;
+    endToEnd["queries"] = server.total;
+    endToEnd["first_push_ms"] = firstPushMs;
+    endToEnd["expiry_push_ms"] = expiryPushMs;
+    endToEnd["pushes"] = allPushes.size();
+
+    QJsonObject report;
+    report["matching_small"] = small;
+    report["matching"] = large;
+    report["end_to_end"] = endToEnd;
+    report["checks"] = checks;
+    return Bench::finish(report, arguments, allPassed, "Domain check failed");
+}
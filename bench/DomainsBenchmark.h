@@ -0,0 +1,20 @@
+#ifndef DOMAINSBENCHMARK_H
+#define DOMAINSBENCHMARK_H
+
+#include <QStringList>
+
+// Domain split tunneling. First the rule trie alone: match cost with a
+// hundred and with N rules, checking every hit and miss. Then end to end
+// on a backend that records config pushes: a connected profile with domain
+// rules refreshes against a loopback stub DNS server, and the bench checks
+// that the burst of answers lands as one push after the batch delay, with
+// the right addresses, and that short-TTL routes are withdrawn in a later
+// push once they expire.
+//
+//   tpn-bench --bench-domains=10000 [--bench-names=20] [--bench-out=domains.json]
+class DomainsBenchmark {
+public:
+    static int run(const QStringList &arguments);  // Needs a QCoreApplication
+};
+
+#endif // DOMAINSBENCHMARK_H
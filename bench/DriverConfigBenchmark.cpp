@@ -0,0 +1,176 @@
+#include "DriverConfigBenchmark.h"
+#include "BenchUtil.h"
+#include "DriverConfig.h"
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QVector>
+#include <algorithm>
+
+namespace {
+
+const int kMinRounds = 20;
+
+IpPrefix makePrefix(quint8 family, quint32 seed, quint8 cidr) {
+    IpPrefix prefix;
+    prefix.family = family;
+    prefix.cidr = cidr;
+    const int bytes = family == 6 ? 16 : 4;
+    for (int i = 0; i < bytes; ++i) prefix.addr[i] = quint8(seed >> ((i & 3) * 8)) ^ quint8(i * 17);
+    return prefix;
+}
+
+TunnelConfig makeConfig(int peers, int allowedPerPeer) {
+    TunnelConfig config;
+    config.iface.privateKey = SecretBuffer(32);
+    memset(config.iface.privateKey.data(), 0x11, 32);
+    config.iface.listenPort = 51820;
+    config.peers.resize(peers);
+    for (int i = 0; i < peers; ++i) {
+        PeerConfig &peer = config.peers[i];
+        for (int b = 0; b < 32; ++b) peer.publicKey[b] = quint8(i * 31 + b);
+        if (i % 3 == 0) {
+            peer.hasPresharedKey = true;
+            peer.presharedKey = SecretBuffer(32);
+            memset(peer.presharedKey.data(), quint8(i), 32);
+        } else {
+            peer.presharedKey = SecretBuffer(32);  // Unset keys are sent as zeros
+        }
+        peer.persistentKeepalive = quint16(i % 2 ? 25 : 0);
+        peer.endpointPort = quint16(50000 + i);
+        peer.endpointAddress = makePrefix(i % 4 == 3 ? 6 : 4, quint32(i), i % 4 == 3 ? 128 : 32);
+        for (int a = 0; a < allowedPerPeer; ++a) {
+            const bool v6 = a % 2;
+            peer.allowedIPs.append(makePrefix(v6 ? 6 : 4, quint32(i * 7919 + a), quint8(v6 ? 48 + a % 80 : 8 + a % 24)));
+        }
+    }
+    return config;
+}
+
+bool samePeer(const PeerConfig &a, const PeerConfig &b, int fields) {
+    if (memcmp(a.publicKey, b.publicKey, 32) != 0) return false;
+    if ((fields & PeerChange::PresharedKey) && !(a.presharedKey == b.presharedKey)) return false;
+    if ((fields & PeerChange::PersistentKeepalive) && a.persistentKeepalive != b.persistentKeepalive) return false;
+    if ((fields & PeerChange::Endpoint)
+        && (a.endpointPort != b.endpointPort || a.endpointAddress != b.endpointAddress)) return false;
+    if ((fields & PeerChange::AllowedIPs) ? a.allowedIPs != b.allowedIPs : !b.allowedIPs.isEmpty()) return false;
+    return true;
+}
+
+bool checkFull(const TunnelConfig &config) {
+    const SecretBuffer buffer = DriverConfig::build(config, fullConfigDelta(config), TunnelConfig(), true);
+    TunnelConfig back;
+    quint32 interfaceFlags = 0;
+    QVector<quint32> peerFlags;
+    if (!DriverConfig::unpack(reinterpret_cast<const char *>(buffer.constData()), buffer.size(), &back,
+                              &interfaceFlags, &peerFlags)) return false;
+    if (!(interfaceFlags & DriverConfig::InterfaceReplacePeers)) return false;
+    if (!(back.iface.privateKey == config.iface.privateKey) || back.iface.listenPort != config.iface.listenPort) return false;
+    if (back.peers.size() != config.peers.size()) return false;
+    for (int i = 0; i < config.peers.size(); ++i) {
+        if (!samePeer(config.peers[i], back.peers[i], PeerChange::AllFields)) return false;
+        if (!(peerFlags[i] & DriverConfig::PeerReplaceAllowedIPs) || (peerFlags[i] & DriverConfig::PeerUpdate)) return false;
+    }
+    return true;
+}
+
+bool checkDelta(const TunnelConfig &applied) {
+    TunnelConfig next = applied;
+    next.peers[0].persistentKeepalive = 60;                        // Updated: keepalive only
+    next.peers[1].allowedIPs.append(makePrefix(6, 0xABCD, 64));    // Updated: allowed IPs
+    const PeerConfig removed = next.peers.takeLast();
+
+    const ConfigDelta delta = diffConfigs(applied, next);
+    const SecretBuffer buffer = DriverConfig::build(next, delta, applied, false);
+    TunnelConfig back;
+    quint32 interfaceFlags = 0;
+    QVector<quint32> peerFlags;
+    if (!DriverConfig::unpack(reinterpret_cast<const char *>(buffer.constData()), buffer.size(), &back,
+                              &interfaceFlags, &peerFlags)) return false;
+    if (interfaceFlags != 0 || back.peers.size() != delta.peers.size()) return false;
+    for (int i = 0; i < delta.peers.size(); ++i) {
+        const PeerChange &change = delta.peers[i];
+        if (change.kind == PeerChange::Removed) {
+            if (memcmp(back.peers[i].publicKey, removed.publicKey, 32) != 0) return false;
+            if (peerFlags[i] != (DriverConfig::PeerHasPublicKey | DriverConfig::PeerRemove)) return false;
+        } else {
+            if (!(peerFlags[i] & DriverConfig::PeerUpdate)) return false;
+            if (!samePeer(next.peers[change.index], back.peers[i], change.fields)) return false;
+        }
+    }
+    return delta.count(PeerChange::Updated) == 2 && delta.count(PeerChange::Removed) == 1;
+}
+
+bool checkEmpty() {
+    const TunnelConfig empty;
+    const SecretBuffer buffer = DriverConfig::build(empty, ConfigDelta(), empty, true);
+    TunnelConfig back;
+    return buffer.size() == int(sizeof(DriverConfig::Interface))
+            && DriverConfig::unpack(reinterpret_cast<const char *>(buffer.constData()), buffer.size(), &back)
+            && back.peers.isEmpty();
+}
+
+bool checkTruncated(const TunnelConfig &config) {
+    const SecretBuffer buffer = DriverConfig::build(config, fullConfigDelta(config), TunnelConfig(), true);
+    const char *data = reinterpret_cast<const char *>(buffer.constData());
+    TunnelConfig back;
+    for (int cut : { 1, int(sizeof(DriverConfig::AllowedIp)), int(sizeof(DriverConfig::Peer)) }) {
+        if (cut < buffer.size() && DriverConfig::unpack(data, buffer.size() - cut, &back)) return false;
+    }
+    QByteArray padded(data, buffer.size());
+    padded.append(char(0));
+    return !DriverConfig::unpack(padded.constData(), padded.size(), &back);
+}
+
+} // namespace
+
+int DriverConfigBenchmark::run(const QStringList &arguments) {
+    const int peers = Bench::intOption(arguments, "--bench-driver-config", 1000, 1);
+    const int allowed = Bench::intOption(arguments, "--bench-allowed", 16);
+
+    const TunnelConfig config = makeConfig(peers, allowed);
+    const ConfigDelta delta = fullConfigDelta(config);
+    const TunnelConfig none;
+
+    // Enough rounds for a stable median at any size
+    QVector<qint64> samples;
+    QElapsedTimer total;
+    total.start();
+    qint64 bytes = 0;
+    while (samples.size() < kMinRounds || total.elapsed() < 500) {
+        QElapsedTimer clock;
+        clock.start();
+        const SecretBuffer buffer = DriverConfig::build(config, delta, none, true);
+        samples.append(clock.nsecsElapsed());
+        bytes = buffer.size();
+    }
+    std::sort(samples.begin(), samples.end());
+    const double medianUs = percentile(samples, 50) / 1000.0;
+
+    QElapsedTimer clock;
+    clock.start();
+    {
+        const SecretBuffer buffer = DriverConfig::build(config, delta, none, true);
+        TunnelConfig back;
+        DriverConfig::unpack(reinterpret_cast<const char *>(buffer.constData()), buffer.size(), &back);
+    }
+    const double unpackUs = clock.nsecsElapsed() / 1000.0 - medianUs;
+
+    QJsonObject checks;
+    checks["full"] = checkFull(config);
+    checks["delta"] = checkDelta(makeConfig(8, 4));
+    checks["empty"] = checkEmpty();
+    checks["truncated"] = checkTruncated(makeConfig(3, 2));
+    const bool allPassed = Bench::allPassed(checks);
+
+    QJsonObject root;
+    root["peers"] = peers;
+    root["allowed_ips_per_peer"] = allowed;
+    root["rounds"] = samples.size();
+    root["bytes"] = bytes;
+    root["build_us_median"] = medianUs;
+    root["build_us_min"] = samples.first() / 1000.0;
+    root["build_ns_per_peer"] = medianUs * 1000.0 / peers;
+    root["unpack_us"] = qMax(0.0, unpackUs);
+    root["round_trip_checks"] = checks;
+    return Bench::finish(root, arguments, allPassed, "Round-trip check failed");
+}
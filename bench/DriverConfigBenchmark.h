@@ -0,0 +1,18 @@
+#ifndef DRIVERCONFIGBENCHMARK_H
+#define DRIVERCONFIGBENCHMARK_H
+
+#include <QStringList>
+
+// Serialization cost of DriverConfig::build for a full config of N peers
+// with mixed IPv4/IPv6 allowed IPs, plus round-trip checks through
+// DriverConfig::unpack: full, partial-update and removal deltas, an empty
+// config, and truncated buffers that must be rejected. Exits non-zero if
+// any check fails.
+//
+//   tpn-bench --bench-driver-config=1000 [--bench-allowed=16] [--bench-out=driver.json]
+class DriverConfigBenchmark {
+public:
+    static int run(const QStringList &arguments);  // Needs a QCoreApplication
+};
+
+#endif // DRIVERCONFIGBENCHMARK_H
@@ -0,0 +1,29 @@
+#include "EchoResponder.h"
+#include <QNetworkDatagram>
+#include <QTimer>
+
+bool EchoResponder::start() {
+    QObject::connect(&m_socket, &QUdpSocket::readyRead, [this]() { onReadyRead(); });
+    return m_socket.bind(QHostAddress::LocalHost, 0);
+}
+
+void EchoResponder::onReadyRead() {
+    while (m_socket.hasPendingDatagrams()) {
+        const QNetworkDatagram datagram = m_socket.receiveDatagram();
+        received++;
+        if ((loss > 0 && m_rng.generateDouble() < loss) || (maxDatagram > 0 && datagram.data().size() > maxDatagram)) {
+            dropped++;
+            continue;
+        }
+        const QByteArray data = datagram.data();
+        const QHostAddress address = datagram.senderAddress();
+        const quint16 port = quint16(datagram.senderPort());
+        if (delayMs <= 0) {
+            m_socket.writeDatagram(data, address, port);
+            continue;
+        }
+        QTimer::singleShot(delayMs, &m_socket, [this, data, address, port]() {
+            m_socket.writeDatagram(data, address, port);
+        });
+    }
+}
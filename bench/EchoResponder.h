@@ -0,0 +1,31 @@
+#ifndef ECHORESPONDER_H
+#define ECHORESPONDER_H
+
+#include <QRandomGenerator>
+#include <QUdpSocket>
+
+// Loopback UDP echo server for the benches, standing in for the echo
+// responder the probers expect next to a WireGuard server. Every datagram
+// is sent back unchanged after delayMs, except for a seeded random
+// fraction `loss` and anything larger than maxDatagram, which are dropped.
+class EchoResponder {
+public:
+    explicit EchoResponder(quint32 seed = 1) : m_rng(seed) {}
+
+    int delayMs = 0;
+    double loss = 0.0;    // 0..1
+    int maxDatagram = 0;  // Stands in for a narrow path, 0 = off
+    int received = 0;
+    int dropped = 0;
+
+    bool start();  // On an ephemeral loopback port
+    quint16 port() const { return m_socket.localPort(); }
+
+private:
+    QUdpSocket m_socket;
+    QRandomGenerator m_rng;
+
+    void onReadyRead();
+};
+
+#endif // ECHORESPONDER_H
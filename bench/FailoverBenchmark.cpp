@@ -0,0 +1,187 @@
+#include "FailoverBenchmark.h"
+#include "BenchUtil.h"
+#include "SimulatedBackend.h"
+#include "Logger.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QTimer>
+#include <algorithm>
+
+namespace {
+
+// The simulated backend reports a single peer with an all-zero public key
+const char kPeerKey[] = "AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA=";
+const int kHealthyMs = 300;  // Traffic flows this long between stalls
+const int kStandbys = 2;
+
+int pollMs(int stallMs) { return qMax(20, stallMs / 5); }
+
+QJsonObject summarize(QVector<double> values) {
+    std::sort(values.begin(), values.end());
+    QJsonObject out;
+    out["count"] = values.size();
+    out["p50"] = percentile(values, 50);
+    out["p95"] = percentile(values, 95);
+    out["max"] = values.isEmpty() ? 0.0 : values.last();
+    return out;
+}
+
+} // namespace
+
+int FailoverBenchmark::run(const QStringList &arguments) {
+    Options options;
+    options.cycles = Bench::intOption(arguments, "--bench-failover", options.cycles, 1);
+    options.deadStandbys = Bench::intOption(arguments, "--bench-dead", options.deadStandbys);
+    if (options.deadStandbys >= kStandbys) {
+        QTextStream(stderr) << "--bench-dead must be below " << kStandbys << ", one standby has to answer.\n";
+        return 1;
+    }
+    options.stallMs = Bench::intOption(arguments, "--bench-stall-ms", options.stallMs, 100);
+    options.backendSpec = Bench::option(arguments, "--bench-backend");
+    options.outputPath = Bench::option(arguments, "--bench-out");
+
+    Logger::setLevel(LogLevel::Warning);
+    FailoverBenchmark bench(options);
+    QObject::connect(&bench, &FailoverBenchmark::finished, qApp, &QCoreApplication::exit);
+    QTimer::singleShot(0, &bench, &FailoverBenchmark::start);
+    return qApp->exec();
+}
+
+FailoverBenchmark::FailoverBenchmark(const Options &options, QObject *parent)
+    : QObject(parent)
+    , m_options(options)
+    , m_backend(new SimulatedBackend(SimulatedBackend::parseProfile(options.backendSpec)))
+    , m_manager(new WireGuardManager(m_backend, this))
+    , m_settings(new QSettings(m_dir.filePath("bench.ini"), QSettings::IniFormat, this))
+{
+    m_manager->setSettings(m_settings);
+    connect(m_manager, &WireGuardManager::importFinished, this, &FailoverBenchmark::onImportFinished);
+    connect(m_manager, &WireGuardManager::tunnelCommandFinished, this, &FailoverBenchmark::onCommandFinished);
+    connect(m_manager, &WireGuardManager::failoverStarted, this, [this]() { m_failovers++; });
+    connect(m_manager, &WireGuardManager::failoverFinished, this, &FailoverBenchmark::onFailoverFinished);
+
+    // Poll fast so a run takes seconds; backoff scaled to match
+    HandshakeWatchdog *watchdog = m_manager->watchdog();
+    watchdog->setInterval(pollMs(options.stallMs));
+    watchdog->setStallTimeout(options.stallMs);
+    watchdog->setBackoff(options.stallMs, options.stallMs * 16);
+
+    // Detection plus a backoff per dead standby, with room to spare
+    m_deadline.setSingleShot(true);
+    m_deadline.setInterval(qMax(10000, options.stallMs * 40));
+    connect(&m_deadline, &QTimer::timeout, this, [this]() {
+        QTextStream(stderr) << "Cycle " << m_cycle << " did not finish within " << m_deadline.interval() << " ms.\n";
+        finish(1);
+    });
+}
+
+bool FailoverBenchmark::writeProfile(const QString &name, int host) {
+    QFile file(m_dir.filePath(name + ".conf"));
+    if (!m_dir.isValid() || !file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+    QTextStream out(&file);
+    out << "[Interface]\nPrivateKey = " << Bench::randomKey() << "\nAddress = 10.200.0.2/32\n"
+        << "\n[Peer]\nPublicKey = " << kPeerKey << "\nEndpoint = 192.0.2." << host << ":51820"
+        << "\nAllowedIPs = 0.0.0.0/0\n";
+    return true;
+}
+
+void FailoverBenchmark::start() {
+    ProfileStore *store = m_manager->profileStore();
+    store->setDirectory(m_dir.filePath("profiles"));
+    store->load();
+    QString error;
+    const bool ok = writeProfile("primary", 1) && writeProfile("standby-a", 2) && writeProfile("standby-b", 3)
+        && store->addProfile(m_dir.filePath("standby-a.conf"), &error) >= 0
+        && store->addProfile(m_dir.filePath("standby-b.conf"), &error) >= 0;
+    if (!ok) {
+        QTextStream(stderr) << "Failed to set up benchmark profiles. " << error << '\n';
+        emit finished(1);
+        return;
+    }
+    m_manager->initialize();
+    m_runTimer.start();
+    m_deadline.start();
+    m_manager->importConfig(m_dir.filePath("primary.conf"));
+}
+
+void FailoverBenchmark::onImportFinished(const QString &tunnelName, bool ok, const QString &error) {
+    Q_UNUSED(tunnelName);
+    if (!ok) {
+        QTextStream(stderr) << "Import failed: " << error << '\n';
+        finish(1);
+        return;
+    }
+    m_manager->startTunnel();
+}
+
+void FailoverBenchmark::onCommandFinished(TunnelWorker::Command command, bool ok, qint64 queuedMs, qint64 runMs) {
+    Q_UNUSED(queuedMs);
+    Q_UNUSED(runMs);
+    if (command == TunnelWorker::Create) m_creates++;
+    if (command != TunnelWorker::Start) return;
+    if (!ok) {
+        QTextStream(stderr) << "Start failed.\n";
+        finish(1);
+        return;
+    }
+    m_deadline.stop();
+    QTimer::singleShot(kHealthyMs, this, &FailoverBenchmark::nextCycle);
+}
+
+void FailoverBenchmark::nextCycle() {
+    if (m_cycle++ >= m_options.cycles) {
+        finish(0);
+        return;
+    }
+    // Each failover is one config push; the live one is dead+1 pushes away
+    m_backend->freezeHandshakes(m_options.deadStandbys + 1);
+    m_frozen.start();
+    m_deadline.start();
+}
+
+void FailoverBenchmark::onFailoverFinished(int attempts, qint64 detectMs, qint64 recoverMs) {
+    m_deadline.stop();
+    m_outageMs.append(double(m_frozen.elapsed()));
+    m_detectMs.append(double(detectMs));
+    m_recoverMs.append(double(recoverMs));
+    m_attempts.append(double(attempts));
+    QTimer::singleShot(kHealthyMs, this, &FailoverBenchmark::nextCycle);
+}
+
+void FailoverBenchmark::finish(int exitCode) {
+    m_deadline.stop();
+    QJsonObject root;
+    root["cycles"] = m_options.cycles;
+    root["dead_standbys"] = m_options.deadStandbys;
+    root["stall_ms"] = m_options.stallMs;
+    root["backend"] = m_backend->describe();
+    root["wall_ms"] = m_runTimer.elapsed();
+    root["failover_attempts"] = m_failovers;
+    root["adapter_creates"] = m_creates;  // More than 1 means a failover re-created the adapter
+    root["detect_ms"] = summarize(m_detectMs);
+    root["recover_ms"] = summarize(m_recoverMs);
+    root["outage_ms"] = summarize(m_outageMs);
+    root["attempts"] = summarize(m_attempts);
+
+    // The stall is noticed on the first poll past the stall timeout; allow
+    // one more poll for the send that starts the unanswered window
+    const int detectLimitMs = m_options.stallMs + 2 * pollMs(m_options.stallMs);
+    const double slowestDetect = m_detectMs.isEmpty() ? 0.0 : *std::max_element(m_detectMs.begin(), m_detectMs.end());
+    QJsonObject checks;
+    checks["allRecovered"] = m_recoverMs.size() == m_options.cycles;
+    checks["detectWithinStall"] = slowestDetect <= detectLimitMs;
+    checks["singleAdapterCreate"] = m_creates == 1;
+    const bool allPassed = Bench::allPassed(checks);
+    checks["allPassed"] = allPassed;
+    root["checks"] = checks;
+    root["detect_limit_ms"] = detectLimitMs;
+    const int written = Bench::writeReport(root, m_options.outputPath);
+    if (exitCode || written) {
+        emit finished(exitCode ? exitCode : written);
+        return;
+    }
+    if (!allPassed) QTextStream(stderr) << "Failover check failed.\n";
+    emit finished(allPassed ? 0 : 1);
+}
@@ -0,0 +1,71 @@
+#ifndef FAILOVERBENCHMARK_H
+#define FAILOVERBENCHMARK_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QTimer>
+#include <QVector>
+#include "WireGuardManager.h"
+
+class SimulatedBackend;
+
+// Connects a profile with two standby profiles for the same server on a
+// SimulatedBackend, then repeatedly freezes its handshakes and measures how
+// long the watchdog takes to notice and how long the endpoint failover takes
+// to bring traffic back. --bench-dead makes that many standbys dead too, to
+// exercise the backoff between attempts. Every cycle must recover, be
+// detected within the stall window and leave the adapter as created once;
+// a cycle that does not finish before a deadline fails the run.
+//
+//   tpn-bench --bench-failover=50 [--bench-dead=1] [--bench-stall-ms=500]
+//             [--bench-backend=config=5] [--bench-out=failover.json]
+class FailoverBenchmark : public QObject {
+    Q_OBJECT
+public:
+    struct Options {
+        int cycles = 20;
+        int deadStandbys = 0;  // Below the 2 standbys: one has to answer
+        int stallMs = 500;
+        QString backendSpec;
+        QString outputPath;  // Empty = stdout
+    };
+
+    static int run(const QStringList &arguments);  // Needs a QCoreApplication
+
+    explicit FailoverBenchmark(const Options &options, QObject *parent = nullptr);
+
+    void start();
+
+signals:
+    void finished(int exitCode);
+
+private slots:
+    void onImportFinished(const QString &tunnelName, bool ok, const QString &error);
+    void onCommandFinished(TunnelWorker::Command command, bool ok, qint64 queuedMs, qint64 runMs);
+    void onFailoverFinished(int attempts, qint64 detectMs, qint64 recoverMs);
+    void nextCycle();
+
+private:
+    Options m_options;
+    SimulatedBackend *m_backend;  // Owned by m_manager
+    WireGuardManager *m_manager;
+    QTemporaryDir m_dir;
+    QSettings *m_settings;
+    int m_cycle = 0;
+    int m_creates = 0;
+    int m_failovers = 0;
+    QElapsedTimer m_runTimer;
+    QElapsedTimer m_frozen;  // Since the current freeze
+    QTimer m_deadline;  // Start, or the current freeze, must finish by then
+
+    QVector<double> m_detectMs;
+    QVector<double> m_recoverMs;
+    QVector<double> m_outageMs;  // Freeze to traffic, as seen from here
+    QVector<double> m_attempts;
+
+    bool writeProfile(const QString &name, int host);
+    void finish(int exitCode);
+};
+
+#endif // FAILOVERBENCHMARK_H
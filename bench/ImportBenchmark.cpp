@@ -0,0 +1,206 @@
+#include "ImportBenchmark.h"
+#include "BenchUtil.h"
+#include "BulkImporter.h"
+#include "KeyCodec.h"
+#include "ProfileStore.h"
+#include <QDir>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include <QtEndian>
+#include <zlib.h>
+
+namespace {
+
+const int kBrokenEvery = 500;  // Every Nth file is invalid, to exercise the error summary
+
+QByteArray makeConfig(int index) {
+    quint8 keys[64];
+    QRandomGenerator::global()->fillRange(reinterpret_cast<quint32 *>(keys), 16);
+    char privateKey[KeyCodec::kEncodedChars];
+    char publicKey[KeyCodec::kEncodedChars];
+    KeyCodec::encode(keys, privateKey);
+    KeyCodec::encode(keys + 32, publicKey);
+
+    QByteArray text = "[Interface]\nPrivateKey = " + QByteArray(privateKey, KeyCodec::kEncodedChars)
+            + "\nAddress = 10.200.0.2/32\nDNS = 10.200.0.1\n\n[Peer]\nPublicKey = "
+            + QByteArray(publicKey, KeyCodec::kEncodedChars)
+            + "\nEndpoint = 198.51.100." + QByteArray::number(index % 250 + 1) + ":51820\nAllowedIPs = ";
+    // A split-tunnel list, so parsing and aggregation have real work to do
+    for (int i = 0; i < 64; ++i) {
+        if (i) text += ", ";
+        text += QByteArray::number(1 + (index + i * 3) % 223) + '.' + QByteArray::number(i * 4) + ".0.0/14";
+    }
+    text += "\nPersistentKeepalive = 25\n";
+    if (index % kBrokenEvery == kBrokenEvery - 1) text.replace("PublicKey = ", "PublicKey = !");
+    return text;
+}
+
+void appendLe16(QByteArray *out, quint16 v) { char b[2]; qToLittleEndian(v, b); out->append(b, 2); }
+void appendLe32(QByteArray *out, quint32 v) { char b[4]; qToLittleEndian(v, b); out->append(b, 4); }
+
+// Stored (uncompressed) entries: enough to time the archive path
+bool writeZip(const QString &path, const QVector<QPair<QString, QByteArray>> &files) {
+    QByteArray zip;
+    QByteArray directory;
+    for (const auto &file : files) {
+        const QByteArray name = file.first.toUtf8();
+        const quint32 crc = quint32(crc32(0, reinterpret_cast<const Bytef *>(file.second.constData()), uInt(file.second.size())));
+        const quint32 offset = quint32(zip.size());
+        appendLe32(&zip, 0x04034b50);
+        appendLe16(&zip, 20); appendLe16(&zip, 0x800); appendLe16(&zip, 0);
+        appendLe16(&zip, 0); appendLe16(&zip, 0);
+        appendLe32(&zip, crc); appendLe32(&zip, quint32(file.second.size())); appendLe32(&zip, quint32(file.second.size()));
+        appendLe16(&zip, quint16(name.size())); appendLe16(&zip, 0);
+        zip += name;
+        zip += file.second;
+
+        appendLe32(&directory, 0x02014b50);
+        appendLe16(&directory, 20); appendLe16(&directory, 20); appendLe16(&directory, 0x800); appendLe16(&directory, 0);
+        appendLe16(&directory, 0); appendLe16(&directory, 0);
+        appendLe32(&directory, crc); appendLe32(&directory, quint32(file.second.size())); appendLe32(&directory, quint32(file.second.size()));
+        appendLe16(&directory, quint16(name.size())); appendLe16(&directory, 0); appendLe16(&directory, 0);
+        appendLe16(&directory, 0); appendLe16(&directory, 0); appendLe32(&directory, 0);
+        appendLe32(&directory, offset);
+        directory += name;
+    }
+    const quint32 directoryOffset = quint32(zip.size());
+    zip += directory;
+    appendLe32(&zip, 0x06054b50);
+    appendLe16(&zip, 0); appendLe16(&zip, 0);
+    appendLe16(&zip, quint16(files.size())); appendLe16(&zip, quint16(files.size()));
+    appendLe32(&zip, quint32(directory.size())); appendLe32(&zip, directoryOffset);
+    appendLe16(&zip, 0);
+
+    QFile out(path);
+    return out.open(QIODevice::WriteOnly | QIODevice::Truncate) && out.write(zip) == zip.size();
+}
+
+struct Run {
+    int imported = 0;
+    int failed = 0;
+    QStringList replaced;
+    int progressEvents = 0;
+    qint64 ms = 0;
+    QString error;
+};
+
+Run importInto(const QString &storeDir, const QString &source, int threads) {
+    ProfileStore store;
+    store.setDirectory(storeDir);
+    store.load();
+    BulkImporter importer(&store);
+    importer.setMaxThreads(threads);
+
+    Run run;
+    QEventLoop loop;
+    QObject::connect(&importer, &BulkImporter::progressChanged, &loop, [&run]() { ++run.progressEvents; });
+    QObject::connect(&importer, &BulkImporter::finished, &loop,
+                     [&](int imported, const QVector<BulkImporter::Failure> &failures, const QStringList &replaced,
+                         const QString &error, qint64 ms) {
+        run.imported = imported;
+        run.failed = failures.size();
+        run.replaced = replaced;
+        run.error = error;
+        run.ms = ms;
+        loop.quit();
+    });
+    importer.start(QStringList() << source);
+    loop.exec();
+    return run;
+}
+
+QJsonObject toJson(const Run &run, int threads, int files) {
+    QJsonObject entry;
+    entry["threads"] = threads;
+    entry["ms"] = run.ms;
+    entry["files_per_s"] = run.ms ? files * 1000.0 / run.ms : 0.0;
+    entry["imported"] = run.imported;
+    entry["failed"] = run.failed;
+    entry["replaced"] = run.replaced.size();
+    entry["progress_events"] = run.progressEvents;
+    if (!run.error.isEmpty()) entry["error"] = run.error;
+    return entry;
+}
+
+} // namespace
+
+int ImportBenchmark::run(const QStringList &arguments) {
+    const int files = Bench::intOption(arguments, "--bench-import", 5000, 1);
+    QVector<int> threadCounts = Bench::intListOption(arguments, "--bench-threads", {});
+    if (threadCounts.isEmpty()) {
+        for (int t = 1; t < QThread::idealThreadCount(); t *= 2) threadCounts.append(t);
+        threadCounts.append(QThread::idealThreadCount());
+    }
+
+    QTemporaryDir root;
+    const QDir dir(root.path());
+    dir.mkpath("source");
+    QVector<QPair<QString, QByteArray>> generated;
+    generated.reserve(files);
+    for (int i = 0; i < files; ++i) {
+        const QString name = QString("server-%1.conf").arg(i, 5, 10, QChar('0'));
+        const QByteArray text = makeConfig(i);
+        QFile file(dir.filePath("source/" + name));
+        if (!file.open(QIODevice::WriteOnly) || file.write(text) != text.size()) {
+            QTextStream(stderr) << "Failed to write " << file.fileName() << '\n';
+            return 1;
+        }
+        generated.append(qMakePair(name, text));
+    }
+    const QString zipPath = dir.filePath("bundle.zip");
+    if (!writeZip(zipPath, generated)) {
+        QTextStream(stderr) << "Failed to write " << zipPath << '\n';
+        return 1;
+    }
+
+    QJsonArray runs;
+    double baselineMs = 0;
+    int maxThreads = 1;
+    for (int threads : qAsConst(threadCounts)) {
+        const Run run = importInto(dir.filePath(QString("store-%1").arg(threads)), dir.filePath("source"), threads);
+        QJsonObject entry = toJson(run, threads, files);
+        if (baselineMs == 0) baselineMs = run.ms;
+        entry["speedup"] = run.ms ? baselineMs / run.ms : 0.0;
+        runs.append(entry);
+        maxThreads = qMax(maxThreads, threads);
+    }
+    const Run zipRun = importInto(dir.filePath("store-zip"), zipPath, maxThreads);
+
+    // Entry names that would leave the store or open a device must fail
+    // their file; one that matches a stored profile must be reported
+    const QString unsafePath = dir.filePath("unsafe.zip");
+    QVector<QPair<QString, QByteArray>> unsafe;
+    unsafe.append(qMakePair(QString("..\\..\\escape.conf"), makeConfig(1)));
+    unsafe.append(qMakePair(QString("CON.conf"), makeConfig(2)));
+    unsafe.append(qMakePair(QString("nested/nul.txt.conf"), makeConfig(3)));
+    unsafe.append(qMakePair(QString("server-00000.conf"), makeConfig(0)));
+    if (!writeZip(unsafePath, unsafe)) {
+        QTextStream(stderr) << "Failed to write " << unsafePath << '\n';
+        return 1;
+    }
+    const Run unsafeRun = importInto(dir.filePath("store-zip"), unsafePath, 1);
+    const QDir zipStore(dir.filePath("store-zip"));
+
+    QJsonObject checks;
+    checks["unsafeNamesRejected"] = unsafeRun.failed == unsafe.size() - 1 && unsafeRun.imported == 1;
+    checks["nothingEscaped"] = zipStore.entryList(QStringList() << "*escape*").isEmpty()
+            && !QFile::exists(dir.filePath("escape.conf")) && !QFile::exists(dir.filePath("../escape.conf"));
+    checks["overwriteReported"] = unsafeRun.replaced == (QStringList() << "server-00000");
+    const bool allPassed = Bench::allPassed(checks);
+    checks["allPassed"] = allPassed;
+
+    QJsonObject report;
+    report["files"] = files;
+    report["expected_failures"] = files / kBrokenEvery;
+    report["directory"] = runs;
+    report["zip"] = toJson(zipRun, maxThreads, files);
+    report["unsafe"] = toJson(unsafeRun, 1, unsafe.size());
+    report["checks"] = checks;
+    return Bench::finish(report, arguments, allPassed, "import name check failed");
+}
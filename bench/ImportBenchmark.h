@@ -0,0 +1,19 @@
+#ifndef IMPORTBENCHMARK_H
+#define IMPORTBENCHMARK_H
+
+#include <QStringList>
+
+// Bulk import scaling: generates N configs (plus a few broken ones) into a
+// directory and a stored .zip, then imports the directory into an empty
+// profile store once per thread count and the archive once at the largest.
+// Reports wall time, files/s and speedup over one thread as JSON. A last
+// archive with traversal and device names plus one existing profile checks
+// that the unsafe ones are refused and the overwrite is reported.
+//
+//   tpn-bench --bench-import=5000 [--bench-threads=1,2,4,8] [--bench-out=import.json]
+class ImportBenchmark {
+public:
+    static int run(const QStringList &arguments);  // Needs a QCoreApplication
+};
+
+#endif // IMPORTBENCHMARK_H
@@ -0,0 +1,151 @@
+#include "IpcBenchmark.h"
+#include "BenchUtil.h"
+#include "ControlChannel.h"
+#include "ControlServer.h"
+#include "Logger.h"
+#include "ProcessInfo.h"
+#include "SimulatedBackend.h"
+#include <QCborArray>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonObject>
+#include <QLocalSocket>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include <algorithm>
+
+namespace {
+
+struct Results {
+    QHash<QString, QVector<qint64>> ns;  // Command -> round trips
+    QHash<QString, int> failures;
+    QString error;
+};
+
+bool writeProfile(const QString &path) {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+    quint32 words[16];
+    QRandomGenerator::global()->fillRange(words);
+    QTextStream out(&file);
+    out << "[Interface]\nPrivateKey = " << QByteArray(reinterpret_cast<const char *>(words), 32).toBase64()
+        << "\nAddress = 10.200.0.2/32\n\n[Peer]\nPublicKey = "
+        << QByteArray(reinterpret_cast<const char *>(words + 8), 32).toBase64()
+        << "\nEndpoint = 192.0.2.1:51820\nAllowedIPs = 0.0.0.0/0\n";
+    return true;
+}
+
+// Runs on the client thread with a blocking socket, like ControlClient
+void drive(const QString &serverName, int rounds, Results *results) {
+    ControlChannel channel(new QLocalSocket);
+    channel.socket()->connectToServer(serverName);
+    if (!channel.socket()->waitForConnected(1000)) {
+        results->error = channel.socket()->errorString();
+        return;
+    }
+
+    qint64 id = 0;
+    auto call = [&](const QString &command, const QString &profile = QString()) {
+        QCborMap request;
+        request.insert(QLatin1String("id"), ++id);
+        request.insert(QLatin1String("cmd"), command);
+        if (!profile.isEmpty()) request.insert(QLatin1String("args"), QCborArray{ profile });
+        QElapsedTimer timer;
+        timer.start();
+        channel.send(request);
+        channel.socket()->flush();
+        QCborMap reply;
+        const bool ok = channel.waitForMessage(&reply, 30000) && reply.value(QLatin1String("id")).toInteger() == id
+            && reply.value(QLatin1String("ok")).toBool();
+        if (ok) results->ns[command].append(timer.nsecsElapsed());
+        else results->failures[command]++;
+    };
+
+    call("connect", "bench");  // Includes the simulated driver; one sample
+    for (int i = 0; i < rounds; ++i) call("ping");
+    for (int i = 0; i < rounds; ++i) call("status");
+    for (int i = 0; i < rounds; ++i) call("stats");
+    call("disconnect");
+}
+
+} // namespace
+
+int IpcBenchmark::run(const QStringList &arguments) {
+    const int rounds = Bench::intOption(arguments, "--bench-ipc", 10000, 1);
+    const QString backendSpec = Bench::option(arguments, "--bench-backend");
+
+    Logger::setLevel(LogLevel::Warning);
+    QTemporaryDir dir;
+    SimulatedBackend *backend = new SimulatedBackend(SimulatedBackend::parseProfile(backendSpec));
+    WireGuardManager manager(backend);
+    QSettings settings(dir.filePath("bench.ini"), QSettings::IniFormat);
+    manager.setSettings(&settings);
+    manager.profileStore()->setDirectory(dir.filePath("profiles"));
+    manager.profileStore()->load();
+    QString error;
+    if (!dir.isValid() || !writeProfile(dir.filePath("bench.conf"))
+        || manager.profileStore()->addProfile(dir.filePath("bench.conf"), &error) < 0) {
+        QTextStream(stderr) << "Failed to set up the benchmark profile. " << error << '\n';
+        return 1;
+    }
+    manager.initialize();
+
+    ControlServer server(&manager);
+    const QString name = QString("tpn-bench-%1").arg(QCoreApplication::applicationPid());
+    if (!server.listen(name, &error)) {
+        QTextStream(stderr) << "Cannot listen: " << error << '\n';
+        return 1;
+    }
+    // A second instance must leave the live server's name alone
+    ControlServer second(&manager);
+    QString secondError;
+    const bool secondRefused = !second.listen(name, &secondError);
+
+    Results results;
+    QElapsedTimer wall;
+    wall.start();
+    QThread *client = QThread::create(drive, name, rounds, &results);
+    QObject::connect(client, &QThread::finished, qApp, &QCoreApplication::quit);
+    client->start();
+    qApp->exec();
+    client->wait();
+    delete client;
+
+    if (!results.error.isEmpty()) {
+        QTextStream(stderr) << "Client failed: " << results.error << '\n';
+        return 1;
+    }
+
+    QJsonObject commands;
+    QStringList names = results.ns.keys() + results.failures.keys();
+    names.removeDuplicates();
+    for (const QString &command : qAsConst(names)) {
+        QVector<qint64> sorted = results.ns.value(command);
+        std::sort(sorted.begin(), sorted.end());
+        QJsonObject entry;
+        entry["count"] = sorted.size();
+        entry["failures"] = results.failures.value(command);
+        entry["p50_us"] = percentile(sorted, 50) / 1000.0;
+        entry["p99_us"] = percentile(sorted, 99) / 1000.0;
+        entry["max_us"] = sorted.isEmpty() ? 0.0 : sorted.last() / 1000.0;
+        commands[command] = entry;
+    }
+    QJsonObject checks;
+    checks["secondInstanceRefused"] = secondRefused;
+    checks["firstStillServes"] = !results.ns.value("ping").isEmpty() && !results.failures.value("ping");
+    const bool allPassed = Bench::allPassed(checks);
+    checks["allPassed"] = allPassed;
+
+    QJsonObject root;
+    root["rounds"] = rounds;
+    root["backend"] = backend->describe();
+    root["wall_ms"] = wall.elapsed();
+    root["rss_kb"] = ProcessInfo::residentKb();
+    root["commands"] = commands;
+    root["checks"] = checks;
+    return Bench::finish(root, arguments, allPassed, "IPC check failed");
+}
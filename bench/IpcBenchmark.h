@@ -0,0 +1,18 @@
+#ifndef IPCBENCHMARK_H
+#define IPCBENCHMARK_H
+
+#include <QStringList>
+
+// Round-trip latency of the control protocol: serves a SimulatedBackend
+// manager on a private socket and drives it from a blocking client on a
+// second thread, the way the CLI talks to a headless instance. Reports
+// per-command p50/p99/max in microseconds as JSON, and checks that a second
+// server refuses to take over the live one's socket name.
+//
+//   tpn-bench --bench-ipc=10000 [--bench-backend=state=10] [--bench-out=ipc.json]
+class IpcBenchmark {
+public:
+    static int run(const QStringList &arguments);  // Needs a QCoreApplication
+};
+
+#endif // IPCBENCHMARK_H
@@ -0,0 +1,156 @@
+#include "KeyBenchmark.h"
+#include "BenchUtil.h"
+#include "ConfigParser.h"
+#include "KeyCodec.h"
+#include "SecretArena.h"
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <QVector>
+
+namespace {
+
+const int kDistinctKeys = 1024;  // Cycled through, so the inputs stay in cache
+
+bool allZero(const quint8 *data, int size) {
+    quint8 bits = 0;
+    for (int i = 0; i < size; ++i) bits |= data[i];
+    return bits == 0;
+}
+
+// Released slots stay mapped inside the arena, so the memory a buffer used
+// can still be inspected after it is gone
+bool checkReleasedBuffer() {
+    const quint8 *slot = nullptr;
+    {
+        SecretBuffer key(32);
+        memset(key.data(), 0xA5, 32);
+        slot = key.constData();
+    }
+    return allZero(slot, 32);
+}
+
+bool checkDetachedCopy() {
+    SecretBuffer original(32);
+    memset(original.data(), 0x5A, 32);
+    const quint8 *slot = nullptr;
+    {
+        SecretBuffer copy = original;
+        copy.data()[0] = 0;  // Detaches into its own slot
+        slot = copy.constData();
+        if (slot == original.constData() || original.constData()[0] != 0x5A) return false;
+    }
+    return allZero(slot, 32);
+}
+
+bool checkParsedKeys() {
+    quint8 secret[32];
+    for (int i = 0; i < 32; ++i) secret[i] = quint8(i + 1);
+    char encoded[KeyCodec::kEncodedChars];
+    KeyCodec::encode(secret, encoded);
+    const QByteArray key(encoded, KeyCodec::kEncodedChars);
+    const QByteArray text = "[Interface]\nPrivateKey = " + key + "\n[Peer]\nPublicKey = " + key
+            + "\nPresharedKey = " + key + "\nAllowedIPs = 0.0.0.0/0\n";
+
+    const quint8 *privateSlot = nullptr;
+    const quint8 *presharedSlot = nullptr;
+    {
+        TunnelConfig config;
+        ConfigParser parser;
+        if (!parser.parse(text.constData(), text.size(), &config) || config.peers.size() != 1) return false;
+        if (memcmp(config.iface.privateKey.constData(), secret, 32) != 0) return false;
+        privateSlot = config.iface.privateKey.constData();
+        presharedSlot = config.peers[0].presharedKey.constData();
+    }
+    return allZero(privateSlot, 32) && allZero(presharedSlot, 32);
+}
+
+bool checkFailedDecode() {
+    char encoded[KeyCodec::kEncodedChars];
+    quint8 secret[32];
+    memset(secret, 0x3C, 32);
+    KeyCodec::encode(secret, encoded);
+    encoded[40] = '-';  // base64url, not accepted
+    quint8 out[32];
+    memset(out, 0xFF, 32);
+    return !KeyCodec::decode(encoded, KeyCodec::kEncodedChars, out) && allZero(out, 32);
+}
+
+} // namespace
+
+int KeyBenchmark::run(const QStringList &arguments) {
+    const int iterations = Bench::intOption(arguments, "--bench-keys", 1000000, 1);
+
+    QVector<QByteArray> encoded(kDistinctKeys);
+    QVector<QString> encodedText(kDistinctKeys);
+    QVector<QByteArray> raw(kDistinctKeys);
+    for (int i = 0; i < kDistinctKeys; ++i) {
+        raw[i].resize(32);
+        QRandomGenerator::global()->fillRange(reinterpret_cast<quint32 *>(raw[i].data()), 8);
+        encoded[i].resize(KeyCodec::kEncodedChars);
+        KeyCodec::encode(reinterpret_cast<const quint8 *>(raw[i].constData()), encoded[i].data());
+        encodedText[i] = QString::fromLatin1(encoded[i]);
+        if (encoded[i] != raw[i].toBase64()) {
+            QTextStream(stderr) << "KeyCodec::encode disagrees with QByteArray::toBase64\n";
+            return 1;
+        }
+    }
+
+    QElapsedTimer clock;
+    quint8 out[32];
+    quint32 sink = 0;
+
+    clock.start();
+    for (int i = 0; i < iterations; ++i) {
+        const QByteArray &in = encoded[i & (kDistinctKeys - 1)];
+        sink += KeyCodec::decode(in.constData(), in.size(), out) ? out[i & 31] : 0;
+    }
+    const double decodeNs = double(clock.nsecsElapsed()) / iterations;
+
+    // The allocating path keys used to take: QString -> UTF-8 -> fromBase64
+    clock.start();
+    for (int i = 0; i < iterations; ++i) {
+        const QByteArray decoded = QByteArray::fromBase64(encodedText[i & (kDistinctKeys - 1)].toUtf8());
+        sink += quint8(decoded.at(i & 31));
+    }
+    const double legacyDecodeNs = double(clock.nsecsElapsed()) / iterations;
+
+    char text[KeyCodec::kEncodedChars];
+    clock.start();
+    for (int i = 0; i < iterations; ++i) {
+        KeyCodec::encode(reinterpret_cast<const quint8 *>(raw[i & (kDistinctKeys - 1)].constData()), text);
+        sink += quint8(text[i & 31]);
+    }
+    const double encodeNs = double(clock.nsecsElapsed()) / iterations;
+
+    clock.start();
+    for (int i = 0; i < iterations; ++i) {
+        SecretBuffer key(32);
+        key.data()[0] = quint8(i);
+        sink += key.constData()[0];
+    }
+    const double allocNs = double(clock.nsecsElapsed()) / iterations;
+
+    QJsonObject checks;
+    checks["released_buffer"] = checkReleasedBuffer();
+    checks["detached_copy"] = checkDetachedCopy();
+    checks["parsed_keys"] = checkParsedKeys();
+    checks["failed_decode"] = checkFailedDecode();
+    const bool allPassed = Bench::allPassed(checks);
+
+    const SecretArena &arena = SecretArena::instance();
+    QJsonObject root;
+    root["iterations"] = iterations;
+    root["decode_ns"] = decodeNs;
+    root["decode_keys_per_s"] = 1e9 / qMax(1e-3, decodeNs);
+    root["legacy_decode_ns"] = legacyDecodeNs;
+    root["encode_ns"] = encodeNs;
+    root["secret_alloc_ns"] = allocNs;
+    root["arena_locked"] = arena.isLocked();
+    root["arena_locked_bytes"] = qint64(arena.lockedBytes());
+    root["wipe_checks"] = checks;
+    root["sink"] = qint64(sink);  // Keeps the loops from being optimized out
+    return Bench::finish(root, arguments, allPassed, "Wipe check failed");
+}
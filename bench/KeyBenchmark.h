@@ -0,0 +1,17 @@
+#ifndef KEYBENCHMARK_H
+#define KEYBENCHMARK_H
+
+#include <QStringList>
+
+// Key decode/encode throughput of KeyCodec against the QByteArray base64
+// round trip, SecretBuffer allocation cost, and wipe checks: keys decoded
+// through the parser, released SecretBuffers and failed decodes must leave
+// only zeros behind. Exits non-zero if any check fails.
+//
+//   tpn-bench --bench-keys=1000000 [--bench-out=keys.json]
+class KeyBenchmark {
+public:
+    static int run(const QStringList &arguments);  // Needs a QCoreApplication
+};
+
+#endif // KEYBENCHMARK_H
@@ -0,0 +1,97 @@
+#include "LogBenchmark.h"
+#include "BenchUtil.h"
+#include "Logger.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QThread>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+int LogBenchmark::run(const QStringList &arguments) {
+    const int records = Bench::intOption(arguments, "--bench-log", 100000, 1);
+    const int threads = Bench::intOption(arguments, "--bench-threads", 4, 1);
+
+    QTemporaryDir dir;
+    Logger &logger = Logger::instance();
+    logger.setFileOutput(dir.path(), 1024 * 1024, 3);
+    Logger::setLevel(LogLevel::Info);
+    const quint64 droppedBefore = logger.dropped();
+    const quint64 uiDroppedBefore = logger.uiDropped();
+    QVector<LogRecord> ui;
+    logger.takeBatch(&ui);  // Start with no backlog or loss notice of our own
+    const quint64 writtenBefore = logger.written();
+
+    // Producer cost is timed per call; the message is prebuilt so only the
+    // logger's own work is measured
+    QVector<QVector<qint64>> costs(threads);
+    std::vector<std::unique_ptr<QThread>> producers;
+    QElapsedTimer wall;
+    wall.start();
+    for (int t = 0; t < threads; ++t) {
+        QVector<qint64> *threadCosts = &costs[t];
+        producers.emplace_back(QThread::create([threadCosts, records, t]() {
+            const QString message = QString("Benchmark record from producer %1").arg(t);
+            threadCosts->resize(records);
+            QElapsedTimer clock;
+            clock.start();
+            for (int i = 0; i < records; ++i) {
+                const qint64 before = clock.nsecsElapsed();
+                TPN_INFO("Bench", message);
+                (*threadCosts)[i] = clock.nsecsElapsed() - before;
+            }
+        }));
+        producers.back()->start();
+    }
+    for (auto &producer : producers) producer->wait();
+    const qint64 produceNs = wall.nsecsElapsed();
+    const bool drained = logger.flush(30000);
+    const qint64 totalNs = wall.nsecsElapsed();
+
+    QVector<qint64> all;
+    all.reserve(records * threads);
+    for (const QVector<qint64> &threadCosts : qAsConst(costs)) all += threadCosts;
+    std::sort(all.begin(), all.end());
+
+    qint64 logBytes = 0;
+    for (const QFileInfo &file : QDir(dir.path()).entryInfoList(QDir::Files)) logBytes += file.size();
+    ui.clear();
+    logger.takeBatch(&ui);  // Keep the UI backlog from outliving the run
+
+    const quint64 dropped = logger.dropped() - droppedBefore;
+    const quint64 uiDropped = logger.uiDropped() - uiDroppedBefore;
+    // Nobody drained the UI side during the flood, so it must have been
+    // trimmed, and the first record handed over must say so
+    const bool lossShown = !ui.isEmpty() && qstrcmp(ui.first().component, "Logger") == 0
+            && ui.first().level == LogLevel::Warning;
+    QJsonObject checks;
+    checks["uiLossReported"] = (uiDropped == 0 && dropped == 0) || lossShown;
+    const quint64 written = logger.written() - writtenBefore;
+    QJsonObject producer;
+    producer["p50_ns"] = percentile(all, 50);
+    producer["p99_ns"] = percentile(all, 99);
+    producer["max_ns"] = all.isEmpty() ? 0.0 : double(all.last());
+
+    QJsonObject root;
+    root["records"] = records * threads;
+    root["threads"] = threads;
+    root["producer"] = producer;
+    root["burst_records_per_s"] = records * threads / (produceNs / 1e9);
+    root["sustained_records_per_s"] = double(written) / (totalNs / 1e9);
+    root["drain_ms"] = (totalNs - produceNs) / 1e6;
+    root["drained"] = drained;
+    root["written"] = double(written);
+    root["dropped"] = double(dropped);
+    root["ui_dropped"] = double(uiDropped);
+    root["log_bytes"] = double(logBytes);
+
+    const bool allPassed = Bench::allPassed(checks);
+    checks["allPassed"] = allPassed;
+    root["checks"] = checks;
+
+    logger.setFileOutput(QString());
+    return Bench::finish(root, arguments, allPassed, "log loss check failed");
+}
@@ -0,0 +1,18 @@
+#ifndef LOGBENCHMARK_H
+#define LOGBENCHMARK_H
+
+#include <QStringList>
+
+// Floods the Logger from several producer threads and reports per-call
+// producer cost (p50/p99), the burst rate producers achieved, how many
+// records the ring had to drop and how long the writer took to catch up.
+// The UI side is left undrained, so its backlog overflows; the check is
+// that the next batch opens with a notice of how many were not shown.
+//
+//   tpn-bench --bench-log=200000 --bench-threads=4 [--bench-out=log.json]
+class LogBenchmark {
+public:
+    static int run(const QStringList &arguments);  // Needs a QCoreApplication
+};
+
+#endif // LOGBENCHMARK_H
@@ -0,0 +1,123 @@
+#include "LogViewBenchmark.h"
+#include "BenchUtil.h"
+#include "LogModel.h"
+#include "ProcessInfo.h"
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonObject>
+
+namespace {
+
+const int kBatch = 1024;  // About what the logger hands the UI per frame under load
+const char *const kComponents[] = { "WG", "Worker", "DNS", "Qt", "Watchdog", "Import" };
+
+LogRecord makeRecord(int i) {
+    LogRecord record;
+    record.timestampMs = 1700000000000LL + i;
+    const int kind = i % 100;
+    record.level = kind < 2 ? LogLevel::Error : kind < 10 ? LogLevel::Warning : kind < 40 ? LogLevel::Debug : LogLevel::Info;
+    record.component = kComponents[(i / 7) % 6];
+    switch (i % 5) {
+    case 0: record.message = QString("Resolved %1 endpoint(s) in %2 ms.").arg(i % 9).arg(i % 113); break;
+    case 1: record.message = QString("Reconfigure done (queued %1 ms, driver %2 ms).").arg(i % 17).arg(i % 41); break;
+    case 2: record.message = QString("Peer %1 stalled, attempt %2: switching endpoint.").arg(i % 997, 4, 16, QChar('0')).arg(i % 3 + 1); break;
+    case 3: record.message = QString("Handshake with 192.0.2.%1:51820 completed.").arg(i % 254 + 1); break;
+    default: record.message = QString("Domain routes: %1 added, %2 removed.").arg(i % 11).arg(i % 5); break;
+    }
+    if (i % 50000 == 49999) record.message += " NEEDLE-TOKEN";  // Rare hit
+    return record;
+}
+
+struct Case {
+    const char *name;
+    LogLevel minLevel;
+    QString component;
+    QString text;
+    bool refine;  // Applied on top of the previous case
+};
+
+// What the filter should return, by scanning every record
+int naiveCount(const LogStore &store, const Case &c) {
+    const int component = c.component.isEmpty() ? -1 : store.componentId(c.component);
+    int count = 0;
+    for (qint64 id = store.firstId(); id < store.endId(); ++id) {
+        if (store.level(id) < c.minLevel) continue;
+        if (component >= 0 && store.component(id) != component) continue;
+        if (!c.text.isEmpty() && !store.message(id).contains(c.text, Qt::CaseInsensitive)) continue;
+        ++count;
+    }
+    return count;
+}
+
+} // namespace
+
+int LogViewBenchmark::run(const QStringList &arguments) {
+    const QVector<int> sizes = Bench::intListOption(arguments, "--bench-viewer", { 10000, 1000000 });
+
+    const QVector<Case> cases{
+        { "warnings", LogLevel::Warning, QString(), QString(), false },
+        { "component", LogLevel::Debug, "DNS", QString(), false },
+        { "substring_common", LogLevel::Debug, QString(), "handshake", false },
+        { "substring_refined", LogLevel::Debug, QString(), "handshake with 192.0.2.1", true },
+        { "substring_rare", LogLevel::Debug, QString(), "needle-token", false },
+        { "combined", LogLevel::Warning, "Worker", "driver", false },
+    };
+
+    bool allPassed = true;
+    QJsonArray runs;
+    for (int size : qAsConst(sizes)) {
+        const qint64 rssBefore = ProcessInfo::residentKb();
+        LogModel model(nullptr, qint64(size) + LogStore::kChunkLines);  // No drops while measuring
+
+        QVector<LogRecord> batch;
+        batch.reserve(kBatch);
+        qint64 appendNs = 0;
+        QElapsedTimer clock;
+        for (int i = 0; i < size; i += batch.size()) {
+            batch.clear();
+            for (int j = i; j < size && batch.size() < kBatch; ++j) batch.append(makeRecord(j));
+            clock.start();
+            model.append(batch);
+            appendNs += clock.nsecsElapsed();
+        }
+        const qint64 rssAfter = ProcessInfo::residentKb();
+
+        QJsonObject filters;
+        for (const Case &c : cases) {
+            if (!c.refine) model.setFilter(LogLevel::Debug, QString(), QString());
+            model.setFilter(c.minLevel, c.component, c.text);
+            QJsonObject entry;
+            entry["ms"] = model.lastFilterNs() / 1e6;
+            entry["rows"] = model.rowCount();
+            const bool ok = model.rowCount() == naiveCount(model.store(), c);
+            entry["ok"] = ok;
+            allPassed = allPassed && ok;
+            filters[c.name] = entry;
+        }
+
+        // New records while filtered are matched as they arrive
+        batch.clear();
+        for (int j = size; j < size + kBatch; ++j) batch.append(makeRecord(j));
+        model.setFilter(LogLevel::Warning, QString(), QString());
+        clock.start();
+        model.append(batch);
+        const qint64 filteredAppendNs = clock.nsecsElapsed();
+        const bool tailOk = model.rowCount() == naiveCount(model.store(), cases[0]);
+        allPassed = allPassed && tailOk;
+
+        QJsonObject result;
+        result["lines"] = size;
+        result["append_lines_per_s"] = appendNs ? size * 1e9 / appendNs : 0.0;
+        result["append_batch_us"] = appendNs / 1e3 / qMax(1, (size + kBatch - 1) / kBatch);
+        result["filtered_append_batch_us"] = filteredAppendNs / 1e3;
+        result["filtered_append_ok"] = tailOk;
+        result["bytes_per_line"] = rssBefore > 0 && rssAfter > rssBefore ? (rssAfter - rssBefore) * 1024.0 / size : 0.0;
+        result["filters"] = filters;
+        runs.append(result);
+    }
+
+    QJsonObject root;
+    root["runs"] = runs;
+    root["chunk_lines"] = LogStore::kChunkLines;
+    return Bench::finish(root, arguments, allPassed, "Filter result mismatch");
+}
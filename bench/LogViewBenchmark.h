@@ -0,0 +1,18 @@
+#ifndef LOGVIEWBENCHMARK_H
+#define LOGVIEWBENCHMARK_H
+
+#include <QStringList>
+
+// Log pane model at scale: fills a LogModel with synthetic records and
+// reports the append rate, memory per line and the latency of level,
+// component, substring and refined (one more typed character) filters.
+// Every filter result is checked against a plain scan of the store.
+// Exits non-zero on a mismatch.
+//
+//   tpn-bench --bench-viewer=10000,1000000 [--bench-out=viewer.json]
+class LogViewBenchmark {
+public:
+    static int run(const QStringList &arguments);  // Needs a QCoreApplication
+};
+
+#endif // LOGVIEWBENCHMARK_H
@@ -0,0 +1,200 @@
+#include "ParseBenchmark.h"
+#include "AllocationCounter.h"
+#include "BenchUtil.h"
+#include "ConfigParser.h"
+#include "KeyCodec.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+namespace {
+
+const int kMinRuns = 3;
+const int kMinRunMs = 200;
+
+// Deterministic per peer, so a parse can be checked without keeping the input
+void peerKey(int peer, quint8 salt, quint8 out[KeyCodec::kKeyBytes]) {
+    for (int i = 0; i < KeyCodec::kKeyBytes; ++i) out[i] = quint8(peer * 131 + i * 7 + salt);
+}
+
+QByteArray encodedKey(int peer, quint8 salt) {
+    quint8 raw[KeyCodec::kKeyBytes];
+    char text[KeyCodec::kEncodedChars];
+    peerKey(peer, salt, raw);
+    KeyCodec::encode(raw, text);
+    return QByteArray(text, KeyCodec::kEncodedChars);
+}
+
+// Peer i: AllowedIPs of `allowed` IPv4 hosts in distinct /16s plus one IPv6
+// /64, so nothing aggregates; odd peers have a preshared key and an IPv6
+// endpoint
+QByteArray makeConfig(int peers, int allowed) {
+    QByteArray text;
+    text.reserve(256 + peers * (200 + allowed * 18));
+    text += "[Interface]\nPrivateKey = " + encodedKey(-1, 0)
+            + "\nAddress = 10.200.0.2/32, fd00:200::2/128\nDNS = 10.200.0.1, fd00:200::1\nMTU = 1420\n";
+    for (int i = 0; i < peers; ++i) {
+        text += "\n[Peer]\nPublicKey = " + encodedKey(i, 1);
+        if (i % 2) {
+            text += "\nPresharedKey = " + encodedKey(i, 2);
+            text += "\nEndpoint = [2001:db8::" + QByteArray::number(i % 0xffff, 16) + "]:51820";
+        } else {
+            text += "\nEndpoint = 192.0.2." + QByteArray::number(i % 254 + 1) + ":51820";
+        }
+        text += "\nAllowedIPs = ";
+        for (int k = 0; k < allowed; ++k) {
+            text += "10." + QByteArray::number(k % 200) + '.' + QByteArray::number(i / 256 % 256) + '.'
+                    + QByteArray::number(i % 256) + "/32, ";
+        }
+        text += "fd00:" + QByteArray::number(i % 0xffff, 16) + "::/64\nPersistentKeepalive = 25\n";
+    }
+    return text;
+}
+
+bool checkConfig(const TunnelConfig &config, int peers, int allowed) {
+    if (config.peers.size() != peers || config.iface.privateKey.size() != KeyCodec::kKeyBytes
+            || config.iface.addresses.size() != 2 || config.iface.dns.size() != 2 || config.iface.mtu != 1420) {
+        return false;
+    }
+    quint8 expected[KeyCodec::kKeyBytes];
+    for (int i = 0; i < peers; ++i) {
+        const PeerConfig &peer = config.peers.at(i);
+        peerKey(i, 1, expected);
+        if (memcmp(peer.publicKey, expected, sizeof(expected)) != 0) return false;
+        if (peer.hasPresharedKey != bool(i % 2) || peer.persistentKeepalive != 25 || peer.endpointPort != 51820) return false;
+        if (peer.hasPresharedKey) {
+            peerKey(i, 2, expected);
+            if (memcmp(peer.presharedKey.constData(), expected, sizeof(expected)) != 0) return false;
+        }
+        const QByteArray host = i % 2 ? "2001:db8::" + QByteArray::number(i % 0xffff, 16)
+                                      : "192.0.2." + QByteArray::number(i % 254 + 1);
+        if (peer.endpointHost != host || peer.allowedIPs.size() != allowed + 1) return false;
+    }
+    return true;
+}
+
+// Errors are reported on the offending line, not at the end of the input
+bool checkMalformed() {
+    const QByteArray good = makeConfig(3, 2);
+    struct Case {
+        QByteArray from;
+        QByteArray to;
+        int line;
+    };
+    const QVector<Case> cases{
+        { "MTU = 1420", "MTU = 14x0", 5 },
+        { "PersistentKeepalive = 25\n\n[Peer]", "PersistentKeepalive = -1\n\n[Peer]", 11 },
+        { "AllowedIPs = 10.0.0.0/32", "AllowedIPs = 10.0.0.0/33", 10 },
+        { "Endpoint = [2001:db8::1]:51820", "Endpoint = [2001:db8::1:51820", 16 },
+    };
+    for (const Case &c : cases) {
+        QByteArray text = good;
+        text.replace(c.from, c.to);
+        TunnelConfig config;
+        ConfigParser parser;
+        if (parser.parse(text.constData(), text.size(), &config) || parser.errorLine() != c.line) return false;
+    }
+    return true;
+}
+
+struct Result {
+    double mbPerSec = 0;
+    double fileMbPerSec = 0;
+    int runs = 0;
+    quint64 allocations = 0;
+    bool ok = false;
+};
+
+Result measure(const QByteArray &text, const QString &path, int peers, int allowed) {
+    Result result;
+    QVector<double> seconds;
+    QElapsedTimer total;
+    total.start();
+    bool ok = true;
+    while (seconds.size() < kMinRuns || total.elapsed() < kMinRunMs) {
+        TunnelConfig config;
+        ConfigParser parser;
+        QElapsedTimer clock;
+        clock.start();
+        ok = parser.parse(text.constData(), text.size(), &config) && ok;
+        seconds.append(clock.nsecsElapsed() / 1e9);
+    }
+    result.runs = seconds.size();
+    result.mbPerSec = text.size() / 1e6 / qMax(1e-9, unsortedPercentile(seconds, 50));
+
+    // Into a fresh config, so the count includes every output list
+    {
+        const quint64 before = AllocationCounter::count();
+        TunnelConfig config;
+        ConfigParser parser;
+        ok = parser.parse(text.constData(), text.size(), &config) && ok;
+        result.allocations = AllocationCounter::count() - before;
+        ok = ok && checkConfig(config, peers, allowed);
+    }
+
+    seconds.clear();
+    total.restart();
+    while (seconds.size() < kMinRuns || total.elapsed() < kMinRunMs) {
+        TunnelConfig config;
+        ConfigParser parser;
+        QElapsedTimer clock;
+        clock.start();
+        ok = parser.parseFile(path, &config) && ok;
+        seconds.append(clock.nsecsElapsed() / 1e9);
+    }
+    result.fileMbPerSec = text.size() / 1e6 / qMax(1e-9, unsortedPercentile(seconds, 50));
+    result.ok = ok;
+    return result;
+}
+
+} // namespace
+
+int ParseBenchmark::run(const QStringList &arguments) {
+    const QVector<int> peerCounts = Bench::intListOption(arguments, "--bench-parse", { 1, 100, 10000 });
+    const int allowed = Bench::intOption(arguments, "--bench-allowed", 8);
+
+    QTemporaryDir dir;
+    bool allPassed = dir.isValid();
+    QJsonArray runs;
+    for (int peers : peerCounts) {
+        const QByteArray text = makeConfig(peers, allowed);
+        const QString path = dir.filePath(QString("peers-%1.conf").arg(peers));
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(text) != text.size()) {
+            QTextStream(stderr) << "Failed to write " << path << '\n';
+            return 1;
+        }
+        file.close();
+
+        const Result result = measure(text, path, peers, allowed);
+        allPassed = allPassed && result.ok;
+        QJsonObject entry;
+        entry["peers"] = peers;
+        entry["bytes"] = text.size();
+        entry["runs"] = result.runs;
+        entry["mb_per_s"] = result.mbPerSec;
+        entry["file_mb_per_s"] = result.fileMbPerSec;
+        if (AllocationCounter::isAvailable()) {
+            entry["allocations"] = double(result.allocations);
+            entry["allocations_per_peer"] = double(result.allocations) / peers;
+        }
+        entry["ok"] = result.ok;
+        runs.append(entry);
+    }
+
+    QJsonObject checks;
+    checks["fields"] = allPassed;
+    checks["malformed_line"] = checkMalformed();
+    allPassed = Bench::allPassed(checks);
+    checks["allPassed"] = allPassed;
+
+    QJsonObject root;
+    root["allowed_ips_per_peer"] = allowed + 1;
+    root["allocations_counted"] = AllocationCounter::isAvailable();
+    root["runs"] = runs;
+    root["checks"] = checks;
+    return Bench::finish(root, arguments, allPassed, "Config parse check failed");
+}
@@ -0,0 +1,19 @@
+#ifndef PARSEBENCHMARK_H
+#define PARSEBENCHMARK_H
+
+#include <QStringList>
+
+// ConfigParser throughput: generates configs with the given peer counts
+// (keys with padding, preshared keys, IPv4 and IPv6 endpoints, a long
+// AllowedIPs list per peer), parses each from memory and from a mapped
+// file, and reports MB/s and heap allocations per peer. Every parse is
+// checked field by field; malformed input must fail on the right line.
+// Allocations are counted where the C library allows it (glibc).
+//
+//   tpn-bench --bench-parse=1,100,10000 [--bench-allowed=8] [--bench-out=parse.json]
+class ParseBenchmark {
+public:
+    static int run(const QStringList &arguments);  // Needs a QCoreApplication
+};
+
+#endif // PARSEBENCHMARK_H
@@ -0,0 +1,226 @@
+#include "PathMtuBenchmark.h"
+#include "BenchUtil.h"
+#include "EchoResponder.h"
+#include "Logger.h"
+#include "PathMtuProber.h"
+#include "SelfTestServer.h"
+#include "SimulatedBackend.h"
+#include "WireGuardManager.h"
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QTimer>
+
+namespace {
+
+const int kTimeoutMs = 10000;
+const int kEthernetPayload = 1472;  // 1500 less IPv4 and UDP headers
+const int kPathLimit = 1400;        // Responder limit in the connect checks
+const int kPinnedMtu = 1280;
+const int kQuietMs = 300;           // Long enough for an unwanted probe to show up
+
+// Waits for one specific tunnel command to finish
+bool waitForCommand(WireGuardManager *manager, TunnelWorker::Command command, bool *ok = nullptr) {
+    QEventLoop loop;
+    QObject::connect(manager, &WireGuardManager::tunnelCommandFinished, &loop,
+                     [&loop, command, ok](TunnelWorker::Command finished, bool result) {
+        if (finished != command) return;
+        if (ok) *ok = result;
+        loop.quit();
+    });
+    QTimer::singleShot(kTimeoutMs, &loop, [&loop]() { loop.exit(1); });
+    return loop.exec() == 0;
+}
+
+bool importProfile(WireGuardManager *manager, const QTemporaryDir &dir, const QString &name, quint16 port, int mtu) {
+    QFile config(dir.filePath(name + ".conf"));
+    if (!config.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+    QString text = QString("[Interface]\nPrivateKey = %1\nAddress = 10.200.0.2/32\n").arg(Bench::randomKey());
+    if (mtu) text += QString("MTU = %1\n").arg(mtu);
+    text += QString("\n[Peer]\nPublicKey = %1\nEndpoint = 127.0.0.1:%2\nAllowedIPs = 0.0.0.0/0\n").arg(Bench::randomKey()).arg(port);
+    config.write(text.toUtf8());
+    config.close();
+    manager->importConfig(config.fileName());
+    return Bench::waitFor(manager, &WireGuardManager::importFinished, kTimeoutMs);
+}
+
+void reconnect(WireGuardManager *manager, const QString &profile) {
+    manager->stopTunnel();
+    waitForCommand(manager, TunnelWorker::Stop);
+    manager->closeTunnel();
+    waitForCommand(manager, TunnelWorker::Close);
+    manager->loadProfile(profile);
+    Bench::waitFor(manager, &WireGuardManager::importFinished, kTimeoutMs);
+    manager->startTunnel();
+}
+
+// Connect, reconnect, pinned MTU and a missing responder on a simulated
+// driver. The endpoints are silent stand-ins for WireGuard, which never
+// answers probes; the echo responder sits on its own port
+QJsonObject checkManager() {
+    QJsonObject checks;
+    EchoResponder echo;
+    EchoResponder wireGuard(2);
+    EchoResponder otherWireGuard(3);
+    EchoResponder deaf(4);  // Configured as the echo port but never answers
+    wireGuard.loss = otherWireGuard.loss = deaf.loss = 1.0;
+    echo.maxDatagram = kPathLimit;
+    QTemporaryDir dir;
+    if (!echo.start() || !wireGuard.start() || !otherWireGuard.start() || !deaf.start()) {
+        checks["responders"] = false;
+        return checks;
+    }
+    SimulatedBackend *backend = new SimulatedBackend(SimulatedBackend::parseProfile("create=0,open=0,config=0,state=0"));
+    WireGuardManager manager(backend);
+    QSettings settings(dir.filePath("bench.ini"), QSettings::IniFormat);
+    manager.setSettings(&settings);
+    manager.watchdog()->setInterval(3600 * 1000);
+    manager.profileStore()->setDirectory(dir.filePath("profiles"));
+    manager.profileStore()->load();
+    manager.initialize();
+    if (!dir.isValid() || !importProfile(&manager, dir, "probed", wireGuard.port(), 0)) {
+        checks["import"] = false;
+        return checks;
+    }
+
+    int discoveries = 0;
+    PathMtuProber::Result discovered;
+    QObject::connect(&manager, &WireGuardManager::pathMtuFinished, [&](const PathMtuProber::Result &result) {
+        discoveries++;
+        discovered = result;
+    });
+
+    // No echo port configured: nothing is probed, nothing is reported
+    manager.startTunnel();
+    bool started = false;
+    waitForCommand(&manager, TunnelWorker::Start, &started);
+    Bench::waitFor(&manager, &WireGuardManager::pathMtuFinished, kQuietMs);
+    checks["offByDefault"] = started && discoveries == 0 && echo.received == 0 && wireGuard.received == 0;
+
+    settings.setValue("Mtu/echoPort", echo.port());
+    manager.setSettings(&settings);
+    reconnect(&manager, "probed");
+    const bool probed = Bench::waitFor(&manager, &WireGuardManager::pathMtuFinished, kTimeoutMs);
+    bool setOk = false;
+    const bool applied = probed && waitForCommand(&manager, TunnelWorker::SetMtu, &setOk) && setOk;
+    const int expected = PathMtuProber::tunnelMtu(kPathLimit);
+    checks["discovered"] = probed && discovered.ok && !discovered.cached && discovered.payload == kPathLimit;
+    checks["applied"] = applied && backend->mtu() == expected;
+    checks["endpointNotProbed"] = wireGuard.received == 0;
+
+    // Same network, same endpoint: straight from the cache, before the start
+    reconnect(&manager, "probed");
+    started = false;
+    waitForCommand(&manager, TunnelWorker::Start, &started);
+    QCoreApplication::processEvents();
+    checks["cached"] = started && discoveries == 1 && backend->mtu() == expected;
+
+    // An MTU line wins over discovery and is applied with the adapter
+    manager.stopTunnel();
+    waitForCommand(&manager, TunnelWorker::Stop);
+    const bool imported = importProfile(&manager, dir, "pinned", wireGuard.port(), kPinnedMtu);
+    manager.startTunnel();
+    started = false;
+    waitForCommand(&manager, TunnelWorker::Start, &started);
+    QCoreApplication::processEvents();
+    checks["pinned"] = imported && started && discoveries == 1 && backend->mtu() == kPinnedMtu;
+
+    // A responder that never answers fails once, loudly; the next connect
+    // gets the remembered failure without sending a probe
+    manager.stopTunnel();
+    waitForCommand(&manager, TunnelWorker::Stop);
+    settings.setValue("Mtu/echoPort", deaf.port());
+    manager.setSettings(&settings);
+    const bool silentImported = importProfile(&manager, dir, "silent", otherWireGuard.port(), 0);
+    manager.startTunnel();
+    const bool failed = Bench::waitFor(&manager, &WireGuardManager::pathMtuFinished, kTimeoutMs)
+            && !discovered.ok && !discovered.cached && discovered.probes > 0;
+    const int deafProbes = deaf.received;
+    reconnect(&manager, "silent");
+    const bool remembered = Bench::waitFor(&manager, &WireGuardManager::pathMtuFinished, kTimeoutMs)
+            && !discovered.ok && discovered.cached && discovered.probes == 0;
+    checks["failureRemembered"] = silentImported && failed && remembered && deaf.received == deafProbes
+            && otherWireGuard.received == 0;
+    manager.stopTunnel();
+    waitForCommand(&manager, TunnelWorker::Stop);
+    return checks;
+}
+
+// The client never calls setSettings(); what it stored under its own name
+// has to reach the prober from the constructor alone
+bool defaultSettingsApplied() {
+    QTemporaryDir dir;
+    const QSettings::Format format = QSettings::defaultFormat();
+    QSettings::setDefaultFormat(QSettings::IniFormat);
+    QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, dir.path());
+    {
+        QSettings client(QSettings::IniFormat, QSettings::UserScope, "TPN", "Client");
+        client.setValue("Mtu/echoPort", 7);
+    }
+    bool applied = false;
+    {
+        WireGuardManager manager(new SimulatedBackend(SimulatedBackend::parseProfile("create=0,open=0,config=0,state=0")));
+        applied = manager.pathMtu()->echoPort() == 7;
+    }
+    QSettings::setDefaultFormat(format);
+    return dir.isValid() && applied;
+}
+
+} // namespace
+
+int PathMtuBenchmark::run(const QStringList &arguments) {
+    const QVector<int> limits = Bench::intListOption(arguments, "--bench-mtu", { 1472, 1400, 1280, 600 });
+    Logger::setLevel(LogLevel::Warning);
+
+    SelfTestServer server;
+    if (!server.listen(QHostAddress::LocalHost)) {
+        QTextStream(stderr) << server.errorString() << '\n';
+        return 1;
+    }
+
+    bool allPassed = true;
+    QJsonArray runs;
+    PathMtuProber::Options options;
+    options.target = QHostAddress::LocalHost;
+    options.port = server.port();
+    options.maxPayload = kEthernetPayload;
+    options.timeoutMs = 200;
+    const int minPayload = 576 - 28;
+    for (int limit : qAsConst(limits)) {
+        server.setMaxDatagram(limit);
+        const PathMtuProber::Result result = PathMtuProber::run(options);
+        // Below the IPv4 minimum MTU nothing is found, and that is the answer
+        const bool ok = limit < minPayload ? !result.ok
+                                           : result.ok && result.payload == qMin(limit, kEthernetPayload)
+                                             && result.pathMtu == result.payload + 28
+                                             && result.tunnelMtu == (result.payload - 32) / 16 * 16;
+        allPassed = allPassed && ok;
+        QJsonObject entry;
+        entry["limit"] = limit;
+        entry["payload"] = result.payload;
+        entry["path_mtu"] = result.pathMtu;
+        entry["tunnel_mtu"] = result.tunnelMtu;
+        entry["probes"] = result.probes;
+        entry["ms"] = result.elapsedMs;
+        entry["error"] = result.error;
+        entry["ok"] = ok;
+        runs.append(entry);
+    }
+    server.setMaxDatagram(0);
+
+    QJsonObject checks = checkManager();
+    checks["defaultSettings"] = defaultSettingsApplied();
+    allPassed = allPassed && Bench::allPassed(checks);
+    checks["allPassed"] = allPassed;
+    server.close();
+
+    QJsonObject root;
+    root["runs"] = runs;
+    root["network"] = PathMtuProber::networkId();
+    root["checks"] = checks;
+    return Bench::finish(root, arguments, allPassed, "Path MTU check failed");
+}
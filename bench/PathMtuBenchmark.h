@@ -0,0 +1,24 @@
+#ifndef PATHMTUBENCHMARK_H
+#define PATHMTUBENCHMARK_H
+
+#include <QStringList>
+
+// Path MTU discovery against a loopback SelfTestServer that drops UDP
+// datagrams above each given size: the probe must find exactly that size
+// (capped at the Ethernet payload) and report the probe count and time.
+// A simulated connect then checks that nothing is probed until Mtu/echoPort
+// names a responder (bench/EchoResponder; the endpoint port itself is never
+// probed), that the discovered MTU reaches the adapter, that a reconnect on
+// the same network takes it from the cache without probing, that an MTU
+// line in the profile overrides both, and that a responder that never
+// answers fails once and is not probed again on the next connect. A
+// manager built without setSettings() must still pick up Mtu/echoPort.
+// Exits non-zero if any check fails.
+//
+//   tpn-bench --bench-mtu=1472,1400,1280,600 [--bench-out=mtu.json]
+class PathMtuBenchmark {
+public:
+    static int run(const QStringList &arguments);  // Needs a QCoreApplication
+};
+
+#endif // PATHMTUBENCHMARK_H
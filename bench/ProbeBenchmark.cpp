@@ -0,0 +1,131 @@
+#include "ProbeBenchmark.h"
+#include "BenchUtil.h"
+#include "EchoResponder.h"
+#include "LatencyProber.h"
+#include <QEventLoop>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QTimer>
+#include <memory>
+#include <vector>
+
+namespace {
+
+const int kTimeoutMs = 500;      // Per probe; well above the largest delay
+const int kProbesPerTarget = 3;
+const double kLossTolerance = 0.15;
+
+int delayFor(int index) { return 2 + (index * 37) % 60; }  // 2..61 ms, index 0 fastest
+bool lossyFor(int index) { return index % 4 == 3; }
+
+} // namespace
+
+int ProbeBenchmark::run(const QStringList &arguments) {
+    const int count = Bench::intOption(arguments, "--bench-probe", 200, 1);
+    const double loss = qBound(0.0, Bench::option(arguments, "--bench-loss", "0.3").toDouble(), 0.9);
+    const int rounds = Bench::intOption(arguments, "--bench-rounds", 3, 1);
+
+    std::vector<std::unique_ptr<EchoResponder>> responders;
+    QVector<LatencyProber::Target> targets;
+    QHash<quint16, int> indexByPort;
+    double serialMs = 0;
+    for (int i = 0; i < count; ++i) {
+        responders.emplace_back(new EchoResponder(quint32(i + 1)));
+        EchoResponder *responder = responders.back().get();
+        responder->delayMs = delayFor(i);
+        responder->loss = lossyFor(i) ? loss : 0.0;
+        if (!responder->start()) {
+            QTextStream(stderr) << "Failed to start echo responder " << i << '\n';
+            return 1;
+        }
+        targets.append({ QString("server-%1").arg(i), QHostAddress(QHostAddress::LocalHost), responder->port() });
+        indexByPort.insert(responder->port(), i);
+        serialMs += kProbesPerTarget * delayFor(i);
+    }
+
+    LatencyProber prober;
+    prober.setTimeoutMs(kTimeoutMs);
+    prober.setProbesPerTarget(kProbesPerTarget);
+    QVector<LatencyProber::Result> ranked;
+    QJsonArray roundMs;
+    bool concurrent = true;
+    for (int round = 0; round < rounds; ++round) {
+        QEventLoop loop;
+        qint64 elapsed = -1;
+        QObject::connect(&prober, &LatencyProber::finished, &loop,
+                         [&](const QVector<LatencyProber::Result> &results, qint64 elapsedMs) {
+            ranked = results;
+            elapsed = elapsedMs;
+            loop.quit();
+        });
+        QTimer::singleShot(kTimeoutMs * 20, &loop, &QEventLoop::quit);
+        if (!prober.probe(targets)) {
+            QTextStream(stderr) << "Failed to start a probe round.\n";
+            return 1;
+        }
+        loop.exec();
+        if (elapsed < 0) {
+            QTextStream(stderr) << "Probe round " << round << " did not finish.\n";
+            return 1;
+        }
+        roundMs.append(elapsed);
+        concurrent = concurrent && (count == 1 || elapsed < serialMs / 4);
+    }
+
+    QVector<double> rttErrorMs;
+    double lossySum = 0;
+    double losslessSum = 0;
+    int lossyCount = 0;
+    bool sampled = ranked.size() == count;
+    for (const LatencyProber::Result &result : qAsConst(ranked)) {
+        const int index = indexByPort.value(result.port, -1);
+        sampled = sampled && index >= 0 && result.samples == rounds * kProbesPerTarget;
+        if (index < 0) continue;
+        if (result.loss < 1.0) rttErrorMs.append(qAbs(result.rttMs - delayFor(index)));
+        if (lossyFor(index)) {
+            lossySum += result.loss;
+            lossyCount++;
+        } else {
+            losslessSum += result.loss;
+        }
+    }
+    const double lossyMean = lossyCount ? lossySum / lossyCount : loss;
+    const double losslessMean = count > lossyCount ? losslessSum / (count - lossyCount) : 0.0;
+    const int best = ranked.isEmpty() ? -1 : indexByPort.value(ranked.first().port, -1);
+
+    QJsonArray top;
+    for (int i = 0; i < qMin(5, ranked.size()); ++i) {
+        const int index = indexByPort.value(ranked[i].port, -1);
+        QJsonObject entry;
+        entry["profile"] = ranked[i].profile;
+        entry["delay_ms"] = index >= 0 ? delayFor(index) : -1;
+        entry["rtt_ms"] = ranked[i].rttMs;
+        entry["loss"] = ranked[i].loss;
+        entry["score"] = ranked[i].score;
+        top.append(entry);
+    }
+
+    QJsonObject checks;
+    checks["everyTargetSampled"] = sampled;
+    checks["rttMatchesDelay"] = !rttErrorMs.isEmpty() && unsortedPercentile(rttErrorMs, 50) <= 5.0;
+    checks["lossMatchesDrops"] = losslessMean < 0.05 && (lossyCount == 0 || qAbs(lossyMean - loss) <= kLossTolerance);
+    checks["fastestLosslessFirst"] = best >= 0 && !lossyFor(best) && delayFor(best) <= delayFor(0) + 3;
+    checks["roundsConcurrent"] = concurrent;
+    const bool allPassed = Bench::allPassed(checks);
+    checks["allPassed"] = allPassed;
+
+    QJsonObject report;
+    report["targets"] = count;
+    report["injected_loss"] = loss;
+    report["round_ms"] = roundMs;
+    report["serial_estimate_ms"] = serialMs;
+    report["rtt_error_ms_p50"] = unsortedPercentile(rttErrorMs, 50);
+    report["rtt_error_ms_p99"] = unsortedPercentile(rttErrorMs, 99);
+    report["lossy_loss_mean"] = lossyMean;
+    report["lossless_loss_mean"] = losslessMean;
+    report["top"] = top;
+    report["checks"] = checks;
+    return Bench::finish(report, arguments, allPassed, "Probe check failed");
+}
@@ -0,0 +1,19 @@
+#ifndef PROBEBENCHMARK_H
+#define PROBEBENCHMARK_H
+
+#include <QStringList>
+
+// Latency probing against N loopback echo responders with known delays;
+// every fourth one also drops a share of the probes. Runs a few rounds and
+// checks the ranking against what was injected: measured RTTs close to the
+// delays, loss estimates close to the drop rate, the fastest lossless
+// responder first, and rounds far shorter than probing one by one.
+//
+//   tpn-bench --bench-probe=200 [--bench-loss=0.3] [--bench-rounds=3]
+//             [--bench-out=probe.json]
+class ProbeBenchmark {
+public:
+    static int run(const QStringList &arguments);  // Needs a QCoreApplication
+};
+
+#endif // PROBEBENCHMARK_H
@@ -0,0 +1,157 @@
+#include "ProfileStoreBenchmark.h"
+#include "BenchUtil.h"
+#include "Logger.h"
+#include "ProfileModel.h"
+#include "ProfileStore.h"
+#include <QApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QTreeView>
+
+namespace {
+
+// A few peers with split-tunnel lists, roughly what providers ship
+QByteArray makeConfig(int index, int revision) {
+    QByteArray text = "[Interface]\nPrivateKey = " + Bench::randomKey().toLatin1()
+            + "\nAddress = 10.203." + QByteArray::number(index / 250) + '.' + QByteArray::number(index % 250 + 1)
+            + "/32\nDNS = 10.203.0.1\n";
+    for (int peer = 0; peer < 3; ++peer) {
+        text += "\n[Peer]\nPublicKey = " + Bench::randomKey().toLatin1() + "\nEndpoint = server-"
+                + QByteArray::number(index) + '-' + QByteArray::number(peer) + ".example.net:"
+                + QByteArray::number(51820 + revision) + "\nAllowedIPs = ";
+        for (int i = 0; i < 16; ++i) {
+            if (i) text += ", ";
+            text += QByteArray::number(1 + (index + peer * 16 + i) % 223) + '.' + QByteArray::number(i * 16) + ".0.0/12";
+        }
+        text += "\nPersistentKeepalive = 25\n";
+    }
+    return text;
+}
+
+bool writeFile(const QString &path, const QByteArray &text) {
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly | QIODevice::Truncate) && file.write(text) == text.size();
+}
+
+struct Load {
+    qint64 us = 0;
+    int profiles = 0;
+    int reparsed = 0;
+};
+
+Load loadStore(ProfileStore *store, const QString &directory) {
+    Load load;
+    QElapsedTimer timer;
+    timer.start();
+    store->setDirectory(directory);
+    store->load();
+    load.us = timer.nsecsElapsed() / 1000;
+    load.profiles = store->count();
+    load.reparsed = store->reparsed();
+    return load;
+}
+
+QJsonObject toJson(const Load &load) {
+    QJsonObject entry;
+    entry["ms"] = load.us / 1000.0;
+    entry["profiles"] = load.profiles;
+    entry["reparsed"] = load.reparsed;
+    return entry;
+}
+
+} // namespace
+
+int ProfileStoreBenchmark::run(const QStringList &arguments) {
+    const int count = Bench::intOption(arguments, "--bench-profiles", 1000, 1);
+    const int stale = qMin(count, Bench::intOption(arguments, "--bench-stale", 10));
+    const int runs = Bench::intOption(arguments, "--bench-runs", 5, 1);
+    Logger::setLevel(LogLevel::Warning);
+
+    QTemporaryDir root;
+    const QString directory = QDir(root.path()).filePath("profiles");
+    QDir().mkpath(directory);
+    for (int i = 0; i < count; ++i) {
+        const QString path = QDir(directory).filePath(QString("profile-%1.conf").arg(i, 5, 10, QChar('0')));
+        if (!writeFile(path, makeConfig(i, 0))) {
+            QTextStream(stderr) << "Failed to write " << path << '\n';
+            return 1;
+        }
+    }
+
+    // Cold: nothing cached yet, every file is read, parsed and compiled
+    ProfileStore cold;
+    const Load coldLoad = loadStore(&cold, directory);
+
+    // Warm: a new store each time, as a new process would have
+    QVector<double> warmMs;
+    Load warmLoad;
+    bool warmClean = true;
+    for (int run = 0; run < runs; ++run) {
+        ProfileStore warm;
+        warmLoad = loadStore(&warm, directory);
+        warmMs.append(warmLoad.us / 1000.0);
+        warmClean = warmClean && warmLoad.reparsed == 0 && warmLoad.profiles == count;
+    }
+
+    ProfileStore warm;
+    loadStore(&warm, directory);
+    bool blobsMatch = warm.count() == cold.count();
+    for (int i = 0; blobsMatch && i < count; ++i) {
+        blobsMatch = warm.profile(i).name == cold.profile(i).name && warm.profile(i).blob == cold.profile(i).blob;
+    }
+
+    // Edited files change size (the port gains a digit), so the cheap
+    // size/mtime check catches them without hashing anything
+    for (int i = 0; i < stale; ++i) {
+        const int index = i * count / stale;
+        writeFile(QDir(directory).filePath(QString("profile-%1.conf").arg(index, 5, 10, QChar('0'))), makeConfig(index, 10000));
+    }
+    ProfileStore edited;
+    const Load staleLoad = loadStore(&edited, directory);
+
+    // The Configs tree over the loaded store, at a typical window size
+    ProfileModel model(&edited);
+    QTreeView view;
+    view.setUniformRowHeights(true);
+    view.setRootIsDecorated(false);
+    view.setModel(&model);
+    view.resize(480, 360);
+    QElapsedTimer treeTimer;
+    treeTimer.start();
+    view.show();
+    QApplication::processEvents();
+    const qint64 treeMs = treeTimer.elapsed();
+    const int materialized = model.rowCount();
+
+    QJsonObject checks;
+    checks["coldParsesAll"] = coldLoad.profiles == count && coldLoad.reparsed == count;
+    checks["warmParsesNone"] = warmClean;
+    checks["cachedBlobsMatch"] = blobsMatch;
+    checks["staleOnlyReparsed"] = staleLoad.profiles == count && staleLoad.reparsed == stale;
+    // One fetch batch (100 rows) more than fills the view
+    checks["treeIsLazy"] = materialized > 0 && (materialized < count || count <= 100);
+    const bool allPassed = Bench::allPassed(checks);
+    checks["allPassed"] = allPassed;
+
+    QJsonObject warmEntry = toJson(warmLoad);
+    warmEntry["ms"] = unsortedPercentile(warmMs, 50);
+    warmEntry["ms_max"] = unsortedPercentile(warmMs, 100);
+    warmEntry["runs"] = runs;
+    QJsonObject tree;
+    tree["first_show_ms"] = treeMs;
+    tree["rows_materialized"] = materialized;
+
+    QJsonObject report;
+    report["profiles"] = count;
+    report["cold"] = toJson(coldLoad);
+    report["warm"] = warmEntry;
+    report["stale"] = toJson(staleLoad);
+    report["speedup"] = warmEntry["ms"].toDouble() > 0 ? coldLoad.us / 1000.0 / warmEntry["ms"].toDouble() : 0.0;
+    report["tree"] = tree;
+    report["checks"] = checks;
+    return Bench::finish(report, arguments, allPassed, "Profile store check failed");
+}
@@ -0,0 +1,20 @@
+#ifndef PROFILESTOREBENCHMARK_H
+#define PROFILESTOREBENCHMARK_H
+
+#include <QStringList>
+
+// Profile store startup with N profiles: a cold load (no cache, every file
+// parsed), warm loads (all from the mapped cache) and a load after some
+// files changed. Checks how many profiles each one reparsed, that cached
+// blobs match freshly compiled ones, and that the Configs tree only
+// materializes the rows it shows. Needs a display for the tree; on Linux
+// QT_QPA_PLATFORM=offscreen works.
+//
+//   tpn-bench --bench-profiles=1000 [--bench-stale=10] [--bench-runs=5]
+//             [--bench-out=profiles.json]
+class ProfileStoreBenchmark {
+public:
+    static int run(const QStringList &arguments);  // Needs the themed QApplication
+};
+
+#endif // PROFILESTOREBENCHMARK_H
@@ -0,0 +1,193 @@
+#include "ReconfigureBenchmark.h"
+#include "BenchUtil.h"
+#include "ConnectionState.h"
+#include "Logger.h"
+#include "ProfileStore.h"
+#include "SimulatedBackend.h"
+#include "WireGuardManager.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonObject>
+#include <QSettings>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QTimer>
+
+namespace {
+
+const int kTimeoutMs = 10000;
+const int kSettleMs = 100;  // For stray signals after the last expected one
+
+struct Switch {
+    bool ok = false;
+    int imports = 0;  // importFinished signals seen
+    qint64 ms = 0;
+    int outages = 0;
+    qint64 outageMs = 0;  // Longest
+};
+
+// Same profile every time, so each import after the first is a server switch
+bool writeConfig(const QString &path, const QString &privateKey, const QString &publicKey, int server) {
+    const QByteArray text = "[Interface]\nPrivateKey = " + privateKey.toLatin1() + "\nAddress = 10.202.0.2/32\n\n"
+            "[Peer]\nPublicKey = " + publicKey.toLatin1() + "\nEndpoint = 198.51.100."
+            + QByteArray::number(server % 250 + 1) + ":51820\nAllowedIPs = 0.0.0.0/0\n";
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly | QIODevice::Truncate) && file.write(text) == text.size();
+}
+
+// Runs the event loop until `command` finishes on the primary tunnel
+bool waitForCommand(WireGuardManager *manager, TunnelWorker::Command command, bool *ok) {
+    QEventLoop loop;
+    QObject::connect(manager, &WireGuardManager::tunnelCommandFinished, &loop,
+                     [&](TunnelWorker::Command finished, bool result) {
+        if (finished != command) return;
+        *ok = result;
+        loop.quit();
+    });
+    QTimer::singleShot(kTimeoutMs, &loop, [&loop]() { loop.exit(1); });
+    return loop.exec() == 0;
+}
+
+void sleepEvents(int ms) {
+    QEventLoop loop;
+    QTimer::singleShot(ms, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+// One server switch; `recreate` closes the adapter first, as a reconnect
+// without in-place updates would
+Switch serverSwitch(WireGuardManager *manager, SimulatedBackend *backend, const QString &path, bool recreate) {
+    Switch result;
+    backend->resetOutages();
+    QElapsedTimer timer;
+    timer.start();
+    QEventLoop loop;
+    QObject::connect(manager, &WireGuardManager::importFinished, &loop, [&](const QString &, bool ok, const QString &) {
+        result.ok = ok;
+        result.imports++;
+        loop.quit();
+    });
+    QTimer::singleShot(kTimeoutMs, &loop, &QEventLoop::quit);
+    if (recreate) manager->closeTunnel();
+    manager->importConfig(path);
+    loop.exec();
+    if (recreate && result.ok) {
+        bool started = false;
+        manager->startTunnel();
+        result.ok = waitForCommand(manager, TunnelWorker::Start, &started) && started;
+    }
+    result.ms = timer.elapsed();
+    sleepEvents(kSettleMs);
+    result.outages = backend->outages();
+    result.outageMs = backend->longestOutageMs();
+    return result;
+}
+
+QJsonObject summarize(const QVector<Switch> &switches, bool *ok) {
+    QVector<double> ms;
+    QVector<double> outageMs;
+    int outages = 0;
+    for (const Switch &s : switches) {
+        *ok = *ok && s.ok && s.imports == 1;
+        ms.append(double(s.ms));
+        outageMs.append(double(s.outageMs));
+        outages += s.outages;
+    }
+    QJsonObject entry;
+    entry["switches"] = switches.size();
+    entry["ms_p50"] = unsortedPercentile(ms, 50);
+    entry["ms_p99"] = unsortedPercentile(ms, 99);
+    entry["outages"] = outages;
+    entry["loss_window_ms_p50"] = unsortedPercentile(outageMs, 50);
+    entry["loss_window_ms_max"] = unsortedPercentile(outageMs, 100);
+    return entry;
+}
+
+} // namespace
+
+int ReconfigureBenchmark::run(const QStringList &arguments) {
+    const int count = Bench::intOption(arguments, "--bench-reconfigure", 20, 1);
+    const QString backendSpec = Bench::option(arguments, "--bench-backend");
+    Logger::setLevel(LogLevel::Warning);
+
+    QTemporaryDir dir;
+    const QString path = QDir(dir.path()).filePath("switch.conf");
+    const QString privateKey = Bench::randomKey();
+    const QString publicKey = Bench::randomKey();
+    if (!dir.isValid() || !writeConfig(path, privateKey, publicKey, 0)) {
+        QTextStream(stderr) << "Failed to write benchmark config.\n";
+        return 1;
+    }
+
+    SimulatedBackend *backend = new SimulatedBackend(SimulatedBackend::parseProfile(backendSpec));
+    WireGuardManager manager(backend);
+    QSettings settings(QDir(dir.path()).filePath("bench.ini"), QSettings::IniFormat);
+    manager.setSettings(&settings);
+    manager.profileStore()->setDirectory(QDir(dir.path()).filePath("profiles"));
+    manager.profileStore()->load();
+    manager.initialize();
+
+    // Connected on server 0 first
+    if (!serverSwitch(&manager, backend, path, true).ok) {
+        QTextStream(stderr) << "Failed to connect the benchmark tunnel.\n";
+        return 1;
+    }
+
+    int server = 1;
+    QVector<Switch> inPlace;
+    QVector<Switch> recreated;
+    for (int i = 0; i < count; ++i) {
+        writeConfig(path, privateKey, publicKey, server++);
+        inPlace.append(serverSwitch(&manager, backend, path, false));
+    }
+    for (int i = 0; i < count; ++i) {
+        writeConfig(path, privateKey, publicKey, server++);
+        recreated.append(serverSwitch(&manager, backend, path, true));
+    }
+
+    // A push the driver rejects while up: the adapter is rebuilt and must
+    // come back up, with the import answered once by the rebuild
+    backend->failConfigs(1);
+    writeConfig(path, privateKey, publicKey, server++);
+    bool started = false;
+    bool startSeen = false;
+    const QMetaObject::Connection watch = QObject::connect(&manager, &WireGuardManager::tunnelCommandFinished,
+                                                           [&](TunnelWorker::Command command, bool ok) {
+        if (command != TunnelWorker::Start) return;
+        started = ok;
+        startSeen = true;
+    });
+    const Switch failed = serverSwitch(&manager, backend, path, false);
+    if (!startSeen) waitForCommand(&manager, TunnelWorker::Start, &started);
+    QObject::disconnect(watch);
+    const bool recoveredUp = manager.connection()->state() == ConnectionSnapshot::Connected;
+    // And nothing stale answers the next import
+    writeConfig(path, privateKey, publicKey, server++);
+    const Switch after = serverSwitch(&manager, backend, path, false);
+
+    QJsonObject checks;
+    bool inPlaceOk = true;
+    bool recreatedOk = true;
+    QJsonObject report;
+    report["in_place"] = summarize(inPlace, &inPlaceOk);
+    report["recreate"] = summarize(recreated, &recreatedOk);
+    int inPlaceOutages = 0;
+    for (const Switch &s : qAsConst(inPlace)) inPlaceOutages += s.outages;
+    checks["switchesAnswered"] = inPlaceOk && recreatedOk;
+    checks["inPlaceKeepsTraffic"] = inPlaceOutages == 0;
+    checks["recoveryComesBackUp"] = failed.ok && started && recoveredUp;
+    checks["recoveryAnsweredOnce"] = failed.imports == 1;
+    checks["nextImportAnsweredOnce"] = after.ok && after.imports == 1 && after.outages == 0;
+    const bool allPassed = Bench::allPassed(checks);
+    checks["allPassed"] = allPassed;
+
+    QJsonObject recovery;
+    recovery["ms"] = failed.ms;
+    recovery["loss_window_ms"] = failed.outageMs;
+    report["recovery"] = recovery;
+    report["backend"] = backend->describe();
+    report["checks"] = checks;
+    return Bench::finish(report, arguments, allPassed, "Reconfigure check failed");
+}
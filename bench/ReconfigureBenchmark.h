@@ -0,0 +1,19 @@
+#ifndef RECONFIGUREBENCHMARK_H
+#define RECONFIGUREBENCHMARK_H
+
+#include <QStringList>
+
+// Server switches on a connected tunnel, on a SimulatedBackend: N endpoint
+// changes pushed in place, then N done the old way (close, import, start),
+// reporting each one's packet-loss window, i.e. how long no adapter was up.
+// Then forces a config push to fail while up and checks that the recreated
+// adapter comes back up and the import is answered exactly once.
+//
+//   tpn-bench --bench-reconfigure=20 [--bench-backend=create=40,state=10]
+//             [--bench-out=reconfigure.json]
+class ReconfigureBenchmark {
+public:
+    static int run(const QStringList &arguments);  // Needs a QCoreApplication
+};
+
+#endif // RECONFIGUREBENCHMARK_H
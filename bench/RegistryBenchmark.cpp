@@ -0,0 +1,180 @@
+#include "RegistryBenchmark.h"
+#include "BenchUtil.h"
+#include "ConfigParser.h"
+#include "Logger.h"
+#include "SimulatedBackend.h"
+#include "TunnelRegistry.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QTimer>
+
+namespace {
+
+const int kTimeoutMs = 30000;
+
+TunnelConfig makeConfig(const QString &allowedIPs, int index) {
+    const QByteArray text = QString("[Interface]\nPrivateKey = %1\nAddress = 10.250.%2.2/32\n\n"
+                                    "[Peer]\nPublicKey = %3\nEndpoint = 192.0.2.%4:51820\nAllowedIPs = %5\n")
+            .arg(Bench::randomKey()).arg(index % 256).arg(Bench::randomKey()).arg(1 + index % 254).arg(allowedIPs).toUtf8();
+    TunnelConfig config;
+    ConfigParser parser;
+    parser.parse(text.constData(), text.size(), &config);
+    return config;
+}
+
+// Runs the event loop until `command` has finished on every instance;
+// false on timeout, *failed counts the ones that reported an error
+bool waitForAll(const QVector<TunnelInstance *> &instances, TunnelWorker::Command command, int *failed) {
+    QEventLoop loop;
+    int remaining = instances.size();
+    *failed = 0;
+    for (TunnelInstance *instance : instances) {
+        QObject::connect(instance->worker(), &TunnelWorker::commandFinished, &loop,
+                         [&loop, &remaining, failed, command](TunnelWorker::Command finished, bool ok) {
+            if (finished != command) return;
+            if (!ok) ++*failed;
+            if (--remaining == 0) loop.quit();
+        });
+    }
+    QTimer::singleShot(kTimeoutMs, &loop, [&loop]() { loop.exit(1); });
+    return remaining == 0 || loop.exec() == 0;
+}
+
+struct Run {
+    int tunnels = 0;
+    qint64 upMs = 0;
+    qint64 downMs = 0;
+    int failed = 0;
+    int adaptersUp = 0;
+    int adaptersLeft = 0;
+    bool allUp = false;
+    bool completed = false;
+};
+
+Run runTunnels(const SimulatedBackend::Profile &profile, int count) {
+    Run run;
+    run.tunnels = count;
+    SimulatedBackend backend(profile);
+    TunnelRegistry registry(&backend);
+    QVector<TunnelInstance *> instances;
+    QVector<TunnelConfig> configs;
+    for (int i = 0; i < count; ++i) {
+        instances.append(registry.add());
+        configs.append(makeConfig(QString("10.%1.0.0/16").arg(i + 1), i));
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < count; ++i) {
+        registry.create(instances[i], QString("tunnel-%1").arg(i + 1), configs[i]);
+        instances[i]->worker()->post(TunnelWorker::Start);
+    }
+    int failed = 0;
+    bool ok = waitForAll(instances, TunnelWorker::Start, &failed);
+    run.upMs = timer.elapsed();
+    run.failed += failed;
+    run.adaptersUp = backend.openAdapters();
+    run.allUp = true;
+    for (const TunnelInstance *instance : qAsConst(instances)) run.allUp = run.allUp && instance->state() == TunnelWorker::Up;
+
+    timer.restart();
+    for (TunnelInstance *instance : qAsConst(instances)) {
+        instance->worker()->post(TunnelWorker::Stop);
+        instance->worker()->post(TunnelWorker::Close);
+    }
+    ok = waitForAll(instances, TunnelWorker::Close, &failed) && ok;
+    run.downMs = timer.elapsed();
+    run.failed += failed;
+    run.adaptersLeft = backend.openAdapters();
+    run.completed = ok;
+    return run;
+}
+
+// Partial overlaps are reported, exact ones and reused names refused
+QJsonObject checkOverlaps() {
+    QJsonObject checks;
+    SimulatedBackend backend(SimulatedBackend::parseProfile("create=0,open=0,config=0,state=0"));
+    TunnelRegistry registry(&backend);
+    int reported = 0;
+    bool partial = false;
+    QObject::connect(&registry, &TunnelRegistry::overlapDetected,
+                     [&](const QString &, const QVector<TunnelRegistry::Overlap> &overlaps) {
+        reported++;
+        partial = overlaps.size() == 1 && !overlaps[0].exact && overlaps[0].tunnel == "corp";
+    });
+
+    QString error;
+    const bool corp = registry.create(registry.add(), "corp", makeConfig("10.1.0.0/16, 172.16.0.0/12", 0), QUuid(), &error);
+    const bool lab = registry.create(registry.add(), "lab", makeConfig("10.1.2.0/24", 1), QUuid(), &error);
+    checks["partial_reported"] = corp && lab && reported == 1 && partial;
+
+    TunnelInstance *duplicate = registry.add();
+    error.clear();
+    const bool exact = registry.create(duplicate, "exit", makeConfig("172.16.0.0/12", 2), QUuid(), &error);
+    checks["exact_refused"] = !exact && !error.isEmpty() && duplicate->name().isEmpty() && reported == 1;
+
+    error.clear();
+    const bool clash = registry.create(duplicate, "lab", makeConfig("10.9.0.0/16", 3), QUuid(), &error);
+    checks["name_refused"] = !clash && !error.isEmpty();
+
+    const bool disjoint = registry.create(duplicate, "exit", makeConfig("192.168.0.0/16", 4), QUuid(), &error);
+    checks["disjoint_accepted"] = disjoint && reported == 1;
+    return checks;
+}
+
+} // namespace
+
+int RegistryBenchmark::run(const QStringList &arguments) {
+    QVector<int> counts = Bench::intListOption(arguments, "--bench-tunnels", { 1, 2, 4, 8, 16 });
+    for (int &count : counts) count = qMin(count, 64);
+    const QString backendSpec = Bench::option(arguments, "--bench-backend");
+    bool profileOk = false;
+    const SimulatedBackend::Profile profile = SimulatedBackend::parseProfile(backendSpec, &profileOk);
+    if (!profileOk) {
+        QTextStream(stderr) << "Invalid backend profile: " << backendSpec << '\n';
+        return 1;
+    }
+    Logger::setLevel(LogLevel::Warning);
+
+    // One tunnel on its own is the serial cost every run is compared with
+    const Run single = runTunnels(profile, 1);
+    bool allPassed = single.completed && !single.failed;
+    QJsonArray runs;
+    for (int count : qAsConst(counts)) {
+        const Run result = runTunnels(profile, count);
+        const qint64 serialUp = single.upMs * count;
+        const qint64 serialDown = single.downMs * count;
+        const bool ok = result.completed && !result.failed && result.allUp
+                && result.adaptersUp == count && result.adaptersLeft == 0;
+        allPassed = allPassed && ok;
+        QJsonObject entry;
+        entry["tunnels"] = count;
+        entry["up_ms"] = result.upMs;
+        entry["down_ms"] = result.downMs;
+        entry["serial_up_ms"] = serialUp;
+        entry["serial_down_ms"] = serialDown;
+        entry["up_speedup"] = result.upMs > 0 ? double(serialUp) / result.upMs : 0.0;
+        entry["down_speedup"] = result.downMs > 0 ? double(serialDown) / result.downMs : 0.0;
+        entry["adapters_up"] = result.adaptersUp;
+        entry["adapters_left"] = result.adaptersLeft;
+        entry["failed"] = result.failed;
+        entry["ok"] = ok;
+        runs.append(entry);
+    }
+
+    QJsonObject checks = checkOverlaps();
+    allPassed = allPassed && Bench::allPassed(checks);
+    checks["allPassed"] = allPassed;
+
+    QJsonObject root;
+    root["backend"] = SimulatedBackend(profile).describe();
+    root["single_up_ms"] = single.upMs;
+    root["single_down_ms"] = single.downMs;
+    root["runs"] = runs;
+    root["checks"] = checks;
+    return Bench::finish(root, arguments, allPassed, "Tunnel registry check failed");
+}
@@ -0,0 +1,21 @@
+#ifndef REGISTRYBENCHMARK_H
+#define REGISTRYBENCHMARK_H
+
+#include <QStringList>
+
+// Brings 1..N tunnels up at once through a TunnelRegistry on the simulated
+// driver (default latencies unless --bench-backend is given), then stops
+// and closes them all at once, and reports both times against N times the
+// single-tunnel cost. Every instance must reach Up on its own adapter and
+// every adapter must be gone afterwards; the AllowedIPs checks cover a
+// partial overlap (reported), an exact one and a name clash (refused).
+// Exits non-zero if any check fails.
+//
+//   tpn-bench --bench-tunnels=1,2,4,8,16 [--bench-backend=create=40,state=10]
+//             [--bench-out=tunnels.json]
+class RegistryBenchmark {
+public:
+    static int run(const QStringList &arguments);  // Needs a QCoreApplication
+};
+
+#endif // REGISTRYBENCHMARK_H
@@ -0,0 +1,193 @@
+#include "ResolverBenchmark.h"
+#include "BenchUtil.h"
+#include "DnsMessage.h"
+#include "EndpointResolver.h"
+#include "Logger.h"
+#include "ProfileStore.h"
+#include "SimulatedBackend.h"
+#include "StubDnsServer.h"
+#include "WireGuardManager.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QSettings>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QTimer>
+
+namespace {
+
+const int kTimeoutMs = 30000;
+
+// Every third host also has an AAAA record, so both families are exercised
+QList<QByteArray> makeHosts(const QByteArray &run, int count) {
+    QList<QByteArray> hosts;
+    for (int i = 0; i < count; ++i) {
+        hosts.append((i % 3 == 0 ? "v6-" : "e-") + run + '-' + QByteArray::number(i) + ".bench.test");
+    }
+    return hosts;
+}
+
+// IPv6 wins when the server has it, as in happy eyeballs
+bool resolvedAsExpected(const QList<QByteArray> &hosts, const ResolvedHosts &results) {
+    for (const QByteArray &host : hosts) {
+        const QHostAddress v6 = StubDnsServer::addressFor(host, DnsRecord::AAAA);
+        const QHostAddress expected = v6.isNull() ? StubDnsServer::addressFor(host, DnsRecord::A) : v6;
+        if (results.value(host) != expected) return false;
+    }
+    return true;
+}
+
+struct Pass {
+    bool done = false;
+    bool correct = false;
+    int resolved = 0;
+    int queries = 0;  // Seen by the server
+    qint64 ms = 0;
+};
+
+Pass resolveDirect(EndpointResolver *resolver, StubDnsServer *server, const QList<QByteArray> &hosts) {
+    Pass pass;
+    const int before = server->total;
+    QEventLoop loop;
+    int requestId = 0;
+    QObject::connect(resolver, &EndpointResolver::finished, &loop,
+                     [&](int id, const ResolvedHosts &results, qint64 elapsedMs) {
+        if (id != requestId) return;
+        pass.done = true;
+        pass.resolved = results.size();
+        pass.correct = resolvedAsExpected(hosts, results);
+        pass.ms = elapsedMs;
+        loop.quit();
+    });
+    QTimer::singleShot(kTimeoutMs, &loop, &QEventLoop::quit);
+    requestId = resolver->resolve(hosts);
+    loop.exec();
+    pass.queries = server->total - before;
+    return pass;
+}
+
+bool writeConfig(const QString &path, const QList<QByteArray> &hosts) {
+    QByteArray text = "[Interface]\nPrivateKey = " + Bench::randomKey().toLatin1() + "\nAddress = 10.201.0.2/32\n";
+    for (int i = 0; i < hosts.size(); ++i) {
+        text += "\n[Peer]\nPublicKey = " + Bench::randomKey().toLatin1()
+                + "\nEndpoint = " + hosts[i] + ":51820\nAllowedIPs = 10." + QByteArray::number(100 + i / 250)
+                + '.' + QByteArray::number(i % 250) + ".0/24\n";
+    }
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly | QIODevice::Truncate) && file.write(text) == text.size();
+}
+
+// importConfig() through to importFinished, with the resolver's answer for
+// the import captured on the way
+Pass importThrough(WireGuardManager *manager, StubDnsServer *server, const QString &path,
+                   const QList<QByteArray> &hosts) {
+    Pass pass;
+    const int before = server->total;
+    ResolvedHosts results;
+    QEventLoop loop;
+    QObject::connect(manager->resolver(), &EndpointResolver::finished, &loop,
+                     [&](int, const ResolvedHosts &answer, qint64) { results = answer; });
+    QObject::connect(manager, &WireGuardManager::importFinished, &loop, [&](const QString &, bool ok, const QString &) {
+        pass.done = ok;
+        loop.quit();
+    });
+    QTimer::singleShot(kTimeoutMs, &loop, &QEventLoop::quit);
+    QElapsedTimer timer;
+    timer.start();
+    manager->importConfig(path);
+    loop.exec();
+    pass.ms = timer.elapsed();
+    pass.resolved = results.size();
+    pass.correct = pass.done && resolvedAsExpected(hosts, results);
+    pass.queries = server->total - before;
+    return pass;
+}
+
+QJsonObject toJson(const Pass &pass) {
+    QJsonObject entry;
+    entry["ms"] = pass.ms;
+    entry["resolved"] = pass.resolved;
+    entry["queries"] = pass.queries;
+    entry["correct"] = pass.correct;
+    return entry;
+}
+
+} // namespace
+
+int ResolverBenchmark::run(const QStringList &arguments) {
+    const QVector<int> counts = Bench::intListOption(arguments, "--bench-resolver", {1, 500});
+    const int delayMs = Bench::intOption(arguments, "--bench-delay", 20);
+    Logger::setLevel(LogLevel::Warning);
+
+    StubDnsServer server;
+    server.delayMs = delayMs;
+    QTemporaryDir dir;
+    if (!server.start() || !dir.isValid()) {
+        QTextStream(stderr) << "Failed to set up the stub DNS server.\n";
+        return 1;
+    }
+
+    QSettings settings(QDir(dir.path()).filePath("bench.ini"), QSettings::IniFormat);
+    settings.setValue("Dns/endpointServer", QHostAddress(QHostAddress::LocalHost).toString());
+    settings.setValue("Dns/endpointServerPort", server.port());
+    WireGuardManager manager(new SimulatedBackend(SimulatedBackend::parseProfile("create=0,open=0,config=0,state=0")));
+    manager.setSettings(&settings);
+    manager.profileStore()->setDirectory(QDir(dir.path()).filePath("profiles"));
+    manager.profileStore()->load();
+    manager.initialize();
+
+    EndpointResolver resolver;
+    resolver.setNameServer(QHostAddress::LocalHost, server.port());
+
+    QJsonArray runs;
+    bool correct = true;
+    bool warmSilent = true;
+    bool overlapped = true;
+    for (int count : counts) {
+        // Fresh names per run, so the cold passes really are cold
+        const QList<QByteArray> direct = makeHosts("d" + QByteArray::number(count), count);
+        const QList<QByteArray> imported = makeHosts("m" + QByteArray::number(count), count);
+        const QString configPath = QDir(dir.path()).filePath(QString("endpoints-%1.conf").arg(count));
+        if (!writeConfig(configPath, imported)) {
+            QTextStream(stderr) << "Failed to write " << configPath << '\n';
+            return 1;
+        }
+
+        const Pass directCold = resolveDirect(&resolver, &server, direct);
+        const Pass directWarm = resolveDirect(&resolver, &server, direct);
+        const Pass importCold = importThrough(&manager, &server, configPath, imported);
+        const Pass importWarm = importThrough(&manager, &server, configPath, imported);
+
+        // Two queries per host, each waiting out the server's delay
+        const qint64 serialMs = qint64(count) * 2 * delayMs;
+        correct = correct && directCold.correct && directWarm.correct && importCold.correct && importWarm.correct;
+        warmSilent = warmSilent && directWarm.queries == 0 && importWarm.queries == 0;
+        if (count > 1) overlapped = overlapped && directCold.ms < serialMs / 2 && importCold.ms < serialMs / 2;
+
+        QJsonObject entry;
+        entry["endpoints"] = count;
+        entry["serial_estimate_ms"] = serialMs;
+        entry["direct_cold"] = toJson(directCold);
+        entry["direct_warm"] = toJson(directWarm);
+        entry["import_cold"] = toJson(importCold);
+        entry["import_warm"] = toJson(importWarm);
+        runs.append(entry);
+    }
+
+    QJsonObject checks;
+    checks["answersCorrect"] = correct;
+    checks["warmSkipsDns"] = warmSilent;
+    checks["lookupsOverlap"] = overlapped;
+    const bool allPassed = Bench::allPassed(checks);
+    checks["allPassed"] = allPassed;
+
+    QJsonObject report;
+    report["delay_ms"] = delayMs;
+    report["runs"] = runs;
+    report["checks"] = checks;
+    return Bench::finish(report, arguments, allPassed, "Resolver check failed");
+}
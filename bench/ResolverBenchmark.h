@@ -0,0 +1,19 @@
+#ifndef RESOLVERBENCHMARK_H
+#define RESOLVERBENCHMARK_H
+
+#include <QStringList>
+
+// Endpoint resolution against a loopback stub DNS server answering after
+// a fixed delay. For each endpoint count it resolves that many unique
+// hostnames directly and through a full profile import, cold and then
+// warm, and compares the cold time with doing the lookups one by one.
+// Checks every answer, that the warm pass asks the server nothing and
+// that lookups overlap.
+//
+//   tpn-bench --bench-resolver=1,500 [--bench-delay=20] [--bench-out=resolver.json]
+class ResolverBenchmark {
+public:
+    static int run(const QStringList &arguments);  // Needs a QCoreApplication
+};
+
+#endif // RESOLVERBENCHMARK_H
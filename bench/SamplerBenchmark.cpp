@@ -0,0 +1,154 @@
+#include "SamplerBenchmark.h"
+#include "BenchUtil.h"
+#include "Logger.h"
+#include "ProfileStore.h"
+#include "SimulatedBackend.h"
+#include "WireGuardManager.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonObject>
+#include <QSettings>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QTimer>
+#include <ctime>
+
+namespace {
+
+const int kTimeoutMs = 10000;
+// Counters and sample times are both whole milliseconds, so one interval's
+// rate can be off by about 2 ms / interval; the window average far less
+const double kRateTolerance = 0.05;
+const double kAverageTolerance = 0.01;
+
+double relativeError(double measured, double expected) {
+    return expected > 0 ? qAbs(measured - expected) / expected : 0.0;
+}
+
+bool connectTunnel(WireGuardManager *manager, const QString &path) {
+    bool ok = false;
+    {
+        QEventLoop loop;
+        QObject::connect(manager, &WireGuardManager::importFinished, &loop, [&](const QString &, bool result) {
+            ok = result;
+            loop.quit();
+        });
+        QTimer::singleShot(kTimeoutMs, &loop, &QEventLoop::quit);
+        manager->importConfig(path);
+        loop.exec();
+    }
+    if (!ok) return false;
+    ok = false;
+    QEventLoop loop;
+    QObject::connect(manager, &WireGuardManager::tunnelCommandFinished, &loop, [&](TunnelWorker::Command command, bool result) {
+        if (command != TunnelWorker::Start) return;
+        ok = result;
+        loop.quit();
+    });
+    QTimer::singleShot(kTimeoutMs, &loop, &QEventLoop::quit);
+    manager->startTunnel();
+    loop.exec();
+    return ok;
+}
+
+} // namespace
+
+int SamplerBenchmark::run(const QStringList &arguments) {
+    const int durationMs = Bench::intOption(arguments, "--bench-sampler", 5000, 500);
+    const int intervalMs = Bench::intOption(arguments, "--bench-interval", 50, 10);
+    SimulatedBackend::Profile profile = SimulatedBackend::parseProfile("create=0,open=0,config=0,state=0");
+    profile.rxRate = Bench::intOption(arguments, "--bench-rx", 1250000, 1);
+    profile.txRate = Bench::intOption(arguments, "--bench-tx", 250000, 1);
+    Logger::setLevel(LogLevel::Warning);
+
+    QTemporaryDir dir;
+    const QString path = QDir(dir.path()).filePath("sampler.conf");
+    const QByteArray text = "[Interface]\nPrivateKey = " + Bench::randomKey().toLatin1()
+            + "\nAddress = 10.204.0.2/32\n\n[Peer]\nPublicKey = " + Bench::randomKey().toLatin1()
+            + "\nEndpoint = 198.51.100.9:51820\nAllowedIPs = 0.0.0.0/0\n";
+    QFile file(path);
+    if (!dir.isValid() || !file.open(QIODevice::WriteOnly) || file.write(text) != text.size()) {
+        QTextStream(stderr) << "Failed to write benchmark config.\n";
+        return 1;
+    }
+    file.close();
+
+    WireGuardManager manager(new SimulatedBackend(profile));
+    QSettings settings(QDir(dir.path()).filePath("bench.ini"), QSettings::IniFormat);
+    manager.setSettings(&settings);
+    manager.profileStore()->setDirectory(QDir(dir.path()).filePath("profiles"));
+    manager.profileStore()->load();
+    manager.initialize();
+    manager.setStatsInterval(intervalMs);
+
+    QVector<TrafficStats> samples;
+    samples.reserve(durationMs / intervalMs + 16);
+    QObject::connect(&manager, &WireGuardManager::statsUpdated, &manager, [&samples](const TrafficStats &stats) {
+        if (stats.peers) samples.append(stats);
+    });
+    if (!connectTunnel(&manager, path)) {
+        QTextStream(stderr) << "Failed to connect the benchmark tunnel.\n";
+        return 1;
+    }
+
+    QElapsedTimer wall;
+    wall.start();
+    const std::clock_t cpuStart = std::clock();
+    {
+        QEventLoop loop;
+        QTimer::singleShot(durationMs, &loop, &QEventLoop::quit);
+        loop.exec();
+    }
+    const double cpuMs = double(std::clock() - cpuStart) * 1000.0 / CLOCKS_PER_SEC;
+    const qint64 wallMs = wall.elapsed();
+
+    // The first sample has no rate; the average needs a few intervals
+    QVector<double> costUs;
+    QVector<double> rxError;
+    QVector<double> txError;
+    QVector<double> averageError;
+    bool handshakes = !samples.isEmpty();
+    bool monotonic = true;
+    for (int i = 0; i < samples.size(); ++i) {
+        const TrafficStats &stats = samples[i];
+        costUs.append(stats.sampleCostNs / 1000.0);
+        handshakes = handshakes && stats.lastHandshakeMs > 0;
+        if (i > 0) {
+            monotonic = monotonic && stats.rxBytes >= samples[i - 1].rxBytes && stats.txBytes >= samples[i - 1].txBytes;
+            rxError.append(relativeError(stats.rxRate, double(profile.rxRate)));
+            txError.append(relativeError(stats.txRate, double(profile.txRate)));
+        }
+        if (i >= 10) {
+            averageError.append(qMax(relativeError(stats.rxAverage, double(profile.rxRate)),
+                                     relativeError(stats.txAverage, double(profile.txRate))));
+        }
+    }
+    const int expectedSamples = durationMs / intervalMs;
+
+    QJsonObject checks;
+    checks["sampledAtInterval"] = samples.size() >= expectedSamples * 8 / 10;
+    checks["countersMonotonic"] = monotonic;
+    checks["handshakeReported"] = handshakes;
+    checks["rateAccurate"] = !rxError.isEmpty() && unsortedPercentile(rxError, 50) <= kRateTolerance
+            && unsortedPercentile(txError, 50) <= kRateTolerance;
+    checks["averageAccurate"] = !averageError.isEmpty() && unsortedPercentile(averageError, 50) <= kAverageTolerance;
+    const bool allPassed = Bench::allPassed(checks);
+    checks["allPassed"] = allPassed;
+
+    QJsonObject report;
+    report["interval_ms"] = intervalMs;
+    report["samples"] = samples.size();
+    report["expected_samples"] = expectedSamples;
+    report["sample_cost_us_p50"] = unsortedPercentile(costUs, 50);
+    report["sample_cost_us_p99"] = unsortedPercentile(costUs, 99);
+    report["cpu_ms"] = cpuMs;
+    report["cpu_percent"] = wallMs ? cpuMs * 100.0 / wallMs : 0.0;
+    report["rate_error_p50"] = unsortedPercentile(rxError, 50);
+    report["rate_error_p99"] = unsortedPercentile(rxError, 99);
+    report["average_error_p50"] = unsortedPercentile(averageError, 50);
+    report["average_error_max"] = unsortedPercentile(averageError, 100);
+    report["checks"] = checks;
+    return Bench::finish(report, arguments, allPassed, "Sampler check failed");
+}
@@ -0,0 +1,18 @@
+#ifndef SAMPLERBENCHMARK_H
+#define SAMPLERBENCHMARK_H
+
+#include <QStringList>
+
+// Traffic sampler cost and accuracy: connects a tunnel on a SimulatedBackend
+// whose counters grow at exactly the given rates, samples for the given
+// time and compares every reported rate and total with the synthetic one.
+// Reports per-sample cost and the process CPU time spent while sampling.
+//
+//   tpn-bench --bench-sampler=5000 [--bench-interval=50] [--bench-rx=1250000]
+//             [--bench-tx=250000] [--bench-out=sampler.json]
+class SamplerBenchmark {
+public:
+    static int run(const QStringList &arguments);  // Needs a QCoreApplication
+};
+
+#endif // SAMPLERBENCHMARK_H
@@ -0,0 +1,133 @@
+#include "SelfTestBenchmark.h"
+#include "BenchUtil.h"
+#include "Logger.h"
+#include "SelfTest.h"
+#include "SelfTestServer.h"
+#include "SimulatedBackend.h"
+#include "WireGuardManager.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QTimer>
+
+namespace {
+
+const int kTimeoutMs = 30000;
+const int kCancelAfterMs = 300;
+const int kCancelLimitMs = 3000;  // A cancelled run must be back within this
+
+QJsonObject toJson(const SelfTest::Result &result) {
+    return QJsonObject::fromVariantMap(result.toVariantMap());
+}
+
+bool isSane(const SelfTest::Result &result, int pings) {
+    return result.ok && result.pingsSent == pings && result.pingsReceived == pings
+            && result.rttMinMs > 0 && result.rttMinMs <= result.rttP50Ms && result.rttP50Ms <= result.rttP99Ms
+            && result.jitterMs >= 0 && result.tcpDownMbps > 0 && result.tcpUpMbps > 0
+            && result.udpMbps > 0 && result.udpLoss >= 0 && result.udpLoss < 1;
+}
+
+// Cancelling mid-phase must not wait out the phase
+bool checkCancel(const SelfTest::Options &base, qint64 *elapsedMs) {
+    SelfTest test;
+    SelfTest::Options options = base;
+    options.durationMs = 20000;
+    options.pings = 1;
+    QElapsedTimer clock;
+    clock.start();
+    if (!test.start(options)) return false;
+    QTimer::singleShot(kCancelAfterMs, &test, [&test]() { test.cancel(); });
+    const bool finished = Bench::waitFor(&test, &SelfTest::finished, kCancelLimitMs + kCancelAfterMs);
+    *elapsedMs = clock.elapsed();
+    return finished && !test.isRunning();
+}
+
+// Connect on a simulated driver: the test runs by itself and lands on the profile
+bool checkManager(quint16 port, SelfTest::Result *stored) {
+    QTemporaryDir dir;
+    SimulatedBackend *backend = new SimulatedBackend(SimulatedBackend::parseProfile("create=0,open=0,config=0,state=0"));
+    WireGuardManager manager(backend);
+    QSettings settings(dir.filePath("bench.ini"), QSettings::IniFormat);
+    manager.setSettings(&settings);
+    manager.setSelfTestEndpoint("127.0.0.1:" + QString::number(port));
+    manager.profileStore()->setDirectory(dir.filePath("profiles"));
+    manager.profileStore()->load();
+    manager.initialize();
+
+    QFile config(dir.filePath("bench.conf"));
+    if (!dir.isValid() || !config.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+    config.write(QString("[Interface]\nPrivateKey = %1\nAddress = 10.200.0.2/32\n\n[Peer]\nPublicKey = %2\n"
+                         "Endpoint = 192.0.2.1:51820\nAllowedIPs = 0.0.0.0/0\n").arg(Bench::randomKey(), Bench::randomKey()).toUtf8());
+    config.close();
+    manager.importConfig(config.fileName());
+    if (!Bench::waitFor(&manager, &WireGuardManager::importFinished, kTimeoutMs)) return false;
+
+    manager.startTunnel();
+    if (!Bench::waitFor(&manager, &WireGuardManager::selfTestFinished, kTimeoutMs)) return false;
+    *stored = manager.lastSelfTest(manager.tunnelName());
+    manager.stopTunnel();
+    Bench::waitFor(&manager, &WireGuardManager::tunnelCommandFinished, kTimeoutMs);
+    return stored->ok && stored->finishedMs > 0;
+}
+
+} // namespace
+
+int SelfTestBenchmark::run(const QStringList &arguments) {
+    const QVector<int> streamCounts = Bench::intListOption(arguments, "--bench-selftest", { 1, 4 });
+    const int durationMs = Bench::intOption(arguments, "--bench-duration", 1000, 100);
+    Logger::setLevel(LogLevel::Warning);
+
+    SelfTestServer server;
+    if (!server.listen(QHostAddress::LocalHost)) {
+        QTextStream(stderr) << server.errorString() << '\n';
+        return 1;
+    }
+
+    SelfTest::Options options;
+    options.host = "127.0.0.1";
+    options.port = server.port();
+    options.pings = 100;
+    options.pingIntervalMs = 1;
+    options.durationMs = durationMs;
+
+    bool allPassed = true;
+    QJsonArray runs;
+    for (int streams : qAsConst(streamCounts)) {
+        options.streams = streams;
+        QElapsedTimer clock;
+        clock.start();
+        const SelfTest::Result result = SelfTest::run(options);
+        QJsonObject entry = toJson(result);
+        entry["wall_ms"] = clock.elapsed();
+        entry["sane"] = isSane(result, options.pings);
+        allPassed = allPassed && isSane(result, options.pings);
+        runs.append(entry);
+    }
+
+    QJsonObject checks;
+    qint64 cancelMs = 0;
+    checks["cancel"] = checkCancel(options, &cancelMs);
+    SelfTest::Result stored;
+    checks["after_start"] = checkManager(server.port(), &stored);
+    // Nothing listening: fails with a message instead of hanging
+    SelfTest::Options closed = options;
+    closed.port = 1;
+    closed.pings = 3;
+    const SelfTest::Result unreachable = SelfTest::run(closed);
+    checks["unreachable"] = !unreachable.ok && !unreachable.error.isEmpty();
+    allPassed = allPassed && Bench::allPassed(checks);
+    checks["allPassed"] = allPassed;
+
+    QJsonObject root;
+    root["runs"] = runs;
+    root["duration_ms"] = durationMs;
+    root["cancel_ms"] = cancelMs;
+    root["stored"] = toJson(stored);
+    root["checks"] = checks;
+    server.close();
+    return Bench::finish(root, arguments, allPassed, "Self-test check failed");
+}
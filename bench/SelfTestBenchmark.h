@@ -0,0 +1,19 @@
+#ifndef SELFTESTBENCHMARK_H
+#define SELFTESTBENCHMARK_H
+
+#include <QStringList>
+
+// Self-test against the bundled SelfTestServer on loopback: runs the full
+// RTT and throughput test for each stream count, checks the numbers are
+// sane (every echo answered, p50 <= p99, data moved in all three phases),
+// that cancelling a long run returns promptly, and that a simulated
+// tunnel start runs the test and stores the result with the profile.
+// Exits non-zero if any check fails.
+//
+//   tpn-bench --bench-selftest=1,4 [--bench-duration=1000] [--bench-out=selftest.json]
+class SelfTestBenchmark {
+public:
+    static int run(const QStringList &arguments);  // Needs a QCoreApplication
+};
+
+#endif // SELFTESTBENCHMARK_H
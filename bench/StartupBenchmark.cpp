@@ -0,0 +1,77 @@
+#include "StartupBenchmark.h"
+#include "BenchUtil.h"
+#include "SimulatedBackend.h"
+#include "mainwindow.h"
+#include <QApplication>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QTimer>
+#include <QVector>
+
+namespace {
+const int kTimeoutMs = 60000;
+const int kMaxFirstPaintMs = 1000;
+}
+
+int StartupBenchmark::run(const QStringList &arguments) {
+    const QString backendSpec = Bench::option(arguments, "--bench-backend", "load=1500");
+    const int maxFirstPaintMs = Bench::intOption(arguments, "--bench-max-paint-ms", kMaxFirstPaintMs, 1);
+    bool ok = false;
+    const SimulatedBackend::Profile profile = SimulatedBackend::parseProfile(backendSpec, &ok);
+    if (!ok) {
+        QTextStream(stderr) << "Bad --bench-backend spec: " << backendSpec << '\n';
+        return 2;
+    }
+
+    MainWindow window(new SimulatedBackend(profile));
+    StartupSequence *startup = window.startup();
+    QVector<StartupSequence::Phase> order;  // As the phases finished
+    QObject::connect(startup, &StartupSequence::phaseFinished, qApp,
+                     [&order](StartupSequence::Phase phase) { order.append(phase); });
+    QObject::connect(startup, &StartupSequence::ready, qApp, []() {
+        QTimer::singleShot(0, qApp, &QCoreApplication::quit);  // Let a pending first paint land
+    });
+    QTimer::singleShot(kTimeoutMs, qApp, &QCoreApplication::quit);
+    window.show();
+    qApp->exec();
+
+    if (!startup->isReady() || startup->firstPaintMs() < 0) {
+        QTextStream(stderr) << "Startup did not finish within " << kTimeoutMs << " ms\n";
+        return 1;
+    }
+
+    QJsonObject phases;
+    QStringList finishOrder;
+    for (StartupSequence::Phase phase : qAsConst(order)) finishOrder.append(StartupSequence::phaseName(phase));
+    for (int phase = 0; phase < StartupSequence::PhaseCount; ++phase) {
+        QJsonObject entry;
+        entry["ms"] = startup->phaseMs(StartupSequence::Phase(phase));
+        entry["ok"] = startup->succeeded(StartupSequence::Phase(phase));
+        phases[StartupSequence::phaseName(StartupSequence::Phase(phase))] = entry;
+    }
+    // What first paint cost when the constructor loaded the driver and the
+    // store before the window could be shown
+    const qint64 blockingEstimate = startup->firstPaintMs()
+            + startup->phaseMs(StartupSequence::Driver) + startup->phaseMs(StartupSequence::Profiles);
+
+    QJsonObject root;
+    root["backend"] = backendSpec;
+    root["first_paint_ms"] = startup->firstPaintMs();
+    root["ready_ms"] = startup->readyMs();
+    root["blocking_first_paint_estimate_ms"] = blockingEstimate;
+    root["phases"] = phases;
+    root["finish_order"] = QJsonArray::fromStringList(finishOrder);
+    root["max_first_paint_ms"] = maxFirstPaintMs;
+
+    // The window must not wait for the (slow) driver load to paint
+    const int windowAt = order.indexOf(StartupSequence::Window);
+    const int driverAt = order.indexOf(StartupSequence::Driver);
+    QJsonObject checks;
+    checks["windowBeforeDriver"] = windowAt >= 0 && driverAt >= 0 && windowAt < driverAt;
+    checks["firstPaintInTime"] = startup->firstPaintMs() <= maxFirstPaintMs;
+    const bool allPassed = Bench::allPassed(checks);
+    checks["allPassed"] = allPassed;
+    root["checks"] = checks;
+    return Bench::finish(root, arguments, allPassed, "Startup check failed");
+}
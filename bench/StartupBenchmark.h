@@ -0,0 +1,21 @@
+#ifndef STARTUPBENCHMARK_H
+#define STARTUPBENCHMARK_H
+
+#include <QStringList>
+
+// Time to first paint and time to ready of the real main window over a
+// SimulatedBackend whose load() is slow, the way a cold wireguard.dll load
+// is. Runs once per process so both are measured from process start;
+// reports them with the per-phase timings as JSON. The window has to paint
+// before the driver load finishes, and within --bench-max-paint-ms of
+// process start, or the run exits non-zero. Needs a display; on Linux
+// QT_QPA_PLATFORM=offscreen works.
+//
+//   tpn-bench --bench-startup [--bench-backend=load=1500] [--bench-max-paint-ms=1000]
+//             [--bench-out=startup.json]
+class StartupBenchmark {
+public:
+    static int run(const QStringList &arguments);  // Needs the themed QApplication
+};
+
+#endif // STARTUPBENCHMARK_H
@@ -0,0 +1,199 @@
+#include "StatusBenchmark.h"
+#include "BenchUtil.h"
+#include "SimulatedBackend.h"
+#include "Logger.h"
+#include "WireGuardManager.h"
+#include <QCoreApplication>
+#include <QDeadlineTimer>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include <memory>
+#include <vector>
+
+namespace {
+
+const int kTimeoutMs = 10000;
+const int kBurst = 1000;  // Synchronous updates in the coalescing check
+
+bool runCycles(WireGuardManager *manager, int cycles) {
+    for (int i = 0; i < cycles; ++i) {
+        manager->startTunnel();
+        if (!Bench::waitFor(manager, &WireGuardManager::tunnelCommandFinished, kTimeoutMs)) return false;
+        manager->stopTunnel();
+        if (!Bench::waitFor(manager, &WireGuardManager::tunnelCommandFinished, kTimeoutMs)) return false;
+    }
+    return true;
+}
+
+struct Subscriber {
+    QAtomicInt calls;
+    QAtomicInteger<quint64> lastVersion;
+};
+
+// A burst of updates between two event loop passes reaches every
+// subscriber as one notification carrying the last of them
+bool checkCoalescing() {
+    ConnectionState state;
+    Subscriber a, b;
+    QObject::connect(&state, &ConnectionState::changed, [&a](const ConnectionSnapshot &s) {
+        a.calls.ref();
+        a.lastVersion.storeRelaxed(s.version);
+    });
+    QObject::connect(&state, &ConnectionState::changed, [&b](const ConnectionSnapshot &s) {
+        b.calls.ref();
+        b.lastVersion.storeRelaxed(s.version);
+    });
+    for (int i = 0; i < kBurst; ++i) {
+        state.setState(i % 2 ? ConnectionSnapshot::Connected : ConnectionSnapshot::Connecting);
+    }
+    const quint64 last = state.snapshot().version;
+    QCoreApplication::processEvents();
+    return state.publishes() == quint64(kBurst) && state.notifications() == 1
+            && a.calls.loadRelaxed() == 1 && b.calls.loadRelaxed() == 1
+            && a.lastVersion.loadRelaxed() == last && b.lastVersion.loadRelaxed() == last
+            && state.state() == ConnectionSnapshot::Connected;
+}
+
+} // namespace
+
+int StatusBenchmark::run(const QStringList &arguments) {
+    const int cycles = Bench::intOption(arguments, "--bench-status", 50, 1);
+    const int subscribers = Bench::intOption(arguments, "--bench-subscribers", 16, 1);
+    const int readers = Bench::intOption(arguments, "--bench-threads", 4, 1);
+    Logger::setLevel(LogLevel::Warning);
+
+    QTemporaryDir dir;
+    SimulatedBackend *backend = new SimulatedBackend(SimulatedBackend::parseProfile("create=0,open=0,config=0,state=0"));
+    WireGuardManager manager(backend);
+    QSettings settings(dir.filePath("bench.ini"), QSettings::IniFormat);
+    manager.setSettings(&settings);
+    // Only state transitions may reach the driver; keep the periodic pollers out
+    manager.setStatsInterval(3600 * 1000);
+    manager.watchdog()->setInterval(3600 * 1000);
+    manager.profileStore()->setDirectory(dir.filePath("profiles"));
+    manager.profileStore()->load();
+    manager.initialize();
+
+    const QString configPath = dir.filePath("bench.conf");
+    QFile config(configPath);
+    if (!dir.isValid() || !config.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        QTextStream(stderr) << "Failed to write benchmark config.\n";
+        return 1;
+    }
+    config.write(QString("[Interface]\nPrivateKey = %1\nAddress = 10.200.0.2/32\n\n[Peer]\nPublicKey = %2\n"
+                         "Endpoint = 192.0.2.1:51820\nAllowedIPs = 0.0.0.0/0\n").arg(Bench::randomKey(), Bench::randomKey()).toUtf8());
+    config.close();
+    manager.importConfig(configPath);
+    if (!Bench::waitFor(&manager, &WireGuardManager::importFinished, kTimeoutMs)) {
+        QTextStream(stderr) << "Import did not finish.\n";
+        return 1;
+    }
+    QCoreApplication::processEvents();
+
+    ConnectionState *connection = manager.connection();
+    int before = backend->driverCalls();
+    if (!runCycles(&manager, cycles)) {
+        QTextStream(stderr) << "Tunnel command timed out.\n";
+        return 1;
+    }
+    const int baselineCalls = backend->driverCalls() - before;
+
+    // Subscribers: half on this thread, half on threads of their own
+    std::vector<std::unique_ptr<Subscriber>> counts;
+    std::vector<std::unique_ptr<QThread>> threads;
+    std::vector<std::unique_ptr<QObject>> contexts;
+    for (int i = 0; i < subscribers; ++i) {
+        counts.emplace_back(new Subscriber);
+        Subscriber *count = counts.back().get();
+        contexts.emplace_back(new QObject);
+        if (i % 2) {
+            threads.emplace_back(new QThread);
+            contexts.back()->moveToThread(threads.back().get());
+            threads.back()->start();
+        }
+        QObject::connect(connection, &ConnectionState::changed, contexts.back().get(),
+                         [count](const ConnectionSnapshot &snapshot) {
+            count->calls.ref();
+            count->lastVersion.storeRelease(snapshot.version);
+        });
+    }
+
+    QAtomicInt stop;
+    QAtomicInteger<quint64> reads;
+    QAtomicInteger<qint64> readNs;
+    QAtomicInteger<quint64> sinkTotal;
+    std::vector<std::unique_ptr<QThread>> pollers;
+    for (int i = 0; i < readers; ++i) {
+        pollers.emplace_back(QThread::create([connection, &stop, &reads, &readNs, &sinkTotal]() {
+            quint64 count = 0;
+            quint64 sink = 0;
+            QElapsedTimer clock;
+            clock.start();
+            while (!stop.loadRelaxed()) {
+                const ConnectionSnapshot snapshot = connection->snapshot();
+                sink += snapshot.version + quint64(snapshot.profile.size());
+                ++count;
+            }
+            readNs.fetchAndAddRelaxed(clock.nsecsElapsed());
+            reads.fetchAndAddRelaxed(count);
+            sinkTotal.fetchAndAddRelaxed(sink);
+        }));
+        pollers.back()->start();
+    }
+
+    const quint64 notificationsBefore = connection->notifications();
+    const quint64 publishesBefore = connection->publishes();
+    before = backend->driverCalls();
+    const bool cyclesOk = runCycles(&manager, cycles);
+    const int subscribedCalls = backend->driverCalls() - before;
+    stop.storeRelaxed(1);
+    for (auto &poller : pollers) poller->wait();
+    const quint64 finalVersion = connection->snapshot().version;
+    // Let the last notification reach the subscriber threads
+    QDeadlineTimer deadline(kTimeoutMs);
+    bool settled = false;
+    while (!settled && !deadline.hasExpired()) {
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+        settled = true;
+        for (const auto &count : counts) settled = settled && count->lastVersion.loadAcquire() == finalVersion;
+    }
+    for (auto &thread : threads) {
+        thread->quit();
+        thread->wait();
+    }
+    const quint64 notifications = connection->notifications() - notificationsBefore;
+    const quint64 publishes = connection->publishes() - publishesBefore;
+
+    bool allDelivered = true;
+    for (const auto &count : counts) {
+        allDelivered = allDelivered && count->lastVersion.loadAcquire() == finalVersion
+                && quint64(count->calls.loadRelaxed()) == notifications;
+    }
+
+    QJsonObject checks;
+    checks["cycles_completed"] = cyclesOk;
+    checks["no_extra_driver_calls"] = cyclesOk && subscribedCalls == baselineCalls;
+    checks["every_subscriber_saw_latest"] = allDelivered;
+    checks["burst_coalesced"] = checkCoalescing();
+    const bool allPassed = Bench::allPassed(checks);
+
+    const double totalReads = double(reads.loadRelaxed());
+    QJsonObject root;
+    root["cycles"] = cycles;
+    root["subscribers"] = subscribers;
+    root["reader_threads"] = readers;
+    root["driver_calls_without_subscribers"] = baselineCalls;
+    root["driver_calls_with_subscribers"] = subscribedCalls;
+    root["snapshot_reads"] = qint64(totalReads);
+    root["snapshot_read_ns"] = totalReads > 0 ? double(readNs.loadRelaxed()) / totalReads : 0.0;
+    root["state_changes"] = qint64(publishes);
+    root["notifications"] = qint64(notifications);
+    root["changes_per_notification"] = notifications ? double(publishes) / notifications : 0.0;
+    root["checks"] = checks;
+    root["sink"] = qint64(sinkTotal.loadRelaxed());  // Keeps the read loop from being optimized out
+    return Bench::finish(root, arguments, allPassed, "Connection state check failed");
+}
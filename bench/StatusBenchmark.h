@@ -0,0 +1,20 @@
+#ifndef STATUSBENCHMARK_H
+#define STATUSBENCHMARK_H
+
+#include <QStringList>
+
+// Connection state fan-out: runs start/stop cycles on a SimulatedBackend
+// once without consumers and once with N subscribers (half on their own
+// threads) plus reader threads polling the snapshot, and checks the driver
+// saw exactly the same number of calls. Also reports snapshot() cost under
+// contention and how many changes each notification coalesced. Exits
+// non-zero if any check fails.
+//
+//   tpn-bench --bench-status=50 [--bench-subscribers=16] [--bench-threads=4]
+//             [--bench-out=status.json]
+class StatusBenchmark {
+public:
+    static int run(const QStringList &arguments);  // Needs a QCoreApplication
+};
+
+#endif // STATUSBENCHMARK_H
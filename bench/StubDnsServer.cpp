@@ -0,0 +1,88 @@
+#include "StubDnsServer.h"
+#include "DnsMessage.h"
+#include <QNetworkDatagram>
+#include <QTimer>
+#include <QtEndian>
+
+namespace {
+
+QByteArray record(quint16 type, quint32 ttl, const QByteArray &rdata) {
+    QByteArray out(12, '\0');
+    uchar *p = reinterpret_cast<uchar *>(out.data());
+    qToBigEndian<quint16>(0xC00C, p);  // Owner: the question name
+    qToBigEndian<quint16>(type, p + 2);
+    qToBigEndian<quint16>(1, p + 4);
+    qToBigEndian<quint32>(ttl, p + 6);
+    qToBigEndian<quint16>(quint16(rdata.size()), p + 10);
+    return out + rdata;
+}
+
+quint32 ttlFor(const QByteArray &name) {
+    if (name.startsWith('t')) {
+        bool ok = false;
+        const quint32 ttl = name.mid(1, name.indexOf('.') - 1).toUInt(&ok);
+        if (ok) return ttl;
+    }
+    return StubDnsServer::kDefaultTtl;
+}
+
+} // namespace
+
+bool StubDnsServer::start() {
+    QObject::connect(&m_socket, &QUdpSocket::readyRead, [this]() { onReadyRead(); });
+    return m_socket.bind(QHostAddress::LocalHost, 0);
+}
+
+QHostAddress StubDnsServer::addressFor(const QByteArray &name, quint16 type) {
+    if (name.startsWith("nx")) return QHostAddress();
+    const quint16 hash = quint16(qHash(name));
+    if (type == DnsRecord::A) return QHostAddress(quint32(10u << 24 | 53u << 16 | hash));
+    if (type != DnsRecord::AAAA || !name.startsWith("v6")) return QHostAddress();
+    Q_IPV6ADDR address = {};
+    address[0] = 0xfd;
+    address[1] = 0x53;
+    address[14] = quint8(hash >> 8);
+    address[15] = quint8(hash);
+    return QHostAddress(address);
+}
+
+QByteArray StubDnsServer::answer(const QByteArray &query, const DnsMessage &message) {
+    const QHostAddress address = addressFor(message.question, message.questionType);
+    const bool exists = !message.question.startsWith("nx");
+    QByteArray packet = DnsMessage::reply(query, exists ? 0 : 3);
+    const quint32 ttl = ttlFor(message.question);
+    int countAt = 6;  // ANCOUNT
+    if (address.protocol() == QAbstractSocket::IPv4Protocol) {
+        quint8 rdata[4];
+        qToBigEndian<quint32>(address.toIPv4Address(), rdata);
+        packet += record(DnsRecord::A, ttl, QByteArray(reinterpret_cast<const char *>(rdata), 4));
+    } else if (address.protocol() == QAbstractSocket::IPv6Protocol) {
+        const Q_IPV6ADDR rdata = address.toIPv6Address();
+        packet += record(DnsRecord::AAAA, ttl, QByteArray(reinterpret_cast<const char *>(rdata.c), 16));
+    } else {
+        // Root names, serial and timers, then the negative TTL as MINIMUM
+        QByteArray soa(22, '\0');
+        qToBigEndian<quint32>(ttl, reinterpret_cast<uchar *>(soa.data()) + 18);
+        packet += record(DnsRecord::SOA, ttl, soa);
+        countAt = 8;  // NSCOUNT
+    }
+    qToBigEndian<quint16>(1, reinterpret_cast<uchar *>(packet.data()) + countAt);
+    return packet;
+}
+
+void StubDnsServer::onReadyRead() {
+    while (m_socket.hasPendingDatagrams()) {
+        const QNetworkDatagram datagram = m_socket.receiveDatagram();
+        DnsMessage message;
+        if (!DnsMessage::parse(datagram.data(), &message) || message.response) continue;
+        total++;
+        asked[message.question]++;
+        if (silent) continue;
+        const QByteArray packet = answer(datagram.data(), message);
+        const QHostAddress address = datagram.senderAddress();
+        const quint16 port = quint16(datagram.senderPort());
+        QTimer::singleShot(delayMs, &m_socket, [this, packet, address, port]() {
+            m_socket.writeDatagram(packet, address, port);
+        });
+    }
+}
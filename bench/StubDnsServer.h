@@ -0,0 +1,37 @@
+#ifndef STUBDNSSERVER_H
+#define STUBDNSSERVER_H
+
+#include <QHash>
+#include <QHostAddress>
+#include <QUdpSocket>
+
+struct DnsMessage;
+
+// Loopback stand-in for a DNS server, for the benches. Names "nx..." do
+// not exist; "t<N>.<...>" answer with a TTL of N seconds, everything else
+// with the default. Every name has an A record; names starting with "v6"
+// have an AAAA record too, the others get NODATA for AAAA. Answers leave
+// after the delay, so in-flight behaviour can be observed.
+class StubDnsServer {
+public:
+    static const quint32 kDefaultTtl = 300;
+
+    int delayMs = 50;
+    bool silent = false;  // Counts queries but never answers
+    int total = 0;
+    QHash<QByteArray, int> asked;  // Question name -> queries
+
+    bool start();  // On an ephemeral loopback port
+    quint16 port() const { return m_socket.localPort(); }
+
+    // What the server answers for `name`; null for NXDOMAIN or NODATA
+    static QHostAddress addressFor(const QByteArray &name, quint16 type);
+
+private:
+    QUdpSocket m_socket;
+
+    static QByteArray answer(const QByteArray &query, const DnsMessage &message);
+    void onReadyRead();
+};
+
+#endif // STUBDNSSERVER_H
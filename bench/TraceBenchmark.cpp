@@ -0,0 +1,129 @@
+#include "TraceBenchmark.h"
+#include "BenchUtil.h"
+#include "Tracer.h"
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+#include <memory>
+#include <vector>
+
+namespace {
+
+const int kBatch = 10000;  // Below the per-thread buffer, so nothing is dropped
+
+// ns per span over `spans` scopes; recording restarts between batches
+// (untimed) so every timed span takes the normal, non-dropping path
+double timeSpans(int spans, bool enabled) {
+    qint64 totalNs = 0;
+    QElapsedTimer clock;
+    for (int done = 0; done < spans; done += kBatch) {
+        const int batch = qMin(kBatch, spans - done);
+        clock.start();
+        for (int i = 0; i < batch; ++i) {
+            TPN_TRACE_SCOPE("Bench::span");
+        }
+        totalNs += clock.nsecsElapsed();
+        if (enabled) {
+            Tracer::instance().setEnabled(false);
+            Tracer::instance().setEnabled(true);
+        }
+    }
+    return double(totalNs) / spans;
+}
+
+// Reads the export back the way a trace viewer would: a traceEvents array
+// of complete ("X") events with ts and dur, one thread_name per thread
+QJsonObject checkExport(const QByteArray &json, int expectedSpans, int expectedThreads, bool *ok) {
+    QJsonParseError error;
+    const QJsonDocument document = QJsonDocument::fromJson(json, &error);
+    const QJsonValue events = document.object().value("traceEvents");
+    int spans = 0, threadNames = 0, malformed = 0;
+    for (const QJsonValue &value : events.toArray()) {
+        const QJsonObject event = value.toObject();
+        const QString phase = event.value("ph").toString();
+        if (phase == "M" && event.value("name").toString() == "thread_name") {
+            threadNames++;
+        } else if (phase == "X" && event.value("ts").isDouble() && event.value("dur").isDouble()
+                   && event.value("dur").toDouble() >= 0 && !event.value("name").toString().isEmpty()) {
+            spans++;
+        } else {
+            malformed++;
+        }
+    }
+    *ok = error.error == QJsonParseError::NoError && events.isArray() && malformed == 0
+        && spans == expectedSpans && threadNames == expectedThreads;
+    QJsonObject out;
+    out["parse_error"] = error.error == QJsonParseError::NoError ? QString() : error.errorString();
+    out["span_events"] = spans;
+    out["expected_spans"] = expectedSpans;
+    out["thread_names"] = threadNames;
+    out["malformed_events"] = malformed;
+    return out;
+}
+
+} // namespace
+
+int TraceBenchmark::run(const QStringList &arguments) {
+    const int spans = Bench::intOption(arguments, "--bench-trace", 1000000, 1);
+    const int threads = Bench::intOption(arguments, "--bench-threads", 4, 1);
+    Tracer &tracer = Tracer::instance();
+
+    tracer.setEnabled(false);
+    const double disabledNs = timeSpans(spans, false);
+    tracer.setEnabled(true);
+    const double enabledNs = timeSpans(spans, true);
+
+    // Concurrent recording: per-thread buffers should keep this flat
+    QVector<double> perThread(threads);
+    {
+        std::vector<std::unique_ptr<QThread>> workers;
+        for (int t = 0; t < threads; ++t) {
+            double *result = &perThread[t];
+            workers.emplace_back(QThread::create([result, spans]() {
+                QElapsedTimer clock;
+                clock.start();
+                const int batch = qMin(spans, kBatch);
+                for (int i = 0; i < batch; ++i) {
+                    TPN_TRACE_SCOPE("Bench::concurrent");
+                }
+                *result = double(clock.nsecsElapsed()) / batch;
+            }));
+            workers.back()->start();
+        }
+        for (auto &worker : workers) worker->wait();
+    }
+    double concurrentNs = 0;
+    for (double ns : qAsConst(perThread)) concurrentNs = qMax(concurrentNs, ns);
+
+    tracer.setEnabled(false);
+    const int exported = tracer.spanCount();
+    QElapsedTimer exportClock;
+    exportClock.start();
+    const QByteArray json = tracer.toChromeJson();
+    const qint64 exportNs = exportClock.nsecsElapsed();
+
+    QJsonObject root;
+    root["spans"] = spans;
+    root["threads"] = threads;
+    root["disabled_ns_per_span"] = disabledNs;
+    root["enabled_ns_per_span"] = enabledNs;
+    root["concurrent_worst_thread_ns_per_span"] = concurrentNs;
+    root["export_spans"] = exported;
+    root["export_ms"] = exportNs / 1e6;
+    root["export_bytes"] = json.size();
+    root["dropped"] = qint64(tracer.dropped());
+
+    // Only the worker threads' spans are left: the single-threaded run
+    // ends with a restart, which discards the main thread's last batch
+    bool exportOk = false;
+    root["export_check"] = checkExport(json, threads * qMin(spans, kBatch), threads, &exportOk);
+    QJsonObject checks;
+    checks["exportValid"] = exportOk;
+    checks["nothingDropped"] = tracer.dropped() == 0;
+    const bool allPassed = Bench::allPassed(checks);
+    checks["allPassed"] = allPassed;
+    root["checks"] = checks;
+    return Bench::finish(root, arguments, allPassed, "Trace check failed");
+}
@@ -0,0 +1,18 @@
+#ifndef TRACEBENCHMARK_H
+#define TRACEBENCHMARK_H
+
+#include <QStringList>
+
+// Cost of a TPN_TRACE_SCOPE with recording off and on, single-threaded and
+// with several threads recording at once, plus the time and size of the
+// Chrome JSON export of full buffers. Reports ns per span as JSON. The
+// export is parsed back and must hold a traceEvents array with one complete
+// event (ph, ts, dur) per recorded span, or the run exits non-zero.
+//
+//   tpn-bench --bench-trace=1000000 [--bench-threads=4] [--bench-out=trace.json]
+class TraceBenchmark {
+public:
+    static int run(const QStringList &arguments);  // Needs a QCoreApplication
+};
+
+#endif // TRACEBENCHMARK_H
@@ -0,0 +1,100 @@
+#include "CidrBenchmark.h"
+#include "ConnectBenchmark.h"
+#include "DnsBenchmark.h"
+#include "DomainsBenchmark.h"
+#include "DriverConfigBenchmark.h"
+#include "FailoverBenchmark.h"
+#include "ImportBenchmark.h"
+#include "IpcBenchmark.h"
+#include "KeyBenchmark.h"
+#include "LogBenchmark.h"
+#include "LogViewBenchmark.h"
+#include "ParseBenchmark.h"
+#include "PathMtuBenchmark.h"
+#include "ProbeBenchmark.h"
+#include "ProcessInfo.h"
+#include "ProfileStoreBenchmark.h"
+#include "ReconfigureBenchmark.h"
+#include "RegistryBenchmark.h"
+#include "ResolverBenchmark.h"
+#include "SamplerBenchmark.h"
+#include "SelfTestBenchmark.h"
+#include "StartupBenchmark.h"
+#include "StatusBenchmark.h"
+#include "TraceBenchmark.h"
+#include "Tracer.h"
+#include "mainwindow.h"
+#include <QApplication>
+#include <QTextStream>
+
+namespace {
+
+struct Mode {
+    const char *flag;
+    int (*run)(const QStringList &arguments);
+    bool widgets;  // Needs the themed QApplication instead of a QCoreApplication
+};
+
+const Mode kModes[] = {
+    { "--bench-connect", &ConnectBenchmark::run, false },
+    { "--bench-log", &LogBenchmark::run, false },
+    { "--bench-cidr", &CidrBenchmark::run, false },
+    { "--bench-failover", &FailoverBenchmark::run, false },
+    { "--bench-ipc", &IpcBenchmark::run, false },
+    { "--bench-import", &ImportBenchmark::run, false },
+    { "--bench-keys", &KeyBenchmark::run, false },
+    { "--bench-trace", &TraceBenchmark::run, false },
+    { "--bench-driver-config", &DriverConfigBenchmark::run, false },
+    { "--bench-status", &StatusBenchmark::run, false },
+    { "--bench-viewer", &LogViewBenchmark::run, false },
+    { "--bench-selftest", &SelfTestBenchmark::run, false },
+    { "--bench-mtu", &PathMtuBenchmark::run, false },
+    { "--bench-tunnels", &RegistryBenchmark::run, false },
+    { "--bench-dns", &DnsBenchmark::run, false },
+    { "--bench-parse", &ParseBenchmark::run, false },
+    { "--bench-resolver", &ResolverBenchmark::run, false },
+    { "--bench-reconfigure", &ReconfigureBenchmark::run, false },
+    { "--bench-probe", &ProbeBenchmark::run, false },
+    { "--bench-sampler", &SamplerBenchmark::run, false },
+    { "--bench-domains", &DomainsBenchmark::run, false },
+    { "--bench-startup", &StartupBenchmark::run, true },
+    { "--bench-profiles", &ProfileStoreBenchmark::run, true },
+};
+
+// The mode whose flag is given bare or as flag=value
+const Mode *findMode(int argc, char *argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        for (const Mode &mode : kModes) {
+            const int length = int(qstrlen(mode.flag));
+            if (qstrncmp(argv[i], mode.flag, uint(length)) == 0 && (argv[i][length] == '\0' || argv[i][length] == '=')) {
+                return &mode;
+            }
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+// Benchmarks and checks, one mode per run; each header has its usage.
+// Exits 2 without a mode, otherwise with the mode's exit code.
+int main(int argc, char *argv[]) {
+    ProcessInfo::markStart();
+    Tracer::instance().applyEnvironment();
+
+    const Mode *mode = findMode(argc, argv);
+    if (!mode) {
+        QTextStream(stderr) << "Usage: tpn-bench <mode>[=value] [options]\nModes:";
+        for (const Mode &m : kModes) QTextStream(stderr) << ' ' << m.flag;
+        QTextStream(stderr) << '\n';
+        return 2;
+    }
+    if (mode->widgets) {
+        // Measures the real themed window, as the client shows it
+        QApplication app(argc, argv);
+        MainWindow::applyTheme(&app);
+        return mode->run(app.arguments());
+    }
+    QCoreApplication app(argc, argv);
+    return mode->run(app.arguments());
+}
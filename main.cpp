@@ -1,96 +1,47 @@
 #include "mainwindow.h"
 #include <QApplication>
-#include <QStyleFactory>
+#include <QStandardPaths>
+#include "ControlClient.h"
+#include "HeadlessMode.h"
+#include "Logger.h"
+#include "ProcessInfo.h"
+#include "SelfTestServer.h"
+#include "Tracer.h"
+#include <QTimer>
 
 int main(int argc, char *argv[]) {
+    ProcessInfo::markStart();
+    Tracer::instance().applyEnvironment();
+
+    // Service and CLI modes never touch the widget or GUI modules
+    if (HeadlessMode::isRequested(argc, argv)) {
+        QCoreApplication app(argc, argv);
+        return HeadlessMode::run(app.arguments());
+    }
+    if (ControlClient::isRequested(argc, argv)) {
+        QCoreApplication app(argc, argv);
+        return ControlClient::run(app.arguments());
+    }
+    if (SelfTestServer::isRequested(argc, argv)) {
+        QCoreApplication app(argc, argv);
+        return SelfTestServer::run(app.arguments());
+    }
+
     QApplication a(argc, argv);
-    a.setStyle(QStyleFactory::create("Fusion"));  // Smooth base for dark theme
+    MainWindow::applyTheme(&a);
 
-    // Global Dark Theme Stylesheet (Astrill-like: dark bg, green accents)
-    a.setStyleSheet(R"(
-        QMainWindow {
-            background-color: #1e1e1e;
-            color: #ffffff;
-        }
-        QPushButton {
-            background-color: #2d2d2d;
-            border: 1px solid #404040;
-            border-radius: 5px;
-            padding: 8px 16px;
-            color: #ffffff;
-            font-weight: bold;
-        }
-        QPushButton:hover {
-            background-color: #404040;
-            border-color: #007acc;
-        }
-        QPushButton:pressed {
-            background-color: #1a1a1a;
-        }
-        QPushButton#toggleButton {
-            background-color: #28a745;
-            border-color: #28a745;
-            min-width: 120px;
-        }
-        QPushButton#toggleButton:hover {
-            background-color: #218838;
-        }
-        QPushButton#toggleButton:pressed {
-            background-color: #1e7e34;
-        }
-        QPushButton#disconnectButton {
-            background-color: #dc3545;
-            border-color: #dc3545;
-        }
-        QPushButton#disconnectButton:hover {
-            background-color: #c82333;
-        }
-        QLabel {
-            color: #ffffff;
-            font-size: 14px;
-        }
-        QLabel#statusLabel {
-            font-size: 16px;
-            font-weight: bold;
-            padding: 10px;
-            border-radius: 3px;
-        }
-        QStatusBar {
-            background-color: #2d2d2d;
-            color: #cccccc;
-            font-size: 12px;
-        }
-        QTextEdit {
-            background-color: #1a1a1a;
-            border: 1px solid #404040;
-            border-radius: 3px;
-            color: #e0e0e0;
-            font-family: 'Consolas';
-            font-size: 11px;
-        }
-        QProgressBar {
-            border: 1px solid #404040;
-            border-radius: 5px;
-            text-align: center;
-            background-color: #2d2d2d;
-            color: #ffffff;
-        }
-        QProgressBar::chunk {
-            background-color: #007acc;
-            border-radius: 3px;
-        }
-        QSplitter::handle {
-            background-color: #404040;
-        }
-        QTreeView {
-            background-color: #1a1a1a;
-            color: #ffffff;
-            border: 1px solid #404040;
-            selection-background-color: #007acc;
-        }
-    )");
+    Logger::installMessageHandler();
+    Logger::instance().setFileOutput(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/logs");
 
-    MainWindow w;
+    // --simulate[=spec] runs the UI without the driver, see SimulatedBackend
+    MainWindow w(TunnelBackend::fromArguments(a.arguments()));
     w.show();
-    return a.exec();
+    QTimer::singleShot(0, []() {
+        TPN_INFO("Main", QString("Started in %1 ms, resident %2 KB (GUI).")
+                 .arg(ProcessInfo::sinceStartMs()).arg(ProcessInfo::residentKb()));
+    });
+    const int result = a.exec();
+    Tracer::instance().finish();
+    Logger::instance().shutdown();  // Flush before static destruction
+    return result;
 }
\ No newline at end of file
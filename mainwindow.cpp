@@ -6,22 +6,66 @@
 #include <QPropertyAnimation>
 #include <QGraphicsDropShadowEffect>
 #include <QTimer>
+#include <QTreeView>
+#include <QListView>
+#include <QLineEdit>
+#include <QComboBox>
+#include <QScrollBar>
+#include <QClipboard>
+#include <QApplication>
+#include <QScreen>
+#include <QStyleFactory>
+#include <QDateTime>
+#include "Tracer.h"
+#include <algorithm>
+
+namespace {
+const int kStatsVisibleMs = 500;   // Sampling period with the window on screen
+const int kStatsHiddenMs = 5000;   // Minimized or in the tray
+
+QString formatRate(double bytesPerSecond) {
+    const double bits = bytesPerSecond * 8;
+    if (bits >= 1e6) return QString::number(bits / 1e6, 'f', 1) + " Mbit/s";
+    return QString::number(bits / 1e3, 'f', 0) + " kbit/s";
+}
+}
 
-MainWindow::MainWindow(QWidget *parent)
+MainWindow::MainWindow(TunnelBackend *backend, QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
-    , m_wgManager(new WireGuardManager(this))
+    , m_wgManager(new WireGuardManager(backend, this))
+    , m_startup(new StartupSequence(m_wgManager, this))
 {
     ui->setupUi(this);
     setupUI();
     setupTray();
 
     // Connect signals
-    connect(m_wgManager, &WireGuardManager::statusChanged, this, &MainWindow::onStatusChanged);
-    connect(m_wgManager, &WireGuardManager::logMessage, this, &MainWindow::onLogMessage);
+    connect(m_wgManager->connection(), &ConnectionState::changed, this, &MainWindow::onConnectionChanged);
     connect(m_wgManager, &WireGuardManager::progressChanged, this, &MainWindow::onProgressChanged);  // New signal
+    connect(m_wgManager, &WireGuardManager::importFinished, this, &MainWindow::onImportFinished);
+    connect(m_wgManager, &WireGuardManager::tunnelCommandFinished, this, &MainWindow::onTunnelCommandFinished);
+    connect(m_wgManager, &WireGuardManager::statsUpdated, this, &MainWindow::onStatsUpdated);
+    connect(m_wgManager, &WireGuardManager::selfTestStarted, this, &MainWindow::onSelfTestStarted);
+    connect(m_wgManager, &WireGuardManager::selfTestFinished, this, &MainWindow::onSelfTestFinished);
     connect(ui->toggleButton, &QPushButton::clicked, this, &MainWindow::onToggleClicked);
-    connect(ui->importButton, &QPushButton::clicked, this, &MainWindow::onImportConfig);
+    connect(m_wgManager->bulkImporter(), &BulkImporter::finished, this, &MainWindow::onBulkImportFinished);
+    connect(m_fastestButton, &QPushButton::clicked, this, &MainWindow::onFastestClicked);
+    connect(m_startup, &StartupSequence::phaseFinished, this, &MainWindow::onStartupPhaseFinished);
+    connect(m_startup, &StartupSequence::ready, this, &MainWindow::onStartupReady);
+
+    // Samples can arrive faster than the screen refreshes; paint the latest once per frame
+    m_statsRepaint.setSingleShot(true);
+    m_statsRepaint.setInterval(qMax(1, int(1000 / qMax(1.0, screen()->refreshRate()))));
+    connect(&m_statsRepaint, &QTimer::timeout, this, &MainWindow::repaintStats);
+
+    // Log records arrive in batches from the logger thread; same per-frame cap
+    m_logFlush.setSingleShot(true);
+    m_logFlush.setInterval(m_statsRepaint.interval());
+    connect(&m_logFlush, &QTimer::timeout, this, &MainWindow::drainLog);
+    connect(&Logger::instance(), &Logger::batchReady, &m_logFlush, [this]() {
+        if (!m_logFlush.isActive()) m_logFlush.start();
+    });
 
     // Animation for button glow
     m_buttonAnimation = new QPropertyAnimation(ui->toggleButton, "geometry", this);
@@ -29,11 +73,17 @@ MainWindow::MainWindow(QWidget *parent)
 
     // Initial
     ui->statusLabel->setText("Disconnected");
-    ui->progressBar->setVisible(false);
-    m_isConnected = false;
     m_isConnecting = false;
 
-    m_wgManager->initialize();
+    // Driver, profiles and endpoint DNS load in the background; until they
+    // are done the window is up but nothing that needs them is clickable
+    ui->progressBar->setVisible(true);
+    ui->toggleButton->setEnabled(false);
+    m_toggleAction->setEnabled(false);
+    ui->importButton->setEnabled(false);
+    m_fastestButton->setEnabled(false);
+    statusBar()->showMessage("Starting...");
+    m_startup->start();
 }
 
 MainWindow::~MainWindow() {
@@ -61,6 +111,19 @@ void MainWindow::setupUI() {
     ui->statusLabel->setPalette(pal);
     mainLayout->addWidget(ui->statusLabel);
 
+    // Live traffic (only while connected)
+    m_statsLabel = new QLabel(central);
+    m_statsLabel->setAlignment(Qt::AlignCenter);
+    m_statsLabel->setVisible(false);
+    mainLayout->addWidget(m_statsLabel);
+
+    m_selfTestLabel = new QLabel(central);
+    m_selfTestLabel->setAlignment(Qt::AlignCenter);
+    m_selfTestLabel->setWordWrap(true);
+    m_selfTestLabel->setStyleSheet("font-size: 11px; color: #cccccc;");
+    m_selfTestLabel->setVisible(false);
+    mainLayout->addWidget(m_selfTestLabel);
+
     // Spacer
     mainLayout->addSpacerItem(new QSpacerItem(0, 20, QSizePolicy::Minimum, QSizePolicy::Fixed));
 
@@ -83,10 +146,18 @@ void MainWindow::setupUI() {
     ui->progressBar->setVisible(false);
     mainLayout->addWidget(ui->progressBar, 0, Qt::AlignCenter);
 
-    // Import button (subtle)
+    // Import button (subtle); several files, a .zip or a folder import in bulk
     ui->importButton = new QPushButton("Import Config", central);
+    QMenu *importMenu = new QMenu(ui->importButton);
+    connect(importMenu->addAction("Import Files..."), &QAction::triggered, this, &MainWindow::onImportConfig);
+    connect(importMenu->addAction("Import Folder..."), &QAction::triggered, this, &MainWindow::onImportFolder);
+    ui->importButton->setMenu(importMenu);
     mainLayout->addWidget(ui->importButton, 0, Qt::AlignCenter);
 
+    // Probe all profiles and load the fastest one
+    m_fastestButton = new QPushButton("Fastest Server", central);
+    mainLayout->addWidget(m_fastestButton, 0, Qt::AlignCenter);
+
     // Spacer
     mainLayout->addSpacerItem(new QSpacerItem(0, 20, QSizePolicy::Minimum, QSizePolicy::Fixed));
 
@@ -95,16 +166,50 @@ void MainWindow::setupUI() {
     splitter->setCollapsible(1, true);  // Collapse logs
     mainLayout->addWidget(splitter);
 
-    // Placeholder for future config tree (empty for MVP)
-    QTreeWidget *configTree = new QTreeWidget(splitter);
-    configTree->setHeaderLabel("Configs");
-    configTree->setMinimumHeight(50);
-
-    // Log text edit
-    ui->logTextEdit = new QTextEdit(splitter);
-    ui->logTextEdit->setReadOnly(true);
-    ui->logTextEdit->setMaximumBlockCount(200);
-    ui->logTextEdit->setMinimumHeight(100);
+    // Config tree over the profile store; rows are materialized lazily
+    m_profileModel = new ProfileModel(m_wgManager->profileStore(), this);
+    m_profileView = new QTreeView(splitter);  // Model attached once the store has loaded
+    m_profileView->setRootIsDecorated(false);
+    m_profileView->setUniformRowHeights(true);  // Lets the view skip offscreen rows
+    m_profileView->setMinimumHeight(50);
+    connect(m_profileView, &QTreeView::activated, this, &MainWindow::onProfileActivated);
+
+    // Log pane: filter row over the whole session's records; the list only
+    // formats the lines on screen
+    QWidget *logPane = new QWidget(splitter);
+    QVBoxLayout *logLayout = new QVBoxLayout(logPane);
+    logLayout->setContentsMargins(0, 0, 0, 0);
+    logLayout->setSpacing(4);
+    QHBoxLayout *filterRow = new QHBoxLayout;
+    m_logSearch = new QLineEdit(logPane);
+    m_logSearch->setPlaceholderText("Filter log");
+    m_logSearch->setClearButtonEnabled(true);
+    filterRow->addWidget(m_logSearch, 1);
+    m_logLevelFilter = new QComboBox(logPane);
+    m_logLevelFilter->addItem("All", int(LogLevel::Debug));
+    for (LogLevel level : { LogLevel::Info, LogLevel::Warning, LogLevel::Error }) {
+        m_logLevelFilter->addItem(QString(Logger::levelName(level)) + "+", int(level));
+    }
+    filterRow->addWidget(m_logLevelFilter);
+    m_logComponentFilter = new QComboBox(logPane);
+    m_logComponentFilter->addItem("Any", QString());
+    filterRow->addWidget(m_logComponentFilter);
+    logLayout->addLayout(filterRow);
+
+    m_logModel = new LogModel(this);
+    m_logView = new QListView(logPane);
+    m_logView->setModel(m_logModel);
+    m_logView->setUniformItemSizes(true);  // Lets the view skip offscreen rows
+    m_logView->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    m_logView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_logView->setMinimumHeight(100);
+    m_logView->setContextMenuPolicy(Qt::CustomContextMenu);
+    logLayout->addWidget(m_logView);
+    connect(m_logView, &QWidget::customContextMenuRequested, this, &MainWindow::onLogContextMenu);
+    connect(m_logSearch, &QLineEdit::textChanged, this, &MainWindow::applyLogFilter);
+    connect(m_logLevelFilter, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MainWindow::applyLogFilter);
+    connect(m_logComponentFilter, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MainWindow::applyLogFilter);
+    connect(m_logModel, &LogModel::componentsChanged, this, &MainWindow::onLogComponentsChanged);
 
     splitter->setSizes(QList<int>() << 200 << 100);  // Initial split
 
@@ -130,40 +235,74 @@ void MainWindow::setupTray() {
     connect(quitAction, &QAction::triggered, qApp, &QApplication::quit);
     trayMenu->addAction(quitAction);
 
+    // Span recording for slow-connect reports; see Tracer
+    trayMenu->addSeparator();
+    QAction *traceAction = trayMenu->addAction("Record Trace");
+    traceAction->setCheckable(true);
+    traceAction->setChecked(Tracer::isEnabled());
+    connect(trayMenu, &QMenu::aboutToShow, traceAction, [traceAction]() { traceAction->setChecked(Tracer::isEnabled()); });
+    connect(traceAction, &QAction::toggled, this, [](bool on) { Tracer::instance().setEnabled(on); });
+    connect(trayMenu->addAction("Save Trace..."), &QAction::triggered, this, &MainWindow::onSaveTrace);
+
     m_trayIcon->setContextMenu(trayMenu);
     m_trayIcon->show();
 }
 
+void MainWindow::onStartupPhaseFinished(StartupSequence::Phase phase, bool ok) {
+    if (phase != StartupSequence::Profiles) return;
+    // The loader thread is done with the store; safe to read and import now
+    m_profileView->setModel(m_profileModel);
+    ui->importButton->setEnabled(true);
+    m_fastestButton->setEnabled(true);
+    if (!ok) statusBar()->showMessage("Some profiles could not be loaded.");
+}
+
+void MainWindow::onStartupReady() {
+    ui->progressBar->setVisible(false);
+    ui->toggleButton->setEnabled(true);
+    m_toggleAction->setEnabled(true);
+    statusBar()->showMessage(m_startup->succeeded(StartupSequence::Driver)
+                             ? "Ready to import a WireGuard config." : "WireGuard driver not available.");
+}
+
 void MainWindow::onToggleClicked() {
+    TPN_TRACE_SCOPE("UI::onToggleClicked");
     if (m_isConnecting) return;  // Prevent spam
     toggleConnection();
 }
 
 void MainWindow::toggleConnection() {
-    if (m_isConnected) {
-        m_isConnecting = true;
-        ui->progressBar->setVisible(true);
-        ui->toggleButton->setEnabled(false);
+    // Commands are queued to the manager's worker; repeated toggles coalesce there
+    m_isConnecting = true;
+    ui->progressBar->setRange(0, 0);
+    ui->progressBar->setVisible(true);
+    ui->toggleButton->setEnabled(false);
+    if (m_wgManager->connection()->snapshot().isConnected()) {
         ui->toggleButton->setText("Disconnecting...");
-        if (m_wgManager->stopTunnel()) {
-            // Animation: Shrink button slightly
-            m_buttonAnimation->setStartValue(ui->toggleButton->geometry());
-            m_buttonAnimation->setEndValue(ui->toggleButton->geometry().adjusted(0, 0, -10, -5));
-            m_buttonAnimation->start();
-            connect(m_buttonAnimation, &QPropertyAnimation::finished, this, &MainWindow::onAnimationFinished);
-        }
+        m_wgManager->stopTunnel();
     } else {
-        m_isConnecting = true;
-        ui->progressBar->setVisible(true);
-        ui->toggleButton->setEnabled(false);
         ui->toggleButton->setText("Connecting...");
-        if (m_wgManager->startTunnel()) {
-            m_buttonAnimation->setStartValue(ui->toggleButton->geometry());
-            m_buttonAnimation->setEndValue(ui->toggleButton->geometry().adjusted(0, 0, 10, 5));
-            m_buttonAnimation->start();
-            connect(m_buttonAnimation, &QPropertyAnimation::finished, this, &MainWindow::onAnimationFinished);
-        }
+        m_wgManager->startTunnel();
+    }
+}
+
+void MainWindow::onTunnelCommandFinished(TunnelWorker::Command command, bool ok) {
+    TPN_TRACE_SCOPE("UI::onTunnelCommandFinished");
+    if (command != TunnelWorker::Start && command != TunnelWorker::Stop) return;
+    if (!ok) {
+        onAnimationFinished();
+        return;
+    }
+
+    // Animation: grow on connect, shrink slightly on disconnect
+    m_buttonAnimation->setStartValue(ui->toggleButton->geometry());
+    if (command == TunnelWorker::Start) {
+        m_buttonAnimation->setEndValue(ui->toggleButton->geometry().adjusted(0, 0, 10, 5));
+    } else {
+        m_buttonAnimation->setEndValue(ui->toggleButton->geometry().adjusted(0, 0, -10, -5));
     }
+    connect(m_buttonAnimation, &QPropertyAnimation::finished, this, &MainWindow::onAnimationFinished, Qt::UniqueConnection);
+    m_buttonAnimation->start();
 }
 
 void MainWindow::onAnimationFinished() {
@@ -175,7 +314,7 @@ void MainWindow::onAnimationFinished() {
 }
 
 void MainWindow::updateToggleButton() {
-    if (m_isConnected) {
+    if (m_wgManager->connection()->snapshot().isConnected()) {
         ui->toggleButton->setText("Disconnect");
         ui->toggleButton->setIcon(QIcon(":/icons/disconnect.png"));
         QPalette pal = ui->toggleButton->palette();
@@ -191,60 +330,281 @@ void MainWindow::updateToggleButton() {
 }
 
 void MainWindow::onImportConfig() {
-    QString fileName = QFileDialog::getOpenFileName(this, "Import WireGuard Config", "", "Config Files (*.conf)");
-    if (fileName.isEmpty()) return;
+    const QStringList fileNames = QFileDialog::getOpenFileNames(this, "Import WireGuard Configs", "",
+                                                                "Configs and Bundles (*.conf *.zip)");
+    if (fileNames.isEmpty()) return;
+    TPN_TRACE_SCOPE("UI::onImportConfig");  // After the dialog, which would dominate
+    if (fileNames.size() > 1 || !fileNames.first().endsWith(".conf", Qt::CaseInsensitive)) {
+        startBulkImport(fileNames);
+        return;
+    }
+    const QString fileName = fileNames.first();
 
-    // Show progress for import
+    // Show progress for import (parse + endpoint DNS run off the UI thread)
     ui->progressBar->setRange(0, 0);
     ui->progressBar->setVisible(true);
+    ui->importButton->setEnabled(false);
     statusBar()->showMessage("Importing config...");
 
-    QByteArray configData = m_wgManager->parseConfigFile(fileName);
+    m_wgManager->importConfig(fileName);
+}
+
+void MainWindow::onImportFolder() {
+    const QString directory = QFileDialog::getExistingDirectory(this, "Import WireGuard Config Folder");
+    if (directory.isEmpty()) return;
+    startBulkImport(QStringList() << directory);
+}
+
+void MainWindow::startBulkImport(const QStringList &paths) {
+    if (!m_wgManager->importBundle(paths)) return;  // Button is disabled while one runs
+    ui->progressBar->setRange(0, 100);
+    ui->progressBar->setValue(0);
+    ui->progressBar->setVisible(true);
+    ui->importButton->setEnabled(false);
+    m_fastestButton->setEnabled(false);
+    statusBar()->showMessage("Importing configs...");
+}
+
+void MainWindow::onBulkImportFinished(int imported, const QVector<BulkImporter::Failure> &failures,
+                                      const QStringList &replaced, const QString &commitError) {
     ui->progressBar->setVisible(false);
-    if (configData.isEmpty()) {
-        QMessageBox::warning(this, "Error", "Invalid config file. Check logs.");
+    ui->importButton->setEnabled(true);
+    m_fastestButton->setEnabled(true);
+    if (!commitError.isEmpty()) {
+        QMessageBox::warning(this, "Import Failed", commitError);
         statusBar()->showMessage("Import failed.");
         return;
     }
+    QString summary = QString("Imported %1 profile(s)").arg(imported);
+    if (!replaced.isEmpty()) summary += QString(", replacing %1 existing").arg(replaced.size());
+    statusBar()->showMessage(summary + '.');
+    if (failures.isEmpty() && replaced.isEmpty()) return;
+
+    QStringList details;
+    for (const QString &name : replaced) details.append(name + ": replaced the existing profile");
+    for (const BulkImporter::Failure &failure : failures) details.append(failure.file + ": " + failure.error);
+    if (!failures.isEmpty()) summary += QString("; %1 file(s) were skipped").arg(failures.size());
+    QMessageBox box(failures.isEmpty() ? QMessageBox::Information : QMessageBox::Warning, "Import",
+                    summary + '.', QMessageBox::Ok, this);
+    box.setDetailedText(details.join('\n'));
+    box.exec();
+}
 
-    QString tunnelName = QFileInfo(fileName).baseName();
-    if (m_wgManager->createTunnel(tunnelName, configData)) {
-        QMessageBox::information(this, "Success", "Config imported.");
-        statusBar()->showMessage("Config ready: " + tunnelName);
-        ui->statusLabel->setText("Ready");
-        QPalette pal = ui->statusLabel->palette();
-        pal.setColor(QPalette::WindowText, QColor("#ffc107"));  // Yellow for ready
-        ui->statusLabel->setPalette(pal);
-    } else {
-        QMessageBox::warning(this, "Error", "Failed to create tunnel.");
+void MainWindow::onProfileActivated(const QModelIndex &index) {
+    TPN_TRACE_SCOPE("UI::onProfileActivated");
+    const QString name = m_profileModel->profileName(index);
+    if (name.isEmpty()) return;
+
+    ui->progressBar->setRange(0, 0);
+    ui->progressBar->setVisible(true);
+    ui->importButton->setEnabled(false);
+    statusBar()->showMessage("Loading " + name + "...");
+    m_wgManager->loadProfile(name);
+}
+
+void MainWindow::onFastestClicked() {
+    TPN_TRACE_SCOPE("UI::onFastestClicked");
+    ui->progressBar->setRange(0, 0);
+    ui->progressBar->setVisible(true);
+    ui->importButton->setEnabled(false);
+    m_fastestButton->setEnabled(false);
+    statusBar()->showMessage("Probing servers...");
+    if (!m_wgManager->probeProfiles(true)) {
+        onImportFinished(QString(), false, "No profiles to probe. Import a config first.");
+    }
+}
+
+void MainWindow::onImportFinished(const QString &tunnelName, bool ok, const QString &error) {
+    TPN_TRACE_SCOPE("UI::onImportFinished");
+    ui->progressBar->setVisible(false);
+    ui->importButton->setEnabled(true);
+    m_fastestButton->setEnabled(true);
+    if (!ok) {
+        QMessageBox::warning(this, "Error", error);
+        statusBar()->showMessage("Import failed.");
+        return;
+    }
+
+    statusBar()->showMessage("Config ready: " + tunnelName);  // The label follows the connection state
+    showSelfTest(m_wgManager->lastSelfTest(tunnelName));
+}
+
+void MainWindow::onSelfTestStarted(const QString &profile) {
+    m_selfTestLabel->setText("Testing " + profile + "...");
+    m_selfTestLabel->setToolTip(QString());
+    m_selfTestLabel->setVisible(true);
+}
+
+void MainWindow::onSelfTestFinished(const QString &profile, const SelfTest::Result &result) {
+    if (profile != m_wgManager->tunnelName()) return;  // Switched away meanwhile
+    showSelfTest(result);
+    if (result.ok) statusBar()->showMessage("Self-test finished.");
+}
+
+void MainWindow::showSelfTest(const SelfTest::Result &result) {
+    if (!result.finishedMs) {
+        m_selfTestLabel->setVisible(false);
+        return;
     }
+    m_selfTestLabel->setText(result.summary());
+    m_selfTestLabel->setToolTip(QString("Tested %1\n%2 of %3 pings answered, min RTT %4 ms\n%5 streams per throughput phase")
+                                .arg(QDateTime::fromMSecsSinceEpoch(result.finishedMs).toString(Qt::SystemLocaleShortDate))
+                                .arg(result.pingsReceived).arg(result.pingsSent).arg(result.rttMinMs, 0, 'f', 2)
+                                .arg(result.streams));
+    m_selfTestLabel->setVisible(true);
 }
 
-void MainWindow::onStatusChanged(const QString &status) {
+void MainWindow::onConnectionChanged(const ConnectionSnapshot &connection) {
+    TPN_TRACE_SCOPE("UI::onConnectionChanged");
+    const QString status = ConnectionSnapshot::stateName(connection.state);
     ui->statusLabel->setText(status);
-    m_trayIcon->setToolTip("WireGuard: " + status);
+    ui->statusLabel->setToolTip(connection.lastError);
+    QString tip = "WireGuard: " + status;
+    if (!connection.profile.isEmpty()) tip += "\n" + connection.profile;
+    if (!connection.endpoint.isEmpty()) tip += " (" + connection.endpoint + ")";
+    m_trayIcon->setToolTip(tip);
+
     QPalette pal = ui->statusLabel->palette();
-    if (status == "Connected") {
+    switch (connection.state) {
+    case ConnectionSnapshot::Connected:
         pal.setColor(QPalette::WindowText, QColor("#28a745"));  // Green
         statusBar()->showMessage("Connected to VPN.");
-    } else if (status == "Disconnected") {
+        break;
+    case ConnectionSnapshot::Disconnected:
         pal.setColor(QPalette::WindowText, QColor("#dc3545"));  // Red
-        statusBar()->showMessage("Disconnected.");
-    } else if (status == "Ready") {
+        statusBar()->showMessage(connection.lastError.isEmpty() ? QString("Disconnected.") : connection.lastError);
+        break;
+    case ConnectionSnapshot::Ready:
+    case ConnectionSnapshot::Reconnecting:
         pal.setColor(QPalette::WindowText, QColor("#ffc107"));  // Yellow
-    } else {
+        break;
+    default:
         pal.setColor(QPalette::WindowText, QColor("#ffffff"));  // White default
+        break;
     }
     ui->statusLabel->setPalette(pal);
+    if (!m_isConnecting) updateToggleButton();  // The tray or IPC may have toggled it
 }
 
-void MainWindow::onLogMessage(const QString &msg) {
-    ui->logTextEdit->append("[" + QTime::currentTime().toString() + "] " + msg);
+void MainWindow::drainLog() {
+    TPN_TRACE_SCOPE("UI::drainLog");
+    // One insert per batch: a burst of records costs a single layout pass.
+    // The view keeps tailing only if it was scrolled to the bottom
+    m_logBatch.clear();
+    if (!Logger::instance().takeBatch(&m_logBatch)) return;
+    const QScrollBar *bar = m_logView->verticalScrollBar();
+    const bool following = bar->value() >= bar->maximum();
+    m_logModel->append(m_logBatch);
+    if (following) m_logView->scrollToBottom();
+}
+
+void MainWindow::applyLogFilter() {
+    TPN_TRACE_SCOPE("UI::applyLogFilter");
+    m_logModel->setFilter(LogLevel(m_logLevelFilter->currentData().toInt()),
+                          m_logComponentFilter->currentData().toString(), m_logSearch->text());
+    m_logView->scrollToBottom();
+}
+
+void MainWindow::onLogComponentsChanged(const QStringList &components) {
+    const QString current = m_logComponentFilter->currentData().toString();
+    const QSignalBlocker blocker(m_logComponentFilter);  // The selection itself does not change
+    m_logComponentFilter->clear();
+    m_logComponentFilter->addItem("Any", QString());
+    QStringList sorted = components;
+    sorted.sort();
+    for (const QString &component : qAsConst(sorted)) m_logComponentFilter->addItem(component, component);
+    m_logComponentFilter->setCurrentIndex(qMax(0, m_logComponentFilter->findData(current)));
+}
+
+void MainWindow::onLogContextMenu(const QPoint &pos) {
+    QMenu *menu = new QMenu(this);
+    QModelIndexList selected = m_logView->selectionModel()->selectedRows();
+    QAction *copy = menu->addAction("Copy");
+    copy->setEnabled(!selected.isEmpty());
+    connect(copy, &QAction::triggered, this, [this, selected]() mutable {
+        std::sort(selected.begin(), selected.end());
+        QStringList lines;
+        for (const QModelIndex &index : qAsConst(selected)) lines.append(m_logModel->lineText(index.row()));
+        QApplication::clipboard()->setText(lines.join('\n'));
+    });
+    connect(menu->addAction("Clear"), &QAction::triggered, m_logModel, &LogModel::clear);
+    menu->addSeparator();
+    QMenu *levels = menu->addMenu("Log Level");
+    const LogLevel current = Logger::level();
+    for (LogLevel level : { LogLevel::Debug, LogLevel::Info, LogLevel::Warning, LogLevel::Error }) {
+        QAction *action = levels->addAction(Logger::levelName(level));
+        action->setCheckable(true);
+        action->setChecked(level == current);
+        connect(action, &QAction::triggered, this, [level]() { Logger::setLevel(level); });
+    }
+    menu->exec(m_logView->viewport()->mapToGlobal(pos));
+    delete menu;
+}
+
+void MainWindow::onSaveTrace() {
+    const QString path = QFileDialog::getSaveFileName(this, "Save Trace", "tpn-trace.json", "Chrome Trace (*.json)");
+    if (path.isEmpty()) return;
+    Tracer::instance().setEnabled(false);  // Consistent snapshot
+    QString error;
+    if (!Tracer::instance().save(path, &error)) {
+        QMessageBox::warning(this, "Error", "Failed to save trace: " + error);
+        return;
+    }
+    statusBar()->showMessage(QString("Saved %1 spans, open in ui.perfetto.dev.").arg(Tracer::instance().spanCount()));
 }
 
 void MainWindow::onProgressChanged(int value) {
-    // For future: If determinate progress, set ui->progressBar->setValue(value);
-    // Currently indeterminate during connect.
+    // Determinate once the manager reports a real percentage
+    ui->progressBar->setRange(0, 100);
+    ui->progressBar->setValue(value);
+}
+
+void MainWindow::onStatsUpdated(const TrafficStats &stats) {
+    m_stats = stats;
+    if (!m_statsRepaint.isActive()) m_statsRepaint.start();
+}
+
+void MainWindow::repaintStats() {
+    TPN_TRACE_SCOPE("UI::repaintStats");
+    if (!m_stats.peers) {
+        m_statsLabel->setVisible(false);
+        return;
+    }
+    QString handshake = "no handshake yet";
+    if (m_stats.lastHandshakeMs) {
+        const qint64 ago = (QDateTime::currentMSecsSinceEpoch() - m_stats.lastHandshakeMs) / 1000;
+        handshake = QString("handshake %1 s ago").arg(qMax<qint64>(0, ago));
+    }
+    m_statsLabel->setText(QString("In %1   Out %2   (%3)")
+                          .arg(formatRate(m_stats.rxRate), formatRate(m_stats.txRate), handshake));
+    m_statsLabel->setToolTip(QString("Received %1 MB, sent %2 MB\nAverage in %3, out %4")
+                             .arg(m_stats.rxBytes / 1e6, 0, 'f', 1).arg(m_stats.txBytes / 1e6, 0, 'f', 1)
+                             .arg(formatRate(m_stats.rxAverage), formatRate(m_stats.txAverage)));
+    m_statsLabel->setVisible(true);
+}
+
+void MainWindow::updateStatsRate() {
+    m_wgManager->setStatsInterval(isVisible() && !isMinimized() ? kStatsVisibleMs : kStatsHiddenMs);
+}
+
+void MainWindow::paintEvent(QPaintEvent *event) {
+    QMainWindow::paintEvent(event);
+    m_startup->markFirstPaint();
+}
+
+void MainWindow::showEvent(QShowEvent *event) {
+    QMainWindow::showEvent(event);
+    updateStatsRate();
+}
+
+void MainWindow::hideEvent(QHideEvent *event) {
+    QMainWindow::hideEvent(event);
+    updateStatsRate();
+}
+
+void MainWindow::changeEvent(QEvent *event) {
+    QMainWindow::changeEvent(event);
+    if (event->type() == QEvent::WindowStateChange) updateStatsRate();
 }
 
 void MainWindow::onTrayActivated(QSystemTrayIcon::ActivationReason reason) {
@@ -258,7 +618,96 @@ void MainWindow::closeEvent(QCloseEvent *event) {
         hide();
         event->ignore();
     } else {
-        m_wgManager->stopTunnel();
+        const ConnectionSnapshot connection = m_wgManager->connection()->snapshot();
+        if (connection.isConnected() || connection.isBusy()) m_wgManager->stopTunnel();
         event->accept();
     }
-}
\ No newline at end of file
+}
+
+void MainWindow::applyTheme(QApplication *app) {
+    app->setStyle(QStyleFactory::create("Fusion"));  // Smooth base for dark theme
+
+    // Global Dark Theme Stylesheet (Astrill-like: dark bg, green accents)
+    app->setStyleSheet(R"(
+        QMainWindow {
+            background-color: #1e1e1e;
+            color: #ffffff;
+        }
+        QPushButton {
+            background-color: #2d2d2d;
+            border: 1px solid #404040;
+            border-radius: 5px;
+            padding: 8px 16px;
+            color: #ffffff;
+            font-weight: bold;
+        }
+        QPushButton:hover {
+            background-color: #404040;
+            border-color: #007acc;
+        }
+        QPushButton:pressed {
+            background-color: #1a1a1a;
+        }
+        QPushButton#toggleButton {
+            background-color: #28a745;
+            border-color: #28a745;
+            min-width: 120px;
+        }
+        QPushButton#toggleButton:hover {
+            background-color: #218838;
+        }
+        QPushButton#toggleButton:pressed {
+            background-color: #1e7e34;
+        }
+        QPushButton#disconnectButton {
+            background-color: #dc3545;
+            border-color: #dc3545;
+        }
+        QPushButton#disconnectButton:hover {
+            background-color: #c82333;
+        }
+        QLabel {
+            color: #ffffff;
+            font-size: 14px;
+        }
+        QLabel#statusLabel {
+            font-size: 16px;
+            font-weight: bold;
+            padding: 10px;
+            border-radius: 3px;
+        }
+        QStatusBar {
+            background-color: #2d2d2d;
+            color: #cccccc;
+            font-size: 12px;
+        }
+        QTextEdit {
+            background-color: #1a1a1a;
+            border: 1px solid #404040;
+            border-radius: 3px;
+            color: #e0e0e0;
+            font-family: 'Consolas';
+            font-size: 11px;
+        }
+        QProgressBar {
+            border: 1px solid #404040;
+            border-radius: 5px;
+            text-align: center;
+            background-color: #2d2d2d;
+            color: #ffffff;
+        }
+        QProgressBar::chunk {
+            background-color: #007acc;
+            border-radius: 3px;
+        }
+        QSplitter::handle {
+            background-color: #404040;
+        }
+        QTreeView {
+            background-color: #1a1a1a;
+            color: #ffffff;
+            border: 1px solid #404040;
+            selection-background-color: #007acc;
+        }
+    )");
+}
@@ -6,7 +6,19 @@
 #include <QAction>
 #include <QPropertyAnimation>
 #include <QSplitter>
+#include <QTimer>
 #include "WireGuardManager.h"
+#include "ProfileModel.h"
+#include "LogModel.h"
+#include "StartupSequence.h"
+#include "Logger.h"
+
+class QApplication;
+class QTreeView;
+class QListView;
+class QLineEdit;
+class QComboBox;
+class QPushButton;
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
@@ -16,31 +28,74 @@ class MainWindow : public QMainWindow {
     Q_OBJECT
 
 public:
-    MainWindow(QWidget *parent = nullptr);
+    explicit MainWindow(TunnelBackend *backend, QWidget *parent = nullptr);  // Takes ownership
     ~MainWindow();
 
+    StartupSequence *startup() const { return m_startup; }
+
+    // Fusion plus the dark stylesheet; call before the first window
+    static void applyTheme(QApplication *app);
+
 private slots:
+    void onStartupPhaseFinished(StartupSequence::Phase phase, bool ok);
+    void onStartupReady();
     void onToggleClicked();
     void onImportConfig();
-    void onStatusChanged(const QString &status);
-    void onLogMessage(const QString &msg);
+    void onImportFolder();
+    void onBulkImportFinished(int imported, const QVector<BulkImporter::Failure> &failures,
+                              const QStringList &replaced, const QString &commitError);
+    void onFastestClicked();
+    void onImportFinished(const QString &tunnelName, bool ok, const QString &error);
+    void onProfileActivated(const QModelIndex &index);
+    void onTunnelCommandFinished(TunnelWorker::Command command, bool ok);
+    void onConnectionChanged(const ConnectionSnapshot &connection);
+    void drainLog();
+    void onLogContextMenu(const QPoint &pos);
+    void applyLogFilter();
+    void onLogComponentsChanged(const QStringList &components);
+    void onSaveTrace();
     void onProgressChanged(int value);
+    void onStatsUpdated(const TrafficStats &stats);
+    void onSelfTestStarted(const QString &profile);
+    void onSelfTestFinished(const QString &profile, const SelfTest::Result &result);
+    void repaintStats();
     void onTrayActivated(QSystemTrayIcon::ActivationReason reason);
     void onAnimationFinished();
 
 private:
     Ui::MainWindow *ui;
     WireGuardManager *m_wgManager;
+    StartupSequence *m_startup;
     QSystemTrayIcon *m_trayIcon;
     QAction *m_toggleAction;
     QPropertyAnimation *m_buttonAnimation;
-    bool m_isConnected = false;
+    ProfileModel *m_profileModel;
+    QTreeView *m_profileView;
+    QPushButton *m_fastestButton;
+    QLabel *m_statsLabel;
+    QLabel *m_selfTestLabel;  // Last self-test of the loaded profile
+    TrafficStats m_stats;   // Latest sample, painted at most once per frame
+    QTimer m_statsRepaint;
+    QTimer m_logFlush;               // One log drain per frame at most
+    QVector<LogRecord> m_logBatch;   // Reused between drains
+    LogModel *m_logModel;            // Whole session, see LogStore
+    QListView *m_logView;
+    QLineEdit *m_logSearch;
+    QComboBox *m_logLevelFilter;
+    QComboBox *m_logComponentFilter;
     bool m_isConnecting = false;
     void setupUI();
     void setupTray();
     void toggleConnection();
+    void startBulkImport(const QStringList &paths);
     void updateToggleButton();
+    void updateStatsRate();
+    void showSelfTest(const SelfTest::Result &result);
     void closeEvent(QCloseEvent *event) override;
+    void paintEvent(QPaintEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+    void changeEvent(QEvent *event) override;
 };
 
 #endif // MAINWINDOW_H
\ No newline at end of file